@@ -20,13 +20,20 @@ struct Stack<std::array<T, Size>>
 {
     using Type = std::array<T, Size>;
 
+    static constexpr int stackSlots = detail::nested_stack_slots_v<2, T>;
+
     [[nodiscard]] static Result push(lua_State* L, const Type& array)
     {
 #if LUABRIDGE_SAFE_STACK_CHECKS
-        if (! lua_checkstack(L, 3))
+        if (! lua_checkstack(L, stackSlots > 0 ? stackSlots : 3))
             return makeErrorCode(ErrorCode::LuaStackOverflow);
 #endif
 
+        return pushUnchecked(L, array);
+    }
+
+    [[nodiscard]] static Result pushUnchecked(lua_State* L, const Type& array)
+    {
         StackRestore stackRestore(L);
 
         lua_createtable(L, static_cast<int>(Size), 0);
@@ -35,7 +42,7 @@ struct Stack<std::array<T, Size>>
         {
             lua_pushinteger(L, static_cast<lua_Integer>(i + 1));
 
-            auto result = Stack<T>::push(L, array[i]);
+            auto result = detail::push_reserved<T>(L, array[i]);
             if (! result)
                 return result;
 
@@ -0,0 +1,551 @@
+// https://github.com/kunitoki/LuaBridge3
+// Copyright 2023, Lucio Asnaghi
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "detail/ClassInfo.h"
+#include "detail/LuaHelpers.h"
+#include "detail/Stack.h"
+
+#include <array>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace luabridge {
+
+//=================================================================================================
+/**
+ * @brief Reference to a C++ container, pushed to lua as a userdata looking up its entries on demand.
+ *
+ * Unlike the `Stack` specializations of the containers, which copy the whole container into a table, a proxy reads and writes the
+ * entries of the live container when they are accessed, through `__index`, `__newindex`, `__len` and `__pairs` (`__iter` on Luau).
+ * Supported containers are `std::map`, `std::unordered_map`, `std::vector` and `std::array`, const qualified for read only access.
+ *
+ * A borrowed proxy references a container owned by C++, which must outlive the proxy and every element referenced from lua. A shared
+ * proxy keeps the container alive while the proxy or any element referenced from lua is alive. Objects of registered classes are
+ * referenced in place, so the proxy can assign them but can't resize or erase from their containers.
+ *
+ * @tparam Container The type of the container, const qualified to prevent modifications from lua.
+ */
+template <class Container>
+class ContainerProxy
+{
+public:
+    using ContainerType = Container;
+
+    /**
+     * @brief Create a proxy borrowing a container.
+     */
+    explicit ContainerProxy(Container& container) noexcept
+        : m_container(std::addressof(container))
+    {
+    }
+
+    /**
+     * @brief Create a proxy sharing the ownership of a container.
+     */
+    explicit ContainerProxy(std::shared_ptr<Container> container) noexcept
+        : m_container(container.get())
+        , m_owner(std::move(container))
+    {
+    }
+
+    /**
+     * @brief Get the referenced container.
+     */
+    [[nodiscard]] Container& container() const noexcept
+    {
+        return *m_container;
+    }
+
+    /**
+     * @brief Get the owner of a shared container, or nullptr if the container is borrowed.
+     */
+    [[nodiscard]] const std::shared_ptr<Container>& owner() const noexcept
+    {
+        return m_owner;
+    }
+
+private:
+    Container* m_container = nullptr;
+    std::shared_ptr<Container> m_owner;
+};
+
+//=================================================================================================
+/**
+ * @brief Create a proxy borrowing a container, which must outlive the proxy.
+ */
+template <class Container>
+[[nodiscard]] ContainerProxy<Container> borrowContainer(Container& container) noexcept
+{
+    return ContainerProxy<Container>(container);
+}
+
+/**
+ * @brief Create a proxy sharing the ownership of a container.
+ */
+template <class Container>
+[[nodiscard]] ContainerProxy<Container> shareContainer(std::shared_ptr<Container> container) noexcept
+{
+    return ContainerProxy<Container>(std::move(container));
+}
+
+namespace detail {
+
+//=================================================================================================
+/**
+ * @brief Traits of the containers supported by `ContainerProxy`.
+ */
+template <class Container>
+struct container_proxy_traits;
+
+template <class Container>
+struct container_proxy_traits<const Container> : container_proxy_traits<Container>
+{
+};
+
+template <class K, class V, class... Rest>
+struct container_proxy_traits<std::map<K, V, Rest...>>
+{
+    using KeyType = K;
+    using ValueType = V;
+
+    static constexpr bool isKeyed = true;
+    static constexpr bool isOrdered = true;
+};
+
+template <class K, class V, class... Rest>
+struct container_proxy_traits<std::unordered_map<K, V, Rest...>>
+{
+    using KeyType = K;
+    using ValueType = V;
+
+    static constexpr bool isKeyed = true;
+    static constexpr bool isOrdered = false;
+};
+
+template <class T, class Allocator>
+struct container_proxy_traits<std::vector<T, Allocator>>
+{
+    using ValueType = T;
+
+    static constexpr bool isKeyed = false;
+    static constexpr bool isResizable = true;
+};
+
+template <class T, std::size_t N>
+struct container_proxy_traits<std::array<T, N>>
+{
+    using ValueType = T;
+
+    static constexpr bool isKeyed = false;
+    static constexpr bool isResizable = false;
+};
+
+//=================================================================================================
+/**
+ * @brief Get the proxy stored in the userdata at the specified index, or nullptr if the value is not a proxy of the container type.
+ */
+template <class Container>
+ContainerProxy<Container>* get_container_proxy(lua_State* L, int index)
+{
+    if (! isfulluserdata(L, index) || ! lua_getmetatable(L, index)) // Stack: mt
+        return nullptr;
+
+    lua_rawgetp(L, LUA_REGISTRYINDEX, getContainerProxyRegistryKey<Container>()); // Stack: mt, proxy metatable | nil
+    const bool isProxy = lua_rawequal(L, -1, -2) != 0;
+    lua_pop(L, 2); // Stack: -
+
+    return isProxy ? align<ContainerProxy<Container>>(lua_touserdata(L, index)) : nullptr;
+}
+
+/**
+ * @brief Push an element of a proxied container.
+ *
+ * Objects of registered classes are pushed by reference, holding the owner of a shared container, other values are pushed as copies.
+ * References stay valid as the proxy doesn't resize or erase from containers of registered classes.
+ */
+template <class Container, class Element>
+Result push_container_element(lua_State* L, const ContainerProxy<Container>& proxy, Element&& element)
+{
+    using ValueType = typename container_proxy_traits<Container>::ValueType;
+    using ReferenceType = std::conditional_t<std::is_const_v<Container>, const ValueType, ValueType>;
+
+    if constexpr (IsUserdata<ValueType>::value)
+    {
+        ReferenceType* pointer = std::addressof(element);
+
+        if (proxy.owner())
+            return Stack<std::shared_ptr<ReferenceType>>::push(L, std::shared_ptr<ReferenceType>(proxy.owner(), pointer));
+
+        return Stack<ReferenceType*>::push(L, pointer);
+    }
+    else
+    {
+        return Stack<ValueType>::push(L, element);
+    }
+}
+
+/**
+ * @brief Get the zero based position of the one based index at the specified stack index, if it is in range.
+ */
+inline std::optional<std::size_t> get_container_position(lua_State* L, int index, std::size_t size)
+{
+    if (lua_type(L, index) != LUA_TNUMBER)
+        return std::nullopt;
+
+    int isValid = 0;
+    const auto position = tointeger(L, index, &isValid);
+    if (! isValid || position < 1 || static_cast<std::size_t>(position) > size)
+        return std::nullopt;
+
+    return static_cast<std::size_t>(position - 1);
+}
+
+//=================================================================================================
+/**
+ * @brief __index metamethod of a container proxy.
+ */
+template <class Container>
+int container_proxy_index(lua_State* L)
+{
+    using Traits = container_proxy_traits<Container>;
+
+    const auto& proxy = *align<ContainerProxy<Container>>(lua_touserdata(L, 1));
+    auto& container = proxy.container();
+
+    Result result;
+
+    if constexpr (Traits::isKeyed)
+    {
+        const auto key = Stack<typename Traits::KeyType>::get(L, 2);
+        const auto it = key ? container.find(*key) : container.end();
+        if (it == container.end())
+        {
+            lua_pushnil(L);
+            return 1;
+        }
+
+        result = push_container_element(L, proxy, it->second);
+    }
+    else
+    {
+        const auto position = get_container_position(L, 2, container.size());
+        if (! position)
+        {
+            lua_pushnil(L);
+            return 1;
+        }
+
+        result = push_container_element(L, proxy, container[*position]);
+    }
+
+    if (! result)
+        raise_lua_error(L, "%s", result.message().c_str());
+
+    return 1;
+}
+
+/**
+ * @brief Assign the value at index 3 to the entry of the key at index 2.
+ *
+ * Assigning nil erases an entry of a map, or the last element of a vector. Containers of registered classes can't be resized or erased
+ * from, as that would invalidate the elements referenced from lua.
+ *
+ * @returns The error message, or nullptr if the entry has been assigned.
+ */
+template <class Container>
+const char* assign_container_entry(lua_State* L, Container& container)
+{
+    using Traits = container_proxy_traits<Container>;
+    using ValueType = typename Traits::ValueType;
+
+    constexpr bool isReferenced = IsUserdata<ValueType>::value;
+
+    if constexpr (Traits::isKeyed)
+    {
+        auto key = Stack<typename Traits::KeyType>::get(L, 2);
+        if (! key)
+            return "invalid key type for the container";
+
+        if (lua_isnil(L, 3))
+        {
+            if constexpr (isReferenced)
+                return "entries of a container of class objects can't be erased";
+            else
+                container.erase(*key);
+
+            return nullptr;
+        }
+
+        auto value = Stack<ValueType>::get(L, 3);
+        if (! value)
+            return "invalid value type for the container";
+
+        container.insert_or_assign(std::move(*key), std::move(*value));
+    }
+    else
+    {
+        const std::size_t size = container.size();
+
+        std::optional<std::size_t> position;
+
+        if constexpr (Traits::isResizable)
+        {
+            position = get_container_position(L, 2, size + 1);
+            if (position && lua_isnil(L, 3))
+            {
+                if constexpr (isReferenced)
+                    return "a container of class objects can't be resized";
+                else if (*position + 1 != size)
+                    return "only the last element of the container can be erased";
+                else
+                    container.pop_back();
+
+                return nullptr;
+            }
+        }
+        else
+        {
+            position = get_container_position(L, 2, size);
+        }
+
+        if (! position)
+            return "index out of range of the container";
+
+        auto value = Stack<ValueType>::get(L, 3);
+        if (! value)
+            return "invalid value type for the container";
+
+        if (*position == size)
+        {
+            if constexpr (isReferenced)
+                return "a container of class objects can't be resized";
+            else if constexpr (Traits::isResizable)
+                container.push_back(std::move(*value));
+        }
+        else
+        {
+            container[*position] = std::move(*value);
+        }
+    }
+
+    return nullptr;
+}
+
+//=================================================================================================
+/**
+ * @brief __newindex metamethod of a container proxy.
+ */
+template <class Container>
+int container_proxy_newindex(lua_State* L)
+{
+    const char* error = "attempt to modify a read only container";
+
+    if constexpr (! std::is_const_v<Container>)
+        error = assign_container_entry(L, align<ContainerProxy<Container>>(lua_touserdata(L, 1))->container());
+
+    if (error != nullptr)
+        raise_lua_error(L, "%s", error);
+
+    return 0;
+}
+
+/**
+ * @brief __len metamethod of a container proxy.
+ */
+template <class Container>
+int container_proxy_len(lua_State* L)
+{
+    const auto& container = align<ContainerProxy<Container>>(lua_touserdata(L, 1))->container();
+
+    lua_pushinteger(L, static_cast<lua_Integer>(container.size()));
+    return 1;
+}
+
+/**
+ * @brief Iterator function of a container proxy, returning the entry following the key at index 2.
+ *
+ * Entries are located from the key on each step, so assigning existing entries while iterating is allowed. Maps can erase the current
+ * entry as well, while erasing from an unordered map ends the iteration.
+ */
+template <class Container>
+int container_proxy_next(lua_State* L)
+{
+    using Traits = container_proxy_traits<Container>;
+
+    const auto* proxy = get_container_proxy<Container>(L, 1);
+    if (proxy == nullptr)
+        raise_lua_error(L, "%s", "invalid container iteration");
+
+    auto& container = proxy->container();
+
+    Result result;
+
+    if constexpr (Traits::isKeyed)
+    {
+        auto it = container.begin();
+
+        if (! lua_isnil(L, 2))
+        {
+            const auto key = Stack<typename Traits::KeyType>::get(L, 2);
+            if (! key)
+                return 0;
+
+            if constexpr (Traits::isOrdered)
+            {
+                it = container.upper_bound(*key);
+            }
+            else
+            {
+                it = container.find(*key);
+                if (it != container.end())
+                    ++it;
+            }
+        }
+
+        if (it == container.end())
+            return 0;
+
+        result = Stack<typename Traits::KeyType>::push(L, it->first);
+        if (result)
+            result = push_container_element(L, *proxy, it->second);
+    }
+    else
+    {
+        std::size_t position = 0;
+
+        if (! lua_isnil(L, 2))
+        {
+            int isValid = 0;
+            position = static_cast<std::size_t>(tointeger(L, 2, &isValid));
+            if (! isValid)
+                return 0;
+        }
+
+        if (position >= container.size())
+            return 0;
+
+        lua_pushinteger(L, static_cast<lua_Integer>(position + 1));
+        result = push_container_element(L, *proxy, container[position]);
+    }
+
+    if (! result)
+        raise_lua_error(L, "%s", result.message().c_str());
+
+    return 2;
+}
+
+/**
+ * @brief __pairs (and __iter on Luau) metamethod of a container proxy.
+ */
+template <class Container>
+int container_proxy_pairs(lua_State* L)
+{
+    lua_pushcfunction_x(L, &container_proxy_next<Container>);
+    lua_pushvalue(L, 1);
+    lua_pushnil(L);
+    return 3;
+}
+
+/**
+ * @brief Push the metatable of the proxies of a container type, creating it in the registry the first time.
+ */
+template <class Container>
+void push_container_proxy_metatable(lua_State* L)
+{
+    lua_rawgetp(L, LUA_REGISTRYINDEX, getContainerProxyRegistryKey<Container>()); // Stack: metatable (mt) | nil
+    if (lua_istable(L, -1))
+        return;
+
+    lua_pop(L, 1); // Stack: -
+    lua_createtable(L, 0, 6); // Stack: mt
+
+#if ! LUABRIDGE_ON_LUAU
+    lua_pushcfunction_x(L, &lua_deleteuserdata_aligned<ContainerProxy<Container>>);
+    rawsetfield(L, -2, "__gc");
+#endif
+
+    lua_pushcfunction_x(L, &container_proxy_index<Container>);
+    rawsetfield(L, -2, "__index");
+
+    lua_pushcfunction_x(L, &container_proxy_newindex<Container>);
+    rawsetfield(L, -2, "__newindex");
+
+    lua_pushcfunction_x(L, &container_proxy_len<Container>);
+    rawsetfield(L, -2, "__len");
+
+    lua_pushcfunction_x(L, &container_proxy_pairs<Container>);
+    rawsetfield(L, -2, "__pairs");
+
+#if LUABRIDGE_ON_LUAU
+    lua_pushcfunction_x(L, &container_proxy_pairs<Container>);
+    rawsetfield(L, -2, "__iter");
+#endif
+
+    lua_pushboolean(L, 0);
+    rawsetfield(L, -2, "__metatable");
+
+    lua_pushvalue(L, -1); // Stack: mt, mt
+    lua_rawsetp(L, LUA_REGISTRYINDEX, getContainerProxyRegistryKey<Container>()); // registry [containerProxyKey] = mt. Stack: mt
+}
+
+} // namespace detail
+
+//=================================================================================================
+/**
+ * @brief Stack specialization for `ContainerProxy`.
+ */
+template <class Container>
+struct Stack<ContainerProxy<Container>>
+{
+    using Type = ContainerProxy<Container>;
+
+    [[nodiscard]] static Result push(lua_State* L, const Type& proxy)
+    {
+#if LUABRIDGE_SAFE_STACK_CHECKS
+        if (! lua_checkstack(L, 2))
+            return makeErrorCode(ErrorCode::LuaStackOverflow);
+#endif
+
+#if LUABRIDGE_ON_LUAU
+        void* pointer = lua_newuserdatadtor(L, maximum_space_needed_to_align<Type>(), [](void* x)
+        {
+            align<Type>(x)->~Type();
+        }); // Stack: proxy
+#else
+        void* pointer = lua_newuserdata_x<Type>(L, maximum_space_needed_to_align<Type>()); // Stack: proxy
+#endif
+
+        new (align<Type>(pointer)) Type(proxy);
+
+        detail::push_container_proxy_metatable<Container>(L); // Stack: proxy, mt
+        lua_setmetatable(L, -2); // Stack: proxy
+
+        return {};
+    }
+
+    [[nodiscard]] static TypeResult<Type> get(lua_State* L, int index)
+    {
+        const auto* proxy = detail::get_container_proxy<Container>(L, index);
+        if (proxy == nullptr)
+            return makeErrorCode(ErrorCode::InvalidTypeCast);
+
+        return *proxy;
+    }
+
+    [[nodiscard]] static bool isInstance(lua_State* L, int index)
+    {
+        return detail::get_container_proxy<Container>(L, index) != nullptr;
+    }
+};
+
+} // namespace luabridge
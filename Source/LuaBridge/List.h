@@ -20,13 +20,20 @@ struct Stack<std::list<T>>
 {
     using Type = std::list<T>;
     
+    static constexpr int stackSlots = detail::nested_stack_slots_v<2, T>;
+
     [[nodiscard]] static Result push(lua_State* L, const Type& list)
     {
 #if LUABRIDGE_SAFE_STACK_CHECKS
-        if (! lua_checkstack(L, 3))
+        if (! lua_checkstack(L, stackSlots > 0 ? stackSlots : 3))
             return makeErrorCode(ErrorCode::LuaStackOverflow);
 #endif
 
+        return pushUnchecked(L, list);
+    }
+
+    [[nodiscard]] static Result pushUnchecked(lua_State* L, const Type& list)
+    {
         StackRestore stackRestore(L);
 
         lua_createtable(L, static_cast<int>(list.size()), 0);
@@ -36,7 +43,7 @@ struct Stack<std::list<T>>
         {
             lua_pushinteger(L, tableIndex);
 
-            auto result = Stack<T>::push(L, *it);
+            auto result = detail::push_reserved<T>(L, *it);
             if (! result)
                 return result;
 
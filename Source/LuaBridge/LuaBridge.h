@@ -16,24 +16,37 @@
 
 #include "detail/Config.h"
 
+#include "detail/BindingImage.h"
+#include "detail/BindingStats.h"
 #include "detail/CFunctions.h"
 #include "detail/ClassInfo.h"
+#include "detail/ClassSchema.h"
 #include "detail/Enum.h"
 #include "detail/Errors.h"
 #include "detail/Expected.h"
+#include "detail/ExternalMemory.h"
+#include "detail/Ffi.h"
 #include "detail/FlagSet.h"
 #include "detail/FuncTraits.h"
 #include "detail/Globals.h"
+#include "detail/IntrusivePtr.h"
 #include "detail/Invoke.h"
 #include "detail/Iterator.h"
 #include "detail/LuaException.h"
+#include "detail/LuaFunction.h"
 #include "detail/LuaHelpers.h"
 #include "detail/LuaRef.h"
 #include "detail/Namespace.h"
+#include "detail/ObjectCensus.h"
 #include "detail/Options.h"
 #include "detail/Overload.h"
+#include "detail/Profiler.h"
+#include "detail/ReleaseQueue.h"
 #include "detail/Result.h"
 #include "detail/ScopeGuard.h"
+#include "detail/Serialization.h"
 #include "detail/Stack.h"
+#include "detail/Transfer.h"
 #include "detail/TypeTraits.h"
 #include "detail/Userdata.h"
+#include "detail/WeakLuaRef.h"
@@ -19,13 +19,20 @@ struct Stack<std::set<K>>
 {
     using Type = std::set<K>;
     
+    static constexpr int stackSlots = detail::nested_stack_slots_v<2, K>;
+
     [[nodiscard]] static Result push(lua_State* L, const Type& set)
     {
 #if LUABRIDGE_SAFE_STACK_CHECKS
-        if (! lua_checkstack(L, 3))
+        if (! lua_checkstack(L, stackSlots > 0 ? stackSlots : 3))
             return makeErrorCode(ErrorCode::LuaStackOverflow);
 #endif
 
+        return pushUnchecked(L, set);
+    }
+
+    [[nodiscard]] static Result pushUnchecked(lua_State* L, const Type& set)
+    {
         StackRestore stackRestore(L);
 
         lua_createtable(L, 0, static_cast<int>(set.size()));
@@ -35,7 +42,7 @@ struct Stack<std::set<K>>
         {
             lua_pushinteger(L, tableIndex);
 
-            auto result = Stack<K>::push(L, *it);
+            auto result = detail::push_reserved<K>(L, *it);
             if (! result)
                 return result;
 
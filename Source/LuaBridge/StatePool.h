@@ -0,0 +1,505 @@
+// https://github.com/kunitoki/LuaBridge3
+// Copyright 2023, Lucio Asnaghi
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "detail/Config.h"
+#include "detail/LuaHelpers.h"
+#include "detail/Namespace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace luabridge {
+
+//=================================================================================================
+/**
+ * @brief Garbage collection performed on a pooled state after each job.
+ */
+enum class StatePoolCollect
+{
+    None, ///< Leave the collector alone.
+    Step, ///< Perform an incremental collection step.
+    Full  ///< Perform a full collection cycle.
+};
+
+//=================================================================================================
+/**
+ * @brief Options of a state pool.
+ */
+struct StatePoolOptions
+{
+    bool resetGlobals = true;                          ///< Restore the globals left by the registration after each job.
+    StatePoolCollect collect = StatePoolCollect::Full; ///< Garbage collection performed after each job.
+};
+
+//=================================================================================================
+/**
+ * @brief Aggregate counters of a state pool.
+ */
+struct StatePoolStats
+{
+    std::size_t states = 0;                  ///< Number of pooled states, each one served by its own worker thread.
+    std::uint64_t submittedJobs = 0;         ///< Number of jobs submitted.
+    std::uint64_t executedJobs = 0;          ///< Number of jobs completed.
+    std::uint64_t stolenJobs = 0;            ///< Number of jobs executed by a worker other than the one they were queued on.
+    std::chrono::nanoseconds uptime{};       ///< Time elapsed since the pool was created.
+    std::chrono::nanoseconds busyTime{};     ///< Time spent by all the workers running jobs and resetting states.
+    std::chrono::nanoseconds totalLatency{}; ///< Sum of the time elapsed between submission and completion of the jobs.
+    std::chrono::nanoseconds maxLatency{};   ///< Longest time elapsed between submission and completion of a job.
+
+    /**
+     * @brief Fraction of the available worker time spent running jobs, between 0 and 1.
+     */
+    [[nodiscard]] double utilization() const noexcept
+    {
+        const auto available = static_cast<double>(uptime.count()) * static_cast<double>(states);
+
+        return available > 0.0 ? static_cast<double>(busyTime.count()) / available : 0.0;
+    }
+
+    /**
+     * @brief Average time elapsed between submission and completion of a job.
+     */
+    [[nodiscard]] std::chrono::nanoseconds averageLatency() const noexcept
+    {
+        return executedJobs > 0 ? totalLatency / static_cast<std::chrono::nanoseconds::rep>(executedJobs) : std::chrono::nanoseconds{};
+    }
+};
+
+//=================================================================================================
+/**
+ * @brief Pool of pre registered lua states, each one owned by a worker thread, running submitted jobs with work stealing.
+ *
+ * Every state is created once, registered as its own main thread and passed to the registration callback. Jobs are queued on the
+ * workers in round robin, and an idle worker steals the oldest jobs queued on the others. A job receives the state of the worker
+ * running it, so it must not capture `LuaRef` or other values bound to a specific state. After each job the stack is cleared, the
+ * globals are restored to the ones left by the registration, and the collector is run, as configured by the options.
+ */
+class StatePool
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Task
+    {
+        std::function<void(lua_State*)> function;
+        Clock::time_point submitted;
+    };
+
+    struct Worker
+    {
+        ~Worker()
+        {
+            if (L != nullptr)
+                lua_close(L);
+        }
+
+        lua_State* L = nullptr;
+        int globalsRef = LUA_NOREF;
+
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::thread thread;
+
+        std::atomic<std::uint64_t> executed{ 0 };
+        std::atomic<std::uint64_t> stolen{ 0 };
+        std::atomic<std::int64_t> busyNanoseconds{ 0 };
+    };
+
+public:
+    /**
+     * @brief Create the states and start the workers.
+     *
+     * The registration is called once per state from the constructing thread, typically to open the libraries and to register the
+     * bindings with `getGlobalNamespace`. If it throws, or a state or a thread can't be created, the workers started so far are
+     * stopped and the states created so far are closed before the exception propagates.
+     *
+     * @param states The number of states and worker threads, 0 to use the number of hardware threads.
+     * @param registration A callable receiving each new `lua_State*`.
+     * @param options The reset options applied after each job.
+     */
+    template <class F>
+    StatePool(std::size_t states, F&& registration, StatePoolOptions options = {})
+        : m_options(options)
+        , m_created(Clock::now())
+    {
+        if (states == 0)
+            states = std::max(1u, std::thread::hardware_concurrency());
+
+        m_workers.reserve(states);
+        for (std::size_t index = 0; index < states; ++index)
+        {
+            auto worker = std::make_unique<Worker>();
+            worker->L = luaL_newstate();
+            if (worker->L == nullptr)
+            {
+                throw_or_assert<std::bad_alloc>();
+                break;
+            }
+
+            registerMainThread(worker->L);
+            registration(worker->L);
+
+            lua_settop(worker->L, 0);
+
+            if (m_options.resetGlobals)
+                worker->globalsRef = snapshotGlobals(worker->L);
+
+            m_workers.emplace_back(std::move(worker));
+        }
+
+        for (std::size_t index = 0; index < m_workers.size(); ++index)
+        {
+#if LUABRIDGE_HAS_EXCEPTIONS
+            try
+            {
+#endif
+                m_workers[index]->thread = std::thread([this, index] { run(index); });
+
+#if LUABRIDGE_HAS_EXCEPTIONS
+            }
+            catch (...)
+            {
+                stop();
+                throw;
+            }
+#endif
+        }
+    }
+
+    StatePool(const StatePool&) = delete;
+    StatePool& operator=(const StatePool&) = delete;
+
+    /**
+     * @brief Complete the queued jobs, then stop the workers and close the states.
+     */
+    ~StatePool()
+    {
+        stop();
+    }
+
+    /**
+     * @brief Number of pooled states.
+     */
+    [[nodiscard]] std::size_t size() const noexcept
+    {
+        return m_workers.size();
+    }
+
+    /**
+     * @brief Queue a job on the pool, callable from any thread.
+     *
+     * @param function A callable receiving the `lua_State*` of the worker running it.
+     *
+     * @returns A future of the result returned by the callable.
+     */
+    template <class F>
+    auto submit(F&& function) -> std::future<std::invoke_result_t<std::decay_t<F>, lua_State*>>
+    {
+        using R = std::invoke_result_t<std::decay_t<F>, lua_State*>;
+
+        auto task = std::make_shared<std::packaged_task<R(lua_State*)>>(std::forward<F>(function));
+        auto future = task->get_future();
+
+        push(Task{ [task](lua_State* L) { (*task)(L); }, Clock::now() });
+
+        return future;
+    }
+
+    /**
+     * @brief Block until all the submitted jobs have completed.
+     */
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        m_idle.wait(lock, [this] { return m_unfinished == 0; });
+    }
+
+    /**
+     * @brief Return the aggregate counters of the pool.
+     */
+    [[nodiscard]] StatePoolStats stats() const
+    {
+        StatePoolStats result;
+        result.states = m_workers.size();
+        result.submittedJobs = m_submitted.load(std::memory_order_relaxed);
+        result.uptime = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_created);
+        result.totalLatency = std::chrono::nanoseconds(m_totalLatencyNanoseconds.load(std::memory_order_relaxed));
+        result.maxLatency = std::chrono::nanoseconds(m_maxLatencyNanoseconds.load(std::memory_order_relaxed));
+
+        for (const auto& worker : m_workers)
+        {
+            result.executedJobs += worker->executed.load(std::memory_order_relaxed);
+            result.stolenJobs += worker->stolen.load(std::memory_order_relaxed);
+            result.busyTime += std::chrono::nanoseconds(worker->busyNanoseconds.load(std::memory_order_relaxed));
+        }
+
+        return result;
+    }
+
+private:
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+
+        m_wakeup.notify_all();
+
+        // Workers not started when the constructor failed have no thread to join
+        for (auto& worker : m_workers)
+        {
+            if (worker->thread.joinable())
+                worker->thread.join();
+        }
+    }
+
+    void push(Task task)
+    {
+        Worker& worker = *m_workers[m_nextWorker.fetch_add(1, std::memory_order_relaxed) % m_workers.size()];
+
+        // Count the task before publishing it, as a worker may pop it as soon as it is queued
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_queued;
+            ++m_unfinished;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            worker.tasks.emplace_back(std::move(task));
+        }
+
+        m_submitted.fetch_add(1, std::memory_order_relaxed);
+        m_wakeup.notify_one();
+    }
+
+    bool pop(Worker& worker, Task& task)
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+
+        if (worker.tasks.empty())
+            return false;
+
+        task = std::move(worker.tasks.front());
+        worker.tasks.pop_front();
+
+        m_queued.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool steal(std::size_t thief, Task& task)
+    {
+        for (std::size_t offset = 1; offset < m_workers.size(); ++offset)
+        {
+            if (pop(*m_workers[(thief + offset) % m_workers.size()], task))
+                return true;
+        }
+
+        return false;
+    }
+
+    void run(std::size_t index)
+    {
+        Worker& worker = *m_workers[index];
+
+        for (;;)
+        {
+            Task task;
+            bool stolen = false;
+
+            if (! pop(worker, task))
+            {
+                stolen = steal(index, task);
+
+                if (! stolen)
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_wakeup.wait(lock, [this] { return m_stopping || m_queued.load(std::memory_order_relaxed) > 0; });
+
+                    if (m_stopping && m_queued.load(std::memory_order_relaxed) == 0)
+                        return;
+
+                    continue;
+                }
+            }
+
+            execute(worker, task, stolen);
+        }
+    }
+
+    void execute(Worker& worker, Task& task, bool stolen)
+    {
+        const auto started = Clock::now();
+
+        task.function(worker.L);
+
+        const auto completed = Clock::now();
+
+        reset(worker);
+
+        const auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(completed - task.submitted).count();
+        const auto busy = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - started).count();
+
+        worker.executed.fetch_add(1, std::memory_order_relaxed);
+        worker.busyNanoseconds.fetch_add(busy, std::memory_order_relaxed);
+        if (stolen)
+            worker.stolen.fetch_add(1, std::memory_order_relaxed);
+
+        m_totalLatencyNanoseconds.fetch_add(latency, std::memory_order_relaxed);
+
+        auto maxLatency = m_maxLatencyNanoseconds.load(std::memory_order_relaxed);
+        while (maxLatency < latency && ! m_maxLatencyNanoseconds.compare_exchange_weak(maxLatency, latency, std::memory_order_relaxed))
+        {
+        }
+
+        bool idle = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            idle = --m_unfinished == 0;
+        }
+
+        if (idle)
+            m_idle.notify_all();
+    }
+
+    void reset(Worker& worker)
+    {
+        lua_State* L = worker.L;
+
+        lua_settop(L, 0);
+
+        if (worker.globalsRef != LUA_NOREF)
+            restoreGlobals(L, worker.globalsRef);
+
+        switch (m_options.collect)
+        {
+        case StatePoolCollect::None:
+            break;
+
+        case StatePoolCollect::Step:
+            lua_gc(L, LUA_GCSTEP, 0);
+            break;
+
+        case StatePoolCollect::Full:
+            lua_gc(L, LUA_GCCOLLECT, 0);
+            break;
+        }
+    }
+
+    static void pushGlobals(lua_State* L)
+    {
+#if LUA_VERSION_NUM >= 502
+        lua_pushglobaltable(L);
+#else
+        lua_pushvalue(L, LUA_GLOBALSINDEX);
+#endif
+    }
+
+    /**
+     * @brief Store a shallow copy of the globals table in the registry.
+     */
+    static int snapshotGlobals(lua_State* L)
+    {
+        lua_newtable(L); // Stack: snapshot (st)
+        pushGlobals(L); // Stack: st, globals (gt)
+
+        lua_pushnil(L); // Stack: st, gt, nil
+        while (lua_next(L, -2) != 0) // Stack: st, gt, key, value
+        {
+            lua_pushvalue(L, -2); // Stack: st, gt, key, value, key
+            lua_insert(L, -2); // Stack: st, gt, key, key, value
+            lua_rawset(L, -5); // st [key] = value. Stack: st, gt, key
+        }
+
+        lua_pop(L, 1); // Stack: st
+
+        return luaL_ref(L, LUA_REGISTRYINDEX); // Stack: -
+    }
+
+    /**
+     * @brief Remove the globals added and restore the globals replaced or removed since the snapshot.
+     *
+     * Only the globals table itself is restored: modifications to the content of tables reachable from it are kept.
+     */
+    static void restoreGlobals(lua_State* L, int snapshotRef)
+    {
+        lua_rawgeti(L, LUA_REGISTRYINDEX, snapshotRef); // Stack: snapshot (st)
+        pushGlobals(L); // Stack: st, globals (gt)
+
+        // Assigning existing fields during a traversal is allowed, including clearing them
+        lua_pushnil(L); // Stack: st, gt, nil
+        while (lua_next(L, -2) != 0) // Stack: st, gt, key, value
+        {
+            lua_pushvalue(L, -2); // Stack: st, gt, key, value, key
+            lua_rawget(L, -5); // Stack: st, gt, key, value, original
+
+            if (lua_rawequal(L, -1, -2))
+            {
+                lua_pop(L, 2); // Stack: st, gt, key
+                continue;
+            }
+
+            lua_pushvalue(L, -3); // Stack: st, gt, key, value, original, key
+            lua_insert(L, -2); // Stack: st, gt, key, value, key, original
+            lua_rawset(L, -5); // gt [key] = original. Stack: st, gt, key, value
+            lua_pop(L, 1); // Stack: st, gt, key
+        }
+
+        lua_pushnil(L); // Stack: st, gt, nil
+        while (lua_next(L, -3) != 0) // Stack: st, gt, key, original
+        {
+            lua_pushvalue(L, -2); // Stack: st, gt, key, original, key
+            lua_rawget(L, -4); // Stack: st, gt, key, original, value
+
+            if (lua_isnil(L, -1))
+            {
+                lua_pop(L, 1); // Stack: st, gt, key, original
+                lua_pushvalue(L, -2); // Stack: st, gt, key, original, key
+                lua_insert(L, -2); // Stack: st, gt, key, key, original
+                lua_rawset(L, -4); // gt [key] = original. Stack: st, gt, key
+            }
+            else
+            {
+                lua_pop(L, 2); // Stack: st, gt, key
+            }
+        }
+
+        lua_pop(L, 2); // Stack: -
+    }
+
+    StatePoolOptions m_options;
+    Clock::time_point m_created;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wakeup;
+    std::condition_variable m_idle;
+    bool m_stopping = false;
+    std::atomic<std::size_t> m_queued{ 0 };
+    std::size_t m_unfinished = 0;
+
+    std::atomic<std::size_t> m_nextWorker{ 0 };
+    std::atomic<std::uint64_t> m_submitted{ 0 };
+    std::atomic<std::int64_t> m_totalLatencyNanoseconds{ 0 };
+    std::atomic<std::int64_t> m_maxLatencyNanoseconds{ 0 };
+};
+
+} // namespace luabridge
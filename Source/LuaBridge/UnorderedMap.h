@@ -20,24 +20,33 @@ struct Stack<std::unordered_map<K, V>>
 {
     using Type = std::unordered_map<K, V>;
 
+    static constexpr int stackSlots = detail::stack_slots_v<K> > 0 && detail::stack_slots_v<V> > 0
+        ? 1 + std::max(detail::stack_slots_v<K>, 1 + detail::stack_slots_v<V>)
+        : 0;
+
     [[nodiscard]] static Result push(lua_State* L, const Type& map)
     {
 #if LUABRIDGE_SAFE_STACK_CHECKS
-        if (! lua_checkstack(L, 3))
+        if (! lua_checkstack(L, stackSlots > 0 ? stackSlots : 3))
             return makeErrorCode(ErrorCode::LuaStackOverflow);
 #endif
 
+        return pushUnchecked(L, map);
+    }
+
+    [[nodiscard]] static Result pushUnchecked(lua_State* L, const Type& map)
+    {
         StackRestore stackRestore(L);
 
         lua_createtable(L, 0, static_cast<int>(map.size()));
 
         for (auto it = map.begin(); it != map.end(); ++it)
         {
-            auto result = Stack<K>::push(L, it->first);
+            auto result = detail::push_reserved<K>(L, it->first);
             if (! result)
                 return result;
 
-            result = Stack<V>::push(L, it->second);
+            result = detail::push_reserved<V>(L, it->second);
             if (! result)
                 return result;
 
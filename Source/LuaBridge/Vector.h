@@ -7,6 +7,7 @@
 
 #include "detail/Stack.h"
 
+#include <cstring>
 #include <vector>
 
 namespace luabridge {
@@ -20,13 +21,20 @@ struct Stack<std::vector<T>>
 {
     using Type = std::vector<T>;
 
+    static constexpr int stackSlots = detail::nested_stack_slots_v<2, T>;
+
     [[nodiscard]] static Result push(lua_State* L, const Type& vector)
     {
 #if LUABRIDGE_SAFE_STACK_CHECKS
-        if (! lua_checkstack(L, 3))
+        if (! lua_checkstack(L, stackSlots > 0 ? stackSlots : 3))
             return makeErrorCode(ErrorCode::LuaStackOverflow);
 #endif
 
+        return pushUnchecked(L, vector);
+    }
+
+    [[nodiscard]] static Result pushUnchecked(lua_State* L, const Type& vector)
+    {
         StackRestore stackRestore(L);
 
         lua_createtable(L, static_cast<int>(vector.size()), 0);
@@ -35,7 +43,7 @@ struct Stack<std::vector<T>>
         {
             lua_pushinteger(L, static_cast<lua_Integer>(i + 1));
             
-            auto result = Stack<T>::push(L, vector[i]);
+            auto result = detail::push_reserved<T>(L, vector[i]);
             if (! result)
                 return result;
 
@@ -78,4 +86,175 @@ struct Stack<std::vector<T>>
     }
 };
 
+#if LUABRIDGE_ON_RAVI
+namespace detail {
+
+//=================================================================================================
+/**
+ * @brief Return the storage of the elements of a Ravi typed array, or nullptr if the value is not an array of the requested type.
+ *
+ * Ravi arrays reserve the slot at offset 0 of their storage, the elements visible from lua start at offset 1. The type of the length
+ * is deduced, as it differs between Ravi releases.
+ */
+template <class T, class Length>
+T* ravi_array_elements(T* (*rawdata)(lua_State*, int, Length*), lua_State* L, int index)
+{
+    Length length = 0;
+    T* data = rawdata(L, index, &length);
+    return data != nullptr ? data + 1 : nullptr;
+}
+
+//=================================================================================================
+/**
+ * @brief Access to the Ravi typed arrays storing values of type `T`.
+ */
+template <class T>
+struct RaviTypedArray;
+
+template <>
+struct RaviTypedArray<lua_Number>
+{
+    static void create(lua_State* L, int size)
+    {
+        ravi_create_number_array(L, size, 0.0);
+    }
+
+    static bool isInstance(lua_State* L, int index)
+    {
+        return ravi_is_number_array(L, index) != 0;
+    }
+
+    static lua_Number* data(lua_State* L, int index)
+    {
+        return ravi_array_elements(&ravi_get_number_array_rawdata, L, index);
+    }
+};
+
+template <>
+struct RaviTypedArray<lua_Integer>
+{
+    static void create(lua_State* L, int size)
+    {
+        ravi_create_integer_array(L, size, 0);
+    }
+
+    static bool isInstance(lua_State* L, int index)
+    {
+        return ravi_is_integer_array(L, index) != 0;
+    }
+
+    static lua_Integer* data(lua_State* L, int index)
+    {
+        return ravi_array_elements(&ravi_get_integer_array_rawdata, L, index);
+    }
+};
+
+//=================================================================================================
+/**
+ * @brief Stack implementation converting numeric vectors to and from Ravi typed arrays with bulk copies.
+ *
+ * Plain lua tables are still accepted when reading from the stack.
+ */
+template <class T>
+struct StackRaviTypedArray
+{
+    using Type = std::vector<T>;
+    using Array = RaviTypedArray<T>;
+
+    [[nodiscard]] static Result push(lua_State* L, const Type& vector)
+    {
+#if LUABRIDGE_SAFE_STACK_CHECKS
+        if (! lua_checkstack(L, 1))
+            return makeErrorCode(ErrorCode::LuaStackOverflow);
+#endif
+
+        Array::create(L, static_cast<int>(vector.size()));
+
+        if (! vector.empty())
+        {
+            T* data = Array::data(L, -1);
+            if (data == nullptr)
+            {
+                lua_pop(L, 1);
+                return makeErrorCode(ErrorCode::InvalidTypeCast);
+            }
+
+            std::memcpy(data, vector.data(), vector.size() * sizeof(T));
+        }
+
+        return {};
+    }
+
+    [[nodiscard]] static TypeResult<Type> get(lua_State* L, int index)
+    {
+        if (! lua_istable(L, index))
+            return makeErrorCode(ErrorCode::InvalidTypeCast);
+
+        const auto size = static_cast<std::size_t>(get_length(L, index));
+
+        if (Array::isInstance(L, index))
+        {
+            Type vector(size);
+
+            if (size > 0)
+            {
+                const T* data = Array::data(L, index);
+                if (data == nullptr)
+                    return makeErrorCode(ErrorCode::InvalidTypeCast);
+
+                std::memcpy(vector.data(), data, size * sizeof(T));
+            }
+
+            return vector;
+        }
+
+        const StackRestore stackRestore(L);
+
+        Type vector;
+        vector.reserve(size);
+
+        int absIndex = lua_absindex(L, index);
+        lua_pushnil(L);
+
+        while (lua_next(L, absIndex) != 0)
+        {
+            auto item = Stack<T>::get(L, -1);
+            if (! item)
+                return makeErrorCode(ErrorCode::InvalidTypeCast);
+
+            vector.emplace_back(*item);
+            lua_pop(L, 1);
+        }
+
+        return vector;
+    }
+
+    [[nodiscard]] static bool isInstance(lua_State* L, int index)
+    {
+        return lua_istable(L, index);
+    }
+};
+
+} // namespace detail
+
+//=================================================================================================
+/**
+ * @brief Stack specialization for `std::vector<lua_Number>`, pushed as a Ravi `number[]` array.
+ */
+template <>
+struct Stack<std::vector<lua_Number>> : detail::StackRaviTypedArray<lua_Number>
+{
+};
+
+//=================================================================================================
+/**
+ * @brief Stack specialization for `std::vector<lua_Integer>`, pushed as a Ravi `integer[]` array.
+ */
+template <>
+struct Stack<std::vector<lua_Integer>> : detail::StackRaviTypedArray<lua_Integer>
+{
+};
+
+#endif // LUABRIDGE_ON_RAVI
+
 } // namespace luabridge
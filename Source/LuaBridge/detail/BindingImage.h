@@ -0,0 +1,526 @@
+// https://github.com/kunitoki/LuaBridge3
+// Copyright 2023, Lucio Asnaghi
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "Config.h"
+#include "CFunctions.h"
+#include "LuaHelpers.h"
+#include "LuaRef.h"
+#include "Namespace.h"
+
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace luabridge {
+namespace detail {
+
+//=================================================================================================
+/**
+ * @brief Flattened copy of the tables and closures created by a registration.
+ *
+ * Tables and closures are stored as a list of objects referenced by index, so that shared references and cycles (like the const and
+ * class tables pointing to each other) are preserved when the image is instantiated.
+ */
+class BindingImageData
+{
+public:
+    enum class ValueType : unsigned char
+    {
+        Nil,
+        Boolean,
+        Integer,
+        Number,
+        String,
+        LightUserdata,
+        SharedUserdata,
+        Object
+    };
+
+    struct Value
+    {
+        ValueType type = ValueType::Nil;
+        bool boolean = false;
+        lua_Integer integer = 0;
+        lua_Number number = 0;
+        void* pointer = nullptr;
+        std::string string;
+        int object = -1;
+    };
+
+    struct Object
+    {
+        lua_CFunction function = nullptr; // Set for closures, nullptr for tables
+        std::vector<Value> upvalues;
+        std::vector<std::pair<Value, Value>> entries;
+        int arraySize = 0;
+        int metatable = -1;
+    };
+
+    /**
+     * @brief Construct the image data, adopting the state used for capturing.
+     *
+     * The closure data (userdata upvalues) living in the adopted state is never copied, instantiated closures point to it.
+     */
+    explicit BindingImageData(lua_State* source)
+        : m_source(source)
+    {
+        LUABRIDGE_ASSERT(m_source != nullptr);
+    }
+
+    BindingImageData(const BindingImageData&) = delete;
+    BindingImageData& operator=(const BindingImageData&) = delete;
+
+    ~BindingImageData()
+    {
+        lua_close(m_source);
+    }
+
+    /**
+     * @brief The adopted state.
+     */
+    lua_State* source() const noexcept
+    {
+        return m_source;
+    }
+
+    /**
+     * @brief Capture the globals and the light userdata keyed registry entries of the adopted state.
+     */
+    void capture()
+    {
+        lua_State* L = m_source;
+
+#if LUABRIDGE_SAFE_STACK_CHECKS
+        luaL_checkstack(L, 3, detail::error_lua_stack_overflow);
+#endif
+
+        push_globals(L); // Stack: globals (gt)
+        const int globalsIndex = lua_gettop(L);
+
+        lua_pushnil(L); // Stack: gt, nil
+        while (lua_next(L, globalsIndex) != 0) // Stack: gt, key, value
+        {
+            if (! (lua_type(L, -2) == LUA_TSTRING && std::string_view(lua_tostring(L, -2)) == "_G"))
+                m_globals.emplace_back(captureValue(L, -2, false), captureValue(L, -1, false));
+
+            lua_pop(L, 1); // Stack: gt, key
+        }
+
+        lua_pop(L, 1); // Stack: -
+
+        lua_pushnil(L); // Stack: nil
+        while (lua_next(L, LUA_REGISTRYINDEX) != 0) // Stack: key, value
+        {
+            if (lua_islightuserdata(L, -2))
+                m_registry.emplace_back(captureValue(L, -2, false), captureValue(L, -1, false));
+
+            lua_pop(L, 1); // Stack: key
+        }
+
+        m_visited.clear();
+
+        // Closures referenced by upvalues must be created before the closures using them
+        std::vector<bool> ordered(m_objects.size(), false);
+        for (std::size_t id = 0; id < m_objects.size(); ++id)
+        {
+            if (m_objects[id].function != nullptr)
+                orderClosure(static_cast<int>(id), ordered);
+        }
+    }
+
+    /**
+     * @brief Recreate the captured objects into a state.
+     */
+    void instantiate(lua_State* L) const
+    {
+#if LUABRIDGE_SAFE_STACK_CHECKS
+        luaL_checkstack(L, 4, detail::error_lua_stack_overflow);
+#endif
+
+        const int objectsCount = static_cast<int>(m_objects.size());
+
+        lua_createtable(L, objectsCount, 0); // Stack: objects (ob)
+        const int objectsIndex = lua_gettop(L);
+
+        // Create all the tables first, so closures and entries can reference them regardless of the order
+        for (int id = 0; id < objectsCount; ++id)
+        {
+            const Object& object = m_objects[static_cast<std::size_t>(id)];
+            if (object.function != nullptr)
+                continue;
+
+            const int recordsSize = static_cast<int>(object.entries.size()) - object.arraySize;
+
+            lua_createtable(L, object.arraySize, recordsSize); // Stack: ob, table
+            lua_rawseti(L, objectsIndex, id + 1); // Stack: ob
+        }
+
+        // Metatables are set while they are still empty, like the registration does, so class tables holding a __gc metamethod for
+        // their instances are not marked for finalization themselves
+        for (int id = 0; id < objectsCount; ++id)
+        {
+            const Object& object = m_objects[static_cast<std::size_t>(id)];
+            if (object.function != nullptr || object.metatable < 0)
+                continue;
+
+            lua_rawgeti(L, objectsIndex, id + 1); // Stack: ob, table
+            lua_rawgeti(L, objectsIndex, object.metatable + 1); // Stack: ob, table, metatable
+            lua_setmetatable(L, -2); // Stack: ob, table
+            lua_pop(L, 1); // Stack: ob
+        }
+
+        for (int id : m_closuresOrder)
+        {
+            const Object& object = m_objects[static_cast<std::size_t>(id)];
+            const int upvaluesCount = static_cast<int>(object.upvalues.size());
+
+#if LUABRIDGE_SAFE_STACK_CHECKS
+            luaL_checkstack(L, upvaluesCount + 1, detail::error_lua_stack_overflow);
+#endif
+
+            for (const Value& upvalue : object.upvalues)
+                pushValue(L, upvalue, objectsIndex); // Stack: ob, upvalues...
+
+            lua_pushcclosure_x(L, object.function, upvaluesCount); // Stack: ob, closure
+            lua_rawseti(L, objectsIndex, id + 1); // Stack: ob
+        }
+
+        for (int id = 0; id < objectsCount; ++id)
+        {
+            const Object& object = m_objects[static_cast<std::size_t>(id)];
+            if (object.function != nullptr)
+                continue;
+
+            lua_rawgeti(L, objectsIndex, id + 1); // Stack: ob, table
+
+            for (const auto& [key, value] : object.entries)
+            {
+                pushValue(L, key, objectsIndex); // Stack: ob, table, key
+                pushValue(L, value, objectsIndex); // Stack: ob, table, key, value
+                lua_rawset(L, -3); // Stack: ob, table
+            }
+
+            lua_pop(L, 1); // Stack: ob
+        }
+
+        push_globals(L); // Stack: ob, globals (gt)
+        for (const auto& [key, value] : m_globals)
+        {
+            pushValue(L, key, objectsIndex); // Stack: ob, gt, key
+            pushValue(L, value, objectsIndex); // Stack: ob, gt, key, value
+            lua_rawset(L, -3); // Stack: ob, gt
+        }
+        lua_pop(L, 1); // Stack: ob
+
+        for (const auto& [key, value] : m_registry)
+        {
+            pushValue(L, key, objectsIndex); // Stack: ob, key
+            pushValue(L, value, objectsIndex); // Stack: ob, key, value
+            lua_rawset(L, LUA_REGISTRYINDEX); // Stack: ob
+        }
+
+        lua_pop(L, 1); // Stack: -
+    }
+
+    /**
+     * @brief Push the global table of a state.
+     */
+    static void push_globals(lua_State* L)
+    {
+#if LUA_VERSION_NUM >= 502
+        lua_pushglobaltable(L);
+#else
+        lua_pushvalue(L, LUA_GLOBALSINDEX);
+#endif
+    }
+
+private:
+    Value captureValue(lua_State* L, int index, bool isUpvalue)
+    {
+        index = lua_absindex(L, index);
+
+        Value result;
+
+        switch (lua_type(L, index))
+        {
+        case LUA_TNIL:
+            break;
+
+        case LUA_TBOOLEAN:
+            result.type = ValueType::Boolean;
+            result.boolean = lua_toboolean(L, index) != 0;
+            break;
+
+        case LUA_TNUMBER:
+#if LUA_VERSION_NUM >= 503
+            if (lua_isinteger(L, index))
+            {
+                result.type = ValueType::Integer;
+                result.integer = lua_tointeger(L, index);
+                break;
+            }
+#endif
+            result.type = ValueType::Number;
+            result.number = lua_tonumber(L, index);
+            break;
+
+        case LUA_TSTRING:
+        {
+            std::size_t length = 0;
+            const char* string = lua_tolstring(L, index, &length);
+
+            result.type = ValueType::String;
+            result.string.assign(string, length);
+            break;
+        }
+
+        case LUA_TLIGHTUSERDATA:
+            result.type = ValueType::LightUserdata;
+            result.pointer = lua_touserdata(L, index);
+            break;
+
+        case LUA_TUSERDATA:
+            if (! isUpvalue)
+            {
+                throw_or_assert<std::logic_error>("Binding images can't contain userdata values outside of function upvalues");
+                break;
+            }
+
+            result.type = ValueType::SharedUserdata;
+            result.pointer = lua_touserdata(L, index);
+            break;
+
+        case LUA_TTABLE:
+            result.type = ValueType::Object;
+            result.object = captureTable(L, index);
+            break;
+
+        case LUA_TFUNCTION:
+            if (! lua_iscfunction(L, index))
+            {
+                throw_or_assert<std::logic_error>("Binding images can only contain C functions");
+                break;
+            }
+
+            result.type = ValueType::Object;
+            result.object = captureClosure(L, index);
+            break;
+
+        default:
+            throw_or_assert<std::logic_error>("Unsupported value type in binding image");
+            break;
+        }
+
+        return result;
+    }
+
+    int captureTable(lua_State* L, int index)
+    {
+        index = lua_absindex(L, index);
+
+        if (auto it = m_visited.find(lua_topointer(L, index)); it != m_visited.end())
+            return it->second;
+
+        const int id = static_cast<int>(m_objects.size());
+        m_objects.emplace_back();
+        m_visited.emplace(lua_topointer(L, index), id);
+
+#if LUABRIDGE_SAFE_STACK_CHECKS
+        luaL_checkstack(L, 3, detail::error_lua_stack_overflow);
+#endif
+
+        int arraySize = 0;
+        std::vector<std::pair<Value, Value>> entries;
+
+        lua_pushnil(L); // Stack: nil
+        while (lua_next(L, index) != 0) // Stack: key, value
+        {
+            if (lua_type(L, -2) == LUA_TNUMBER)
+                ++arraySize;
+
+            Value key = captureValue(L, -2, false);
+            entries.emplace_back(std::move(key), captureValue(L, -1, false));
+
+            lua_pop(L, 1); // Stack: key
+        }
+
+        int metatable = -1;
+        if (lua_getmetatable(L, index)) // Stack: metatable
+        {
+            metatable = captureTable(L, -1);
+            lua_pop(L, 1); // Stack: -
+        }
+
+        Object& object = m_objects[static_cast<std::size_t>(id)];
+        object.entries = std::move(entries);
+        object.arraySize = arraySize;
+        object.metatable = metatable;
+
+        return id;
+    }
+
+    int captureClosure(lua_State* L, int index)
+    {
+        if (auto it = m_visited.find(lua_topointer(L, index)); it != m_visited.end())
+            return it->second;
+
+        const int id = static_cast<int>(m_objects.size());
+        m_objects.emplace_back();
+        m_visited.emplace(lua_topointer(L, index), id);
+
+        std::vector<Value> upvalues;
+        for (int n = 1; lua_getupvalue(L, index, n) != nullptr; ++n) // Stack: upvalue
+        {
+            upvalues.emplace_back(captureValue(L, -1, true));
+            lua_pop(L, 1); // Stack: -
+        }
+
+        Object& object = m_objects[static_cast<std::size_t>(id)];
+        object.function = lua_tocfunction(L, index);
+        object.upvalues = std::move(upvalues);
+
+        return id;
+    }
+
+    void orderClosure(int id, std::vector<bool>& ordered)
+    {
+        if (ordered[static_cast<std::size_t>(id)])
+            return;
+
+        ordered[static_cast<std::size_t>(id)] = true;
+
+        for (const Value& upvalue : m_objects[static_cast<std::size_t>(id)].upvalues)
+        {
+            if (upvalue.type == ValueType::Object && m_objects[static_cast<std::size_t>(upvalue.object)].function != nullptr)
+                orderClosure(upvalue.object, ordered);
+        }
+
+        m_closuresOrder.push_back(id);
+    }
+
+    static void pushValue(lua_State* L, const Value& value, int objectsIndex)
+    {
+        switch (value.type)
+        {
+        case ValueType::Nil:
+            lua_pushnil(L);
+            break;
+
+        case ValueType::Boolean:
+            lua_pushboolean(L, value.boolean ? 1 : 0);
+            break;
+
+        case ValueType::Integer:
+            lua_pushinteger(L, value.integer);
+            break;
+
+        case ValueType::Number:
+            lua_pushnumber(L, value.number);
+            break;
+
+        case ValueType::String:
+            lua_pushlstring(L, value.string.data(), value.string.size());
+            break;
+
+        case ValueType::LightUserdata:
+        case ValueType::SharedUserdata:
+            lua_pushlightuserdata(L, value.pointer);
+            break;
+
+        case ValueType::Object:
+            lua_rawgeti(L, objectsIndex, value.object + 1);
+            break;
+        }
+    }
+
+    lua_State* m_source;
+    std::vector<Object> m_objects;
+    std::vector<int> m_closuresOrder;
+    std::vector<std::pair<Value, Value>> m_globals;
+    std::vector<std::pair<Value, Value>> m_registry;
+    std::unordered_map<const void*, int> m_visited;
+};
+
+} // namespace detail
+
+//=================================================================================================
+/**
+ * @brief Snapshot of a set of registrations that can be instantiated into many lua_State.
+ *
+ * The registration is run once in a private state and the resulting namespaces, classes, functions and properties are captured. Each
+ * call to `instantiate` then recreates the tables with their final size and the closures directly, without running the registration
+ * templates again. Data bound to closures (member pointers, lambdas and other callables) is not copied: every instantiated state shares
+ * the same copy owned by the image, which is kept alive as long as any state instantiated from it is alive. Instantiated closures
+ * reference it through a light userdata in place of the callable userdata, so calling them costs the same as calling registered ones.
+ *
+ * Only the values created by the registration classes can be captured: userdata values (for example objects added by copy with
+ * `Namespace::addVariable`) and Lua functions are not supported.
+ */
+class BindingImage
+{
+public:
+    /**
+     * @brief Run a registration and capture its result.
+     *
+     * @param registration A callable receiving the global `Namespace` of the capturing state.
+     *
+     * @returns The binding image.
+     */
+    template <class F>
+    static BindingImage capture(F&& registration)
+    {
+        auto data = std::make_shared<detail::BindingImageData>(luaL_newstate());
+
+        lua_State* L = data->source();
+
+        detail::BindingImageData::push_globals(L);
+        lua_pushvalue(L, -1);
+        rawsetfield(L, -2, "_G");
+        lua_pop(L, 1);
+
+        std::forward<F>(registration)(getGlobalNamespace(L));
+
+        lua_settop(L, 0);
+        data->capture();
+
+        return BindingImage(std::move(data));
+    }
+
+    /**
+     * @brief Instantiate the captured registrations into a state.
+     *
+     * Globals and registry entries with the same keys are replaced. The image itself is only read, but the callables bound by the
+     * registration are shared by every state instantiated from it: a stateful callable (a `mutable` lambda, a functor with data members
+     * or a `std::function` holding them) called from states running on different threads must synchronize its own state.
+     *
+     * @param L A Lua state.
+     */
+    void instantiate(lua_State* L) const
+    {
+        LUABRIDGE_ASSERT(m_data != nullptr);
+
+        m_data->instantiate(L);
+
+        // Keep the shared closure data alive for as long as the state
+        lua_newuserdata_aligned<std::shared_ptr<const detail::BindingImageData>>(L, m_data);
+        lua_rawsetp(L, LUA_REGISTRYINDEX, m_data.get());
+    }
+
+private:
+    explicit BindingImage(std::shared_ptr<const detail::BindingImageData> data)
+        : m_data(std::move(data))
+    {
+    }
+
+    std::shared_ptr<const detail::BindingImageData> m_data;
+};
+
+} // namespace luabridge
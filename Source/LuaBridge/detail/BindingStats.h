@@ -0,0 +1,456 @@
+// https://github.com/kunitoki/LuaBridge3
+// Copyright 2023, Lucio Asnaghi
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "Config.h"
+#include "ClassInfo.h"
+#include "Errors.h"
+#include "LuaHelpers.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace luabridge {
+
+//=================================================================================================
+/**
+ * @brief Counters of a registered binding, collected when `LUABRIDGE_ENABLE_PROFILING` is enabled.
+ */
+struct BindingStats
+{
+    static constexpr std::size_t histogramBuckets = 48;
+
+    std::string name;                                        ///< Registered name, prefixed by the class name for class members.
+    std::uint64_t calls = 0;                                 ///< Number of calls, including the failed ones.
+    std::uint64_t decodeFailures = 0;                        ///< Number of calls rejected because an argument could not be decoded.
+    std::chrono::nanoseconds totalTime{};                    ///< Time spent in the calls returning normally.
+    std::array<std::uint64_t, histogramBuckets> histogram{}; ///< Latencies of the calls returning normally, bucket b counts [2^(b-1), 2^b) ns.
+
+    /**
+     * @brief Upper bound of the latency of the given fraction of calls, between 0 and 1, as resolved by the histogram.
+     */
+    [[nodiscard]] std::chrono::nanoseconds percentile(double fraction) const noexcept
+    {
+        std::uint64_t samples = 0;
+        for (const auto count : histogram)
+            samples += count;
+
+        if (samples == 0)
+            return std::chrono::nanoseconds{};
+
+        const auto target = static_cast<std::uint64_t>(std::clamp(fraction, 0.0, 1.0) * static_cast<double>(samples));
+
+        std::uint64_t seen = 0;
+        for (std::size_t bucket = 0; bucket < histogramBuckets; ++bucket)
+        {
+            seen += histogram[bucket];
+            if (seen > 0 && seen >= target)
+                return std::chrono::nanoseconds(std::int64_t(1) << bucket);
+        }
+
+        return std::chrono::nanoseconds(std::int64_t(1) << (histogramBuckets - 1));
+    }
+
+    /**
+     * @brief Average time spent in a call returning normally.
+     */
+    [[nodiscard]] std::chrono::nanoseconds averageTime() const noexcept
+    {
+        std::uint64_t samples = 0;
+        for (const auto count : histogram)
+            samples += count;
+
+        return samples > 0 ? totalTime / static_cast<std::chrono::nanoseconds::rep>(samples) : std::chrono::nanoseconds{};
+    }
+};
+
+namespace detail {
+
+//=================================================================================================
+/**
+ * @brief Counters of a named binding, split in cache line sized shards written by different threads with relaxed atomics.
+ */
+class BindingRecord
+{
+public:
+    explicit BindingRecord(std::string name)
+        : m_name(std::move(name))
+    {
+    }
+
+    void addCall() noexcept
+    {
+        shard().calls.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void addDecodeFailure() noexcept
+    {
+        shard().decodeFailures.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void addLatency(std::uint64_t nanoseconds) noexcept
+    {
+        auto& current = shard();
+        current.totalNanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+        current.histogram[bucketOf(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    BindingStats snapshot() const
+    {
+        BindingStats stats;
+        stats.name = m_name;
+
+        std::uint64_t totalNanoseconds = 0;
+        for (const auto& current : m_shards)
+        {
+            stats.calls += current.calls.load(std::memory_order_relaxed);
+            stats.decodeFailures += current.decodeFailures.load(std::memory_order_relaxed);
+            totalNanoseconds += current.totalNanoseconds.load(std::memory_order_relaxed);
+
+            for (std::size_t bucket = 0; bucket < BindingStats::histogramBuckets; ++bucket)
+                stats.histogram[bucket] += current.histogram[bucket].load(std::memory_order_relaxed);
+        }
+
+        stats.totalTime = std::chrono::nanoseconds(static_cast<std::chrono::nanoseconds::rep>(totalNanoseconds));
+        return stats;
+    }
+
+    void reset() noexcept
+    {
+        for (auto& current : m_shards)
+        {
+            current.calls.store(0, std::memory_order_relaxed);
+            current.decodeFailures.store(0, std::memory_order_relaxed);
+            current.totalNanoseconds.store(0, std::memory_order_relaxed);
+
+            for (auto& count : current.histogram)
+                count.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    const std::string& name() const noexcept
+    {
+        return m_name;
+    }
+
+private:
+    static constexpr std::size_t shardsCount = 16;
+
+    struct alignas(64) Shard
+    {
+        std::atomic<std::uint64_t> calls{ 0 };
+        std::atomic<std::uint64_t> decodeFailures{ 0 };
+        std::atomic<std::uint64_t> totalNanoseconds{ 0 };
+        std::array<std::atomic<std::uint64_t>, BindingStats::histogramBuckets> histogram{};
+    };
+
+    static std::size_t bucketOf(std::uint64_t nanoseconds) noexcept
+    {
+        std::size_t bucket = 0;
+        while (nanoseconds != 0 && bucket < BindingStats::histogramBuckets - 1)
+        {
+            nanoseconds >>= 1;
+            ++bucket;
+        }
+
+        return bucket;
+    }
+
+    Shard& shard() noexcept
+    {
+        static std::atomic<std::size_t> nextShard{ 0 };
+        thread_local const std::size_t index = nextShard.fetch_add(1, std::memory_order_relaxed) % shardsCount;
+
+        return m_shards[index];
+    }
+
+    std::string m_name;
+    std::array<Shard, shardsCount> m_shards;
+};
+
+//=================================================================================================
+/**
+ * @brief Process wide records of the named bindings, shared by all the states.
+ *
+ * Records are never destroyed, so the closures of any state can keep a plain pointer to them.
+ */
+class BindingRegistry
+{
+public:
+    static BindingRegistry& instance()
+    {
+        static auto* registry = new BindingRegistry;
+        return *registry;
+    }
+
+    BindingRecord* record(const std::string& name)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto& record = m_records[name];
+        if (! record)
+        {
+            record = std::make_unique<BindingRecord>(name);
+            m_pointers.insert(record.get());
+        }
+
+        return record.get();
+    }
+
+    /**
+     * @brief Get the record at an address taken from a closure upvalue, or null if the address is not a record.
+     */
+    const BindingRecord* find(const void* pointer) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        const auto it = m_pointers.find(pointer);
+        return it != m_pointers.end() ? static_cast<const BindingRecord*>(*it) : nullptr;
+    }
+
+    std::vector<BindingStats> snapshot() const
+    {
+        std::vector<BindingStats> stats;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            stats.reserve(m_records.size());
+            for (const auto& [name, record] : m_records)
+                stats.push_back(record->snapshot());
+        }
+
+        std::sort(stats.begin(), stats.end(), [](const auto& lhs, const auto& rhs) { return lhs.name < rhs.name; });
+        return stats;
+    }
+
+    void reset()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        for (auto& [name, record] : m_records)
+            record->reset();
+    }
+
+private:
+    BindingRegistry() = default;
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::string, std::unique_ptr<BindingRecord>> m_records;
+    std::unordered_set<const void*> m_pointers;
+};
+
+//=================================================================================================
+/**
+ * @brief The record of the binding being called on this thread, null when it is not named.
+ */
+inline BindingRecord*& current_binding() noexcept
+{
+    thread_local BindingRecord* record = nullptr;
+    return record;
+}
+
+//=================================================================================================
+/**
+ * @brief Scope of a call of a binding thunk, counting the call and its latency on the record in the given upvalue.
+ *
+ * Named closures carry their record as the last upvalue, past the ones used by the thunk. When the call raises a lua error the
+ * latency is not recorded and the current binding is left to the next thunk called on the thread.
+ */
+class BindingCallScope
+{
+public:
+    BindingCallScope(lua_State* L, int upvalue) noexcept
+    {
+#if LUABRIDGE_ENABLE_PROFILING
+        m_record = static_cast<BindingRecord*>(lua_touserdata(L, lua_upvalueindex(upvalue)));
+        m_previous = std::exchange(current_binding(), m_record);
+
+        if (m_record != nullptr)
+        {
+            m_record->addCall();
+            m_start = std::chrono::steady_clock::now();
+        }
+#else
+        unused(L, upvalue);
+#endif
+    }
+
+    ~BindingCallScope()
+    {
+#if LUABRIDGE_ENABLE_PROFILING
+        if (m_record != nullptr)
+        {
+            const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start);
+            m_record->addLatency(static_cast<std::uint64_t>(std::max(elapsed.count(), std::chrono::nanoseconds::rep(0))));
+        }
+
+        current_binding() = m_previous;
+#endif
+    }
+
+    void addDecodeFailure() noexcept
+    {
+#if LUABRIDGE_ENABLE_PROFILING
+        if (m_record != nullptr)
+            m_record->addDecodeFailure();
+#endif
+    }
+
+    BindingCallScope(const BindingCallScope&) = delete;
+    BindingCallScope& operator=(const BindingCallScope&) = delete;
+
+private:
+#if LUABRIDGE_ENABLE_PROFILING
+    BindingRecord* m_record = nullptr;
+    BindingRecord* m_previous = nullptr;
+    std::chrono::steady_clock::time_point m_start;
+#endif
+};
+
+//=================================================================================================
+/**
+ * @brief Count an argument that could not be decoded on the binding being called.
+ */
+inline void count_argument_decode_failure() noexcept
+{
+#if LUABRIDGE_ENABLE_PROFILING
+    if (auto* record = current_binding())
+        record->addDecodeFailure();
+#endif
+}
+
+//=================================================================================================
+/**
+ * @brief Name the binding closure on top of the stack, appending the record of its name to its upvalues.
+ *
+ * The name is prefixed by the type name of the class table at the given index, when not zero, and followed by the suffix. It does
+ * nothing unless `LUABRIDGE_ENABLE_PROFILING` is enabled.
+ */
+inline void name_binding(lua_State* L, int classIndex, const char* name, const char* suffix = nullptr)
+{
+#if LUABRIDGE_ENABLE_PROFILING
+    LUABRIDGE_ASSERT(name != nullptr);
+
+    const lua_CFunction function = lua_tocfunction(L, -1);
+    if (function == nullptr)
+        return;
+
+    classIndex = classIndex != 0 ? lua_absindex(L, classIndex) : 0;
+    const int closureIndex = lua_gettop(L);
+
+    int upvalues = 0;
+    while (lua_getupvalue(L, closureIndex, upvalues + 1) != nullptr) // Stack: closure, upvalues...
+        ++upvalues;
+
+    std::string fullName;
+
+    if (classIndex != 0)
+    {
+        lua_rawgetp(L, classIndex, getTypeKey()); // Stack: closure, upvalues..., type name | nil
+        if (const char* className = lua_tostring(L, -1))
+            fullName.append(className).append(".");
+
+        lua_pop(L, 1); // Stack: closure, upvalues...
+    }
+
+    fullName.append(name);
+
+    if (suffix != nullptr)
+        fullName.append(" [").append(suffix).append("]");
+
+    lua_pushlightuserdata(L, BindingRegistry::instance().record(fullName)); // Stack: closure, upvalues..., record
+    lua_pushcclosure_x(L, function, upvalues + 1); // Stack: closure, named closure
+    lua_replace(L, closureIndex); // Stack: named closure
+#else
+    unused(L, classIndex, name, suffix);
+#endif
+}
+
+} // namespace detail
+
+//=================================================================================================
+/**
+ * @brief Get the counters of all the named bindings, sorted by name.
+ *
+ * Bindings are named when registered with `LUABRIDGE_ENABLE_PROFILING` enabled, otherwise the list is empty. Counters are shared by
+ * all the states registering a binding with the same name.
+ */
+[[nodiscard]] inline std::vector<BindingStats> getBindingStats()
+{
+#if LUABRIDGE_ENABLE_PROFILING
+    return detail::BindingRegistry::instance().snapshot();
+#else
+    return {};
+#endif
+}
+
+/**
+ * @brief Reset the counters of all the named bindings.
+ */
+inline void resetBindingStats()
+{
+#if LUABRIDGE_ENABLE_PROFILING
+    detail::BindingRegistry::instance().reset();
+#endif
+}
+
+/**
+ * @brief lua_CFunction pushing a table of the counters of all the named bindings, keyed by name.
+ *
+ * Each entry holds `calls`, `decodeFailures`, `totalTime`, `p50`, `p90` and `p99`, with times in seconds. Register it with
+ * `addFunction` to make the stats visible to scripts.
+ */
+inline int pushBindingStats(lua_State* L)
+{
+    const auto stats = getBindingStats();
+
+    lua_createtable(L, 0, static_cast<int>(stats.size())); // Stack: stats table (sb)
+
+    for (const auto& binding : stats)
+    {
+        const auto seconds = [](std::chrono::nanoseconds time)
+        {
+            return static_cast<lua_Number>(std::chrono::duration<double>(time).count());
+        };
+
+        lua_createtable(L, 0, 6); // Stack: sb, entry (en)
+
+        lua_pushnumber(L, static_cast<lua_Number>(binding.calls));
+        rawsetfield(L, -2, "calls");
+
+        lua_pushnumber(L, static_cast<lua_Number>(binding.decodeFailures));
+        rawsetfield(L, -2, "decodeFailures");
+
+        lua_pushnumber(L, seconds(binding.totalTime));
+        rawsetfield(L, -2, "totalTime");
+
+        lua_pushnumber(L, seconds(binding.percentile(0.5)));
+        rawsetfield(L, -2, "p50");
+
+        lua_pushnumber(L, seconds(binding.percentile(0.9)));
+        rawsetfield(L, -2, "p90");
+
+        lua_pushnumber(L, seconds(binding.percentile(0.99)));
+        rawsetfield(L, -2, "p99");
+
+        rawsetfield(L, -2, binding.name.c_str()); // sb [name] = en. Stack: sb
+    }
+
+    return 1;
+}
+
+} // namespace luabridge
@@ -7,7 +7,9 @@
 #pragma once
 
 #include "Config.h"
+#include "BindingStats.h"
 #include "Errors.h"
+#include "Ffi.h"
 #include "FuncTraits.h"
 #include "LuaHelpers.h"
 #include "Options.h"
@@ -18,8 +20,11 @@
 #include <algorithm>
 #include <array>
 #include <cstdint>
+#include <functional>
+#include <new>
 #include <optional>
 #include <string>
+#include <string_view>
 
 namespace luabridge {
 namespace detail {
@@ -36,7 +41,10 @@ auto unwrap_argument_or_error(lua_State* L, std::size_t index, std::size_t start
 {
     auto result = Stack<T>::get(L, static_cast<int>(index + start));
     if (! result)
+    {
+        count_argument_decode_failure();
         raise_lua_error(L, "Error decoding argument #%d: %s", static_cast<int>(index + 1), result.message().c_str());
+    }
 
     return std::move(*result);
 }
@@ -53,9 +61,18 @@ auto make_arguments_list(lua_State* L)
     return make_arguments_list_impl<ArgsPack, Start>(L, std::make_index_sequence<std::tuple_size_v<ArgsPack>>());
 }
 
+//=================================================================================================
+/**
+ * @brief Stack slots needed to push all the arguments, zero if any of the argument types doesn't declare it.
+ */
+template <class... Types>
+inline static constexpr int arguments_stack_slots_v = ((stack_slots_v<Types> > 0) && ...) ? (0 + ... + stack_slots_v<Types>) : 0;
+
 //=================================================================================================
 /**
  * @brief Helpers for iterating through tuple arguments, pushing each argument to the lua stack.
+ *
+ * When the stack slots of all the arguments are known, they are reserved once before the first push.
  */
 template <std::size_t Index = 0, class... Types>
 auto push_arguments(lua_State*, std::tuple<Types...>)
@@ -70,7 +87,24 @@ auto push_arguments(lua_State* L, std::tuple<Types...> t)
 {
     using T = std::tuple_element_t<Index, std::tuple<Types...>>;
 
-    auto result = Stack<T>::push(L, std::get<Index>(t));
+    constexpr int slots = arguments_stack_slots_v<Types...>;
+
+    Result result;
+
+    if constexpr (slots > 0)
+    {
+#if LUABRIDGE_SAFE_STACK_CHECKS
+        if (Index == 0 && ! lua_checkstack(L, slots))
+            return std::make_tuple(Result(makeErrorCode(ErrorCode::LuaStackOverflow)), Index + 1);
+#endif
+
+        result = push_reserved<T>(L, std::get<Index>(t));
+    }
+    else
+    {
+        result = Stack<T>::push(L, std::get<Index>(t));
+    }
+
     if (! result)
         return std::make_tuple(result, Index + 1);
 
@@ -137,6 +171,7 @@ inline bool is_metamethod(std::string_view method_name)
         "__mode",
         "__mul",
         "__name",
+        "__namecall",
         "__newindex",
         "__pairs",
         "__pow",
@@ -185,6 +220,297 @@ inline Options get_class_options(lua_State* L, int index)
     return options;
 }
 
+//=================================================================================================
+/**
+ * @brief Push the table of the fields assigned from lua to an object of an extensible class.
+ *
+ * The table is the user value of the userdata. On Lua 5.1 and LuaJIT it is the environment of the userdata, told apart from the default
+ * environment by a marker key. Luau userdata don't have user values, so there the tables are kept in a weak keyed table in the registry.
+ *
+ * @returns True if the object has a fields table, which is pushed. Nothing is pushed otherwise.
+ */
+inline bool push_instance_fields(lua_State* L, int index)
+{
+    LUABRIDGE_ASSERT(lua_type(L, index) == LUA_TUSERDATA);
+
+#if LUABRIDGE_ON_LUAU
+    index = lua_absindex(L, index);
+
+    lua_rawgetp(L, LUA_REGISTRYINDEX, getInstanceFieldsKey()); // Stack: instance fields (if) | nil
+    if (! lua_istable(L, -1))
+    {
+        lua_pop(L, 1);
+        return false;
+    }
+
+    lua_pushvalue(L, index); // Stack: if, object
+    lua_rawget(L, -2); // Stack: if, fields | nil
+    lua_remove(L, -2); // Stack: fields | nil
+#elif LUA_VERSION_NUM >= 504
+    lua_getiuservalue(L, index, 1); // Stack: fields | nil
+#elif LUA_VERSION_NUM >= 502
+    lua_getuservalue(L, index); // Stack: fields | nil
+#else
+    lua_getfenv(L, index); // Stack: fields | environment
+    lua_rawgetp(L, -1, getInstanceFieldsKey()); // Stack: fields | environment, marker | nil
+    const bool isFields = lua_toboolean(L, -1) != 0;
+    lua_pop(L, 1); // Stack: fields | environment
+
+    if (! isFields)
+    {
+        lua_pop(L, 1);
+        return false;
+    }
+#endif
+
+    if (lua_istable(L, -1))
+        return true;
+
+    lua_pop(L, 1);
+    return false;
+}
+
+//=================================================================================================
+/**
+ * @brief Push the table of the fields assigned from lua to an object of an extensible class, creating it if missing.
+ */
+inline void push_or_create_instance_fields(lua_State* L, int index)
+{
+#if LUABRIDGE_SAFE_STACK_CHECKS
+    luaL_checkstack(L, 4, detail::error_lua_stack_overflow);
+#endif
+
+    index = lua_absindex(L, index);
+
+    if (push_instance_fields(L, index))
+        return;
+
+    lua_newtable(L); // Stack: fields
+
+#if LUABRIDGE_ON_LUAU
+    lua_rawgetp(L, LUA_REGISTRYINDEX, getInstanceFieldsKey()); // Stack: fields, instance fields (if) | nil
+    if (! lua_istable(L, -1))
+    {
+        lua_pop(L, 1); // Stack: fields
+        lua_newtable(L); // Stack: fields, if
+        lua_newtable(L); // Stack: fields, if, metatable (mt)
+        lua_pushstring(L, "k");
+        rawsetfield(L, -2, "__mode"); // mt ["__mode"] = "k". Stack: fields, if, mt
+        lua_setmetatable(L, -2); // Stack: fields, if
+        lua_pushvalue(L, -1); // Stack: fields, if, if
+        lua_rawsetp(L, LUA_REGISTRYINDEX, getInstanceFieldsKey()); // Stack: fields, if
+    }
+
+    lua_pushvalue(L, index); // Stack: fields, if, object
+    lua_pushvalue(L, -3); // Stack: fields, if, object, fields
+    lua_rawset(L, -3); // if [object] = fields. Stack: fields, if
+    lua_pop(L, 1); // Stack: fields
+#elif LUA_VERSION_NUM >= 504
+    lua_pushvalue(L, -1); // Stack: fields, fields
+    lua_setiuservalue(L, index, 1); // Stack: fields
+#elif LUA_VERSION_NUM >= 502
+    lua_pushvalue(L, -1); // Stack: fields, fields
+    lua_setuservalue(L, index); // Stack: fields
+#else
+    lua_pushboolean(L, 1); // Stack: fields, true
+    lua_rawsetp(L, -2, getInstanceFieldsKey()); // fields [instanceFieldsKey] = true. Stack: fields
+    lua_pushvalue(L, -1); // Stack: fields, fields
+    lua_setfenv(L, index); // Stack: fields
+#endif
+}
+
+//=================================================================================================
+/**
+ * @brief Store a field assigned from lua to an object of an extensible class, the new value is at index 3.
+ *
+ * Names of registered methods can only be shadowed when the class allows overriding methods. Const objects, metamethod names and objects
+ * of classes that aren't extensible are left to the caller.
+ *
+ * @returns True if the field has been stored.
+ */
+inline bool try_set_instance_field(lua_State* L, const char* key)
+{
+    if (key == nullptr || lua_type(L, 1) != LUA_TUSERDATA || is_metamethod(key))
+        return false;
+
+    lua_getmetatable(L, 1); // Stack: class table (cl)
+
+    const Options options = get_class_options(L, -1);
+    lua_rawgetp(L, -1, getClassKey()); // Stack: cl, class table | nil
+    const bool isConst = lua_istable(L, -1);
+    lua_pop(L, 1); // Stack: cl
+
+    if (isConst || ! options.test(extensibleClass))
+    {
+        lua_pop(L, 1); // Stack: -
+        return false;
+    }
+
+    if (! options.test(allowOverridingMethods))
+    {
+        for (;;)
+        {
+            lua_pushvalue(L, 2); // Stack: cl, field name
+            lua_rawget(L, -2); // Stack: cl, member | nil
+            if (! lua_isnil(L, -1))
+                luaL_error(L, "immutable member '%s'", key);
+
+            lua_pop(L, 1); // Stack: cl
+            lua_rawgetp(L, -1, getParentKey()); // Stack: cl, parent cl | nil
+            lua_remove(L, -2); // Stack: parent cl | nil
+
+            if (lua_isnil(L, -1))
+                break;
+        }
+    }
+
+    lua_pop(L, 1); // Stack: -
+
+    push_or_create_instance_fields(L, 1); // Stack: fields
+    lua_pushvalue(L, 2); // Stack: fields, field name
+    lua_pushvalue(L, 3); // Stack: fields, field name, new value
+    lua_rawset(L, -3); // fields [field name] = new value. Stack: fields
+    lua_pop(L, 1); // Stack: -
+
+    return true;
+}
+
+//=================================================================================================
+/**
+ * @brief Check if a callable is a typed index or new index fallback, receiving the key as `std::string_view`.
+ */
+template <class F, class = void>
+struct is_typed_fallback : std::false_type
+{
+};
+
+template <class F>
+struct is_typed_fallback<F, std::enable_if_t<is_callable_v<F>>>
+    : std::bool_constant<std::is_same_v<function_argument_or_void_t<1, F>, std::string_view>>
+{
+};
+
+template <class F>
+inline static constexpr bool is_typed_fallback_v = is_typed_fallback<F>::value;
+
+/**
+ * @brief Invoker of a typed fallback, stored at the start of its userdata.
+ *
+ * Typed fallbacks are stored as the upvalue of a `typed_fallback_thunk` closure, and called directly by the __index and __newindex
+ * metamethods with the object at index 1 and the key at index 2, instead of through a lua_call to the closure.
+ */
+using typed_fallback_invoker = int (*)(lua_State* L, void* storage);
+
+/**
+ * @brief Get the callable of a typed fallback, stored after its invoker.
+ */
+template <class F>
+F* get_typed_fallback_function(void* storage) noexcept
+{
+    return align<F>(static_cast<char*>(storage) + sizeof(typed_fallback_invoker));
+}
+
+template <class F>
+int typed_fallback_gc_metamethod(lua_State* L)
+{
+    get_typed_fallback_function<F>(lua_touserdata(L, 1))->~F();
+    return 0;
+}
+
+/**
+ * @brief Call a typed fallback from its userdata.
+ */
+inline int call_typed_fallback(lua_State* L, void* storage)
+{
+    return (*static_cast<typed_fallback_invoker*>(storage))(L, storage);
+}
+
+/**
+ * @brief Closure of a typed fallback, holding its userdata as upvalue.
+ *
+ * The metamethods recognize typed fallbacks by this function, and call them without going through it.
+ */
+inline int typed_fallback_thunk(lua_State* L)
+{
+    return call_typed_fallback(L, get_closure_storage(L, lua_upvalueindex(1)));
+}
+
+/**
+ * @brief Get the storage of a typed fallback from its closure at the given index, or nullptr if it's not a typed fallback.
+ */
+[[nodiscard]] inline void* get_typed_fallback_storage(lua_State* L, int index)
+{
+    if (lua_tocfunction(L, index) != &typed_fallback_thunk)
+        return nullptr;
+
+    lua_getupvalue(L, index, 1); // Stack: typed fallback (tfb)
+    void* storage = get_closure_storage(L, -1);
+    lua_pop(L, 1); // Stack: -
+
+    return storage;
+}
+
+/**
+ * @brief Push the closure of a typed fallback, with the userdata holding its invoker and callable as upvalue.
+ */
+template <class F>
+void push_typed_fallback(lua_State* L, F function, typed_fallback_invoker invoker)
+{
+    const std::size_t size = sizeof(typed_fallback_invoker) + maximum_space_needed_to_align<F>();
+
+#if LUABRIDGE_ON_LUAU
+    void* storage = lua_newuserdatadtor(L, size, [](void* x)
+    {
+        get_typed_fallback_function<F>(x)->~F();
+    }); // Stack: typed fallback (tfb)
+#else
+    void* storage = lua_newuserdata_x<F>(L, size); // Stack: tfb
+
+    lua_newtable(L); // Stack: tfb, mt
+    lua_pushcfunction_x(L, &typed_fallback_gc_metamethod<F>);
+    rawsetfield(L, -2, "__gc");
+    lua_setmetatable(L, -2); // Stack: tfb
+#endif
+
+    new (storage) typed_fallback_invoker(invoker);
+    new (get_typed_fallback_function<F>(storage)) F(std::move(function));
+
+    lua_pushcclosure_x(L, &typed_fallback_thunk, 1); // Stack: typed fallback closure
+}
+
+/**
+ * @brief Invoke a typed index fallback, which pushes its results and returns their number.
+ */
+template <class T, class F>
+int invoke_typed_index_fallback(lua_State* L, void* storage)
+{
+    T* object = Userdata::get<T>(L, 1, is_const_member_function_pointer_v<F>);
+    if (object == nullptr)
+        return 0;
+
+    std::size_t length = 0;
+    const char* key = lua_tolstring(L, 2, &length);
+
+    return std::invoke(*get_typed_fallback_function<F>(storage), *object, std::string_view(key, length), L);
+}
+
+/**
+ * @brief Invoke a typed new index fallback, with the new value on top of the stack.
+ */
+template <class T, class F>
+int invoke_typed_newindex_fallback(lua_State* L, void* storage)
+{
+    T* object = Userdata::get<T>(L, 1, false);
+    if (object == nullptr)
+        return 0;
+
+    std::size_t length = 0;
+    const char* key = lua_tolstring(L, 2, &length);
+
+    std::invoke(*get_typed_fallback_function<F>(storage), *object, std::string_view(key, length), L);
+    return 0;
+}
+
 //=================================================================================================
 /**
  * @brief __index metamethod for a namespace or class static and non-static members.
@@ -197,6 +523,27 @@ inline std::optional<int> try_call_index_fallback(lua_State* L)
     LUABRIDGE_ASSERT(lua_istable(L, -1)); // Stack: mt
 
     lua_rawgetp(L, -1, getIndexFallbackKey()); // Stack: mt, ifb (may be nil)
+    if (void* storage = get_typed_fallback_storage(L, -1)) // Stack: mt, typed fallback (tfb)
+    {
+        lua_pop(L, 1); // Stack: mt
+
+        if (lua_type(L, 2) != LUA_TSTRING)
+            return std::nullopt;
+
+        const int stackTop = lua_gettop(L);
+        const int results = call_typed_fallback(L, storage); // Stack: mt, results...
+
+        if (results > 0 && ! lua_isnoneornil(L, stackTop + 1))
+        {
+            lua_settop(L, stackTop + 1); // Stack: mt, result
+            lua_remove(L, -2); // Stack: result
+            return 1;
+        }
+
+        lua_settop(L, stackTop); // Stack: mt
+        return std::nullopt;
+    }
+
     if (! lua_iscfunction(L, -1))
     {
         lua_pop(L, 1); // Stack: mt
@@ -228,6 +575,20 @@ inline int index_metamethod(lua_State* L)
     lua_getmetatable(L, 1); // Stack: class/const table (mt)
     LUABRIDGE_ASSERT(lua_istable(L, -1));
 
+    Options options = get_class_options(L, -1);
+
+    // Fields assigned from lua to objects of extensible classes come first
+    if (options.test(extensibleClass) && lua_type(L, 1) == LUA_TUSERDATA && push_instance_fields(L, 1)) // Stack: mt, fields
+    {
+        lua_pushvalue(L, 2); // Stack: mt, fields, field name
+        lua_rawget(L, -2); // Stack: mt, fields, field | nil
+
+        if (! lua_isnil(L, -1))
+            return 1;
+
+        lua_pop(L, 2); // Stack: mt
+    }
+
     // Protect internal meta methods
     const char* key = lua_tostring(L, 2);
     if (key != nullptr && is_metamethod(key))
@@ -239,8 +600,7 @@ inline int index_metamethod(lua_State* L)
     for (;;)
     {
         // If we allow method overriding, we need to prioritise it
-        const Options options = get_class_options(L, -1); // Stack: mt
-        if (options.test(allowOverridingMethods))
+        if (options.test(allowOverridingMethods)) // Stack: mt
         {
             if (auto result = try_call_index_fallback(L))
                 return *result;
@@ -250,7 +610,7 @@ inline int index_metamethod(lua_State* L)
         lua_pushvalue(L, 2); // Stack: mt, field name
         lua_rawget(L, -2); // Stack: mt, field | nil
 
-        if (lua_iscfunction(L, -1)) // Stack: mt, field
+        if (lua_iscfunction(L, -1) || is_ffi_cdata(L, -1)) // Stack: mt, field
         {
             lua_remove(L, -2); // Stack: field
             return 1;
@@ -297,11 +657,170 @@ inline int index_metamethod(lua_State* L)
         // Remove the metatable and repeat the search in the parent one.
         LUABRIDGE_ASSERT(lua_istable(L, -1)); // Stack: mt, parent mt
         lua_remove(L, -2); // Stack: parent mt
+
+        options = get_class_options(L, -1);
     }
 
     // no return
 }
 
+#if LUABRIDGE_ON_LUAU
+inline int namecall_metamethod(lua_State* L);
+
+//=================================================================================================
+/**
+ * @brief Build the table mapping method name atoms to functions, and install the __namecall metamethod using it.
+ *
+ * The class or const table is at the given index. Methods of the parent classes are included unless they are shadowed by a member
+ * of a derived class. The metamethod is only installed when the host assigns string atoms through the `useratom` callback and every
+ * method reachable from the class is a C function: classes allowing to override methods or having an index fallback in their hierarchy
+ * (including extensible classes) could resolve a method to a Lua function, which couldn't yield if called from the metamethod, so they
+ * keep the regular `__index` lookup. The metamethod is removed again if a continued registration makes the class ineligible.
+ */
+inline void build_namecall_atoms(lua_State* L, int index)
+{
+#if LUABRIDGE_SAFE_STACK_CHECKS
+    luaL_checkstack(L, 6, detail::error_lua_stack_overflow);
+#endif
+
+    index = lua_absindex(L, index);
+
+    bool eligible = lua_callbacks(L)->useratom != nullptr;
+    int mappedAtoms = 0;
+
+    lua_newtable(L); // Stack: atoms table (at)
+    lua_pushvalue(L, index); // Stack: at, mt
+
+    while (eligible)
+    {
+        // Lua overrides and index fallbacks could resolve a name to a Lua function
+        lua_rawgetp(L, -1, getIndexFallbackKey()); // Stack: at, mt, ifb | nil
+        const bool hasIndexFallback = ! lua_isnil(L, -1);
+        lua_pop(L, 1); // Stack: at, mt
+
+        if (hasIndexFallback || get_class_options(L, -1).test(allowOverridingMethods))
+        {
+            eligible = false;
+            break;
+        }
+
+        lua_pushnil(L); // Stack: at, mt, nil
+        while (lua_next(L, -2) != 0) // Stack: at, mt, key, value
+        {
+            int atom = -1;
+            const char* name = lua_type(L, -2) == LUA_TSTRING ? lua_tostringatom(L, -2, &atom) : nullptr;
+
+            if (name != nullptr && atom >= 0 && lua_iscfunction(L, -1) && ! is_metamethod(name))
+            {
+                lua_rawgeti(L, -4, atom); // Stack: at, mt, key, value, existing | nil
+                if (lua_isnil(L, -1))
+                {
+                    lua_pushvalue(L, -2); // Stack: at, mt, key, value, nil, value
+                    lua_rawseti(L, -6, atom); // at [atom] = value. Stack: at, mt, key, value, nil
+                    ++mappedAtoms;
+                }
+                lua_pop(L, 1); // Stack: at, mt, key, value
+            }
+
+            lua_pop(L, 1); // Stack: at, mt, key
+        }
+
+        // Properties shadow the methods with the same name in the parent classes
+        lua_rawgetp(L, -1, getPropgetKey()); // Stack: at, mt, propget table (pg)
+        lua_pushnil(L); // Stack: at, mt, pg, nil
+        while (lua_next(L, -2) != 0) // Stack: at, mt, pg, key, getter
+        {
+            int atom = -1;
+            if (lua_type(L, -2) == LUA_TSTRING && lua_tostringatom(L, -2, &atom) != nullptr && atom >= 0)
+            {
+                lua_rawgeti(L, -5, atom); // Stack: at, mt, pg, key, getter, existing | nil
+                if (lua_isnil(L, -1))
+                {
+                    lua_pushboolean(L, 0); // Stack: at, mt, pg, key, getter, nil, false
+                    lua_rawseti(L, -7, atom); // at [atom] = false. Stack: at, mt, pg, key, getter, nil
+                }
+                lua_pop(L, 1); // Stack: at, mt, pg, key, getter
+            }
+
+            lua_pop(L, 1); // Stack: at, mt, pg, key
+        }
+        lua_pop(L, 1); // Stack: at, mt
+
+        lua_rawgetp(L, -1, getParentKey()); // Stack: at, mt, parent mt | nil
+        lua_remove(L, -2); // Stack: at, parent mt | nil
+
+        if (lua_isnil(L, -1))
+            break;
+    }
+
+    lua_pop(L, 1); // Stack: at
+
+    if (! eligible || mappedAtoms == 0)
+    {
+        lua_pop(L, 1); // Stack: -
+        lua_pushnil(L); // Stack: nil
+    }
+
+    lua_rawsetp(L, index, getNamecallAtomsKey()); // mt [namecallAtomsKey] = at | nil. Stack: -
+
+    if (eligible && mappedAtoms > 0)
+        lua_pushcfunction_x(L, &namecall_metamethod); // Stack: function
+    else
+        lua_pushnil(L); // Stack: nil
+
+    rawsetfield(L, index, "__namecall"); // mt ["__namecall"] = function | nil. Stack: -
+}
+
+//=================================================================================================
+/**
+ * @brief __namecall metamethod for class instances.
+ *
+ * Serves `object:method(...)` calls by looking up the method atom in the table built by `build_namecall_atoms`, without going through
+ * the __index metamethod. Unmapped names (properties) fall back to the regular lookup, a Lua function found this way is called from
+ * the metamethod and can't yield.
+ */
+inline int namecall_metamethod(lua_State* L)
+{
+#if LUABRIDGE_SAFE_STACK_CHECKS
+    luaL_checkstack(L, 3, detail::error_lua_stack_overflow);
+#endif
+
+    int atom = -1;
+    const char* name = lua_namecallatom(L, &atom);
+    if (name == nullptr)
+        luaL_error(L, "%s", "invalid namecall invocation");
+
+    const int nargs = lua_gettop(L); // Stack: object, args...
+
+    lua_getmetatable(L, 1); // Stack: object, args..., mt
+    lua_rawgetp(L, -1, getNamecallAtomsKey()); // Stack: object, args..., mt, atoms table (at) | nil
+
+    if (atom >= 0 && lua_istable(L, -1))
+        lua_rawgeti(L, -1, atom); // Stack: object, args..., mt, at, function | false | nil
+    else
+        lua_pushnil(L); // Stack: object, args..., mt, at, nil
+
+    if (lua_isfunction(L, -1))
+    {
+        lua_replace(L, -3); // Stack: object, args..., function, at
+        lua_pop(L, 1); // Stack: object, args..., function
+    }
+    else
+    {
+        lua_pop(L, 3); // Stack: object, args...
+        lua_getfield(L, 1, name); // Stack: object, args..., function | nil
+
+        if (! lua_isfunction(L, -1))
+            luaL_error(L, "attempt to call missing method '%s' of %s", name, luaL_typename(L, 1));
+    }
+
+    lua_insert(L, 1); // Stack: function, object, args...
+    lua_call(L, nargs, LUA_MULTRET);
+
+    return lua_gettop(L);
+}
+#endif // LUABRIDGE_ON_LUAU
+
 //=================================================================================================
 /**
  * @brief __newindex metamethod for non-static members.
@@ -372,6 +891,18 @@ inline std::optional<int> try_call_newindex_fallback(lua_State* L, const char* k
         lua_remove(L, -2); // Stack: mt, nifb, pmt
     }
 
+    if (void* storage = get_typed_fallback_storage(L, -3)) // Stack: mt, typed fallback (tfb), mt, ct
+    {
+        lua_pop(L, 3); // Stack: mt
+
+        const int stackTop = lua_gettop(L);
+        lua_pushvalue(L, 3); // Stack: mt, new value
+        call_typed_fallback(L, storage);
+        lua_settop(L, stackTop); // Stack: mt
+
+        return 0;
+    }
+
     if (is_key_metamethod)
     {
         lua_remove(L, -2); // Stack: mt, nifb, ct
@@ -435,7 +966,15 @@ inline int newindex_metamethod(lua_State* L, bool pushSelf)
         // Try in the parent
         lua_rawgetp(L, -1, getParentKey()); // Stack: mt, parent mt | nil
         if (lua_isnil(L, -1)) // Stack: mt, nil
+        {
+            lua_pop(L, 2); // Stack: -
+
+            // Store a new field of an object of an extensible class
+            if (pushSelf && try_set_instance_field(L, key))
+                return 0;
+
             luaL_error(L, "no writable member '%s'", key);
+        }
 
         LUABRIDGE_ASSERT(lua_istable(L, -1)); // Stack: mt, parent mt
         lua_remove(L, -2); // Stack: parent mt
@@ -485,7 +1024,9 @@ inline int read_only_error(lua_State* L)
 
 //=================================================================================================
 /**
- * @brief
+ * @brief Index fallback of extensible classes, looking up the methods added from lua to the class.
+ *
+ * The static table holding them is in the first upvalue. Fields assigned to single objects are looked up by `index_metamethod` first.
  */
 inline int index_extended_class(lua_State* L)
 {
@@ -494,15 +1035,17 @@ inline int index_extended_class(lua_State* L)
     if (! lua_isstring(L, -1))
         luaL_error(L, "%s", "invalid non string index access in extensible class");
 
-    const char* key = lua_tostring(L, -1);
-    LUABRIDGE_ASSERT(key != nullptr);
-
-    lua_pushvalue(L, lua_upvalueindex(1));
-    rawgetfield(L, -1, key);
+    lua_pushvalue(L, lua_upvalueindex(1)); // Stack: object, field name, static table (st)
+    lua_pushvalue(L, -2); // Stack: object, field name, st, field name
+    lua_rawget(L, -2); // Stack: object, field name, st, method | nil
 
     return 1;
 }
 
+//=================================================================================================
+/**
+ * @brief New index fallback of extensible classes, adding methods from lua to the class.
+ */
 inline int newindex_extended_class(lua_State* L)
 {
     LUABRIDGE_ASSERT(lua_istable(L, -3));
@@ -510,12 +1053,9 @@ inline int newindex_extended_class(lua_State* L)
     if (! lua_isstring(L, -2))
         luaL_error(L, "%s", "invalid non string new index access in extensible class");
 
-    const char* key = lua_tostring(L, -2);
-    LUABRIDGE_ASSERT(key != nullptr);
-
-    lua_getmetatable(L, -3);
-    lua_pushvalue(L, -2);
-    rawsetfield(L, -2, key);
+    lua_getmetatable(L, -3); // Stack: table, field name, method, static table (st)
+    lua_insert(L, -3); // Stack: table, st, field name, method
+    lua_rawset(L, -3); // st [field name] = method. Stack: table, st
 
     return 0;
 }
@@ -544,6 +1084,10 @@ static int tostring_metamethod(lua_State* L)
 //=================================================================================================
 /**
  * @brief __gc metamethod for a class.
+ *
+ * The storage kind is read from the userdata header and the matching destroy function is called directly. The object is released
+ * but the userdata header is kept valid, so the same function is used to dispose objects and it does nothing when called again. The
+ * external memory reported for the object, if any, and its count in the object census are released as well.
  */
 template <class C>
 static int gc_metamethod(lua_State* L)
@@ -551,7 +1095,74 @@ static int gc_metamethod(lua_State* L)
     Userdata* ud = Userdata::getExact<C>(L, 1);
     LUABRIDGE_ASSERT(ud);
 
-    ud->~Userdata();
+    if (! ud->isDisposed())
+        count_object_released(L, 1);
+
+    if constexpr (has_external_memory_size_v<C>)
+    {
+        if (! ud->isDisposed() && ud->getKind() != UserdataKind::Pointer)
+            ud->releaseExternalMemory(L);
+    }
+
+    switch (ud->getKind())
+    {
+    case UserdataKind::Value:
+        if constexpr (std::is_destructible_v<C>)
+            static_cast<UserdataValue<C>*>(ud)->destroy();
+        break;
+
+    case UserdataKind::Pointer:
+        static_cast<UserdataPtr*>(ud)->destroy();
+        break;
+
+    case UserdataKind::External:
+        static_cast<UserdataValueExternal<C>*>(ud)->destroy();
+        break;
+
+    case UserdataKind::Shared:
+        static_cast<UserdataSharedBase*>(ud)->destroy();
+        break;
+
+    case UserdataKind::Intrusive:
+        if constexpr (IsIntrusiveRefCounted<C>::value)
+            static_cast<UserdataIntrusive<C>*>(ud)->destroy();
+        break;
+
+    default:
+        break;
+    }
+
+    return 0;
+}
+
+//=================================================================================================
+/**
+ * @brief `dispose` method and __close metamethod for a class.
+ *
+ * Release the object immediately through the destroy function stored in its own metatable, so objects of derived classes are released
+ * with their dynamic type. Objects held by pointer are owned by C++ and are only detached.
+ */
+inline int dispose_metamethod(lua_State* L)
+{
+    if (! lua_isuserdata(L, 1) || lua_islightuserdata(L, 1) || ! lua_getmetatable(L, 1))
+        luaL_argerror(L, 1, "object expected");
+
+    // Stack: mt
+    lua_rawgetp(L, -1, getTypeKey()); // Stack: mt, type name | nil
+    if (! lua_isstring(L, -1))
+        luaL_argerror(L, 1, "object expected");
+
+    lua_pop(L, 1); // Stack: mt
+
+#if LUABRIDGE_ON_LUAU
+    lua_rawgetp(L, -1, getDestroyKey()); // Stack: mt, destroy function
+#else
+    rawgetfield(L, -1, "__gc"); // Stack: mt, destroy function
+#endif
+    LUABRIDGE_ASSERT(lua_iscfunction(L, -1));
+
+    lua_pushvalue(L, 1); // Stack: mt, destroy function, object
+    lua_call(L, 1, 0); // Stack: mt
 
     return 0;
 }
@@ -571,6 +1182,8 @@ struct property_getter<T, void>
 {
     static int call(lua_State* L)
     {
+        BindingCallScope scope(L, 2);
+
         LUABRIDGE_ASSERT(lua_islightuserdata(L, lua_upvalueindex(1)));
 
         T* ptr = static_cast<T*>(lua_touserdata(L, lua_upvalueindex(1)));
@@ -594,9 +1207,11 @@ struct property_getter
 {
     static int call(lua_State* L)
     {
+        BindingCallScope scope(L, 2);
+
         C* c = Userdata::get<C>(L, 1, true);
 
-        T C::** mp = static_cast<T C::**>(lua_touserdata(L, lua_upvalueindex(1)));
+        T C::** mp = static_cast<T C::**>(get_closure_storage(L, lua_upvalueindex(1)));
 
         Result result;
 
@@ -655,6 +1270,8 @@ struct property_setter<T, void>
 {
     static int call(lua_State* L)
     {
+        BindingCallScope scope(L, 2);
+
         LUABRIDGE_ASSERT(lua_islightuserdata(L, lua_upvalueindex(1)));
 
         T* ptr = static_cast<T*>(lua_touserdata(L, lua_upvalueindex(1)));
@@ -662,7 +1279,10 @@ struct property_setter<T, void>
 
         auto result = Stack<T>::get(L, 1);
         if (! result)
+        {
+            count_argument_decode_failure();
             raise_lua_error(L, "%s", result.error().message().c_str());
+        }
 
         *ptr = std::move(*result);
 
@@ -680,9 +1300,11 @@ struct property_setter
 {
     static int call(lua_State* L)
     {
+        BindingCallScope scope(L, 2);
+
         C* c = Userdata::get<C>(L, 1, false);
 
-        T C::** mp = static_cast<T C::**>(lua_touserdata(L, lua_upvalueindex(1)));
+        T C::** mp = static_cast<T C::**>(get_closure_storage(L, lua_upvalueindex(1)));
 
 #if LUABRIDGE_HAS_EXCEPTIONS
         try
@@ -690,7 +1312,10 @@ struct property_setter
 #endif
             auto result = Stack<T>::get(L, 2);
             if (! result)
+            {
+                count_argument_decode_failure();
                 raise_lua_error(L, "%s", result.error().message().c_str());
+            }
 
             c->** mp = std::move(*result);
 
@@ -844,11 +1469,13 @@ int invoke_member_function(lua_State* L)
 {
     using FnTraits = function_traits<F>;
 
-    LUABRIDGE_ASSERT(isfulluserdata(L, lua_upvalueindex(1)));
+    BindingCallScope scope(L, 2);
+
+    LUABRIDGE_ASSERT(is_closure_storage(L, lua_upvalueindex(1)));
 
     T* ptr = Userdata::get<T>(L, 1, false);
 
-    const F& func = *static_cast<const F*>(lua_touserdata(L, lua_upvalueindex(1)));
+    const F& func = *static_cast<const F*>(get_closure_storage(L, lua_upvalueindex(1)));
     LUABRIDGE_ASSERT(func != nullptr);
 
     return function<typename FnTraits::result_type, typename FnTraits::argument_types, 2>::call(L, ptr, func);
@@ -859,11 +1486,13 @@ int invoke_const_member_function(lua_State* L)
 {
     using FnTraits = function_traits<F>;
 
-    LUABRIDGE_ASSERT(isfulluserdata(L, lua_upvalueindex(1)));
+    BindingCallScope scope(L, 2);
+
+    LUABRIDGE_ASSERT(is_closure_storage(L, lua_upvalueindex(1)));
 
     const T* ptr = Userdata::get<T>(L, 1, true);
 
-    const F& func = *static_cast<const F*>(lua_touserdata(L, lua_upvalueindex(1)));
+    const F& func = *static_cast<const F*>(get_closure_storage(L, lua_upvalueindex(1)));
     LUABRIDGE_ASSERT(func != nullptr);
 
     return function<typename FnTraits::result_type, typename FnTraits::argument_types, 2>::call(L, ptr, func);
@@ -880,11 +1509,13 @@ int invoke_member_cfunction(lua_State* L)
 {
     using F = int (T::*)(lua_State * L);
 
-    LUABRIDGE_ASSERT(isfulluserdata(L, lua_upvalueindex(1)));
+    BindingCallScope scope(L, 2);
+
+    LUABRIDGE_ASSERT(is_closure_storage(L, lua_upvalueindex(1)));
 
     T* t = Userdata::get<T>(L, 1, false);
 
-    const F& func = *static_cast<const F*>(lua_touserdata(L, lua_upvalueindex(1)));
+    const F& func = *static_cast<const F*>(get_closure_storage(L, lua_upvalueindex(1)));
     LUABRIDGE_ASSERT(func != nullptr);
 
     return (t->*func)(L);
@@ -895,11 +1526,13 @@ int invoke_const_member_cfunction(lua_State* L)
 {
     using F = int (T::*)(lua_State * L) const;
 
-    LUABRIDGE_ASSERT(isfulluserdata(L, lua_upvalueindex(1)));
+    BindingCallScope scope(L, 2);
+
+    LUABRIDGE_ASSERT(is_closure_storage(L, lua_upvalueindex(1)));
 
     const T* t = Userdata::get<T>(L, 1, true);
 
-    const F& func = *static_cast<const F*>(lua_touserdata(L, lua_upvalueindex(1)));
+    const F& func = *static_cast<const F*>(get_closure_storage(L, lua_upvalueindex(1)));
     LUABRIDGE_ASSERT(func != nullptr);
 
     return (t->*func)(L);
@@ -916,6 +1549,8 @@ int invoke_proxy_function(lua_State* L)
 {
     using FnTraits = function_traits<F>;
 
+    BindingCallScope scope(L, 2);
+
     LUABRIDGE_ASSERT(lua_islightuserdata(L, lua_upvalueindex(1)));
 
     auto func = reinterpret_cast<F>(lua_touserdata(L, lua_upvalueindex(1)));
@@ -935,9 +1570,11 @@ int invoke_proxy_functor(lua_State* L)
 {
     using FnTraits = function_traits<F>;
 
-    LUABRIDGE_ASSERT(isfulluserdata(L, lua_upvalueindex(1)));
+    BindingCallScope scope(L, 2);
 
-    auto& func = *align<F>(lua_touserdata(L, lua_upvalueindex(1)));
+    LUABRIDGE_ASSERT(is_closure_storage(L, lua_upvalueindex(1)));
+
+    auto& func = *align<F>(get_closure_storage(L, lua_upvalueindex(1)));
 
     return function<typename FnTraits::result_type, typename FnTraits::argument_types, 1>::call(L, func);
 }
@@ -953,9 +1590,11 @@ int invoke_proxy_constructor(lua_State* L)
 {
     using FnTraits = function_traits<F>;
 
-    LUABRIDGE_ASSERT(isfulluserdata(L, lua_upvalueindex(1)));
+    BindingCallScope scope(L, 2);
+
+    LUABRIDGE_ASSERT(is_closure_storage(L, lua_upvalueindex(1)));
 
-    auto& func = *align<F>(lua_touserdata(L, lua_upvalueindex(1)));
+    auto& func = *align<F>(get_closure_storage(L, lua_upvalueindex(1)));
 
     function<void, typename FnTraits::argument_types, 1>::call(L, func);
 
@@ -971,6 +1610,8 @@ int invoke_proxy_constructor(lua_State* L)
 template <bool Member>
 inline int try_overload_functions(lua_State* L)
 {
+    BindingCallScope scope(L, 2);
+
     const int nargs = lua_gettop(L);
     const int effective_args = nargs - (Member ? 1 : 0);
 
@@ -1041,6 +1682,9 @@ inline int try_overload_functions(lua_State* L)
     lua_getstack_info_x(L, 0, "n", &debug);
     lua_pushfstring(L, "All %d overloads of %s returned an error:", nerrors, debug.name);
 
+    // The overloads are not named, a call none of them accepted counts as a decode failure of the overload set
+    scope.addDecodeFailure();
+
     // Concatenate error messages of each overload
     for (int i = 1; i <= nerrors; ++i)
     {
@@ -1295,6 +1939,8 @@ struct external_constructor
 template <class C, class Args>
 int constructor_container_proxy(lua_State* L)
 {
+    BindingCallScope scope(L, 1);
+
     using T = typename ContainerTraits<C>::Type;
 
     T* object = constructor<T, Args>::call(detail::make_arguments_list<Args, 2>(L));
@@ -1312,6 +1958,8 @@ int constructor_container_proxy(lua_State* L)
 template <class T, class Args>
 int constructor_placement_proxy(lua_State* L)
 {
+    BindingCallScope scope(L, 1);
+
     auto args = make_arguments_list<Args, 2>(L);
 
     std::error_code ec;
@@ -1323,6 +1971,9 @@ int constructor_placement_proxy(lua_State* L)
 
     value->commit();
 
+    count_object_created(L);
+    value->trackExternalMemory(report_object_external_memory(L, value->getObject()));
+
     return 1;
 }
 
@@ -1355,6 +2006,9 @@ struct constructor_forwarder
 
         value->commit();
 
+        count_object_created(L);
+        value->trackExternalMemory(report_object_external_memory(L, obj));
+
         return obj;
     }
 
@@ -1387,6 +2041,8 @@ struct factory_forwarder
         if (! value)
             raise_lua_error(L, "%s", ec.message().c_str());
 
+        value->trackExternalMemory(report_object_external_memory(L, obj));
+
         return obj;
     }
 
@@ -155,6 +155,127 @@ template <class T, auto = typeName<T>().find_first_of('.')>
   return reinterpret_cast<void*>(0x8107);
 }
 
+//=================================================================================================
+/**
+ * @brief The key of the pointer identity cache table in another metatable.
+ */
+[[nodiscard]] inline const void* getPointerCacheKey() noexcept
+{
+    return reinterpret_cast<void*>(0xca4e);
+}
+
+//=================================================================================================
+/**
+ * @brief The key of the method atoms table used by __namecall in another metatable.
+ */
+[[nodiscard]] inline const void* getNamecallAtomsKey() noexcept
+{
+    return reinterpret_cast<void*>(0xa70c);
+}
+
+//=================================================================================================
+/**
+ * @brief The key of the function destroying the objects of a class in its metatable.
+ *
+ * Used to dispose objects on Luau, where userdata are destroyed without a __gc metamethod.
+ */
+[[nodiscard]] inline const void* getDestroyKey() noexcept
+{
+    return reinterpret_cast<void*>(0xde57);
+}
+
+//=================================================================================================
+/**
+ * @brief The key of the external memory counters in the registry.
+ */
+[[nodiscard]] inline const void* getExternalMemoryKey() noexcept
+{
+    return reinterpret_cast<void*>(0xe8a3);
+}
+
+//=================================================================================================
+/**
+ * @brief The key of the weak references table in the registry.
+ */
+[[nodiscard]] inline const void* getWeakReferencesKey() noexcept
+{
+    return reinterpret_cast<void*>(0x3ea7);
+}
+
+//=================================================================================================
+/**
+ * @brief The key of the deferred release queue holder in the registry.
+ */
+[[nodiscard]] inline const void* getReleaseQueueKey() noexcept
+{
+    return reinterpret_cast<void*>(0x7f1c);
+}
+
+//=================================================================================================
+/**
+ * @brief The key of the weak table of the coroutines with deferred release in the registry.
+ */
+[[nodiscard]] inline const void* getReleaseQueueThreadsKey() noexcept
+{
+    return reinterpret_cast<void*>(0x7f1d);
+}
+
+//=================================================================================================
+/**
+ * @brief The key of the hook transferring the objects of a class to another state, in its metatable.
+ */
+[[nodiscard]] inline const void* getTransferKey() noexcept
+{
+    return reinterpret_cast<void*>(0x7a5f);
+}
+
+//=================================================================================================
+/**
+ * @brief The key of the hook serializing the objects of a class, in its metatable.
+ */
+[[nodiscard]] inline const void* getSerializeKey() noexcept
+{
+    return reinterpret_cast<void*>(0x5e7a);
+}
+
+//=================================================================================================
+/**
+ * @brief The key of the table of serialization hooks by class name, in the registry.
+ */
+[[nodiscard]] inline const void* getSerializersKey() noexcept
+{
+    return reinterpret_cast<void*>(0x5e7b);
+}
+
+//=================================================================================================
+/**
+ * @brief The key of the running profiler of a state, in the registry.
+ */
+[[nodiscard]] inline const void* getProfilerKey() noexcept
+{
+    return reinterpret_cast<void*>(0x9f01);
+}
+
+//=================================================================================================
+/**
+ * @brief The key of the live object counters of a class, in its class and const tables, and of the table of all of them by class name,
+ * in the registry.
+ */
+[[nodiscard]] inline const void* getObjectCensusKey() noexcept
+{
+    return reinterpret_cast<void*>(0xce25);
+}
+
+//=================================================================================================
+/**
+ * @brief The key marking the fields table of an object of an extensible class, in its environment on Lua 5.1 and LuaJIT, and of the
+ * weak keyed table of the fields tables by object, in the registry on Luau.
+ */
+[[nodiscard]] inline const void* getInstanceFieldsKey() noexcept
+{
+    return reinterpret_cast<void*>(0xf1e1);
+}
+
 //=================================================================================================
 /**
  * @brief Get the key for the static table in the Lua registry.
@@ -197,5 +318,29 @@ template <class T>
 
     return reinterpret_cast<void*>(value);
 }
+
+//=================================================================================================
+/**
+ * @brief Get the key for the table mapping the names of an enum to its values in the Lua registry.
+ */
+template <class T>
+[[nodiscard]] const void* getEnumNamesRegistryKey() noexcept
+{
+    static auto value = typeHash<T>() ^ 3;
+
+    return reinterpret_cast<void*>(value);
+}
+
+//=================================================================================================
+/**
+ * @brief Get the key for the metatable of the proxies of a container type in the Lua registry.
+ */
+template <class T>
+[[nodiscard]] const void* getContainerProxyRegistryKey() noexcept
+{
+    static auto value = typeHash<T>() ^ 4;
+
+    return reinterpret_cast<void*>(value);
+}
 } // namespace detail
 } // namespace luabridge
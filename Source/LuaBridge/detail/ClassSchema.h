@@ -0,0 +1,269 @@
+// https://github.com/kunitoki/LuaBridge3
+// Copyright 2023, Lucio Asnaghi
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "Config.h"
+#include "FuncTraits.h"
+
+#include <tuple>
+#include <utility>
+
+namespace luabridge {
+namespace detail {
+
+//=================================================================================================
+/**
+ * @brief Number of user supplied entries that will end up in each of the tables of a registered class.
+ *
+ * Used to presize the tables when the members of a class are known upfront, avoiding rehashes while they are filled.
+ */
+struct ClassTableSizes
+{
+    int constRecords = 0;
+    int classRecords = 0;
+    int staticRecords = 0;
+    int properties = 0;
+    int staticProperties = 0;
+
+    constexpr ClassTableSizes operator+(const ClassTableSizes& other) const noexcept
+    {
+        return {
+            constRecords + other.constRecords,
+            classRecords + other.classRecords,
+            staticRecords + other.staticRecords,
+            properties + other.properties,
+            staticProperties + other.staticProperties
+        };
+    }
+};
+
+//=================================================================================================
+/**
+ * @brief Schema entry for a member function or a set of overloaded member functions.
+ */
+template <class... Functions>
+struct SchemaFunction
+{
+    const char* name;
+    std::tuple<Functions...> functions;
+
+    template <class T>
+    static constexpr ClassTableSizes sizes() noexcept
+    {
+        return { const_functions_count<T, Functions...> > 0 ? 1 : 0, 1, 0, 0, 0 };
+    }
+
+    template <class C>
+    void registerInto(C& cls) const
+    {
+        std::apply([&](const auto&... fns) { cls.addFunction(name, fns...); }, functions);
+    }
+};
+
+//=================================================================================================
+/**
+ * @brief Schema entry for a member property, with the same arguments accepted by `Class<T>::addProperty`.
+ */
+template <class... Args>
+struct SchemaProperty
+{
+    const char* name;
+    std::tuple<Args...> args;
+
+    template <class T>
+    static constexpr ClassTableSizes sizes() noexcept
+    {
+        return { 0, 0, 0, 1, 0 };
+    }
+
+    template <class C>
+    void registerInto(C& cls) const
+    {
+        std::apply([&](const auto&... xs) { cls.addProperty(name, xs...); }, args);
+    }
+};
+
+//=================================================================================================
+/**
+ * @brief Schema entry for a static function or a set of overloaded static functions.
+ */
+template <class... Functions>
+struct SchemaStaticFunction
+{
+    const char* name;
+    std::tuple<Functions...> functions;
+
+    template <class T>
+    static constexpr ClassTableSizes sizes() noexcept
+    {
+        return { 0, 0, 1, 0, 0 };
+    }
+
+    template <class C>
+    void registerInto(C& cls) const
+    {
+        std::apply([&](const auto&... fns) { cls.addStaticFunction(name, fns...); }, functions);
+    }
+};
+
+//=================================================================================================
+/**
+ * @brief Schema entry for a static property, with the same arguments accepted by `Class<T>::addStaticProperty`.
+ */
+template <class... Args>
+struct SchemaStaticProperty
+{
+    const char* name;
+    std::tuple<Args...> args;
+
+    template <class T>
+    static constexpr ClassTableSizes sizes() noexcept
+    {
+        return { 0, 0, 0, 0, 1 };
+    }
+
+    template <class C>
+    void registerInto(C& cls) const
+    {
+        std::apply([&](const auto&... xs) { cls.addStaticProperty(name, xs...); }, args);
+    }
+};
+
+//=================================================================================================
+/**
+ * @brief Schema entry for the constructor signatures of the class.
+ */
+template <class... Signatures>
+struct SchemaConstructor
+{
+    template <class T>
+    static constexpr ClassTableSizes sizes() noexcept
+    {
+        return { 0, 0, 1, 0, 0 };
+    }
+
+    template <class C>
+    void registerInto(C& cls) const
+    {
+        cls.template addConstructor<Signatures...>();
+    }
+};
+
+} // namespace detail
+
+//=================================================================================================
+/**
+ * @brief Compile time description of a class registration.
+ *
+ * Holds the class name and the list of its members, it is usually declared `constexpr` and registered with `Namespace::addClass`.
+ *
+ * @tparam T The class being described.
+ * @tparam Members The schema entries, created with `schemaFunction`, `schemaProperty`, `schemaStaticFunction`,
+ *         `schemaStaticProperty` and `schemaConstructor`.
+ */
+template <class T, class... Members>
+class ClassSchema
+{
+public:
+    constexpr ClassSchema(const char* name, Members... members)
+        : m_name(name)
+        , m_members(std::move(members)...)
+    {
+    }
+
+    /**
+     * @brief The class name.
+     */
+    constexpr const char* name() const noexcept
+    {
+        return m_name;
+    }
+
+    /**
+     * @brief The schema entries.
+     */
+    constexpr const std::tuple<Members...>& members() const noexcept
+    {
+        return m_members;
+    }
+
+    /**
+     * @brief Number of entries going into each of the class tables.
+     */
+    static constexpr detail::ClassTableSizes sizes() noexcept
+    {
+        return (detail::ClassTableSizes{} + ... + Members::template sizes<T>());
+    }
+
+private:
+    const char* m_name;
+    std::tuple<Members...> m_members;
+};
+
+//=================================================================================================
+/**
+ * @brief Create a class schema.
+ *
+ * @param name The class name.
+ * @param members The schema entries.
+ */
+template <class T, class... Members>
+constexpr ClassSchema<T, Members...> classSchema(const char* name, Members... members)
+{
+    return ClassSchema<T, Members...>(name, std::move(members)...);
+}
+
+/**
+ * @brief Describe a member function, or a set of overloads, for a class schema.
+ */
+template <class... Functions>
+constexpr detail::SchemaFunction<Functions...> schemaFunction(const char* name, Functions... functions)
+{
+    static_assert(sizeof...(Functions) > 0);
+
+    return { name, std::tuple<Functions...>(std::move(functions)...) };
+}
+
+/**
+ * @brief Describe a member property for a class schema.
+ */
+template <class... Args>
+constexpr detail::SchemaProperty<Args...> schemaProperty(const char* name, Args... args)
+{
+    return { name, std::tuple<Args...>(std::move(args)...) };
+}
+
+/**
+ * @brief Describe a static function, or a set of overloads, for a class schema.
+ */
+template <class... Functions>
+constexpr detail::SchemaStaticFunction<Functions...> schemaStaticFunction(const char* name, Functions... functions)
+{
+    static_assert(sizeof...(Functions) > 0);
+
+    return { name, std::tuple<Functions...>(std::move(functions)...) };
+}
+
+/**
+ * @brief Describe a static property for a class schema.
+ */
+template <class... Args>
+constexpr detail::SchemaStaticProperty<Args...> schemaStaticProperty(const char* name, Args... args)
+{
+    return { name, std::tuple<Args...>(std::move(args)...) };
+}
+
+/**
+ * @brief Describe the constructor signatures for a class schema.
+ */
+template <class... Signatures>
+constexpr detail::SchemaConstructor<Signatures...> schemaConstructor()
+{
+    static_assert(sizeof...(Signatures) > 0);
+
+    return {};
+}
+
+} // namespace luabridge
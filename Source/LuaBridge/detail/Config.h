@@ -77,3 +77,11 @@
 #define LUABRIDGE_ASSERT(expr) assert(expr)
 #endif
 #endif
+
+#if !defined(LUABRIDGE_ENABLE_PROFILING)
+#define LUABRIDGE_ENABLE_PROFILING 0
+#endif
+
+#if !defined(LUABRIDGE_ENABLE_OBJECT_CENSUS)
+#define LUABRIDGE_ENABLE_OBJECT_CENSUS 0
+#endif
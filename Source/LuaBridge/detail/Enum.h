@@ -5,14 +5,280 @@
 #pragma once
 
 #include "Config.h"
+#include "ClassInfo.h"
 #include "Errors.h"
 #include "LuaHelpers.h"
 #include "Stack.h"
 
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
 #include <type_traits>
+#include <utility>
 
 namespace luabridge {
 
+//=================================================================================================
+/**
+ * @brief Names of the values of an enum, to be specialized for enums accepting their names from lua.
+ *
+ * A specialization provides a `names` array of value and name pairs:
+ *
+ * @code
+ * template <>
+ * struct luabridge::EnumNames<MyEnum>
+ * {
+ *     static constexpr std::pair<MyEnum, const char*> names[] = { { MyEnum::A, "A" }, { MyEnum::B, "B" } };
+ * };
+ * @endcode
+ */
+template <class T>
+struct EnumNames
+{
+};
+
+namespace detail {
+
+//=================================================================================================
+/**
+ * @brief Check if the names of an enum are specified.
+ */
+template <class T, class = void>
+struct has_enum_names : std::false_type
+{
+};
+
+template <class T>
+struct has_enum_names<T, std::void_t<decltype(std::size(EnumNames<T>::names))>> : std::true_type
+{
+};
+
+template <class T>
+inline static constexpr bool has_enum_names_v = has_enum_names<T>::value;
+
+//=================================================================================================
+/**
+ * @brief Offset of an enum value from the first value, computed in modular arithmetic so it works for any underlying type.
+ */
+template <class Type>
+constexpr std::uintmax_t enum_value_offset(Type value, Type first) noexcept
+{
+    return static_cast<std::uintmax_t>(value) - static_cast<std::uintmax_t>(first);
+}
+
+/**
+ * @brief Sort enum values at compile time.
+ */
+template <class Type, std::size_t N>
+constexpr std::array<Type, N> sorted_enum_values(std::array<Type, N> values) noexcept
+{
+    for (std::size_t i = 1; i < N; ++i)
+    {
+        for (std::size_t j = i; j > 0 && values[j] < values[j - 1]; --j)
+        {
+            const Type value = values[j];
+            values[j] = values[j - 1];
+            values[j - 1] = value;
+        }
+    }
+
+    return values;
+}
+
+/**
+ * @brief Count the distinct values of a sorted array.
+ */
+template <class Type, std::size_t N>
+constexpr std::size_t distinct_enum_values(const std::array<Type, N>& sorted) noexcept
+{
+    std::size_t count = N > 0 ? 1 : 0;
+
+    for (std::size_t i = 1; i < N; ++i)
+    {
+        if (sorted[i] != sorted[i - 1])
+            ++count;
+    }
+
+    return count;
+}
+
+/**
+ * @brief Build a bitset of sorted enum values, one bit per offset from the first value.
+ */
+template <std::size_t Words, class Type, std::size_t N>
+constexpr std::array<std::uint64_t, Words> enum_values_bitset(const std::array<Type, N>& sorted) noexcept
+{
+    std::array<std::uint64_t, Words> bits{};
+
+    for (std::size_t i = 0; i < N; ++i)
+    {
+        const auto offset = enum_value_offset(sorted[i], sorted[0]);
+        bits[static_cast<std::size_t>(offset / 64)] |= std::uint64_t(1) << (offset % 64);
+    }
+
+    return bits;
+}
+
+//=================================================================================================
+/**
+ * @brief Set of the valid values of an enum, with the lookup strategy chosen at compile time.
+ *
+ * Contiguous values are checked with a range test, dense values with a bitset covering their range (at most 8 bits per value), and
+ * sparse values with a binary search over the sorted values.
+ */
+template <class Type, Type... Values>
+struct EnumValueSet
+{
+    static_assert(sizeof...(Values) > 0);
+
+    static constexpr std::size_t maxDenseBits = 1 << 16;
+
+    static constexpr std::array<Type, sizeof...(Values)> sorted = sorted_enum_values(std::array<Type, sizeof...(Values)>{ Values... });
+
+    static constexpr std::uintmax_t last = enum_value_offset(sorted.back(), sorted.front());
+
+    static constexpr std::size_t distinct = distinct_enum_values(sorted);
+
+    static constexpr bool isContiguous = last == distinct - 1;
+
+    static constexpr bool isDense = ! isContiguous && last < maxDenseBits && last / distinct < 8;
+
+    static constexpr std::size_t words = isDense ? static_cast<std::size_t>(last / 64 + 1) : 1;
+
+    static constexpr std::array<std::uint64_t, words> bits = isDense
+        ? enum_values_bitset<words>(sorted)
+        : std::array<std::uint64_t, words>{};
+
+    [[nodiscard]] static bool contains(Type value) noexcept
+    {
+        const auto offset = enum_value_offset(value, sorted.front());
+
+        if constexpr (isContiguous)
+            return offset <= last;
+        else if constexpr (isDense)
+            return offset <= last && ((bits[static_cast<std::size_t>(offset / 64)] >> (offset % 64)) & 1) != 0;
+        else
+            return std::binary_search(sorted.begin(), sorted.end(), value);
+    }
+};
+
+//=================================================================================================
+/**
+ * @brief Name of an enum value.
+ */
+template <class Type>
+struct EnumNameEntry
+{
+    Type value{};
+    const char* name = nullptr;
+};
+
+/**
+ * @brief Sort the names of an enum by value at compile time.
+ */
+template <class T, std::size_t N = std::size(EnumNames<T>::names)>
+constexpr auto sorted_enum_names() noexcept
+{
+    using Entry = EnumNameEntry<std::underlying_type_t<T>>;
+
+    std::array<Entry, N> entries{};
+
+    for (std::size_t i = 0; i < N; ++i)
+        entries[i] = Entry{ static_cast<std::underlying_type_t<T>>(EnumNames<T>::names[i].first), EnumNames<T>::names[i].second };
+
+    for (std::size_t i = 1; i < N; ++i)
+    {
+        for (std::size_t j = i; j > 0 && entries[j].value < entries[j - 1].value; --j)
+        {
+            const Entry entry = entries[j];
+            entries[j] = entries[j - 1];
+            entries[j - 1] = entry;
+        }
+    }
+
+    return entries;
+}
+
+/**
+ * @brief Check if sorted names cover contiguous values, one name per value, so they can be indexed by value.
+ */
+template <class Type, std::size_t N>
+constexpr bool contiguous_enum_names(const std::array<EnumNameEntry<Type>, N>& entries) noexcept
+{
+    for (std::size_t i = 0; i < N; ++i)
+    {
+        if (enum_value_offset(entries[i].value, entries[0].value) != i)
+            return false;
+    }
+
+    return true;
+}
+
+//=================================================================================================
+/**
+ * @brief Names of an enum sorted by value at compile time, to find the name of a value.
+ */
+template <class T>
+struct EnumNameTable
+{
+    using Type = std::underlying_type_t<T>;
+
+    static constexpr auto entries = sorted_enum_names<T>();
+
+    static constexpr bool isContiguous = contiguous_enum_names(entries);
+
+    [[nodiscard]] static const char* find(T value) noexcept
+    {
+        const auto key = static_cast<Type>(value);
+
+        if constexpr (isContiguous)
+        {
+            const auto offset = enum_value_offset(key, entries.front().value);
+            return offset < entries.size() ? entries[static_cast<std::size_t>(offset)].name : nullptr;
+        }
+        else
+        {
+            const auto it = std::lower_bound(entries.begin(), entries.end(), key,
+                [](const auto& entry, Type k) { return entry.value < k; });
+
+            return it != entries.end() && it->value == key ? it->name : nullptr;
+        }
+    }
+};
+
+/**
+ * @brief Push the table mapping the names of an enum to their index in the sorted names, creating it in the registry the first time.
+ *
+ * Indices are stored instead of values, so values not representable by a lua number are resolved exactly.
+ */
+template <class T>
+void push_enum_names(lua_State* L)
+{
+    lua_rawgetp(L, LUA_REGISTRYINDEX, getEnumNamesRegistryKey<T>()); // Stack: names table (nt) | nil
+    if (lua_istable(L, -1))
+        return;
+
+    lua_pop(L, 1); // Stack: -
+
+    const auto& entries = EnumNameTable<T>::entries;
+
+    lua_createtable(L, 0, static_cast<int>(entries.size())); // Stack: nt
+
+    for (std::size_t i = 0; i < entries.size(); ++i)
+    {
+        lua_pushinteger(L, static_cast<lua_Integer>(i)); // Stack: nt, index
+        rawsetfield(L, -2, entries[i].name); // nt [name] = index. Stack: nt
+    }
+
+    lua_pushvalue(L, -1); // Stack: nt, nt
+    lua_rawsetp(L, LUA_REGISTRYINDEX, getEnumNamesRegistryKey<T>()); // registry [enumNamesKey] = nt. Stack: nt
+}
+
+} // namespace detail
+
 //=================================================================================================
 /**
  * @brief LuaBridge enum wrapper for enums as integers.
@@ -21,7 +287,10 @@ namespace luabridge {
  * the developer to make sure that a lua integer could be converted back to C++. Failing to validate a lua
  * integer before converting to the corresponding C++ enum value could lead to a C++ enum that has no defined value.
  *
- * For improved security, specify which values the enum will have, so runtime validation could be performed.
+ * For improved security, specify which values the enum will have, so runtime validation could be performed. The check is generated at
+ * compile time: a range test for contiguous values, a bitset for dense values, and a binary search for sparse values.
+ *
+ * When `EnumNames<T>` is specialized, strings holding the name of a value are accepted as well, resolved with a single table lookup.
  */
 template <class T, T... Values>
 struct Enum
@@ -37,30 +306,82 @@ struct Enum
 
     [[nodiscard]] static TypeResult<T> get(lua_State* L, int index)
     {
-        const auto result = Stack<Type>::get(L, index);
+        const auto result = getUnderlying(L, index);
         if (! result)
             return result.error();
 
         if constexpr (sizeof...(Values) > 0)
         {
-            constexpr Type values[] = { static_cast<Type>(Values)... };
-            for (std::size_t i = 0; i < sizeof...(Values); ++i)
-            {
-                if (values[i] == *result)
-                    return static_cast<T>(*result);
-            }
+            if (! detail::EnumValueSet<Type, static_cast<Type>(Values)...>::contains(*result))
+                return makeErrorCode(ErrorCode::InvalidTypeCast);
+        }
+
+        return static_cast<T>(*result);
+    }
 
-            return makeErrorCode(ErrorCode::InvalidTypeCast);
+    [[nodiscard]] static bool isInstance(lua_State* L, int index)
+    {
+        if constexpr (detail::has_enum_names_v<T>)
+        {
+            if (lua_type(L, index) == LUA_TSTRING)
+                return getByName(L, index).has_value();
         }
-        else
+
+        return lua_type(L, index) == LUA_TNUMBER;
+    }
+
+    /**
+     * @brief Get the name of an enum value, as specified by `EnumNames<T>`.
+     *
+     * @returns The name of the value, or nullptr if the value has no name.
+     */
+    [[nodiscard]] static const char* name(T value) noexcept
+    {
+        static_assert(detail::has_enum_names_v<T>, "The names of the enum are specified by specializing EnumNames<T>");
+
+        return detail::EnumNameTable<T>::find(value);
+    }
+
+private:
+    static TypeResult<Type> getUnderlying(lua_State* L, int index)
+    {
+        if constexpr (detail::has_enum_names_v<T>)
         {
-            return static_cast<T>(*result);
+            if (lua_type(L, index) == LUA_TSTRING)
+            {
+                const auto value = getByName(L, index);
+                if (! value)
+                    return makeErrorCode(ErrorCode::InvalidTypeCast);
+
+                return *value;
+            }
         }
+
+        return Stack<Type>::get(L, index);
     }
 
-    [[nodiscard]] static bool isInstance(lua_State* L, int index)
+    static std::optional<Type> getByName(lua_State* L, int index)
     {
-        return lua_type(L, index) == LUA_TNUMBER;
+#if LUABRIDGE_SAFE_STACK_CHECKS
+        if (! lua_checkstack(L, 3))
+            return std::nullopt;
+#endif
+
+        const int absIndex = lua_absindex(L, index);
+
+        detail::push_enum_names<T>(L); // Stack: names table (nt)
+        lua_pushvalue(L, absIndex); // Stack: nt, name
+        lua_rawget(L, -2); // Stack: nt, index | nil
+
+        int isValid = 0;
+        const auto position = tointeger(L, -1, &isValid);
+        lua_pop(L, 2); // Stack: -
+
+        const auto& entries = detail::EnumNameTable<T>::entries;
+        if (! isValid || position < 0 || static_cast<std::size_t>(position) >= entries.size())
+            return std::nullopt;
+
+        return entries[static_cast<std::size_t>(position)].value;
     }
 };
 
@@ -35,7 +35,17 @@ enum class ErrorCode
 
     InvalidTypeCast,
 
-    InvalidTableSizeInCast
+    InvalidTableSizeInCast,
+
+    ValueNotTransferable,
+
+    ValueNotSerializable,
+
+    InvalidSerializedData,
+
+    SerializationStreamFailed,
+
+    ValueNestedTooDeeply
 };
 
 //=================================================================================================
@@ -72,6 +82,21 @@ struct ErrorCategory : std::error_category
         case ErrorCode::InvalidTableSizeInCast:
             return "The lua table has different size than expected";
 
+        case ErrorCode::ValueNotTransferable:
+            return "The lua value can't be transferred to another state";
+
+        case ErrorCode::ValueNotSerializable:
+            return "The lua value can't be serialized";
+
+        case ErrorCode::InvalidSerializedData:
+            return "The serialized data is truncated or corrupted";
+
+        case ErrorCode::SerializationStreamFailed:
+            return "The serialization stream failed to read or write";
+
+        case ErrorCode::ValueNestedTooDeeply:
+            return "The lua value has too many nested tables to be transferred";
+
         default:
             return "Unknown error";
         }
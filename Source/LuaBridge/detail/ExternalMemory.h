@@ -0,0 +1,255 @@
+// https://github.com/kunitoki/LuaBridge3
+// Copyright 2023, Lucio Asnaghi
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "Config.h"
+#include "ClassInfo.h"
+#include "LuaHelpers.h"
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace luabridge {
+
+//=================================================================================================
+/**
+ * @brief Customization point reporting the memory owned by objects of a class outside of their userdata.
+ *
+ * The lua garbage collector only sees the size of the userdata, so an object owning a large heap buffer looks tiny and collections are
+ * scheduled too late. By default the `luabridge_memory_size` member function of the class is used if present, for classes that can't be
+ * modified specialize this template with a static `get` function:
+ *
+ * @code
+ * template <>
+ * struct luabridge::ExternalMemorySize<Image>
+ * {
+ *     static std::size_t get(const Image& image) { return image.width() * image.height() * 4; }
+ * };
+ * @endcode
+ *
+ * The size is sampled when the object is pushed and the same amount is released with the object, so later changes of the size (for
+ * example a growing buffer) are not reported.
+ */
+template <class T, class = void>
+struct ExternalMemorySize
+{
+};
+
+template <class T>
+struct ExternalMemorySize<T, std::void_t<decltype(std::declval<const T&>().luabridge_memory_size())>>
+{
+    static std::size_t get(const T& object)
+    {
+        return static_cast<std::size_t>(object.luabridge_memory_size());
+    }
+};
+
+//=================================================================================================
+/**
+ * @brief Aggregate counters of the external memory reported to a lua state.
+ */
+struct ExternalMemoryStats
+{
+    std::size_t bytes = 0;   ///< Memory owned by the live objects, as reported by `ExternalMemorySize`.
+    std::size_t objects = 0; ///< Number of live objects with reported memory.
+};
+
+namespace detail {
+
+//=================================================================================================
+/**
+ * @brief Check if the objects of a class report their external memory.
+ */
+template <class T, class = void>
+struct has_external_memory_size : std::false_type
+{
+};
+
+template <class T>
+struct has_external_memory_size<T, std::void_t<decltype(ExternalMemorySize<T>::get(std::declval<const T&>()))>> : std::true_type
+{
+};
+
+template <class T>
+inline static constexpr bool has_external_memory_size_v = has_external_memory_size<T>::value;
+
+//=================================================================================================
+/**
+ * @brief Per state storage of the external memory counters.
+ *
+ * On Luau objects are destroyed without access to the state, so they release their memory through a pointer to the counters, which are
+ * kept alive by the registry and by the objects still counted.
+ */
+struct ExternalMemoryState
+{
+    ExternalMemoryStats stats;
+    std::size_t pendingBytes = 0; ///< Reported bytes not yet accounted with a collector step.
+#if LUABRIDGE_ON_LUAU
+    bool orphaned = false; ///< The state has been closed, the counters are deleted with the last object.
+#endif
+};
+
+/**
+ * @brief Remove an object from the external memory counters.
+ */
+inline void release_external_memory(ExternalMemoryState& state, std::size_t size) noexcept
+{
+    LUABRIDGE_ASSERT(state.stats.objects > 0);
+    LUABRIDGE_ASSERT(size <= state.stats.bytes);
+
+    state.stats.bytes -= size;
+    state.stats.objects -= 1;
+
+#if LUABRIDGE_ON_LUAU
+    if (state.orphaned && state.stats.objects == 0)
+        delete &state;
+#endif
+}
+
+#if LUABRIDGE_ON_LUAU
+/**
+ * @brief Release the reference of the registry to the external memory counters, when the state is closed.
+ */
+inline void orphan_external_memory_state(ExternalMemoryState* state) noexcept
+{
+    if (state->stats.objects == 0)
+        delete state;
+    else
+        state->orphaned = true;
+}
+#endif
+
+/**
+ * @brief The external memory reported for an object, released when the object is collected or disposed.
+ *
+ * On Luau the record also points to the counters, as the userdata holding the object can be destroyed without access to the state.
+ */
+struct ExternalMemoryRecord
+{
+#if LUABRIDGE_ON_LUAU
+    ExternalMemoryState* state = nullptr;
+#endif
+    std::size_t size = 0;
+
+#if LUABRIDGE_ON_LUAU
+    void release() noexcept
+    {
+        if (state != nullptr)
+            release_external_memory(*std::exchange(state, nullptr), size);
+    }
+#endif
+};
+
+/**
+ * @brief Get the external memory counters of a state, creating them if requested.
+ */
+inline ExternalMemoryState* get_external_memory_state(lua_State* L, bool create)
+{
+    lua_rawgetp(L, LUA_REGISTRYINDEX, getExternalMemoryKey()); // Stack: state | nil
+#if LUABRIDGE_ON_LUAU
+    auto* holder = static_cast<ExternalMemoryState**>(lua_touserdata(L, -1));
+    auto* state = holder != nullptr ? *holder : nullptr;
+#else
+    auto* state = static_cast<ExternalMemoryState*>(lua_touserdata(L, -1));
+#endif
+    lua_pop(L, 1);
+
+    if (state == nullptr && create)
+    {
+#if LUABRIDGE_ON_LUAU
+        state = new ExternalMemoryState();
+
+        void* storage = lua_newuserdatadtor(L, sizeof(ExternalMemoryState*), [](void* x)
+        {
+            orphan_external_memory_state(*static_cast<ExternalMemoryState**>(x));
+        }); // Stack: holder
+
+        new (storage) ExternalMemoryState*(state);
+#else
+        state = new (lua_newuserdata_x<ExternalMemoryState>(L, sizeof(ExternalMemoryState))) ExternalMemoryState(); // Stack: state
+#endif
+        lua_rawsetp(L, LUA_REGISTRYINDEX, getExternalMemoryKey()); // Stack: -
+    }
+
+    return state;
+}
+
+/**
+ * @brief Report the external memory of a new object, advancing the collector as if the memory had been allocated by lua.
+ */
+inline ExternalMemoryRecord report_external_memory(lua_State* L, std::size_t size)
+{
+    auto* state = get_external_memory_state(L, true);
+
+    state->stats.bytes += size;
+    state->stats.objects += 1;
+    state->pendingBytes += size;
+
+    if (state->pendingBytes >= 1024)
+    {
+        const auto kilobytes = state->pendingBytes / 1024;
+        state->pendingBytes %= 1024;
+
+        lua_gc(L, LUA_GCSTEP, static_cast<int>(kilobytes));
+    }
+
+#if LUABRIDGE_ON_LUAU
+    return { state, size };
+#else
+    return { size };
+#endif
+}
+
+#if ! LUABRIDGE_ON_LUAU
+/**
+ * @brief Release the external memory reported for an object.
+ */
+inline void release_external_memory(lua_State* L, const ExternalMemoryRecord& record)
+{
+    auto* state = get_external_memory_state(L, false);
+    LUABRIDGE_ASSERT(state != nullptr);
+
+    if (state != nullptr)
+        release_external_memory(*state, record.size);
+}
+#endif
+
+/**
+ * @brief Report the external memory of an object now owned by a userdata, if its class supports it.
+ */
+template <class T>
+ExternalMemoryRecord report_object_external_memory([[maybe_unused]] lua_State* L, [[maybe_unused]] const T* object)
+{
+    if constexpr (has_external_memory_size_v<T>)
+    {
+        if (object != nullptr)
+            return report_external_memory(L, ExternalMemorySize<T>::get(*object));
+    }
+
+    return {};
+}
+
+} // namespace detail
+
+//=================================================================================================
+/**
+ * @brief Get the aggregate counters of the external memory owned by the objects of a state.
+ *
+ * Only objects of classes specializing `ExternalMemorySize`, or having a `luabridge_memory_size` member function, are counted. An
+ * object shared by multiple userdata is counted once per userdata.
+ *
+ * @param L A lua state.
+ *
+ * @returns The external memory counters of the state.
+ */
+inline ExternalMemoryStats getExternalMemoryStats(lua_State* L)
+{
+    const auto* state = detail::get_external_memory_state(L, false);
+    return state != nullptr ? state->stats : ExternalMemoryStats{};
+}
+
+} // namespace luabridge
@@ -0,0 +1,207 @@
+// https://github.com/kunitoki/LuaBridge3
+// Copyright 2023, Lucio Asnaghi
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "Config.h"
+#include "LuaHelpers.h"
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+namespace luabridge {
+namespace detail {
+
+//=================================================================================================
+/**
+ * @brief Check if a type can be passed as argument to a function called through the LuaJIT FFI, with the same conversions of the
+ * classic binding.
+ *
+ * Only `double` qualifies: the FFI truncates out of range integers and floats instead of rejecting them, converts any value to `bool`
+ * and doesn't convert numbers to strings.
+ */
+template <class T>
+inline static constexpr bool is_ffi_argument_v = std::is_same_v<T, double>;
+
+/**
+ * @brief Check if a type can be returned by a function called through the LuaJIT FFI, with the same conversions of the classic
+ * binding.
+ *
+ * Character types are excluded, as the classic binding pushes them as strings, and so are 64 bit integers, as the FFI returns them
+ * boxed in a cdata instead of a Lua number.
+ */
+template <class T>
+[[nodiscard]] constexpr bool is_ffi_result() noexcept
+{
+    if constexpr (std::is_void_v<T> || std::is_same_v<T, bool> || std::is_same_v<T, float> || std::is_same_v<T, double>)
+        return true;
+    else if constexpr (std::is_integral_v<T>)
+        return sizeof(T) <= 4
+            && ! std::is_same_v<T, char>
+            && ! std::is_same_v<T, wchar_t>
+            && ! std::is_same_v<T, char16_t>
+            && ! std::is_same_v<T, char32_t>;
+    else
+        return false;
+}
+
+template <class T>
+inline static constexpr bool is_ffi_result_v = is_ffi_result<T>();
+
+//=================================================================================================
+/**
+ * @brief Check if the value at the given index is a LuaJIT FFI cdata.
+ */
+[[nodiscard]] inline bool is_ffi_cdata([[maybe_unused]] lua_State* L, [[maybe_unused]] int index)
+{
+#if LUABRIDGE_ON_LUAJIT
+    return lua_type(L, index) == 10; // LUA_TCDATA, not exported by the LuaJIT headers
+#else
+    return false;
+#endif
+}
+
+//=================================================================================================
+/**
+ * @brief Return the C declaration of a type supported by the FFI.
+ */
+template <class T>
+std::string ffi_type_name()
+{
+    if constexpr (std::is_void_v<T>)
+        return "void";
+    else if constexpr (std::is_same_v<T, bool>)
+        return "bool";
+    else if constexpr (std::is_same_v<T, float>)
+        return "float";
+    else if constexpr (std::is_same_v<T, double>)
+        return "double";
+    else
+    {
+        static_assert(std::is_integral_v<T>);
+
+        return (std::is_signed_v<T> ? "int" : "uint") + std::to_string(sizeof(T) * 8) + "_t";
+    }
+}
+
+//=================================================================================================
+/**
+ * @brief Traits of a function pointer callable through the FFI.
+ */
+template <class F>
+struct ffi_function_traits
+{
+    static constexpr bool value = false;
+};
+
+template <class R, class... Args>
+struct ffi_function_traits<R (*)(Args...)>
+{
+    static constexpr bool value = is_ffi_result_v<R> && (is_ffi_argument_v<Args> && ...);
+
+    /**
+     * @brief The FFI declaration of the function pointer type, like `int32_t (*)(double, const char*)`.
+     */
+    static std::string signature()
+    {
+        std::string result = ffi_type_name<R>() + " (*)(";
+
+        if constexpr (sizeof...(Args) == 0)
+        {
+            result += "void";
+        }
+        else
+        {
+            bool first = true;
+            ((result += (first ? "" : ", ") + ffi_type_name<Args>(), first = false), ...);
+        }
+
+        return result + ")";
+    }
+};
+
+template <class R, class... Args>
+struct ffi_function_traits<R (*)(Args...) noexcept> : ffi_function_traits<R (*)(Args...)>
+{
+};
+
+template <class F>
+inline static constexpr bool is_ffi_function_v = ffi_function_traits<F>::value;
+
+//=================================================================================================
+/**
+ * @brief Push a function pointer as a LuaJIT FFI cdata, so calls from Lua can be compiled in traces.
+ *
+ * @returns true if the cdata has been pushed, false if nothing has been pushed because the FFI library is not available.
+ */
+template <class F>
+bool push_ffi_function([[maybe_unused]] lua_State* L, [[maybe_unused]] F function)
+{
+    static_assert(is_ffi_function_v<F>);
+
+#if LUABRIDGE_ON_LUAJIT
+#if LUABRIDGE_SAFE_STACK_CHECKS
+    luaL_checkstack(L, 4, detail::error_lua_stack_overflow);
+#endif
+
+    // Look up the module in the registry, as the globals (and `require`) are under the control of the scripts
+    lua_getfield(L, LUA_REGISTRYINDEX, "_LOADED"); // Stack: loaded | nil
+    if (! lua_istable(L, -1))
+    {
+        lua_pop(L, 1);
+        return false;
+    }
+
+    lua_getfield(L, -1, "ffi"); // Stack: loaded, ffi | nil
+    lua_remove(L, -2); // Stack: ffi | nil
+    if (! lua_istable(L, -1))
+    {
+        // Not required yet: open it with the loader preloaded by luaL_openlibs, which is missing when LuaJIT is built without the
+        // FFI. The library registers itself in the loaded modules when opened, so this happens only once
+        lua_pop(L, 1);
+
+        lua_getfield(L, LUA_REGISTRYINDEX, "_PRELOAD"); // Stack: preload | nil
+        if (! lua_istable(L, -1))
+        {
+            lua_pop(L, 1);
+            return false;
+        }
+
+        lua_getfield(L, -1, "ffi"); // Stack: preload, loader | nil
+        lua_remove(L, -2); // Stack: loader | nil
+        if (! lua_iscfunction(L, -1))
+        {
+            lua_pop(L, 1);
+            return false;
+        }
+
+        lua_pushstring(L, "ffi"); // Stack: loader, "ffi"
+        if (lua_pcall(L, 1, 1, 0) != 0 || ! lua_istable(L, -1)) // Stack: ffi | error
+        {
+            lua_pop(L, 1);
+            return false;
+        }
+    }
+
+    lua_getfield(L, -1, "cast"); // Stack: ffi, cast
+    lua_pushstring(L, ffi_function_traits<F>::signature().c_str()); // Stack: ffi, cast, signature
+    lua_pushlightuserdata(L, reinterpret_cast<void*>(function)); // Stack: ffi, cast, signature, pointer
+    if (lua_pcall(L, 2, 1, 0) != 0) // Stack: ffi, cdata | error
+    {
+        lua_pop(L, 2);
+        return false;
+    }
+
+    lua_remove(L, -2); // Stack: cdata
+    return true;
+
+#else
+    return false;
+
+#endif
+}
+
+} // namespace detail
+} // namespace luabridge
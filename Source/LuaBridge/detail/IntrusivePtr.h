@@ -0,0 +1,208 @@
+// https://github.com/kunitoki/LuaBridge3
+// Copyright 2023, Lucio Asnaghi
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "Config.h"
+#include "TypeTraits.h"
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+namespace luabridge {
+
+//=================================================================================================
+/**
+ * @brief Base class adding an intrusive reference count to an object.
+ *
+ * Objects deriving from this class are deleted when the last reference is released. Use `IntrusivePtr` to hold them, LuaBridge will
+ * store only the object pointer inside the userdata and will increment and decrement the embedded counter directly.
+ *
+ * @tparam CounterType The counter type, either a `std::atomic` of an integral type or a plain integral type when the object is only
+ *         referenced from a single thread.
+ */
+template <class CounterType>
+class IntrusiveRefCounted
+{
+public:
+    IntrusiveRefCounted(const IntrusiveRefCounted&) = delete;
+    IntrusiveRefCounted& operator=(const IntrusiveRefCounted&) = delete;
+
+    /**
+     * @brief Increment the reference count of the object.
+     */
+    void incReferenceCount() const noexcept
+    {
+        if constexpr (std::is_integral_v<CounterType>)
+            ++m_refCount;
+        else
+            m_refCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Decrement the reference count of the object, deleting it when it drops to zero.
+     */
+    void decReferenceCount() const noexcept
+    {
+        LUABRIDGE_ASSERT(getReferenceCount() > 0);
+
+        if constexpr (std::is_integral_v<CounterType>)
+        {
+            if (--m_refCount == 0)
+                delete this;
+        }
+        else
+        {
+            if (m_refCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                delete this;
+        }
+    }
+
+    /**
+     * @brief Return the current reference count of the object.
+     */
+    int getReferenceCount() const noexcept
+    {
+        return static_cast<int>(m_refCount);
+    }
+
+protected:
+    IntrusiveRefCounted() noexcept = default;
+
+    virtual ~IntrusiveRefCounted()
+    {
+        // It's dangerous to delete an object that's still referenced by something else!
+        LUABRIDGE_ASSERT(getReferenceCount() == 0);
+    }
+
+private:
+    mutable CounterType m_refCount{ 0 };
+};
+
+/**
+ * @brief Intrusively reference counted object, safe to be shared between threads.
+ */
+using AtomicRefCounted = IntrusiveRefCounted<std::atomic<std::int32_t>>;
+
+/**
+ * @brief Intrusively reference counted object, to be used when the object is only referenced by a single thread (and lua_State).
+ */
+using SingleThreadedRefCounted = IntrusiveRefCounted<std::int32_t>;
+
+//=================================================================================================
+/**
+ * @brief Smart pointer holding a reference to an intrusively reference counted object.
+ *
+ * The object must expose `incReferenceCount` and `decReferenceCount`, typically by deriving from `AtomicRefCounted` or
+ * `SingleThreadedRefCounted`.
+ *
+ * @tparam T The class of the object referenced.
+ */
+template <class T>
+class IntrusivePtr
+{
+public:
+    using element_type = T;
+
+    IntrusivePtr() noexcept = default;
+
+    IntrusivePtr(std::nullptr_t) noexcept
+    {
+    }
+
+    IntrusivePtr(T* object) noexcept
+        : m_object(object)
+    {
+        if (m_object != nullptr)
+            m_object->incReferenceCount();
+    }
+
+    IntrusivePtr(const IntrusivePtr& other) noexcept
+        : IntrusivePtr(other.m_object)
+    {
+    }
+
+    template <class U, class = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    IntrusivePtr(const IntrusivePtr<U>& other) noexcept
+        : IntrusivePtr(static_cast<T*>(other.get()))
+    {
+    }
+
+    IntrusivePtr(IntrusivePtr&& other) noexcept
+        : m_object(std::exchange(other.m_object, nullptr))
+    {
+    }
+
+    ~IntrusivePtr()
+    {
+        if (m_object != nullptr)
+            m_object->decReferenceCount();
+    }
+
+    IntrusivePtr& operator=(const IntrusivePtr& other) noexcept
+    {
+        IntrusivePtr(other).swap(*this);
+        return *this;
+    }
+
+    IntrusivePtr& operator=(IntrusivePtr&& other) noexcept
+    {
+        IntrusivePtr(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    IntrusivePtr& operator=(T* object) noexcept
+    {
+        IntrusivePtr(object).swap(*this);
+        return *this;
+    }
+
+    void swap(IntrusivePtr& other) noexcept
+    {
+        std::swap(m_object, other.m_object);
+    }
+
+    T* get() const noexcept { return m_object; }
+
+    T* operator->() const noexcept { return m_object; }
+
+    T& operator*() const noexcept { return *m_object; }
+
+    explicit operator bool() const noexcept { return m_object != nullptr; }
+
+    friend bool operator==(const IntrusivePtr& lhs, const IntrusivePtr& rhs) noexcept { return lhs.m_object == rhs.m_object; }
+
+    friend bool operator!=(const IntrusivePtr& lhs, const IntrusivePtr& rhs) noexcept { return lhs.m_object != rhs.m_object; }
+
+private:
+    T* m_object = nullptr;
+};
+
+//=================================================================================================
+/**
+ * @brief Register IntrusivePtr support as an intrusive container.
+ *
+ * The userdata only holds the object pointer and a reference, without storing the container itself.
+ */
+template <class T>
+struct ContainerTraits<IntrusivePtr<T>>
+{
+    using Type = T;
+
+    using IsIntrusive = bool;
+
+    static IntrusivePtr<T> construct(T* t)
+    {
+        return t;
+    }
+
+    static T* get(const IntrusivePtr<T>& c)
+    {
+        return c.get();
+    }
+};
+
+} // namespace luabridge
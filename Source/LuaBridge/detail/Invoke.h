@@ -177,10 +177,10 @@ LuaResult call(const LuaRef& object, Args&&... args)
     object.push();
 
     {
-        const auto [result, index] = detail::push_arguments(L, std::forward_as_tuple(args...));
+        [[maybe_unused]] const auto [result, index] = detail::push_arguments(L, std::forward_as_tuple(args...));
         if (! result)
         {
-            lua_pop(L, static_cast<int>(index) + 1);
+            lua_settop(L, stackTop);
             return LuaResult(L, result, result.message());
         }
     }
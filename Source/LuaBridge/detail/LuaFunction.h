@@ -0,0 +1,231 @@
+// https://github.com/kunitoki/LuaBridge3
+// Copyright 2023, Lucio Asnaghi
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "Config.h"
+#include "CFunctions.h"
+#include "Errors.h"
+#include "LuaException.h"
+#include "LuaRef.h"
+#include "Result.h"
+#include "Stack.h"
+
+#include <functional>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace luabridge {
+
+template <class Signature>
+class LuaFunction;
+
+//=================================================================================================
+/**
+ * @brief Typed reference to a Lua function.
+ *
+ * Holds a single registry reference to the function. Calling it pushes the arguments with their `Stack` specializations, calls the
+ * function expecting exactly the number of results of the signature, and converts the result with `Stack<R>::get`, so unlike calling
+ * a `LuaRef` no `LuaResult` is built and nothing is allocated when the call succeeds (unless the argument or result conversions
+ * allocate themselves).
+ *
+ * If the call fails and exceptions are enabled on the state, a `LuaException` is thrown, otherwise the error is returned.
+ *
+ * @tparam R The result type, `void` to discard the results.
+ * @tparam Args The argument types.
+ */
+template <class R, class... Args>
+class LuaFunction<R(Args...)>
+{
+    static_assert(! std::is_same_v<std::decay_t<R>, const char*> && ! std::is_same_v<std::decay_t<R>, std::string_view>,
+        "Results of a LuaFunction can't reference strings popped from the stack, use std::string instead");
+
+public:
+    using ResultType = std::conditional_t<std::is_void_v<R>, Result, TypeResult<R>>;
+
+    /**
+     * @brief Create a reference to a Lua function.
+     *
+     * @param function A reference to the function, or to any callable value.
+     */
+    explicit LuaFunction(LuaRef function) noexcept
+        : m_function(std::move(function))
+    {
+    }
+
+    /**
+     * @brief Get the state the function lives in.
+     */
+    [[nodiscard]] lua_State* state() const noexcept
+    {
+        return m_function.state();
+    }
+
+    /**
+     * @brief Get the reference to the function.
+     */
+    [[nodiscard]] const LuaRef& ref() const noexcept
+    {
+        return m_function;
+    }
+
+    /**
+     * @brief Check if the referenced value can be called.
+     */
+    [[nodiscard]] bool isValid() const
+    {
+        return m_function.isCallable();
+    }
+
+    /**
+     * @brief Call the function.
+     *
+     * @returns The converted result, or the error of the call.
+     */
+    ResultType operator()(Args... args) const
+    {
+        lua_State* L = m_function.state();
+        const int stackTop = lua_gettop(L);
+
+#if LUABRIDGE_SAFE_STACK_CHECKS
+        if (! lua_checkstack(L, 1))
+            return makeErrorCode(ErrorCode::LuaStackOverflow);
+#endif
+
+        m_function.push(L); // Stack: function
+
+        {
+            [[maybe_unused]] const auto [result, index] = detail::push_arguments(L, std::forward_as_tuple(args...)); // Stack: function, args...
+            if (! result)
+            {
+                lua_settop(L, stackTop);
+                return result.error();
+            }
+        }
+
+        const int code = lua_pcall(L, static_cast<int>(sizeof...(Args)), std::is_void_v<R> ? 0 : 1, 0); // Stack: result | error
+        if (code != LUABRIDGE_LUA_OK)
+        {
+            const auto ec = makeErrorCode(ErrorCode::LuaFunctionCallFailed);
+
+#if LUABRIDGE_HAS_EXCEPTIONS
+            if (LuaException::areExceptionsEnabled(L))
+                LuaException::raise(L, ec);
+#endif
+
+            lua_settop(L, stackTop);
+            return ec;
+        }
+
+        if constexpr (std::is_void_v<R>)
+        {
+            return {};
+        }
+        else
+        {
+            auto result = Stack<R>::get(L, -1);
+            lua_settop(L, stackTop);
+            return result;
+        }
+    }
+
+private:
+    LuaRef m_function;
+};
+
+//=================================================================================================
+/**
+ * @brief Stack specialization for `LuaFunction`.
+ */
+template <class R, class... Args>
+struct Stack<LuaFunction<R(Args...)>>
+{
+    [[nodiscard]] static Result push(lua_State* L, const LuaFunction<R(Args...)>& function)
+    {
+#if LUABRIDGE_SAFE_STACK_CHECKS
+        if (! lua_checkstack(L, 1))
+            return makeErrorCode(ErrorCode::LuaStackOverflow);
+#endif
+
+        function.ref().push(L);
+        return {};
+    }
+
+    [[nodiscard]] static TypeResult<LuaFunction<R(Args...)>> get(lua_State* L, int index)
+    {
+        if (! isInstance(L, index))
+            return makeErrorCode(ErrorCode::InvalidTypeCast);
+
+        return LuaFunction<R(Args...)>(LuaRef::fromStack(L, index));
+    }
+
+    [[nodiscard]] static bool isInstance(lua_State* L, int index)
+    {
+        return lua_isfunction(L, index);
+    }
+};
+
+//=================================================================================================
+/**
+ * @brief Stack specialization for `std::function`.
+ *
+ * A Lua function is converted into a `std::function` calling it through a `LuaFunction`. Since a `std::function` can't return an
+ * error, a failed call throws a `LuaException` if exceptions are enabled on the state, or a `std::system_error` otherwise. When
+ * exceptions are disabled at compile time, a failed call returns a value initialized result.
+ *
+ * A `std::function` is pushed as a C closure owning a copy of it.
+ */
+template <class R, class... Args>
+struct Stack<std::function<R(Args...)>>
+{
+    [[nodiscard]] static Result push(lua_State* L, const std::function<R(Args...)>& function)
+    {
+#if LUABRIDGE_SAFE_STACK_CHECKS
+        if (! lua_checkstack(L, 2))
+            return makeErrorCode(ErrorCode::LuaStackOverflow);
+#endif
+
+        if (! function)
+        {
+            lua_pushnil(L);
+            return {};
+        }
+
+        detail::push_function(L, std::function<R(Args...)>(function));
+        return {};
+    }
+
+    [[nodiscard]] static TypeResult<std::function<R(Args...)>> get(lua_State* L, int index)
+    {
+        if (! isInstance(L, index))
+            return makeErrorCode(ErrorCode::InvalidTypeCast);
+
+        return std::function<R(Args...)>([function = LuaFunction<R(Args...)>(LuaRef::fromStack(L, index))](Args... args) -> R
+        {
+            [[maybe_unused]] auto result = function(std::forward<Args>(args)...);
+
+#if LUABRIDGE_HAS_EXCEPTIONS
+            result.throw_on_error();
+#else
+            if constexpr (! std::is_void_v<R>)
+            {
+                if (! result)
+                    return R();
+            }
+#endif
+
+            if constexpr (! std::is_void_v<R>)
+                return *std::move(result);
+        });
+    }
+
+    [[nodiscard]] static bool isInstance(lua_State* L, int index)
+    {
+        return lua_isfunction(L, index);
+    }
+};
+
+} // namespace luabridge
@@ -235,6 +235,41 @@ inline int get_length(lua_State* L, int idx)
 
 #endif // LUA_VERSION_NUM < 502
 
+/**
+ * @brief Get the length of a table or string without invoking metamethods.
+ */
+inline int get_raw_length(lua_State* L, int idx)
+{
+#if LUA_VERSION_NUM < 502
+    return static_cast<int>(lua_objlen(L, idx));
+#else
+    return static_cast<int>(lua_rawlen(L, idx));
+#endif
+}
+
+/**
+ * @brief Check if the value at an index is an integral key inside the array part of a table of the given raw length.
+ */
+inline bool is_array_key(lua_State* L, int idx, int arraySize)
+{
+    if (lua_type(L, idx) != LUA_TNUMBER)
+        return false;
+
+#if LUA_VERSION_NUM >= 503
+    if (! lua_isinteger(L, idx))
+        return false;
+
+    const lua_Integer key = lua_tointeger(L, idx);
+#else
+    const lua_Number number = lua_tonumber(L, idx);
+    const auto key = static_cast<lua_Integer>(number);
+    if (static_cast<lua_Number>(key) != number)
+        return false;
+#endif
+
+    return key >= 1 && key <= arraySize;
+}
+
 #ifndef LUA_OK
 #define LUABRIDGE_LUA_OK 0
 #else
@@ -392,6 +427,25 @@ inline void rawsetfield(lua_State* L, int index, const char* key)
     return lua_isuserdata(L, index) && !lua_islightuserdata(L, index);
 }
 
+/**
+ * @brief Returns true if the value is the storage of a callable bound to a closure.
+ *
+ * Registered closures hold their callable in a full userdata, while closures instantiated from a `BindingImage` hold a light userdata
+ * pointing to the one owned by the image, resolved once when they are instantiated.
+ */
+[[nodiscard]] inline bool is_closure_storage(lua_State* L, int index)
+{
+    return lua_isuserdata(L, index) != 0;
+}
+
+/**
+ * @brief Get the storage of the callable bound to a closure, from the userdata at the given index.
+ */
+[[nodiscard]] inline void* get_closure_storage(lua_State* L, int index)
+{
+    return lua_touserdata(L, index);
+}
+
 /**
  * @brief Test lua_State objects for global equality.
  *
@@ -552,12 +606,23 @@ inline int raise_lua_error(lua_State* L, const char* fmt, ...)
     return lua_error_x(L);
 }
 
+/**
+ * @brief Checks if every value of an integral type fits into another integral type, so no range check is needed at runtime.
+ */
+template <class T, class U = lua_Integer>
+inline static constexpr bool is_integral_range_within_v = std::is_unsigned_v<T> == std::is_unsigned_v<U>
+    ? sizeof(T) <= sizeof(U)
+    : std::is_unsigned_v<T> && sizeof(T) < sizeof(U);
+
 /**
  * @brief Checks if the value on the stack is a number type and can fit into the corresponding c++ integral type..
  */
 template <class U = lua_Integer, class T>
 constexpr bool is_integral_representable_by(T value)
 {
+    if constexpr (is_integral_range_within_v<T, U>)
+        return true;
+
     constexpr bool same_signedness = (std::is_unsigned_v<T> && std::is_unsigned_v<U>)
         || (!std::is_unsigned_v<T> && !std::is_unsigned_v<U>);
 
@@ -11,6 +11,7 @@
 #include "Config.h"
 #include "Errors.h"
 #include "Expected.h"
+#include "ReleaseQueue.h"
 #include "Stack.h"
 
 #include <iostream>
@@ -654,10 +655,10 @@ class LuaRef : public LuaRefBase<LuaRef, LuaRef>
         ~TableItem()
         {
             if (m_keyRef != LUA_NOREF)
-                luaL_unref(m_L, LUA_REGISTRYINDEX, m_keyRef);
+                detail::release_registry_ref(m_L, m_keyRef);
 
             if (m_tableRef != LUA_NOREF)
-                luaL_unref(m_L, LUA_REGISTRYINDEX, m_tableRef);
+                detail::release_registry_ref(m_L, m_tableRef);
         }
 
         //=========================================================================================
@@ -909,11 +910,13 @@ public:
      * The corresponding Lua registry reference will be released.
      *
      * @note If the state refers to a thread, it is the responsibility of the caller to ensure that the thread still exists when the LuaRef is destroyed.
+     *
+     * @note The reference can be destroyed from a thread not owning the state only if `enableDeferredRelease` has been called.
      */
     ~LuaRef()
     {
         if (m_ref != LUA_NOREF)
-            luaL_unref(m_L, LUA_REGISTRYINDEX, m_ref);
+            detail::release_registry_ref(m_L, m_ref);
     }
 
     //=============================================================================================
@@ -1024,7 +1027,7 @@ public:
     LuaRef& operator=(LuaRef&& rhs) noexcept
     {
         if (m_ref != LUA_NOREF)
-            luaL_unref(m_L, LUA_REGISTRYINDEX, m_ref);
+            detail::release_registry_ref(m_L, m_ref);
 
         m_L = rhs.m_L;
         m_ref = std::exchange(rhs.m_ref, LUA_NOREF);
@@ -8,16 +8,22 @@
 #pragma once
 
 #include "Config.h"
+#include "BindingStats.h"
 #include "ClassInfo.h"
+#include "ClassSchema.h"
+#include "Ffi.h"
 #include "FlagSet.h"
 #include "LuaHelpers.h"
 #include "LuaException.h"
 #include "Options.h"
+#include "Serialization.h"
+#include "Transfer.h"
 #include "TypeTraits.h"
 
 #include <stdexcept>
 #include <string_view>
 #include <string>
+#include <tuple>
 #include <type_traits>
 #include <utility>
 
@@ -157,15 +163,18 @@ class Namespace : public detail::Registrar
         //=========================================================================================
         /**
          * @brief Create the const table.
+         *
+         * The records and properties hints are the number of user members that will be registered, used to presize the table and its
+         * property getters table. The internal records are not accounted for.
          */
-        void createConstTable(const char* name, bool trueConst, Options options)
+        void createConstTable(const char* name, bool trueConst, Options options, int recordsHint = 0, int propertiesHint = 0)
         {
             LUABRIDGE_ASSERT(name != nullptr);
 
             std::string type_name = std::string(trueConst ? "const " : "") + name;
 
             // Stack: namespace table (ns)
-            lua_newtable(L); // Stack: ns, const table (co)
+            lua_createtable(L, 0, recordsHint); // Stack: ns, const table (co)
             lua_pushvalue(L, -1); // Stack: ns, co, co
             lua_setmetatable(L, -2); // co.__metatable = co. Stack: ns, co
 
@@ -181,9 +190,19 @@ class Namespace : public detail::Registrar
             lua_pushcfunction_x(L, &detail::newindex_object_metamethod);
             rawsetfield(L, -2, "__newindex");
 
-            lua_newtable(L);
+            lua_createtable(L, 0, propertiesHint);
             lua_rawsetp(L, -2, detail::getPropgetKey());
 
+            if (options.test(cachedPointers))
+            {
+                lua_newtable(L); // Stack: ns, co, pointer cache (pc)
+                lua_newtable(L); // Stack: ns, co, pc, pointer cache metatable (pm)
+                lua_pushstring(L, "v");
+                rawsetfield(L, -2, "__mode"); // pm ["__mode"] = "v". Stack: ns, co, pc, pm
+                lua_setmetatable(L, -2); // Stack: ns, co, pc
+                lua_rawsetp(L, -2, detail::getPointerCacheKey()); // co [pointerCacheKey] = pc. Stack: ns, co
+            }
+
             if (! options.test(visibleMetatables))
             {
                 lua_pushboolean(L, 0);
@@ -197,16 +216,16 @@ class Namespace : public detail::Registrar
          *
          * The Lua stack should have the const table on top.
          */
-        void createClassTable(const char* name, Options options)
+        void createClassTable(const char* name, Options options, int recordsHint = 0, int propertiesHint = 0)
         {
             LUABRIDGE_ASSERT(name != nullptr);
 
             // Stack: namespace table (ns), const table (co)
 
             // Class table is the same as const table except the propset table
-            createConstTable(name, false, options); // Stack: ns, co, cl
+            createConstTable(name, false, options, recordsHint, propertiesHint); // Stack: ns, co, cl
 
-            lua_newtable(L); // Stack: ns, co, cl, propset table (ps)
+            lua_createtable(L, 0, propertiesHint); // Stack: ns, co, cl, propset table (ps)
             lua_rawsetp(L, -2, detail::getPropsetKey()); // cl [propsetKey] = ps. Stack: ns, co, cl
 
             lua_pushvalue(L, -2); // Stack: ns, co, cl, co
@@ -214,19 +233,34 @@ class Namespace : public detail::Registrar
 
             lua_pushvalue(L, -1); // Stack: ns, co, cl, cl
             lua_rawsetp(L, -3, detail::getClassKey()); // co [classKey] = cl. Stack: ns, co, cl
+
+            if (options.test(disposableClass))
+            {
+                // Disposing ends the lifetime of the object without modifying it, so const objects can be disposed too
+                for (int index : { -2, -3 })
+                {
+                    lua_pushcfunction_x(L, &detail::dispose_metamethod); // Stack: ns, co, cl, function
+                    rawsetfield(L, index, "dispose"); // cl | co ["dispose"] = function. Stack: ns, co, cl
+
+#if LUA_VERSION_NUM >= 504
+                    lua_pushcfunction_x(L, &detail::dispose_metamethod); // Stack: ns, co, cl, function
+                    rawsetfield(L, index, "__close"); // cl | co ["__close"] = function. Stack: ns, co, cl
+#endif
+                }
+            }
         }
 
         //=========================================================================================
         /**
          * @brief Create the static table.
          */
-        void createStaticTable(const char* name, Options options)
+        void createStaticTable(const char* name, Options options, int recordsHint = 0, int propertiesHint = 0)
         {
             LUABRIDGE_ASSERT(name != nullptr);
 
             // Stack: namespace table (ns), const table (co), class table (cl)
             lua_newtable(L); // Stack: ns, co, cl, visible static table (vst)
-            lua_newtable(L); // Stack: ns, co, cl, st, static metatable (st)
+            lua_createtable(L, 0, recordsHint); // Stack: ns, co, cl, st, static metatable (st)
             lua_pushvalue(L, -1); // Stack: ns, co, cl, vst, st, st
             lua_setmetatable(L, -3); // st.__metatable = mt. Stack: ns, co, cl, vst, st
             lua_insert(L, -2); // Stack: ns, co, cl, st, vst
@@ -238,10 +272,10 @@ class Namespace : public detail::Registrar
             lua_pushcfunction_x(L, &detail::newindex_static_metamethod);
             rawsetfield(L, -2, "__newindex");
 
-            lua_newtable(L); // Stack: ns, co, cl, st, proget table (pg)
+            lua_createtable(L, 0, propertiesHint); // Stack: ns, co, cl, st, proget table (pg)
             lua_rawsetp(L, -2, detail::getPropgetKey()); // st [propgetKey] = pg. Stack: ns, co, cl, st
 
-            lua_newtable(L); // Stack: ns, co, cl, st, propset table (ps)
+            lua_createtable(L, 0, propertiesHint); // Stack: ns, co, cl, st, propset table (ps)
             lua_rawsetp(L, -2, detail::getPropsetKey()); // st [propsetKey] = pg. Stack: ns, co, cl, st
 
             lua_pushvalue(L, -2); // Stack: ns, co, cl, st, cl
@@ -265,6 +299,15 @@ class Namespace : public detail::Registrar
             LUABRIDGE_ASSERT(lua_istable(L, -2));
             LUABRIDGE_ASSERT(lua_istable(L, -1));
         }
+
+        //=========================================================================================
+        /**
+         * @brief Name the binding closure on top of the stack after the class, when profiling is enabled.
+         */
+        void nameBinding(const char* name, const char* suffix = nullptr) const
+        {
+            detail::name_binding(L, -3, name, suffix); // Stack: co, cl, st, closure
+        }
     };
 
     //=============================================================================================
@@ -289,8 +332,9 @@ class Namespace : public detail::Registrar
          * @param name   The new class name.
          * @param parent A parent namespace object.
          * @param options Class options.
+         * @param sizes Number of members that will be registered, used to presize the class tables.
          */
-        Class(const char* name, Namespace& parent, Options options)
+        Class(const char* name, Namespace& parent, Options options, const detail::ClassTableSizes& sizes = {})
             : ClassBase(parent)
         {
             LUABRIDGE_ASSERT(name != nullptr);
@@ -302,16 +346,20 @@ class Namespace : public detail::Registrar
             {
                 lua_pop(L, 1); // Stack: ns
 
-                createConstTable(name, true, options); // Stack: ns, const table (co)
-#if !defined(LUABRIDGE_ON_LUAU)
+                createConstTable(name, true, options, sizes.constRecords, sizes.properties); // Stack: ns, const table (co)
                 lua_pushcfunction_x(L, &detail::gc_metamethod<T>); // Stack: ns, co, function
+#if LUABRIDGE_ON_LUAU
+                lua_rawsetp(L, -2, detail::getDestroyKey()); // co [destroyKey] = function. Stack: ns, co
+#else
                 rawsetfield(L, -2, "__gc"); // co ["__gc"] = function. Stack: ns, co
 #endif
                 ++m_stackSize;
 
-                createClassTable(name, options); // Stack: ns, co, class table (cl)
-#if !defined(LUABRIDGE_ON_LUAU)
+                createClassTable(name, options, sizes.classRecords, sizes.properties); // Stack: ns, co, class table (cl)
                 lua_pushcfunction_x(L, &detail::gc_metamethod<T>); // Stack: ns, co, cl, function
+#if LUABRIDGE_ON_LUAU
+                lua_rawsetp(L, -2, detail::getDestroyKey()); // cl [destroyKey] = function. Stack: ns, co, cl
+#else
                 rawsetfield(L, -2, "__gc"); // cl ["__gc"] = function. Stack: ns, co, cl
 #endif
 
@@ -319,7 +367,7 @@ class Namespace : public detail::Registrar
                 rawsetfield(L, -2, "__tostring");
                 ++m_stackSize;
 
-                createStaticTable(name, options); // Stack: ns, co, cl, st
+                createStaticTable(name, options, sizes.staticRecords, sizes.staticProperties); // Stack: ns, co, cl, st
                 ++m_stackSize;
 
                 // Map T back to its tables.
@@ -365,30 +413,36 @@ class Namespace : public detail::Registrar
          * @param name The class name.
          * @param parent A parent namespace object.
          * @param staticKey Key where the class is stored.
+         * @param options Class options.
+         * @param sizes Number of members that will be registered, used to presize the class tables.
         */
-        Class(const char* name, Namespace& parent, const void* const staticKey, Options options)
+        Class(const char* name, Namespace& parent, const void* const staticKey, Options options, const detail::ClassTableSizes& sizes = {})
             : ClassBase(parent)
         {
             LUABRIDGE_ASSERT(name != nullptr);
             LUABRIDGE_ASSERT(lua_istable(L, -1)); // Stack: namespace table (ns)
 
-            createConstTable(name, true, options); // Stack: ns, const table (co)
-#if !defined(LUABRIDGE_ON_LUAU)
+            createConstTable(name, true, options, sizes.constRecords, sizes.properties); // Stack: ns, const table (co)
             lua_pushcfunction_x(L, &detail::gc_metamethod<T>); // Stack: ns, co, function
+#if LUABRIDGE_ON_LUAU
+            lua_rawsetp(L, -2, detail::getDestroyKey()); // co [destroyKey] = function. Stack: ns, co
+#else
             rawsetfield(L, -2, "__gc"); // co ["__gc"] = function. Stack: ns, co
 #endif
             ++m_stackSize;
 
-            createClassTable(name, options); // Stack: ns, co, class table (cl)
-#if !defined(LUABRIDGE_ON_LUAU)
+            createClassTable(name, options, sizes.classRecords, sizes.properties); // Stack: ns, co, class table (cl)
             lua_pushcfunction_x(L, &detail::gc_metamethod<T>); // Stack: ns, co, cl, function
+#if LUABRIDGE_ON_LUAU
+            lua_rawsetp(L, -2, detail::getDestroyKey()); // cl [destroyKey] = function. Stack: ns, co, cl
+#else
             rawsetfield(L, -2, "__gc"); // cl ["__gc"] = function. Stack: ns, co, cl
 #endif
             lua_pushcfunction_x(L, &detail::tostring_metamethod<T>);
             rawsetfield(L, -2, "__tostring");
             ++m_stackSize;
 
-            createStaticTable(name, options); // Stack: ns, co, cl, st
+            createStaticTable(name, options, sizes.staticRecords, sizes.staticProperties); // Stack: ns, co, cl, st
             ++m_stackSize;
 
             lua_rawgetp(L, LUA_REGISTRYINDEX, staticKey); // Stack: ns, co, cl, st, parent st (pst) | nil
@@ -441,6 +495,11 @@ class Namespace : public detail::Registrar
         {
             LUABRIDGE_ASSERT(m_stackSize > 3);
 
+#if LUABRIDGE_ON_LUAU
+            detail::build_namecall_atoms(L, -3); // Stack: co, cl, st
+            detail::build_namecall_atoms(L, -2); // Stack: co, cl, st
+#endif
+
             m_stackSize -= 3;
             lua_pop(L, 3);
             return Namespace(*this);
@@ -466,6 +525,7 @@ class Namespace : public detail::Registrar
 
             lua_pushlightuserdata(L, const_cast<U*>(value)); // Stack: co, cl, st, pointer
             lua_pushcclosure_x(L, &detail::property_getter<U>::call, 1); // Stack: co, cl, st, getter
+            nameBinding(name, "get");
             detail::add_property_getter(L, name, -2); // Stack: co, cl, st
 
             lua_pushstring(L, name); // Stack: co, cl, st, name
@@ -495,12 +555,14 @@ class Namespace : public detail::Registrar
 
             lua_pushlightuserdata(L, value); // Stack: co, cl, st, pointer
             lua_pushcclosure_x(L, &detail::property_getter<U>::call, 1); // Stack: co, cl, st, getter
+            nameBinding(name, "get");
             detail::add_property_getter(L, name, -2); // Stack: co, cl, st
 
             if (isWritable)
             {
                 lua_pushlightuserdata(L, value); // Stack: co, cl, st, ps, pointer
                 lua_pushcclosure_x(L, &detail::property_setter<U>::call, 1); // Stack: co, cl, st, ps, setter
+                nameBinding(name, "set");
             }
             else
             {
@@ -533,12 +595,14 @@ class Namespace : public detail::Registrar
 
             lua_pushlightuserdata(L, reinterpret_cast<void*>(get)); // Stack: co, cl, st, function ptr
             lua_pushcclosure_x(L, &detail::invoke_proxy_function<U (*)()>, 1); // Stack: co, cl, st, getter
+            nameBinding(name, "get");
             detail::add_property_getter(L, name, -2); // Stack: co, cl, st
 
             if (set != nullptr)
             {
                 lua_pushlightuserdata(L, reinterpret_cast<void*>(set)); // Stack: co, cl, st, function ptr
                 lua_pushcclosure_x(L, &detail::invoke_proxy_function<void (*)(U)>, 1); // Stack: co, cl, st, setter
+                nameBinding(name, "set");
             }
             else
             {
@@ -559,12 +623,14 @@ class Namespace : public detail::Registrar
 
             lua_pushlightuserdata(L, reinterpret_cast<void*>(get)); // Stack: co, cl, st, function ptr
             lua_pushcclosure_x(L, &detail::invoke_proxy_function<U (*)() noexcept>, 1); // Stack: co, cl, st, getter
+            nameBinding(name, "get");
             detail::add_property_getter(L, name, -2); // Stack: co, cl, st
 
             if (set != nullptr)
             {
                 lua_pushlightuserdata(L, reinterpret_cast<void*>(set)); // Stack: co, cl, st, function ptr
                 lua_pushcclosure_x(L, &detail::invoke_proxy_function<void (*)(U) noexcept>, 1); // Stack: co, cl, st, setter
+                nameBinding(name, "set");
             }
             else
             {
@@ -591,6 +657,7 @@ class Namespace : public detail::Registrar
 
             lua_newuserdata_aligned<GetType>(L, std::move(get)); // Stack: co, cl, st, function userdata (ud)
             lua_pushcclosure_x(L, &detail::invoke_proxy_functor<GetType>, 1); // Stack: co, cl, st, function
+            nameBinding(name, "get");
             detail::add_property_getter(L, name, -2); // Stack: co, cl, st
 
             return *this;
@@ -607,10 +674,12 @@ class Namespace : public detail::Registrar
 
             lua_newuserdata_aligned<GetType>(L, std::move(get)); // Stack: co, cl, st, function userdata (ud)
             lua_pushcclosure_x(L, &detail::invoke_proxy_functor<GetType>, 1); // Stack: co, cl, st, function
+            nameBinding(name, "get");
             detail::add_property_getter(L, name, -2); // Stack: co, cl, st
 
             lua_newuserdata_aligned<SetType>(L, std::move(set)); // Stack: co, cl, st, function userdata (ud)
             lua_pushcclosure_x(L, &detail::invoke_proxy_functor<SetType>, 1); // Stack: co, cl, st, function
+            nameBinding(name, "set");
             detail::add_property_setter(L, name, -2); // Stack: co, cl, st
 
             return *this;
@@ -636,8 +705,17 @@ class Namespace : public detail::Registrar
             {
                 ([&]
                 {
+                    if constexpr (detail::is_ffi_function_v<Functions>)
+                    {
+                        if (detail::get_class_options(L, -2).test(ffiFunctions) && detail::push_ffi_function(L, functions))
+                            return;
+                    }
+
                     detail::push_function(L, std::move(functions));
 
+                    if constexpr (! detail::is_cfunction_pointer_v<Functions>)
+                        nameBinding(name);
+
                 } (), ...);
             }
             else
@@ -666,6 +744,7 @@ class Namespace : public detail::Registrar
                 } (), ...);
 
                 lua_pushcclosure_x(L, &detail::try_overload_functions<false>, 1);
+                nameBinding(name);
             }
 
             rawsetfield(L, -2, name);
@@ -689,6 +768,7 @@ class Namespace : public detail::Registrar
 
             new (lua_newuserdata_x<MemberPtrType>(L, sizeof(MemberPtrType))) MemberPtrType(mp); // Stack: co, cl, st, field ptr
             lua_pushcclosure_x(L, &detail::property_getter<U, T>::call, 1); // Stack: co, cl, st, getter
+            nameBinding(name, "get");
             lua_pushvalue(L, -1); // Stack: co, cl, st, getter, getter
             detail::add_property_getter(L, name, -5); // Stack: co, cl, st, getter
             detail::add_property_getter(L, name, -3); // Stack: co, cl, st
@@ -697,6 +777,7 @@ class Namespace : public detail::Registrar
             {
                 new (lua_newuserdata_x<MemberPtrType>(L, sizeof(MemberPtrType))) MemberPtrType(mp); // Stack: co, cl, st, field ptr
                 lua_pushcclosure_x(L, &detail::property_setter<U, T>::call, 1); // Stack: co, cl, st, setter
+                nameBinding(name, "set");
                 detail::add_property_setter(L, name, -3); // Stack: co, cl, st
             }
 
@@ -718,6 +799,7 @@ class Namespace : public detail::Registrar
 
             new (lua_newuserdata_x<GetType>(L, sizeof(GetType))) GetType(get); // Stack: co, cl, st, function ptr
             lua_pushcclosure_x(L, &detail::invoke_const_member_function<GetType, T>, 1); // Stack: co, cl, st, getter
+            nameBinding(name, "get");
             lua_pushvalue(L, -1); // Stack: co, cl, st, getter, getter
             detail::add_property_getter(L, name, -5); // Stack: co, cl, st, getter
             detail::add_property_getter(L, name, -3); // Stack: co, cl, st
@@ -726,6 +808,7 @@ class Namespace : public detail::Registrar
             {
                 new (lua_newuserdata_x<SetType>(L, sizeof(SetType))) SetType(set); // Stack: co, cl, st, function ptr
                 lua_pushcclosure_x(L, &detail::invoke_member_function<SetType, T>, 1); // Stack: co, cl, st, setter
+                nameBinding(name, "set");
                 detail::add_property_setter(L, name, -3); // Stack: co, cl, st
             }
 
@@ -743,6 +826,7 @@ class Namespace : public detail::Registrar
 
             new (lua_newuserdata_x<GetType>(L, sizeof(GetType))) GetType(get); // Stack: co, cl, st, function ptr
             lua_pushcclosure_x(L, &detail::invoke_const_member_function<GetType, T>, 1); // Stack: co, cl, st, getter
+            nameBinding(name, "get");
             lua_pushvalue(L, -1); // Stack: co, cl, st, getter, getter
             detail::add_property_getter(L, name, -5); // Stack: co, cl, st, getter
             detail::add_property_getter(L, name, -3); // Stack: co, cl, st
@@ -751,6 +835,7 @@ class Namespace : public detail::Registrar
             {
                 new (lua_newuserdata_x<SetType>(L, sizeof(SetType))) SetType(set); // Stack: co, cl, st, function ptr
                 lua_pushcclosure_x(L, &detail::invoke_member_function<SetType, T>, 1); // Stack: co, cl, st, setter
+                nameBinding(name, "set");
                 detail::add_property_setter(L, name, -3); // Stack: co, cl, st
             }
 
@@ -772,6 +857,7 @@ class Namespace : public detail::Registrar
 
             new (lua_newuserdata_x<GetType>(L, sizeof(GetType))) GetType(get); // Stack: co, cl, st, function ptr
             lua_pushcclosure_x(L, &detail::invoke_const_member_function<GetType, T>, 1); // Stack: co, cl, st, getter
+            nameBinding(name, "get");
             lua_pushvalue(L, -1); // Stack: co, cl, st, getter, getter
             detail::add_property_getter(L, name, -5); // Stack: co, cl, st, getter
             detail::add_property_getter(L, name, -3); // Stack: co, cl, st
@@ -780,6 +866,7 @@ class Namespace : public detail::Registrar
             {
                 new (lua_newuserdata_x<SetType>(L, sizeof(SetType))) SetType(set); // Stack: co, cl, st, function ptr
                 lua_pushcclosure_x(L, &detail::invoke_member_function<SetType, T>, 1); // Stack: co, cl, st, setter
+                nameBinding(name, "set");
                 detail::add_property_setter(L, name, -3); // Stack: co, cl, st
             }
 
@@ -797,6 +884,7 @@ class Namespace : public detail::Registrar
 
             new (lua_newuserdata_x<GetType>(L, sizeof(GetType))) GetType(get); // Stack: co, cl, st, function ptr
             lua_pushcclosure_x(L, &detail::invoke_const_member_function<GetType, T>, 1); // Stack: co, cl, st, getter
+            nameBinding(name, "get");
             lua_pushvalue(L, -1); // Stack: co, cl, st, getter, getter
             detail::add_property_getter(L, name, -5); // Stack: co, cl, st, getter
             detail::add_property_getter(L, name, -3); // Stack: co, cl, st
@@ -805,6 +893,7 @@ class Namespace : public detail::Registrar
             {
                 new (lua_newuserdata_x<SetType>(L, sizeof(SetType))) SetType(set); // Stack: co, cl, st, function ptr
                 lua_pushcclosure_x(L, &detail::invoke_member_function<SetType, T>, 1); // Stack: co, cl, st, setter
+                nameBinding(name, "set");
                 detail::add_property_setter(L, name, -3); // Stack: co, cl, st
             }
 
@@ -828,6 +917,7 @@ class Namespace : public detail::Registrar
 
             lua_pushlightuserdata(L, reinterpret_cast<void*>(get)); // Stack: co, cl, st, function ptr
             lua_pushcclosure_x(L, &detail::invoke_proxy_function<TG (*)(const T*)>, 1); // Stack: co, cl, st, getter
+            nameBinding(name, "get");
             lua_pushvalue(L, -1); // Stack: co, cl, st,, getter, getter
             detail::add_property_getter(L, name, -5); // Stack: co, cl, st, getter
             detail::add_property_getter(L, name, -3); // Stack: co, cl, st
@@ -836,6 +926,7 @@ class Namespace : public detail::Registrar
             {
                 lua_pushlightuserdata( L, reinterpret_cast<void*>(set)); // Stack: co, cl, st, function ptr
                 lua_pushcclosure_x(L, &detail::invoke_proxy_function<void (*)(T*, TS)>, 1); // Stack: co, cl, st, setter
+                nameBinding(name, "set");
                 detail::add_property_setter(L, name, -3); // Stack: co, cl, st
             }
 
@@ -850,6 +941,7 @@ class Namespace : public detail::Registrar
 
             lua_pushlightuserdata(L, reinterpret_cast<void*>(get)); // Stack: co, cl, st, function ptr
             lua_pushcclosure_x(L, &detail::invoke_proxy_function<TG (*)(const T*) noexcept>, 1); // Stack: co, cl, st, getter
+            nameBinding(name, "get");
             lua_pushvalue(L, -1); // Stack: co, cl, st,, getter, getter
             detail::add_property_getter(L, name, -5); // Stack: co, cl, st, getter
             detail::add_property_getter(L, name, -3); // Stack: co, cl, st
@@ -858,6 +950,7 @@ class Namespace : public detail::Registrar
             {
                 lua_pushlightuserdata( L, reinterpret_cast<void*>(set)); // Stack: co, cl, st, function ptr
                 lua_pushcclosure_x(L, &detail::invoke_proxy_function<void (*)(T*, TS) noexcept>, 1); // Stack: co, cl, st, setter
+                nameBinding(name, "set");
                 detail::add_property_setter(L, name, -3); // Stack: co, cl, st
             }
 
@@ -910,6 +1003,7 @@ class Namespace : public detail::Registrar
 
             lua_newuserdata_aligned<GetType>(L, std::move(get)); // Stack: co, cl, st, function userdata (ud)
             lua_pushcclosure_x(L, &detail::invoke_proxy_functor<GetType>, 1); // Stack: co, cl, st, getter
+            nameBinding(name, "get");
             lua_pushvalue(L, -1); // Stack: co, cl, st, getter, getter
             detail::add_property_getter(L, name, -4); // Stack: co, cl, st, getter
             detail::add_property_getter(L, name, -4); // Stack: co, cl, st
@@ -932,6 +1026,7 @@ class Namespace : public detail::Registrar
 
             lua_newuserdata_aligned<SetType>(L, std::move(set)); // Stack: co, cl, st, function userdata (ud)
             lua_pushcclosure_x(L, &detail::invoke_proxy_functor<SetType>, 1); // Stack: co, cl, st, setter
+            nameBinding(name, "set");
             detail::add_property_setter(L, name, -3); // Stack: co, cl, st
 
             return *this;
@@ -965,6 +1060,9 @@ class Namespace : public detail::Registrar
                 {
                     detail::push_member_function<T>(L, std::move(functions));
 
+                    if constexpr (! detail::is_cfunction_pointer_v<Functions>)
+                        nameBinding(name);
+
                 } (), ...);
 
                 if constexpr (detail::const_functions_count<T, Functions...> == 1)
@@ -1011,6 +1109,7 @@ class Namespace : public detail::Registrar
                     LUABRIDGE_ASSERT(idx > 1);
 
                     lua_pushcclosure_x(L, &detail::try_overload_functions<true>, 1);
+                    nameBinding(name);
                     lua_pushvalue(L, -1); // Stack: co, cl, st, function, function
                     rawsetfield(L, -4, name); // Stack: co, cl, st, function
                     rawsetfield(L, -4, name); // Stack: co, cl, st
@@ -1047,6 +1146,7 @@ class Namespace : public detail::Registrar
                     LUABRIDGE_ASSERT(idx > 1);
 
                     lua_pushcclosure_x(L, &detail::try_overload_functions<true>, 1);
+                    nameBinding(name);
                     rawsetfield(L, -3, name); // Stack: co, cl, st
                 }
             }
@@ -1101,6 +1201,7 @@ class Namespace : public detail::Registrar
                 lua_pushcclosure_x(L, &detail::try_overload_functions<true>, 1);
             }
 
+            nameBinding("__call");
             rawsetfield(L, -2, "__call");
 
             return *this;
@@ -1165,6 +1266,7 @@ class Namespace : public detail::Registrar
                 lua_pushcclosure_x(L, &detail::try_overload_functions<true>, 1);
             }
 
+            nameBinding("__call");
             rawsetfield(L, -2, "__call"); // Stack: co, cl, st
 
             return *this;
@@ -1212,6 +1314,7 @@ class Namespace : public detail::Registrar
                 lua_pushcclosure_x(L, &detail::try_overload_functions<true>, 1);
             }
 
+            nameBinding("__call");
             rawsetfield(L, -2, "__call");
 
             return *this;
@@ -1272,6 +1375,7 @@ class Namespace : public detail::Registrar
                 lua_pushcclosure_x(L, &detail::try_overload_functions<true>, 1);
             }
 
+            nameBinding("__call");
             rawsetfield(L, -2, "__call"); // Stack: co, cl, st
 
             return *this;
@@ -1295,6 +1399,7 @@ class Namespace : public detail::Registrar
 
             lua_newuserdata_aligned<F>(L, F(std::move(allocator), std::move(deallocator))); // Stack: co, cl, st, upvalue
             lua_pushcclosure_x(L, &detail::invoke_proxy_constructor<F>, 1); // Stack: co, cl, st, function
+            nameBinding("__call");
             rawsetfield(L, -2, "__call"); // Stack: co, cl, st
 
             return *this;
@@ -1309,6 +1414,7 @@ class Namespace : public detail::Registrar
         template <class Function>
         auto addIndexMetaMethod(Function function)
             -> std::enable_if_t<!std::is_pointer_v<Function>
+                && !detail::is_typed_fallback_v<Function>
                 && std::is_invocable_v<Function, T&, const LuaRef&, lua_State*>, Class<T>&>
         {
             using FnType = decltype(function);
@@ -1348,6 +1454,39 @@ class Namespace : public detail::Registrar
             return *this;
         }
 
+        //=========================================================================================
+        /**
+         * @brief Add a typed index metamethod fallback, receiving the key as a string view and pushing its result directly.
+         *
+         * The fallback pushes its result on the stack and returns the number of values pushed: returning zero, or pushing nil, continues
+         * the lookup in the parent classes. It's called directly by the __index metamethod for string keys, without references to the
+         * key and the result or an additional lua_call. The view points into the interned lua string of the key. A const member function
+         * fallback is used for const objects as well.
+         */
+        template <class Function>
+        auto addIndexMetaMethod(Function function)
+            -> std::enable_if_t<!std::is_pointer_v<Function>
+                && detail::is_typed_fallback_v<Function>
+                && std::is_invocable_r_v<int, Function, T&, std::string_view, lua_State*>, Class<T>&>
+        {
+            return addTypedIndexFallback(std::move(function));
+        }
+
+        Class<T>& addIndexMetaMethod(int (*idxf)(T&, std::string_view, lua_State*))
+        {
+            return addTypedIndexFallback(idxf);
+        }
+
+        Class<T>& addIndexMetaMethod(int (T::* idxf)(std::string_view, lua_State*))
+        {
+            return addTypedIndexFallback(idxf);
+        }
+
+        Class<T>& addIndexMetaMethod(int (T::* idxf)(std::string_view, lua_State*) const)
+        {
+            return addTypedIndexFallback(idxf);
+        }
+
         //=========================================================================================
         /**
          * @brief Add an insert index metamethod function fallback that is triggered when no result is found in functions, properties or any other members.
@@ -1357,6 +1496,7 @@ class Namespace : public detail::Registrar
         template <class Function>
         auto addNewIndexMetaMethod(Function function)
             -> std::enable_if_t<!std::is_pointer_v<Function>
+                && !detail::is_typed_fallback_v<Function>
                 && std::is_invocable_v<Function, T&, const LuaRef&, const LuaRef&, lua_State*>, Class<T>&>
         {
             using FnType = decltype(function);
@@ -1395,6 +1535,162 @@ class Namespace : public detail::Registrar
 
             return *this;
         }
+
+        //=========================================================================================
+        /**
+         * @brief Add a typed new index metamethod fallback, receiving the key as a string view and the new value on top of the stack.
+         *
+         * The fallback reads the value with `Stack` from the top of the stack. It's called directly by the __newindex metamethod for
+         * string keys, without references to the key and the value or an additional lua_call.
+         */
+        template <class Function>
+        auto addNewIndexMetaMethod(Function function)
+            -> std::enable_if_t<!std::is_pointer_v<Function>
+                && detail::is_typed_fallback_v<Function>
+                && std::is_invocable_v<Function, T&, std::string_view, lua_State*>, Class<T>&>
+        {
+            return addTypedNewIndexFallback(std::move(function));
+        }
+
+        Class<T>& addNewIndexMetaMethod(void (*idxf)(T&, std::string_view, lua_State*))
+        {
+            return addTypedNewIndexFallback(idxf);
+        }
+
+        Class<T>& addNewIndexMetaMethod(void (T::* idxf)(std::string_view, lua_State*))
+        {
+            return addTypedNewIndexFallback(idxf);
+        }
+
+        //=========================================================================================
+        /**
+         * @brief Allow objects of the class to be copied to other states with `luabridge::transfer`.
+         *
+         * The copy is made with the copy constructor, and pushed with the class registered in the destination state.
+         */
+        Class<T>& addTransfer()
+        {
+            static_assert(std::is_copy_constructible_v<T>, "Transferred objects must be copy constructible, provide a transfer hook instead");
+
+            return addTransfer([](const T& object, lua_State* to) { return Stack<T>::push(to, object); });
+        }
+
+        /**
+         * @brief Set the hook used by `luabridge::transfer` to copy or move objects of the class to other states.
+         *
+         * The hook receives the object and the destination state, and on success it must push exactly one value on the destination.
+         * The hook is not inherited by derived classes.
+         */
+        template <class Function>
+        auto addTransfer(Function function)
+            -> std::enable_if_t<std::is_invocable_r_v<Result, Function, const T&, lua_State*>, Class<T>&>
+        {
+            assertStackState(); // Stack: const table (co), class table (cl), static table (st)
+
+            auto hook = [function = std::move(function)](const void* object, lua_State* to) -> Result
+            {
+                return function(*static_cast<const T*>(object), to);
+            };
+
+            lua_newuserdata_aligned<detail::TransferHook>(L, detail::TransferHook{ std::move(hook) }); // Stack: co, cl, st, hook
+            lua_pushcclosure_x(L, &detail::transfer_hook_holder, 1); // Stack: co, cl, st, holder
+            lua_pushvalue(L, -1); // Stack: co, cl, st, holder, holder
+            lua_rawsetp(L, -5, detail::getTransferKey()); // co [transferKey] = holder. Stack: co, cl, st, holder
+            lua_rawsetp(L, -3, detail::getTransferKey()); // cl [transferKey] = holder. Stack: co, cl, st
+
+            return *this;
+        }
+
+        //=========================================================================================
+        /**
+         * @brief Allow objects of the class to be serialized with `luabridge::serialize`, by copying their bytes.
+         *
+         * The bytes are copied back into a value initialized object, which is pushed with the class registered in the deserializing
+         * state. The format depends on the layout and byte order of the platform, and objects holding pointers can't be restored.
+         */
+        Class<T>& addSerializer()
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "Serialized objects must be trivially copyable, provide serialization hooks instead");
+            static_assert(std::is_default_constructible_v<T>, "Serialized objects must be default constructible, provide serialization hooks instead");
+
+            return addSerializer(
+                [](const T& object, SerializationWriter& writer) { writer.writeValue(object); },
+                [](SerializationReader& reader, lua_State* L) -> Result
+                {
+                    T object{};
+                    if (! reader.readValue(object))
+                        return makeErrorCode(ErrorCode::InvalidSerializedData);
+
+                    return Stack<T>::push(L, object);
+                });
+        }
+
+        /**
+         * @brief Set the hooks used by `luabridge::serialize` and `luabridge::deserialize` for objects of the class.
+         *
+         * The serializer writes the object state, the deserializer reads it back and on success it must push exactly one value. Objects
+         * are matched by class name when deserialized, so the names of serializable classes must be unique. The hooks are not inherited
+         * by derived classes.
+         */
+        template <class Serializer, class Deserializer>
+        auto addSerializer(Serializer serializer, Deserializer deserializer)
+            -> std::enable_if_t<std::is_invocable_v<Serializer, const T&, SerializationWriter&>
+                    && std::is_invocable_r_v<Result, Deserializer, SerializationReader&, lua_State*>, Class<T>&>
+        {
+            assertStackState(); // Stack: const table (co), class table (cl), static table (st)
+
+            auto serializeHook = [serializer = std::move(serializer)](const void* object, SerializationWriter& writer)
+            {
+                serializer(*static_cast<const T*>(object), writer);
+            };
+
+            lua_newuserdata_aligned<detail::SerializationHook>(
+                L, detail::SerializationHook{ std::move(serializeHook), std::move(deserializer) }); // Stack: co, cl, st, hook
+            lua_rawgetp(L, -3, detail::getTypeKey()); // Stack: co, cl, st, hook, name
+            lua_pushcclosure_x(L, &detail::serialization_hook_holder, 2); // Stack: co, cl, st, holder
+            lua_pushvalue(L, -1); // Stack: co, cl, st, holder, holder
+            lua_rawsetp(L, -5, detail::getSerializeKey()); // co [serializeKey] = holder. Stack: co, cl, st, holder
+            lua_pushvalue(L, -1); // Stack: co, cl, st, holder, holder
+            lua_rawsetp(L, -4, detail::getSerializeKey()); // cl [serializeKey] = holder. Stack: co, cl, st, holder
+
+            detail::push_serializers_table(L); // Stack: co, cl, st, holder, serializers (se)
+            lua_rawgetp(L, -4, detail::getTypeKey()); // Stack: co, cl, st, holder, se, name
+            lua_pushvalue(L, -3); // Stack: co, cl, st, holder, se, name, holder
+            lua_rawset(L, -3); // se [name] = holder. Stack: co, cl, st, holder, se
+            lua_pop(L, 2); // Stack: co, cl, st
+
+            return *this;
+        }
+
+    private:
+        template <class Function>
+        Class<T>& addTypedIndexFallback(Function function)
+        {
+            assertStackState(); // Stack: const table (co), class table (cl), static table (st)
+
+            detail::push_typed_fallback(L, std::move(function), &detail::invoke_typed_index_fallback<T, Function>); // Stack: co, cl, st, tfb
+
+            if constexpr (detail::is_const_member_function_pointer_v<Function>)
+            {
+                lua_pushvalue(L, -1); // Stack: co, cl, st, tfb, tfb
+                lua_rawsetp(L, -5, detail::getIndexFallbackKey()); // co [indexFallbackKey] = tfb. Stack: co, cl, st, tfb
+            }
+
+            lua_rawsetp(L, -3, detail::getIndexFallbackKey()); // cl [indexFallbackKey] = tfb. Stack: co, cl, st
+
+            return *this;
+        }
+
+        template <class Function>
+        Class<T>& addTypedNewIndexFallback(Function function)
+        {
+            assertStackState(); // Stack: const table (co), class table (cl), static table (st)
+
+            detail::push_typed_fallback(L, std::move(function), &detail::invoke_typed_newindex_fallback<T, Function>); // Stack: co, cl, st, tfb
+            lua_rawsetp(L, -3, detail::getNewIndexFallbackKey()); // cl [newIndexFallbackKey] = tfb. Stack: co, cl, st
+
+            return *this;
+        }
     };
 
     class Table : public detail::Registrar
@@ -1426,6 +1722,7 @@ class Namespace : public detail::Registrar
 
             lua_newuserdata_aligned<FnType>(L, std::move(function)); // Stack: ns, function userdata (ud)
             lua_pushcclosure_x(L, &detail::invoke_proxy_functor<FnType>, 1); // Stack: ns, function
+            detail::name_binding(L, 0, name);
             rawsetfield(L, -3, name); // Stack: ns
 
             return *this;
@@ -1441,6 +1738,7 @@ class Namespace : public detail::Registrar
 
             lua_newuserdata_aligned<FnType>(L, std::move(function)); // Stack: ns, function userdata (ud)
             lua_pushcclosure_x(L, &detail::invoke_proxy_functor<FnType>, 1); // Stack: ns, function
+            detail::name_binding(L, 0, name);
             rawsetfield(L, -2, name); // Stack: ns
 
             return *this;
@@ -1720,12 +2018,14 @@ public:
 
         lua_pushlightuserdata(L, value); // Stack: ns, pointer
         lua_pushcclosure_x(L, &detail::property_getter<T>::call, 1); // Stack: ns, getter
+        detail::name_binding(L, 0, name, "get");
         detail::add_property_getter(L, name, -2); // Stack: ns
 
         if (isWritable)
         {
             lua_pushlightuserdata(L, value); // Stack: ns, pointer
             lua_pushcclosure_x(L, &detail::property_setter<T>::call, 1); // Stack: ns, setter
+            detail::name_binding(L, 0, name, "set");
         }
         else
         {
@@ -1762,6 +2062,7 @@ public:
 
         lua_pushlightuserdata(L, const_cast<T*>(value)); // Stack: ns, pointer
         lua_pushcclosure_x(L, &detail::property_getter<T>::call, 1); // Stack: ns, getter
+        detail::name_binding(L, 0, name, "get");
         detail::add_property_getter(L, name, -2); // Stack: ns
 
         lua_pushstring(L, name); // Stack: ns, ps, name
@@ -1799,12 +2100,14 @@ public:
 
         lua_pushlightuserdata(L, reinterpret_cast<void*>(get)); // Stack: ns, function ptr
         lua_pushcclosure_x(L, &detail::invoke_proxy_function<TG (*)()>, 1); // Stack: ns, getter
+        detail::name_binding(L, 0, name, "get");
         detail::add_property_getter(L, name, -2);
 
         if (set != nullptr)
         {
             lua_pushlightuserdata(L, reinterpret_cast<void*>(set)); // Stack: ns, function ptr
             lua_pushcclosure_x(L, &detail::invoke_proxy_function<void (*)(TS)>, 1);
+            detail::name_binding(L, 0, name, "set");
         }
         else
         {
@@ -1832,12 +2135,14 @@ public:
 
         lua_pushlightuserdata(L, reinterpret_cast<void*>(get)); // Stack: ns, function ptr
         lua_pushcclosure_x(L, &detail::invoke_proxy_function<TG (*)() noexcept>, 1); // Stack: ns, getter
+        detail::name_binding(L, 0, name, "get");
         detail::add_property_getter(L, name, -2);
 
         if (set != nullptr)
         {
             lua_pushlightuserdata(L, reinterpret_cast<void*>(set)); // Stack: ns, function ptr
             lua_pushcclosure_x(L, &detail::invoke_proxy_function<void (*)(TS) noexcept>, 1);
+            detail::name_binding(L, 0, name, "set");
         }
         else
         {
@@ -1868,6 +2173,7 @@ public:
         using GetType = decltype(get);
         lua_newuserdata_aligned<GetType>(L, std::move(get)); // Stack: ns, function userdata (ud)
         lua_pushcclosure_x(L, &detail::invoke_proxy_functor<GetType>, 1); // Stack: ns, ud, getter
+        detail::name_binding(L, 0, name, "get");
 
         detail::add_property_getter(L, name, -2); // Stack: ns, ud, getter
 
@@ -1903,6 +2209,7 @@ public:
 
         lua_newuserdata_aligned<SetType>(L, std::move(set)); // Stack: ns, function userdata (ud)
         lua_pushcclosure_x(L, &detail::invoke_proxy_functor<SetType>, 1); // Stack: ns, ud, getter
+        detail::name_binding(L, 0, name, "set");
         detail::add_property_setter(L, name, -2); // Stack: ns, ud, getter
 
         return *this;
@@ -1965,6 +2272,9 @@ public:
             {
                 detail::push_function(L, std::move(functions));
 
+                if constexpr (! detail::is_cfunction_pointer_v<Functions>)
+                    detail::name_binding(L, 0, name);
+
             } (), ...);
         }
         else
@@ -1993,6 +2303,7 @@ public:
             } (), ...);
 
             lua_pushcclosure_x(L, &detail::try_overload_functions<false>, 1);
+            detail::name_binding(L, 0, name);
         }
 
         rawsetfield(L, -2, name);
@@ -2000,6 +2311,38 @@ public:
         return *this;
     }
 
+    //=============================================================================================
+    /**
+     * @brief Add or replace a function, exposing it through the LuaJIT FFI when possible.
+     *
+     * On LuaJIT, plain function pointers whose arguments and result are converted by the FFI exactly like the classic binding does (see
+     * `detail::is_ffi_function_v`) are registered as FFI cdata, so calls can be compiled in JIT traces. Any other function, or any other
+     * Lua flavour, falls back to `addFunction`.
+     *
+     * @param name The function name.
+     * @param function The function that will be invoked.
+     *
+     * @returns This namespace registration object.
+     */
+    template <class Function>
+    auto addFfiFunction(const char* name, Function function)
+        -> std::enable_if_t<detail::is_callable_v<Function>, Namespace&>
+    {
+        LUABRIDGE_ASSERT(name != nullptr);
+        LUABRIDGE_ASSERT(lua_istable(L, -1)); // Stack: namespace table (ns)
+
+        if constexpr (detail::is_ffi_function_v<Function>)
+        {
+            if (detail::push_ffi_function(L, function)) // Stack: ns, cdata
+            {
+                rawsetfield(L, -2, name);
+                return *this;
+            }
+        }
+
+        return addFunction(name, std::move(function));
+    }
+
     //=============================================================================================
     Table beginTable(const char* name)
     {
@@ -2040,6 +2383,30 @@ public:
         assertIsActive();
         return Class<Derived>(name, *this, detail::getStaticRegistryKey<Base>(), options);
     }
+
+    //=============================================================================================
+    /**
+     * @brief Register a class described by a compile time schema.
+     *
+     * This is a presizing hint: the class tables are created with room for the members listed in the schema, then the members are
+     * registered in order through the same `Class<T>` methods used by `beginClass`.
+     *
+     * @param schema The class schema, as returned by `classSchema`.
+     * @param options The class options.
+     *
+     * @returns A namespace registration object.
+     */
+    template <class T, class... Members>
+    Namespace addClass(const ClassSchema<T, Members...>& schema, Options options = defaultOptions)
+    {
+        assertIsActive();
+
+        Class<T> cls(schema.name(), *this, options, schema.sizes());
+
+        std::apply([&cls](const auto&... members) { (members.registerInto(cls), ...); }, schema.members());
+
+        return cls.endClass();
+    }
 };
 
 //=================================================================================================
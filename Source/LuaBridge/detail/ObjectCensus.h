@@ -0,0 +1,283 @@
+// https://github.com/kunitoki/LuaBridge3
+// Copyright 2023, Lucio Asnaghi
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "Config.h"
+#include "ClassInfo.h"
+#include "Errors.h"
+#include "LuaHelpers.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace luabridge {
+
+//=================================================================================================
+/**
+ * @brief Counters of the objects of a registered class living in a lua state.
+ */
+struct ObjectCensus
+{
+    std::string name;        ///< Name of the class, as registered.
+    std::size_t live = 0;    ///< Number of userdata holding an object not yet released.
+    std::size_t created = 0; ///< Number of userdata created with an object since the class was registered.
+    std::size_t bytes = 0;   ///< Size of the userdata of the live objects.
+};
+
+namespace detail {
+
+//=================================================================================================
+/**
+ * @brief Per class storage of the object counters, referenced by the class and const tables.
+ */
+struct ObjectCensusCounters
+{
+    std::size_t live = 0;
+    std::size_t created = 0;
+    std::size_t bytes = 0;
+};
+
+/**
+ * @brief Create the object counters of a class, with its class or const table on top of the stack.
+ *
+ * Counters are created with the first object of the class, so they are never part of the registration captured by a binding image.
+ */
+inline ObjectCensusCounters* create_object_census_counters(lua_State* L)
+{
+    // Stack: metatable (mt)
+    lua_rawgetp(L, -1, getConstKey()); // Stack: mt, const table (co) | nil
+    if (lua_istable(L, -1))
+    {
+        lua_pushvalue(L, -2); // Stack: mt, co, class table (cl)
+    }
+    else
+    {
+        lua_pop(L, 1); // Stack: mt
+        lua_pushvalue(L, -1); // Stack: mt, co
+        lua_rawgetp(L, -1, getClassKey()); // Stack: mt, co, cl | nil
+    }
+
+    if (! lua_istable(L, -1))
+    {
+        lua_pop(L, 2); // Stack: mt
+        return nullptr;
+    }
+
+    lua_rawgetp(L, -1, getTypeKey()); // Stack: mt, co, cl, name | nil
+    if (lua_type(L, -1) != LUA_TSTRING)
+    {
+        lua_pop(L, 3); // Stack: mt
+        return nullptr;
+    }
+
+    auto* counters = new (lua_newuserdata_x<ObjectCensusCounters>(L, sizeof(ObjectCensusCounters))) ObjectCensusCounters(); // Stack: mt, co, cl, name, counters (oc)
+
+    lua_pushvalue(L, -1); // Stack: mt, co, cl, name, oc, oc
+    lua_rawsetp(L, -4, getObjectCensusKey()); // cl [objectCensusKey] = oc. Stack: mt, co, cl, name, oc
+
+    lua_pushvalue(L, -1); // Stack: mt, co, cl, name, oc, oc
+    lua_rawsetp(L, -5, getObjectCensusKey()); // co [objectCensusKey] = oc. Stack: mt, co, cl, name, oc
+
+    lua_rawgetp(L, LUA_REGISTRYINDEX, getObjectCensusKey()); // Stack: mt, co, cl, name, oc, census table (ct) | nil
+    if (! lua_istable(L, -1))
+    {
+        lua_pop(L, 1); // Stack: mt, co, cl, name, oc
+        lua_newtable(L); // Stack: mt, co, cl, name, oc, ct
+        lua_pushvalue(L, -1); // Stack: mt, co, cl, name, oc, ct, ct
+        lua_rawsetp(L, LUA_REGISTRYINDEX, getObjectCensusKey()); // registry [objectCensusKey] = ct. Stack: mt, co, cl, name, oc, ct
+    }
+
+    lua_insert(L, -3); // Stack: mt, co, cl, ct, name, oc
+    lua_rawset(L, -3); // ct [name] = oc. Stack: mt, co, cl, ct
+    lua_pop(L, 3); // Stack: mt
+
+    return counters;
+}
+
+/**
+ * @brief Get the object counters of the class of the userdata at the specified index, creating them if requested.
+ */
+inline ObjectCensusCounters* get_object_census_counters(lua_State* L, int index, bool create)
+{
+    if (! lua_getmetatable(L, index)) // Stack: mt
+        return nullptr;
+
+    lua_rawgetp(L, -1, getObjectCensusKey()); // Stack: mt, counters | nil
+    auto* counters = static_cast<ObjectCensusCounters*>(lua_touserdata(L, -1));
+    lua_pop(L, 1); // Stack: mt
+
+    if (counters == nullptr && create)
+        counters = create_object_census_counters(L);
+
+    lua_pop(L, 1); // Stack: -
+
+    return counters;
+}
+
+/**
+ * @brief Count a new userdata holding an object, with the userdata on top of the stack and its metatable already set.
+ */
+inline void count_object_created([[maybe_unused]] lua_State* L)
+{
+#if LUABRIDGE_ENABLE_OBJECT_CENSUS
+    if (auto* counters = get_object_census_counters(L, -1, true))
+    {
+        counters->live += 1;
+        counters->created += 1;
+        counters->bytes += static_cast<std::size_t>(get_raw_length(L, -1));
+    }
+#endif
+}
+
+/**
+ * @brief Count a userdata at the specified index releasing its object.
+ */
+inline void count_object_released([[maybe_unused]] lua_State* L, [[maybe_unused]] int index)
+{
+#if LUABRIDGE_ENABLE_OBJECT_CENSUS
+    if (auto* counters = get_object_census_counters(L, index, false))
+    {
+        const auto size = static_cast<std::size_t>(get_raw_length(L, index));
+
+        LUABRIDGE_ASSERT(counters->live > 0);
+        LUABRIDGE_ASSERT(size <= counters->bytes);
+
+        counters->live -= 1;
+        counters->bytes -= size;
+    }
+#endif
+}
+
+} // namespace detail
+
+//=================================================================================================
+/**
+ * @brief Get the object counters of the classes registered in a state, sorted by class name.
+ *
+ * A class is listed once its first object is created with `LUABRIDGE_ENABLE_OBJECT_CENSUS` enabled, otherwise the list is empty.
+ *
+ * @param L A lua state.
+ *
+ * @returns The counters of each class with counted objects.
+ */
+[[nodiscard]] inline std::vector<ObjectCensus> getObjectCensus(lua_State* L)
+{
+    std::vector<ObjectCensus> census;
+
+    lua_rawgetp(L, LUA_REGISTRYINDEX, detail::getObjectCensusKey()); // Stack: census table (ct) | nil
+    if (lua_istable(L, -1))
+    {
+        lua_pushnil(L); // Stack: ct, nil
+        while (lua_next(L, -2) != 0) // Stack: ct, name, counters
+        {
+            const auto* counters = static_cast<const detail::ObjectCensusCounters*>(lua_touserdata(L, -1));
+            if (counters != nullptr && lua_type(L, -2) == LUA_TSTRING)
+                census.push_back({ lua_tostring(L, -2), counters->live, counters->created, counters->bytes });
+
+            lua_pop(L, 1); // Stack: ct, name
+        }
+    }
+
+    lua_pop(L, 1); // Stack: -
+
+    std::sort(census.begin(), census.end(), [](const auto& lhs, const auto& rhs) { return lhs.name < rhs.name; });
+    return census;
+}
+
+/**
+ * @brief Get the object counters of a registered class.
+ *
+ * @tparam T A registered class.
+ *
+ * @param L A lua state.
+ *
+ * @returns The counters of the class, zero if no object of the class has been counted.
+ */
+template <class T>
+[[nodiscard]] ObjectCensus getObjectCensus(lua_State* L)
+{
+    ObjectCensus census;
+
+    lua_rawgetp(L, LUA_REGISTRYINDEX, detail::getClassRegistryKey<T>()); // Stack: class table (cl) | nil
+    if (lua_istable(L, -1))
+    {
+        lua_rawgetp(L, -1, detail::getTypeKey()); // Stack: cl, type name | nil
+        if (lua_type(L, -1) == LUA_TSTRING)
+            census.name = lua_tostring(L, -1);
+
+        lua_pop(L, 1); // Stack: cl
+
+        lua_rawgetp(L, -1, detail::getObjectCensusKey()); // Stack: cl, counters | nil
+        if (const auto* counters = static_cast<const detail::ObjectCensusCounters*>(lua_touserdata(L, -1)))
+        {
+            census.live = counters->live;
+            census.created = counters->created;
+            census.bytes = counters->bytes;
+        }
+
+        lua_pop(L, 1); // Stack: cl
+    }
+
+    lua_pop(L, 1); // Stack: -
+
+    return census;
+}
+
+/**
+ * @brief lua_CFunction pushing the object counters of the classes registered in the state.
+ *
+ * Called without arguments, it returns a table keyed by class name. Called with a class name, it returns the counters of that class
+ * only, or nil if the class is not counted. Each entry holds `live`, `created` and `bytes`. Register it with `addFunction` to make the
+ * census visible to scripts.
+ */
+inline int pushObjectCensus(lua_State* L)
+{
+    const auto pushCounters = [L](const ObjectCensus& census)
+    {
+        lua_createtable(L, 0, 3); // Stack: entry (en)
+
+        lua_pushnumber(L, static_cast<lua_Number>(census.live));
+        rawsetfield(L, -2, "live");
+
+        lua_pushnumber(L, static_cast<lua_Number>(census.created));
+        rawsetfield(L, -2, "created");
+
+        lua_pushnumber(L, static_cast<lua_Number>(census.bytes));
+        rawsetfield(L, -2, "bytes");
+    };
+
+    const char* name = lua_type(L, 1) == LUA_TSTRING ? lua_tostring(L, 1) : nullptr;
+    const auto census = getObjectCensus(L);
+
+    if (name != nullptr)
+    {
+        for (const auto& entry : census)
+        {
+            if (entry.name == name)
+            {
+                pushCounters(entry); // Stack: en
+                return 1;
+            }
+        }
+
+        lua_pushnil(L);
+        return 1;
+    }
+
+    lua_createtable(L, 0, static_cast<int>(census.size())); // Stack: census table (ct)
+
+    for (const auto& entry : census)
+    {
+        pushCounters(entry); // Stack: ct, en
+        rawsetfield(L, -2, entry.name.c_str()); // ct [name] = en. Stack: ct
+    }
+
+    return 1;
+}
+
+} // namespace luabridge
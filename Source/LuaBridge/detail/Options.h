@@ -15,6 +15,9 @@ namespace detail {
 struct OptionExtensibleClass;
 struct OptionAllowOverridingMethods;
 struct OptionVisibleMetatables;
+struct OptionCachedPointers;
+struct OptionFfiFunctions;
+struct OptionDisposableClass;
 } // namespace Detail
 
 /**
@@ -23,7 +26,10 @@ struct OptionVisibleMetatables;
 using Options = FlagSet<uint32_t,
     detail::OptionExtensibleClass,
     detail::OptionAllowOverridingMethods,
-    detail::OptionVisibleMetatables>;
+    detail::OptionVisibleMetatables,
+    detail::OptionCachedPointers,
+    detail::OptionFfiFunctions,
+    detail::OptionDisposableClass>;
 
 /**
  * @brief Set of default options.
@@ -47,4 +53,26 @@ static inline constexpr Options allowOverridingMethods = Options::Value<detail::
  */
 static inline constexpr Options visibleMetatables = Options::Value<detail::OptionVisibleMetatables>();
 
+/**
+ * @brief Reuse the same userdata when the same object pointer or reference of a class is pushed again.
+ *
+ * Userdata are kept in a per class weak valued table keyed by the object address, use `invalidateCachedPointer` when the object dies.
+ */
+static inline constexpr Options cachedPointers = Options::Value<detail::OptionCachedPointers>();
+
+/**
+ * @brief Register class static functions as LuaJIT FFI function pointers when their signature allows it.
+ *
+ * Calls to those functions can then be compiled in JIT traces. The option has no effect when not running on LuaJIT, or when the FFI
+ * library can't be loaded with `require`.
+ */
+static inline constexpr Options ffiFunctions = Options::Value<detail::OptionFfiFunctions>();
+
+/**
+ * @brief Add a `dispose` method and a `__close` metamethod to class objects, to release them before they are collected.
+ *
+ * Disposed objects can't be used anymore: passing them to C++ raises a lua error. The `__close` metamethod is only available from Lua 5.4.
+ */
+static inline constexpr Options disposableClass = Options::Value<detail::OptionDisposableClass>();
+
 } // namespace luabridge
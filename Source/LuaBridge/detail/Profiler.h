@@ -0,0 +1,342 @@
+// https://github.com/kunitoki/LuaBridge3
+// Copyright 2023, Lucio Asnaghi
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "Config.h"
+#include "BindingStats.h"
+#include "ClassInfo.h"
+#include "LuaHelpers.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace luabridge {
+
+//=================================================================================================
+/**
+ * @brief Sampling profiler of the scripts running in a state, collecting stacks in folded format.
+ *
+ * Samples are taken by a count hook every given number of virtual machine instructions (on Luau by the interrupt callback, every
+ * given number of interrupts). Each sample walks the stack of the running thread: Lua frames are named after their function and
+ * source, while C frames of bindings named with `LUABRIDGE_ENABLE_PROFILING` enabled take the name of their registration, so the
+ * time spent in scripts called back by C++ functions is attributed to them. Other C frames are named `[C]`, followed by the name
+ * of the function at the call site when it is known.
+ *
+ * Only one profiler at a time can run on a state. The hook is installed on the thread passed to the constructor, and inherited by
+ * the coroutines created while it runs. A hook already set on the thread (or interrupt callback on Luau) keeps receiving its events
+ * while sampling, and is restored when stopped. Samples must be read on the thread running the state, or after the profiler is
+ * stopped.
+ */
+class Profiler
+{
+public:
+    static constexpr int defaultInterval = 1000;
+    static constexpr int maxFrames = 128;
+
+    /**
+     * @brief Create a profiler of a state, sampling every interval instructions once started.
+     */
+    explicit Profiler(lua_State* L, int interval = defaultInterval) noexcept
+        : m_L(L)
+        , m_interval(std::max(interval, 1))
+    {
+    }
+
+    ~Profiler()
+    {
+        stop();
+    }
+
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    /**
+     * @brief Start sampling.
+     *
+     * @returns True if the profiler is running, false if another profiler is already running on the state.
+     */
+    bool start()
+    {
+        if (m_running)
+            return true;
+
+        lua_rawgetp(m_L, LUA_REGISTRYINDEX, detail::getProfilerKey()); // Stack: profiler | nil
+        const bool occupied = ! lua_isnil(m_L, -1);
+        lua_pop(m_L, 1); // Stack: -
+
+        if (occupied)
+            return false;
+
+        lua_pushlightuserdata(m_L, this); // Stack: profiler
+        lua_rawsetp(m_L, LUA_REGISTRYINDEX, detail::getProfilerKey()); // registry [profilerKey] = profiler. Stack: -
+
+        m_countdown = m_interval;
+
+#if LUABRIDGE_ON_LUAU
+        m_previousInterrupt = std::exchange(lua_callbacks(m_L)->interrupt, &Profiler::interrupt);
+#else
+        m_previousHook = lua_gethook(m_L);
+        m_previousHookMask = m_previousHook != nullptr ? lua_gethookmask(m_L) : 0;
+        m_previousHookCount = lua_gethookcount(m_L);
+        m_previousCountdown = m_previousHookCount;
+
+        // The hook also receives the events of the previous hook, counting instructions for both
+        m_hookCount = m_interval;
+        if ((m_previousHookMask & LUA_MASKCOUNT) != 0 && m_previousHookCount > 0)
+            m_hookCount = std::gcd(m_interval, m_previousHookCount);
+
+        lua_sethook(m_L, &Profiler::hook, m_previousHookMask | LUA_MASKCOUNT, m_hookCount);
+#endif
+
+        m_running = true;
+        return true;
+    }
+
+    /**
+     * @brief Stop sampling, keeping the samples collected so far.
+     */
+    void stop()
+    {
+        if (! m_running)
+            return;
+
+#if LUABRIDGE_ON_LUAU
+        lua_callbacks(m_L)->interrupt = m_previousInterrupt;
+#else
+        lua_sethook(m_L, m_previousHook, m_previousHookMask, m_previousHookCount);
+#endif
+
+        lua_pushnil(m_L); // Stack: nil
+        lua_rawsetp(m_L, LUA_REGISTRYINDEX, detail::getProfilerKey()); // registry [profilerKey] = nil. Stack: -
+
+        m_running = false;
+    }
+
+    /**
+     * @brief Check if the profiler is sampling.
+     */
+    [[nodiscard]] bool isRunning() const noexcept
+    {
+        return m_running;
+    }
+
+    /**
+     * @brief Number of samples collected.
+     */
+    [[nodiscard]] std::uint64_t samples() const noexcept
+    {
+        return m_samples;
+    }
+
+    /**
+     * @brief Discard the samples collected so far.
+     */
+    void reset()
+    {
+        m_stacks.clear();
+        m_samples = 0;
+    }
+
+    /**
+     * @brief Write the collected stacks in folded format, one line per distinct stack from the outermost frame, with its count.
+     *
+     * The output can be fed directly to flame graph generators.
+     */
+    void writeFolded(std::ostream& stream) const
+    {
+        std::vector<std::pair<std::string, std::uint64_t>> stacks(m_stacks.begin(), m_stacks.end());
+        std::sort(stacks.begin(), stacks.end());
+
+        for (const auto& [stack, count] : stacks)
+            stream << stack << ' ' << count << '\n';
+    }
+
+    /**
+     * @brief Get the collected stacks in folded format.
+     */
+    [[nodiscard]] std::string folded() const
+    {
+        std::ostringstream stream;
+        writeFolded(stream);
+        return stream.str();
+    }
+
+private:
+    static Profiler* instance(lua_State* L)
+    {
+        lua_rawgetp(L, LUA_REGISTRYINDEX, detail::getProfilerKey()); // Stack: profiler | nil
+        auto* profiler = static_cast<Profiler*>(lua_touserdata(L, -1));
+        lua_pop(L, 1); // Stack: -
+
+        return profiler;
+    }
+
+#if LUABRIDGE_ON_LUAU
+    static void interrupt(lua_State* L, int gc)
+    {
+        auto* profiler = instance(L);
+        if (profiler == nullptr)
+            return;
+
+        if (gc < 0 && --profiler->m_countdown <= 0)
+        {
+            profiler->m_countdown = profiler->m_interval;
+            profiler->sample(L);
+        }
+
+        if (profiler->m_previousInterrupt != nullptr)
+            profiler->m_previousInterrupt(L, gc);
+    }
+#else
+    static void hook(lua_State* L, lua_Debug* ar)
+    {
+        auto* profiler = instance(L);
+        if (profiler == nullptr)
+            return;
+
+        if (ar->event != LUA_HOOKCOUNT)
+        {
+            if (profiler->m_previousHook != nullptr)
+                profiler->m_previousHook(L, ar);
+
+            return;
+        }
+
+        if ((profiler->m_countdown -= profiler->m_hookCount) <= 0)
+        {
+            profiler->m_countdown = profiler->m_interval;
+            profiler->sample(L);
+        }
+
+        if ((profiler->m_previousHookMask & LUA_MASKCOUNT) != 0 && (profiler->m_previousCountdown -= profiler->m_hookCount) <= 0)
+        {
+            profiler->m_previousCountdown = profiler->m_previousHookCount;
+            profiler->m_previousHook(L, ar);
+        }
+    }
+#endif
+
+    void sample(lua_State* L)
+    {
+        if (! lua_checkstack(L, 2))
+            return;
+
+        m_frames.clear();
+
+        for (int level = 0; level < maxFrames; ++level)
+        {
+            lua_Debug ar;
+
+#if LUABRIDGE_ON_LUAU
+            if (lua_getinfo(L, level, "snf", &ar) == 0) // Stack: function
+                break;
+#else
+            if (lua_getstack(L, level, &ar) == 0 || lua_getinfo(L, "Snf", &ar) == 0) // Stack: function
+                break;
+#endif
+
+            m_frames.push_back(frameName(L, ar));
+            lua_pop(L, 1); // Stack: -
+        }
+
+        if (m_frames.empty())
+            return;
+
+        std::string stack;
+        for (auto it = m_frames.rbegin(); it != m_frames.rend(); ++it)
+        {
+            if (! stack.empty())
+                stack.push_back(';');
+
+            stack.append(*it);
+        }
+
+        ++m_stacks[stack];
+        ++m_samples;
+    }
+
+    static std::string frameName(lua_State* L, const lua_Debug& ar)
+    {
+        std::string name;
+
+        if (lua_iscfunction(L, -1))
+        {
+            name = bindingName(L);
+
+            if (name.empty())
+                name = ar.name != nullptr ? std::string("[C] ") + ar.name : std::string("[C]");
+        }
+        else if (ar.what != nullptr && std::strcmp(ar.what, "main") == 0)
+        {
+            name = std::string("main chunk@") + ar.short_src;
+        }
+        else
+        {
+            name = std::string(ar.name != nullptr ? ar.name : "?") + "@" + ar.short_src + ":" + std::to_string(ar.linedefined);
+        }
+
+        // Separators of the folded format
+        std::replace(name.begin(), name.end(), ';', ':');
+        std::replace(name.begin(), name.end(), '\n', ' ');
+
+        return name;
+    }
+
+    /**
+     * @brief Name of the binding record carried as last upvalue by the C closure on top of the stack, empty if it has none.
+     */
+    static std::string bindingName(lua_State* L)
+    {
+        const int closureIndex = lua_gettop(L);
+
+        int upvalues = 0;
+        while (lua_getupvalue(L, closureIndex, upvalues + 1) != nullptr) // Stack: closure, upvalue
+        {
+            lua_pop(L, 1); // Stack: closure
+            ++upvalues;
+        }
+
+        if (upvalues == 0 || lua_getupvalue(L, closureIndex, upvalues) == nullptr) // Stack: closure, upvalue
+            return {};
+
+        const void* pointer = lua_islightuserdata(L, -1) ? lua_touserdata(L, -1) : nullptr;
+        lua_pop(L, 1); // Stack: closure
+
+        if (pointer == nullptr)
+            return {};
+
+        const auto* record = detail::BindingRegistry::instance().find(pointer);
+        return record != nullptr ? record->name() : std::string();
+    }
+
+    lua_State* m_L = nullptr;
+    int m_interval = defaultInterval;
+    bool m_running = false;
+    std::uint64_t m_samples = 0;
+    std::unordered_map<std::string, std::uint64_t> m_stacks;
+    std::vector<std::string> m_frames;
+
+    int m_countdown = defaultInterval;
+
+#if LUABRIDGE_ON_LUAU
+    void (*m_previousInterrupt)(lua_State*, int) = nullptr;
+#else
+    int m_hookCount = defaultInterval;
+    lua_Hook m_previousHook = nullptr;
+    int m_previousHookMask = 0;
+    int m_previousHookCount = 0;
+    int m_previousCountdown = 0;
+#endif
+};
+
+} // namespace luabridge
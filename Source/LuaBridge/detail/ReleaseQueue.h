@@ -0,0 +1,411 @@
+// https://github.com/kunitoki/LuaBridge3
+// Copyright 2023, Lucio Asnaghi
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "Config.h"
+#include "ClassInfo.h"
+#include "LuaHelpers.h"
+
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace luabridge {
+namespace detail {
+
+//=================================================================================================
+/**
+ * @brief Lock free multiple producers queue of registry references released by threads not owning the lua state.
+ *
+ * The queue is owned by a userdata in the registry of the state, and destroyed with it.
+ */
+struct ReleaseQueue
+{
+    struct Node
+    {
+        int ref;
+        Node* next;
+    };
+
+    ~ReleaseQueue()
+    {
+        for (auto* node = takeAll(); node != nullptr;)
+            delete std::exchange(node, node->next);
+    }
+
+    /**
+     * @brief Enqueue a reference, callable from any thread.
+     */
+    void push(int ref)
+    {
+        auto* node = new Node{ ref, head.load(std::memory_order_relaxed) };
+
+        while (! head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    /**
+     * @brief Detach all the enqueued references, only the owning thread consumes the queue.
+     */
+    Node* takeAll() noexcept
+    {
+        return head.exchange(nullptr, std::memory_order_acquire);
+    }
+
+    [[nodiscard]] bool isPending() const noexcept
+    {
+        return head.load(std::memory_order_relaxed) != nullptr;
+    }
+
+    [[nodiscard]] bool isOwnedByCurrentThread() const noexcept
+    {
+        return owner.load(std::memory_order_relaxed) == std::this_thread::get_id();
+    }
+
+    std::atomic<std::thread::id> owner;
+    std::atomic<Node*> head{ nullptr };
+};
+
+//=================================================================================================
+/**
+ * @brief Process wide index of the release queues by lua thread.
+ *
+ * Other threads can't read the registry of a state while the owning thread is running, so the queues are also looked up here. Lookups
+ * are lock free: the index is an immutable map replaced as a whole by the rare updates, and replaced maps are deleted once no lookup is
+ * reading them. Entries also record the registry of their state, so a thread address reused by another state is never matched.
+ */
+class ReleaseQueues
+{
+public:
+    [[nodiscard]] static ReleaseQueues& instance()
+    {
+        static ReleaseQueues queues;
+        return queues;
+    }
+
+    ReleaseQueues(const ReleaseQueues&) = delete;
+    ReleaseQueues& operator=(const ReleaseQueues&) = delete;
+
+    ~ReleaseQueues()
+    {
+        delete m_current.load(std::memory_order_relaxed);
+
+        for (const auto* map : m_retired)
+            delete map;
+    }
+
+    [[nodiscard]] ReleaseQueue* find(lua_State* L)
+    {
+        if (m_current.load(std::memory_order_acquire) == nullptr)
+            return nullptr;
+
+        m_readers.fetch_add(1);
+
+        ReleaseQueue* queue = nullptr;
+
+        if (const auto* map = m_current.load(); map != nullptr)
+        {
+            auto it = map->find(L);
+            if (it != map->end() && it->second.registry == lua_topointer(L, LUA_REGISTRYINDEX))
+                queue = it->second.queue;
+        }
+
+        m_readers.fetch_sub(1);
+        return queue;
+    }
+
+    void add(lua_State* L, ReleaseQueue* queue, const void* sentinel)
+    {
+        update([&](Map& map)
+        {
+            map[L] = Entry{ queue, lua_topointer(L, LUA_REGISTRYINDEX), sentinel };
+        });
+    }
+
+    void remove(ReleaseQueue* queue)
+    {
+        update([&](Map& map)
+        {
+            for (auto it = map.begin(); it != map.end();)
+                it = (it->second.queue == queue) ? map.erase(it) : std::next(it);
+        });
+    }
+
+    void removeThread(lua_State* L, const void* sentinel)
+    {
+        update([&](Map& map)
+        {
+            if (auto it = map.find(L); it != map.end() && it->second.sentinel == sentinel)
+                map.erase(it);
+        });
+    }
+
+private:
+    struct Entry
+    {
+        ReleaseQueue* queue = nullptr;
+        const void* registry = nullptr; ///< The registry of the state of the thread.
+        const void* sentinel = nullptr; ///< The sentinel removing a coroutine when collected, nullptr for main threads.
+    };
+
+    using Map = std::unordered_map<lua_State*, Entry>;
+
+    ReleaseQueues() = default;
+
+    template <class F>
+    void update(F&& modify)
+    {
+        std::lock_guard lock(m_mutex);
+
+        const Map* current = m_current.load(std::memory_order_relaxed);
+
+        auto next = current != nullptr ? std::make_unique<Map>(*current) : std::make_unique<Map>();
+        modify(*next);
+
+        m_current.store(next->empty() ? nullptr : next.release());
+
+        if (current != nullptr)
+            m_retired.push_back(current);
+
+        // A lookup started after the store reads the new map, so with no lookup running the replaced maps can be deleted
+        if (m_readers.load() == 0)
+        {
+            for (const auto* map : m_retired)
+                delete map;
+
+            m_retired.clear();
+        }
+    }
+
+    std::mutex m_mutex;
+    std::atomic<const Map*> m_current{ nullptr };
+    std::atomic<std::size_t> m_readers{ 0 };
+    std::vector<const Map*> m_retired;
+};
+
+#if ! LUABRIDGE_ON_LUAU
+/**
+ * @brief Destroy the release queue when the state is closed.
+ */
+inline int release_queue_gc(lua_State* L)
+{
+    auto* queue = *static_cast<ReleaseQueue**>(lua_touserdata(L, 1));
+    if (queue == nullptr)
+        return 0;
+
+    ReleaseQueues::instance().remove(queue);
+
+    delete queue;
+    return 0;
+}
+
+/**
+ * @brief Remove a coroutine from the index when it is collected, through the finalizer of its sentinel.
+ */
+inline int release_queue_thread_gc(lua_State* L)
+{
+    void* sentinel = lua_touserdata(L, 1);
+
+    ReleaseQueues::instance().removeThread(*static_cast<lua_State**>(sentinel), sentinel);
+    return 0;
+}
+
+/**
+ * @brief Get the sentinel removing a coroutine from the index when it is collected, creating it if needed.
+ *
+ * The sentinel is stored in a weak keyed table of the registry, keyed by the coroutine, so it becomes garbage together with it.
+ *
+ * @returns The sentinel, or nullptr for the main thread which is removed with its queue.
+ */
+inline const void* get_release_queue_sentinel(lua_State* L)
+{
+    if (lua_pushthread(L) == 1) // Stack: thread
+    {
+        lua_pop(L, 1); // Stack: -
+        return nullptr;
+    }
+
+    lua_rawgetp(L, LUA_REGISTRYINDEX, getReleaseQueueThreadsKey()); // Stack: thread, threads (th) | nil
+    if (! lua_istable(L, -1))
+    {
+        lua_pop(L, 1); // Stack: thread
+        lua_newtable(L); // Stack: thread, th
+        lua_newtable(L); // Stack: thread, th, metatable (mt)
+        lua_pushstring(L, "k");
+        rawsetfield(L, -2, "__mode"); // mt ["__mode"] = "k". Stack: thread, th, mt
+        lua_setmetatable(L, -2); // Stack: thread, th
+        lua_pushvalue(L, -1); // Stack: thread, th, th
+        lua_rawsetp(L, LUA_REGISTRYINDEX, getReleaseQueueThreadsKey()); // Stack: thread, th
+    }
+
+    lua_pushvalue(L, -2); // Stack: thread, th, thread
+    lua_rawget(L, -2); // Stack: thread, th, sentinel | nil
+
+    void* sentinel = lua_touserdata(L, -1);
+    lua_pop(L, 1); // Stack: thread, th
+
+    if (sentinel == nullptr)
+    {
+        sentinel = lua_newuserdata(L, sizeof(lua_State*)); // Stack: thread, th, sentinel
+        new (sentinel) lua_State*(L);
+
+        lua_newtable(L); // Stack: thread, th, sentinel, mt
+        lua_pushcfunction_x(L, &release_queue_thread_gc);
+        rawsetfield(L, -2, "__gc"); // mt ["__gc"] = gc. Stack: thread, th, sentinel, mt
+        lua_setmetatable(L, -2); // Stack: thread, th, sentinel
+
+        lua_pushvalue(L, -3); // Stack: thread, th, sentinel, thread
+        lua_insert(L, -2); // Stack: thread, th, thread, sentinel
+        lua_rawset(L, -3); // th [thread] = sentinel. Stack: thread, th
+    }
+
+    lua_pop(L, 2); // Stack: -
+    return sentinel;
+}
+#endif
+
+/**
+ * @brief Get the release queue of a lua thread, or nullptr if deferred release is not enabled for it. Safe to call from any thread.
+ */
+[[nodiscard]] inline ReleaseQueue* get_release_queue([[maybe_unused]] lua_State* L)
+{
+#if LUABRIDGE_ON_LUAU
+    return nullptr;
+
+#else
+    return ReleaseQueues::instance().find(L);
+
+#endif
+}
+
+/**
+ * @brief Release all the references enqueued by other threads, must be called from the owning thread.
+ */
+inline std::size_t drain_release_queue(lua_State* L, ReleaseQueue& queue)
+{
+    std::size_t count = 0;
+
+    for (auto* node = queue.takeAll(); node != nullptr; ++count)
+    {
+        luaL_unref(L, LUA_REGISTRYINDEX, node->ref);
+
+        delete std::exchange(node, node->next);
+    }
+
+    return count;
+}
+
+/**
+ * @brief Release a registry reference, deferring it to the owning thread if called from another thread.
+ *
+ * When called from the owning thread, the references enqueued by other threads are released too.
+ */
+inline void release_registry_ref(lua_State* L, int ref)
+{
+    if (auto* queue = get_release_queue(L))
+    {
+        if (! queue->isOwnedByCurrentThread())
+        {
+            queue->push(ref);
+            return;
+        }
+
+        if (queue->isPending())
+            drain_release_queue(L, *queue);
+    }
+
+    luaL_unref(L, LUA_REGISTRYINDEX, ref);
+}
+
+} // namespace detail
+
+//=================================================================================================
+/**
+ * @brief Allow `LuaRef` objects of a state to be destroyed from threads not owning the state.
+ *
+ * Once enabled, the registry references of `LuaRef` objects destroyed on other threads are pushed to a lock free queue instead of being
+ * released, and they are released in batches by the owning thread on the next `LuaRef` destruction or on `collectReleasedRefs`. The
+ * thread calling this function becomes the owning thread, call it again to hand over the state to another thread.
+ *
+ * Only the references bound to a lua thread this has been called with are deferred, so references created from coroutines should be
+ * bound to `main_thread (L)`, or this should be called with the coroutine too, which is forgotten when collected. The queue is kept in
+ * the registry of the state and shared by all its threads. Not supported on Luau.
+ *
+ * @param L A lua state or thread.
+ *
+ * @returns true if deferred release is enabled, false if not supported.
+ */
+inline bool enableDeferredRelease([[maybe_unused]] lua_State* L)
+{
+#if LUABRIDGE_ON_LUAU
+    return false;
+
+#else
+#if LUABRIDGE_SAFE_STACK_CHECKS
+    if (! lua_checkstack(L, 5))
+        return false;
+#endif
+
+    detail::ReleaseQueue* queue = nullptr;
+
+    lua_rawgetp(L, LUA_REGISTRYINDEX, detail::getReleaseQueueKey()); // Stack: holder | nil
+    if (lua_isuserdata(L, -1))
+        queue = *static_cast<detail::ReleaseQueue**>(lua_touserdata(L, -1));
+
+    lua_pop(L, 1); // Stack: -
+
+    if (queue == nullptr)
+    {
+        auto** holder = static_cast<detail::ReleaseQueue**>(lua_newuserdata(L, sizeof(detail::ReleaseQueue*))); // Stack: holder
+        *holder = nullptr;
+
+        lua_newtable(L); // Stack: holder, metatable (mt)
+        lua_pushcfunction_x(L, &detail::release_queue_gc); // Stack: holder, mt, gc
+        rawsetfield(L, -2, "__gc"); // mt ["__gc"] = gc. Stack: holder, mt
+        lua_setmetatable(L, -2); // Stack: holder
+        lua_rawsetp(L, LUA_REGISTRYINDEX, detail::getReleaseQueueKey()); // Stack: -
+
+        queue = new detail::ReleaseQueue();
+        *holder = queue;
+    }
+
+    queue->owner.store(std::this_thread::get_id(), std::memory_order_relaxed);
+
+    detail::ReleaseQueues::instance().add(L, queue, detail::get_release_queue_sentinel(L));
+    return true;
+
+#endif
+}
+
+//=================================================================================================
+/**
+ * @brief Release the references of `LuaRef` objects destroyed by threads not owning the state.
+ *
+ * Must be called from the owning thread, at a point where it is safe to modify the registry.
+ *
+ * @param L A lua state.
+ *
+ * @returns The number of references released.
+ */
+inline std::size_t collectReleasedRefs(lua_State* L)
+{
+    auto* queue = detail::get_release_queue(L);
+    if (queue == nullptr)
+        return 0;
+
+    LUABRIDGE_ASSERT(queue->isOwnedByCurrentThread());
+
+    return detail::drain_release_queue(L, *queue);
+}
+
+} // namespace luabridge
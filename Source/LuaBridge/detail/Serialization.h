@@ -0,0 +1,1134 @@
+// https://github.com/kunitoki/LuaBridge3
+// Copyright 2023, Lucio Asnaghi
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "Config.h"
+#include "ClassInfo.h"
+#include "Errors.h"
+#include "LuaHelpers.h"
+#include "Result.h"
+#include "ScopeGuard.h"
+#include "Userdata.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace luabridge {
+
+//=================================================================================================
+/**
+ * @brief Writer passed to the serialization hook of a class, appending the bytes of the object state.
+ */
+class SerializationWriter
+{
+public:
+    explicit SerializationWriter(std::vector<std::uint8_t>& buffer) noexcept
+        : m_buffer(buffer)
+    {
+    }
+
+    /**
+     * @brief Append raw bytes.
+     */
+    void write(const void* data, std::size_t size)
+    {
+        const auto* bytes = static_cast<const std::uint8_t*>(data);
+        m_buffer.insert(m_buffer.end(), bytes, bytes + size);
+    }
+
+    /**
+     * @brief Append a trivially copyable value, in native byte order.
+     */
+    template <class T>
+    void writeValue(const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable values can be written as raw bytes");
+
+        write(std::addressof(value), sizeof(T));
+    }
+
+    /**
+     * @brief Append a length prefixed string.
+     */
+    void writeString(std::string_view value)
+    {
+        writeValue(static_cast<std::uint64_t>(value.size()));
+        write(value.data(), value.size());
+    }
+
+private:
+    std::vector<std::uint8_t>& m_buffer;
+};
+
+//=================================================================================================
+/**
+ * @brief Reader passed to the deserialization hook of a class, reading back what the serialization hook wrote.
+ *
+ * All read functions return false, leaving the output untouched, when not enough bytes are left.
+ */
+class SerializationReader
+{
+public:
+    SerializationReader(const std::uint8_t* data, std::size_t size) noexcept
+        : m_data(data)
+        , m_size(size)
+    {
+    }
+
+    /**
+     * @brief Read raw bytes.
+     */
+    bool read(void* data, std::size_t size)
+    {
+        if (size > remaining())
+            return false;
+
+        if (size > 0)
+            std::memcpy(data, m_data + m_position, size);
+
+        m_position += size;
+        return true;
+    }
+
+    /**
+     * @brief Read a trivially copyable value, in native byte order.
+     */
+    template <class T>
+    bool readValue(T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable values can be read as raw bytes");
+
+        return read(std::addressof(value), sizeof(T));
+    }
+
+    /**
+     * @brief Read a length prefixed string.
+     */
+    bool readString(std::string& value)
+    {
+        const std::size_t position = m_position;
+
+        std::uint64_t size = 0;
+        if (! readValue(size) || size > remaining())
+        {
+            m_position = position;
+            return false;
+        }
+
+        value.assign(reinterpret_cast<const char*>(m_data + m_position), static_cast<std::size_t>(size));
+        m_position += static_cast<std::size_t>(size);
+        return true;
+    }
+
+    /**
+     * @brief The number of bytes left to read.
+     */
+    std::size_t remaining() const noexcept
+    {
+        return m_size - m_position;
+    }
+
+private:
+    const std::uint8_t* m_data;
+    std::size_t m_size;
+    std::size_t m_position = 0;
+};
+
+namespace detail {
+
+//=================================================================================================
+/**
+ * @brief Hooks writing and reading back the state of an object of a registered class.
+ *
+ * The hooks are stored as the first upvalue of a closure in the class metatables and in the registry, the class name is the second.
+ */
+struct SerializationHook
+{
+    std::function<void(const void* object, SerializationWriter& writer)> serialize;
+    std::function<Result(SerializationReader& reader, lua_State* L)> deserialize;
+};
+
+/**
+ * @brief The closure holding the serialization hooks and the class name as its upvalues, it is never called.
+ */
+inline int serialization_hook_holder(lua_State*)
+{
+    return 0;
+}
+
+/**
+ * @brief Push the registry table of serialization hook holders by class name, creating it if needed.
+ */
+inline void push_serializers_table(lua_State* L)
+{
+    lua_rawgetp(L, LUA_REGISTRYINDEX, getSerializersKey()); // Stack: serializers (se) | nil
+    if (lua_istable(L, -1))
+        return;
+
+    lua_pop(L, 1); // Stack: -
+    lua_newtable(L); // Stack: se
+    lua_pushvalue(L, -1); // Stack: se, se
+    lua_rawsetp(L, LUA_REGISTRYINDEX, getSerializersKey()); // registry [serializersKey] = se. Stack: se
+}
+
+//=================================================================================================
+/**
+ * @brief Tags of the binary serialization format, one byte before each value.
+ */
+enum class SerializationTag : std::uint8_t
+{
+    Nil,
+    False,
+    True,
+    Integer,    // Zigzag varint
+    Number,     // 8 bytes little endian IEEE 754 double
+    String,     // Varint length, bytes
+    StringRef,  // Varint id of a string already seen
+    Table,      // Varint array size, varint record count, array values, key value pairs
+    Reference,  // Varint id of a table or object already seen
+    IntegerRun, // Varint count, zigzag varints, only in the array part of a table
+    NumberRun,  // Varint count, doubles, only in the array part of a table
+    Object      // Class name as a string value, varint payload size, payload
+};
+
+inline constexpr std::uint8_t serializationMagic[] = { 'L', 'B', 'S', 1 };
+
+inline constexpr std::size_t serializationChunkSize = 64 * 1024;
+
+inline constexpr int serializationMaxDepth = 1000;
+
+//=================================================================================================
+/**
+ * @brief Destination of the encoder, either a buffer or a stream written in chunks.
+ */
+class SerializationOutput
+{
+public:
+    explicit SerializationOutput(std::vector<std::uint8_t>& buffer) noexcept
+        : m_buffer(&buffer)
+    {
+    }
+
+    explicit SerializationOutput(std::ostream& stream)
+        : m_buffer(&m_chunk)
+        , m_stream(&stream)
+    {
+        m_chunk.reserve(serializationChunkSize + 64);
+    }
+
+    SerializationOutput(const SerializationOutput&) = delete;
+    SerializationOutput& operator=(const SerializationOutput&) = delete;
+
+    void write(const void* data, std::size_t size)
+    {
+        // Large strings and payloads go straight to the stream instead of growing the chunk
+        if (m_stream != nullptr && size >= serializationChunkSize)
+        {
+            flush();
+            m_stream->write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+            return;
+        }
+
+        const auto* bytes = static_cast<const std::uint8_t*>(data);
+        m_buffer->insert(m_buffer->end(), bytes, bytes + size);
+
+        if (m_stream != nullptr && m_chunk.size() >= serializationChunkSize)
+            flush();
+    }
+
+    void writeByte(std::uint8_t value)
+    {
+        m_buffer->push_back(value);
+
+        if (m_stream != nullptr && m_chunk.size() >= serializationChunkSize)
+            flush();
+    }
+
+    void writeTag(SerializationTag tag)
+    {
+        writeByte(static_cast<std::uint8_t>(tag));
+    }
+
+    void writeVarint(std::uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            writeByte(static_cast<std::uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+
+        writeByte(static_cast<std::uint8_t>(value));
+    }
+
+    void writeInteger(std::int64_t value)
+    {
+        writeVarint((static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+    }
+
+    void writeNumber(double value)
+    {
+        std::uint64_t bits = 0;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        std::uint8_t bytes[sizeof(bits)];
+        for (std::size_t i = 0; i < sizeof(bits); ++i)
+            bytes[i] = static_cast<std::uint8_t>(bits >> (i * 8));
+
+        write(bytes, sizeof(bytes));
+    }
+
+    /**
+     * @brief Write the pending chunk to the stream, if any.
+     *
+     * @returns False if the stream failed, now or on a previous flush.
+     */
+    bool flush()
+    {
+        if (m_stream == nullptr)
+            return true;
+
+        if (! m_chunk.empty())
+        {
+            m_stream->write(reinterpret_cast<const char*>(m_chunk.data()), static_cast<std::streamsize>(m_chunk.size()));
+            m_chunk.clear();
+        }
+
+        return ! m_stream->fail();
+    }
+
+private:
+    std::vector<std::uint8_t> m_chunk;
+    std::vector<std::uint8_t>* m_buffer;
+    std::ostream* m_stream = nullptr;
+};
+
+//=================================================================================================
+/**
+ * @brief Source of the decoder, either a buffer or a stream.
+ *
+ * Streams are read through their buffer, so no byte past the end of the value is consumed.
+ */
+class SerializationInput
+{
+public:
+    SerializationInput(const std::uint8_t* data, std::size_t size) noexcept
+        : m_data(data)
+        , m_size(size)
+    {
+    }
+
+    explicit SerializationInput(std::istream& stream) noexcept
+        : m_stream(stream.rdbuf())
+    {
+    }
+
+    SerializationInput(const SerializationInput&) = delete;
+    SerializationInput& operator=(const SerializationInput&) = delete;
+
+    bool read(void* data, std::size_t size)
+    {
+        if (m_stream != nullptr)
+            return static_cast<std::size_t>(m_stream->sgetn(static_cast<char*>(data), static_cast<std::streamsize>(size))) == size;
+
+        if (size > m_size - m_position)
+            return false;
+
+        std::memcpy(data, m_data + m_position, size);
+        m_position += size;
+        return true;
+    }
+
+    bool readByte(std::uint8_t& value)
+    {
+        if (m_stream != nullptr)
+        {
+            const auto character = m_stream->sbumpc();
+            if (character == std::char_traits<char>::eof())
+                return false;
+
+            value = static_cast<std::uint8_t>(character);
+            return true;
+        }
+
+        if (m_position == m_size)
+            return false;
+
+        value = m_data[m_position++];
+        return true;
+    }
+
+    bool readTag(SerializationTag& tag)
+    {
+        std::uint8_t value = 0;
+        if (! readByte(value) || value > static_cast<std::uint8_t>(SerializationTag::Object))
+            return false;
+
+        tag = static_cast<SerializationTag>(value);
+        return true;
+    }
+
+    bool readVarint(std::uint64_t& value)
+    {
+        value = 0;
+
+        for (unsigned shift = 0; shift < 64; shift += 7)
+        {
+            std::uint8_t byte = 0;
+            if (! readByte(byte))
+                return false;
+
+            value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+
+            if ((byte & 0x80) == 0)
+                return true;
+        }
+
+        return false;
+    }
+
+    bool readInteger(std::int64_t& value)
+    {
+        std::uint64_t bits = 0;
+        if (! readVarint(bits))
+            return false;
+
+        value = static_cast<std::int64_t>((bits >> 1) ^ (~(bits & 1) + 1));
+        return true;
+    }
+
+    bool readNumber(double& value)
+    {
+        std::uint8_t bytes[sizeof(std::uint64_t)];
+        if (! read(bytes, sizeof(bytes)))
+            return false;
+
+        std::uint64_t bits = 0;
+        for (std::size_t i = 0; i < sizeof(bits); ++i)
+            bits |= static_cast<std::uint64_t>(bytes[i]) << (i * 8);
+
+        std::memcpy(&value, &bits, sizeof(value));
+        return true;
+    }
+
+    /**
+     * @brief Get the next bytes as contiguous memory, copied into the scratch buffer when reading from a stream.
+     *
+     * The scratch buffer grows with the bytes actually read, so a corrupted size can't trigger a huge allocation.
+     */
+    const std::uint8_t* view(std::size_t size, std::vector<std::uint8_t>& scratch)
+    {
+        static constexpr std::uint8_t empty = 0;
+        if (size == 0)
+            return &empty;
+
+        if (m_stream == nullptr)
+        {
+            if (size > m_size - m_position)
+                return nullptr;
+
+            const std::uint8_t* data = m_data + m_position;
+            m_position += size;
+            return data;
+        }
+
+        scratch.clear();
+
+        while (scratch.size() < size)
+        {
+            const std::size_t offset = scratch.size();
+            const std::size_t count = std::min(size - offset, serializationChunkSize);
+
+            scratch.resize(offset + count);
+            if (! read(scratch.data() + offset, count))
+                return nullptr;
+        }
+
+        return scratch.data();
+    }
+
+    /**
+     * @brief Upper bound of the values left, used to limit the presizing of tables.
+     */
+    std::size_t available() const noexcept
+    {
+        return m_stream != nullptr ? (std::size_t(1) << 16) : m_size - m_position;
+    }
+
+private:
+    const std::uint8_t* m_data = nullptr;
+    std::size_t m_size = 0;
+    std::size_t m_position = 0;
+    std::streambuf* m_stream = nullptr;
+};
+
+//=================================================================================================
+/**
+ * @brief Binary encoder of a value on the stack, using raw stack operations only.
+ *
+ * Tables and objects are written once and referenced by id afterwards, which preserves shared references and cycles, and so are
+ * strings. Consecutive numbers of the same kind in the array part of a table are written as packed runs.
+ */
+class Serializer
+{
+public:
+    Serializer(lua_State* L, SerializationOutput& output) noexcept
+        : L(L)
+        , m_output(output)
+    {
+    }
+
+    Result run(int index)
+    {
+        index = lua_absindex(L, index);
+
+        const int top = lua_gettop(L);
+
+        // Serialization hooks might throw
+        ScopeGuard restoreStack([this, top] { lua_settop(L, top); });
+
+        m_output.write(serializationMagic, sizeof(serializationMagic));
+
+        if (auto result = writeValue(index, 0); ! result)
+            return result;
+
+        if (! m_output.flush())
+            return makeErrorCode(ErrorCode::SerializationStreamFailed);
+
+        return {};
+    }
+
+private:
+    enum class NumberKind
+    {
+        None,
+        Integer,
+        Number
+    };
+
+    Result writeValue(int index, int depth)
+    {
+        switch (lua_type(L, index))
+        {
+        case LUA_TNIL:
+            m_output.writeTag(SerializationTag::Nil);
+            return {};
+
+        case LUA_TBOOLEAN:
+            m_output.writeTag(lua_toboolean(L, index) ? SerializationTag::True : SerializationTag::False);
+            return {};
+
+        case LUA_TNUMBER:
+            if (numberKind(index) == NumberKind::Integer)
+            {
+                m_output.writeTag(SerializationTag::Integer);
+                m_output.writeInteger(toInteger(index));
+            }
+            else
+            {
+                m_output.writeTag(SerializationTag::Number);
+                m_output.writeNumber(static_cast<double>(lua_tonumber(L, index)));
+            }
+            return {};
+
+        case LUA_TSTRING:
+            writeString(index);
+            return {};
+
+        case LUA_TTABLE:
+            if (writeReference(index))
+                return {};
+
+            return writeTable(index, depth);
+
+        case LUA_TUSERDATA:
+            if (writeReference(index))
+                return {};
+
+            return writeObject(index);
+
+        default:
+            return makeErrorCode(ErrorCode::ValueNotSerializable);
+        }
+    }
+
+    void writeString(int index)
+    {
+        std::size_t length = 0;
+        const char* string = lua_tolstring(L, index, &length);
+
+        // Strings stay alive while serializing, as they are reachable from the serialized value
+        const auto [it, inserted] = m_strings.try_emplace(std::string_view(string, length), m_strings.size() + 1);
+        if (! inserted)
+        {
+            m_output.writeTag(SerializationTag::StringRef);
+            m_output.writeVarint(it->second);
+            return;
+        }
+
+        m_output.writeTag(SerializationTag::String);
+        m_output.writeVarint(length);
+        m_output.write(string, length);
+    }
+
+    Result writeTable(int index, int depth)
+    {
+        if (depth >= serializationMaxDepth || ! lua_checkstack(L, 3))
+            return makeErrorCode(ErrorCode::ValueNotSerializable);
+
+        const int arraySize = get_raw_length(L, index);
+
+        std::uint64_t records = 0;
+        lua_pushnil(L); // Stack: nil
+        while (lua_next(L, index) != 0) // Stack: key, value
+        {
+            if (! is_array_key(L, -2, arraySize))
+                ++records;
+
+            lua_pop(L, 1); // Stack: key
+        }
+
+        m_output.writeTag(SerializationTag::Table);
+        m_output.writeVarint(static_cast<std::uint64_t>(arraySize));
+        m_output.writeVarint(records);
+
+        for (int key = 1; key <= arraySize;)
+        {
+            lua_rawgeti(L, index, key); // Stack: value
+
+            if (const auto kind = numberKind(-1); kind != NumberKind::None)
+            {
+                const int count = writeRun(index, key, arraySize, kind);
+                if (count > 1)
+                {
+                    key += count;
+                    continue;
+                }
+            }
+
+            if (auto result = writeValue(lua_gettop(L), depth + 1); ! result)
+                return result;
+
+            lua_pop(L, 1); // Stack: -
+            ++key;
+        }
+
+        lua_pushnil(L); // Stack: nil
+        while (lua_next(L, index) != 0) // Stack: key, value
+        {
+            const int valueIndex = lua_gettop(L);
+
+            if (! is_array_key(L, valueIndex - 1, arraySize))
+            {
+                if (auto result = writeValue(valueIndex - 1, depth + 1); ! result)
+                    return result;
+
+                if (auto result = writeValue(valueIndex, depth + 1); ! result)
+                    return result;
+            }
+
+            lua_pop(L, 1); // Stack: key
+        }
+
+        return {};
+    }
+
+    /**
+     * @brief Write the run of numbers of the same kind starting with the value on top of the stack, at the given key.
+     *
+     * @returns The length of the run. If it's 1 nothing is written and the value is left on the stack, otherwise it's popped.
+     */
+    int writeRun(int index, int key, int arraySize, NumberKind kind)
+    {
+        int count = 1;
+        while (key + count <= arraySize)
+        {
+            lua_rawgeti(L, index, key + count); // Stack: first, value
+            const bool sameKind = numberKind(-1) == kind;
+            lua_pop(L, 1); // Stack: first
+
+            if (! sameKind)
+                break;
+
+            ++count;
+        }
+
+        if (count == 1)
+            return count;
+
+        lua_pop(L, 1); // Stack: -
+
+        m_output.writeTag(kind == NumberKind::Integer ? SerializationTag::IntegerRun : SerializationTag::NumberRun);
+        m_output.writeVarint(static_cast<std::uint64_t>(count));
+
+        for (int i = 0; i < count; ++i)
+        {
+            lua_rawgeti(L, index, key + i); // Stack: value
+
+            if (kind == NumberKind::Integer)
+                m_output.writeInteger(toInteger(-1));
+            else
+                m_output.writeNumber(static_cast<double>(lua_tonumber(L, -1)));
+
+            lua_pop(L, 1); // Stack: -
+        }
+
+        return count;
+    }
+
+    Result writeObject(int index)
+    {
+        if (! lua_checkstack(L, 3) || ! lua_getmetatable(L, index)) // Stack: metatable (mt)
+            return makeErrorCode(ErrorCode::ValueNotSerializable);
+
+        lua_rawgetp(L, -1, getSerializeKey()); // Stack: mt, holder | nil
+        if (! lua_iscfunction(L, -1) || lua_getupvalue(L, -1, 1) == nullptr) // Stack: mt, holder, hook
+        {
+            lua_pop(L, 2);
+            return makeErrorCode(ErrorCode::ValueNotSerializable);
+        }
+
+        // The hook is kept alive by the metatable of the object, which is reachable from the serialized value
+        const auto* hook = align<SerializationHook>(get_closure_storage(L, -1));
+        lua_pop(L, 1); // Stack: mt, holder
+
+        const auto* object = static_cast<Userdata*>(lua_touserdata(L, index));
+        if (object->isDisposed())
+        {
+            lua_pop(L, 2);
+            return makeErrorCode(ErrorCode::ValueNotSerializable);
+        }
+
+        m_payload.clear();
+        SerializationWriter writer(m_payload);
+        hook->serialize(object->getPointer(), writer);
+
+        m_output.writeTag(SerializationTag::Object);
+
+        lua_getupvalue(L, -1, 2); // Stack: mt, holder, name
+        writeString(-1);
+        lua_pop(L, 3); // Stack: -
+
+        m_output.writeVarint(m_payload.size());
+        m_output.write(m_payload.data(), m_payload.size());
+        return {};
+    }
+
+    /**
+     * @brief Write a reference to a table or object already written, or assign it an id.
+     */
+    bool writeReference(int index)
+    {
+        const auto [it, inserted] = m_objects.try_emplace(lua_topointer(L, index), m_objects.size() + 1);
+        if (inserted)
+            return false;
+
+        m_output.writeTag(SerializationTag::Reference);
+        m_output.writeVarint(it->second);
+        return true;
+    }
+
+    NumberKind numberKind(int index) const
+    {
+        if (lua_type(L, index) != LUA_TNUMBER)
+            return NumberKind::None;
+
+#if LUA_VERSION_NUM >= 503
+        return lua_isinteger(L, index) ? NumberKind::Integer : NumberKind::Number;
+#else
+        // Integral numbers are written as integers, except negative zero which would lose its sign
+        const auto number = static_cast<double>(lua_tonumber(L, index));
+        if (number != std::trunc(number) || number < -9223372036854775808.0 || number >= 9223372036854775808.0)
+            return NumberKind::Number;
+
+        return (number == 0.0 && std::signbit(number)) ? NumberKind::Number : NumberKind::Integer;
+#endif
+    }
+
+    std::int64_t toInteger(int index) const
+    {
+#if LUA_VERSION_NUM >= 503
+        return static_cast<std::int64_t>(lua_tointeger(L, index));
+#else
+        return static_cast<std::int64_t>(lua_tonumber(L, index));
+#endif
+    }
+
+    lua_State* L;
+    SerializationOutput& m_output;
+    std::unordered_map<const void*, std::uint64_t> m_objects;
+    std::unordered_map<std::string_view, std::uint64_t> m_strings;
+    std::vector<std::uint8_t> m_payload;
+};
+
+//=================================================================================================
+/**
+ * @brief Binary decoder pushing the serialized value on the stack.
+ *
+ * The input is untrusted: sizes, ids and tags are validated, and tables are presized no more than the input could fill.
+ */
+class Deserializer
+{
+public:
+    Deserializer(lua_State* L, SerializationInput& input) noexcept
+        : L(L)
+        , m_input(input)
+    {
+    }
+
+    Result run()
+    {
+        std::uint8_t magic[sizeof(serializationMagic)];
+        if (! m_input.read(magic, sizeof(magic)) || std::memcmp(magic, serializationMagic, sizeof(magic)) != 0)
+            return makeErrorCode(ErrorCode::InvalidSerializedData);
+
+        if (! lua_checkstack(L, 3))
+            return makeErrorCode(ErrorCode::LuaStackOverflow);
+
+        const int top = lua_gettop(L);
+
+        // Deserialization hooks might throw
+        ScopeGuard restoreStack([this, top] { lua_settop(L, top); });
+
+        lua_newtable(L); // Stack: objects (ob)
+        m_objectsIndex = lua_gettop(L);
+
+        lua_newtable(L); // Stack: ob, strings (sr)
+        m_stringsIndex = lua_gettop(L);
+
+        if (auto result = readValue(0); ! result)
+            return result;
+
+        restoreStack.reset();
+
+        lua_replace(L, m_objectsIndex); // Stack: value, sr
+        lua_pop(L, 1); // Stack: value
+        return {};
+    }
+
+private:
+    Result readValue(int depth)
+    {
+        SerializationTag tag;
+        if (! m_input.readTag(tag))
+            return invalidData();
+
+        return readValue(tag, depth);
+    }
+
+    Result readValue(SerializationTag tag, int depth)
+    {
+        if (! lua_checkstack(L, 3))
+            return makeErrorCode(ErrorCode::LuaStackOverflow);
+
+        switch (tag)
+        {
+        case SerializationTag::Nil:
+            lua_pushnil(L);
+            return {};
+
+        case SerializationTag::False:
+        case SerializationTag::True:
+            lua_pushboolean(L, tag == SerializationTag::True);
+            return {};
+
+        case SerializationTag::Integer:
+        {
+            std::int64_t value = 0;
+            if (! m_input.readInteger(value))
+                return invalidData();
+
+            pushInteger(value);
+            return {};
+        }
+
+        case SerializationTag::Number:
+        {
+            double value = 0.0;
+            if (! m_input.readNumber(value))
+                return invalidData();
+
+            lua_pushnumber(L, static_cast<lua_Number>(value));
+            return {};
+        }
+
+        case SerializationTag::String:
+            return readString();
+
+        case SerializationTag::StringRef:
+            return readReference(m_stringsIndex, m_stringCount);
+
+        case SerializationTag::Table:
+            return readTable(depth);
+
+        case SerializationTag::Reference:
+            return readReference(m_objectsIndex, m_objectCount);
+
+        case SerializationTag::Object:
+            return readObject();
+
+        default:
+            return invalidData();
+        }
+    }
+
+    Result readString()
+    {
+        std::uint64_t length = 0;
+        if (! m_input.readVarint(length) || length > std::numeric_limits<std::size_t>::max())
+            return invalidData();
+
+        const auto* data = m_input.view(static_cast<std::size_t>(length), m_scratch);
+        if (data == nullptr)
+            return invalidData();
+
+        lua_pushlstring(L, reinterpret_cast<const char*>(data), static_cast<std::size_t>(length)); // Stack: string
+        lua_pushvalue(L, -1); // Stack: string, string
+        lua_rawseti(L, m_stringsIndex, ++m_stringCount); // sr [id] = string. Stack: string
+        return {};
+    }
+
+    Result readTable(int depth)
+    {
+        if (depth >= serializationMaxDepth)
+            return invalidData();
+
+        std::uint64_t arraySize = 0;
+        std::uint64_t records = 0;
+        if (! m_input.readVarint(arraySize) || ! m_input.readVarint(records) || arraySize > INT_MAX)
+            return invalidData();
+
+        const auto limit = static_cast<std::uint64_t>(std::min<std::size_t>(m_input.available(), INT_MAX));
+        lua_createtable(L, static_cast<int>(std::min(arraySize, limit)), static_cast<int>(std::min(records, limit))); // Stack: table (tb)
+
+        lua_pushvalue(L, -1); // Stack: tb, tb
+        lua_rawseti(L, m_objectsIndex, ++m_objectCount); // ob [id] = tb. Stack: tb
+
+        const int tableIndex = lua_gettop(L);
+
+        for (std::uint64_t key = 1; key <= arraySize;)
+        {
+            SerializationTag tag;
+            if (! m_input.readTag(tag))
+                return invalidData();
+
+            if (tag == SerializationTag::IntegerRun || tag == SerializationTag::NumberRun)
+            {
+                std::uint64_t count = 0;
+                if (! m_input.readVarint(count) || count > arraySize - key + 1)
+                    return invalidData();
+
+                for (std::uint64_t i = 0; i < count; ++i, ++key)
+                {
+                    if (tag == SerializationTag::IntegerRun)
+                    {
+                        std::int64_t value = 0;
+                        if (! m_input.readInteger(value))
+                            return invalidData();
+
+                        pushInteger(value);
+                    }
+                    else
+                    {
+                        double value = 0.0;
+                        if (! m_input.readNumber(value))
+                            return invalidData();
+
+                        lua_pushnumber(L, static_cast<lua_Number>(value));
+                    }
+
+                    lua_rawseti(L, tableIndex, static_cast<int>(key)); // tb [key] = value. Stack: tb
+                }
+
+                continue;
+            }
+
+            if (auto result = readValue(tag, depth + 1); ! result) // Stack: tb, value
+                return result;
+
+            lua_rawseti(L, tableIndex, static_cast<int>(key)); // tb [key] = value. Stack: tb
+            ++key;
+        }
+
+        for (std::uint64_t i = 0; i < records; ++i)
+        {
+            if (auto result = readValue(depth + 1); ! result) // Stack: tb, key
+                return result;
+
+            if (lua_isnil(L, -1) || (lua_type(L, -1) == LUA_TNUMBER && std::isnan(static_cast<double>(lua_tonumber(L, -1)))))
+                return invalidData();
+
+            if (auto result = readValue(depth + 1); ! result) // Stack: tb, key, value
+                return result;
+
+            lua_rawset(L, tableIndex); // tb [key] = value. Stack: tb
+        }
+
+        return {};
+    }
+
+    Result readObject()
+    {
+        SerializationTag tag;
+        if (! m_input.readTag(tag) || (tag != SerializationTag::String && tag != SerializationTag::StringRef))
+            return invalidData();
+
+        if (auto result = readValue(tag, 0); ! result) // Stack: name
+            return result;
+
+        push_serializers_table(L); // Stack: name, serializers (se)
+        lua_pushvalue(L, -2); // Stack: name, se, name
+        lua_rawget(L, -2); // Stack: name, se, holder | nil
+        if (! lua_iscfunction(L, -1) || lua_getupvalue(L, -1, 1) == nullptr) // Stack: name, se, holder, hook
+            return makeErrorCode(ErrorCode::ClassNotRegistered);
+
+        // The hook is kept alive by the registry
+        const auto* hook = align<SerializationHook>(get_closure_storage(L, -1));
+        lua_pop(L, 4); // Stack: -
+
+        std::uint64_t size = 0;
+        if (! m_input.readVarint(size) || size > std::numeric_limits<std::size_t>::max())
+            return invalidData();
+
+        const auto* payload = m_input.view(static_cast<std::size_t>(size), m_scratch);
+        if (payload == nullptr)
+            return invalidData();
+
+        const int top = lua_gettop(L);
+
+        SerializationReader reader(payload, static_cast<std::size_t>(size));
+        if (auto result = hook->deserialize(reader, L); ! result)
+            return result;
+
+        if (lua_gettop(L) != top + 1)
+            return invalidData();
+
+        lua_pushvalue(L, -1); // Stack: object, object
+        lua_rawseti(L, m_objectsIndex, ++m_objectCount); // ob [id] = object. Stack: object
+        return {};
+    }
+
+    Result readReference(int tableIndex, std::uint64_t count)
+    {
+        std::uint64_t id = 0;
+        if (! m_input.readVarint(id) || id == 0 || id > count)
+            return invalidData();
+
+        lua_rawgeti(L, tableIndex, static_cast<int>(id)); // Stack: value
+        return {};
+    }
+
+    void pushInteger(std::int64_t value)
+    {
+#if LUA_VERSION_NUM >= 503
+        lua_pushinteger(L, static_cast<lua_Integer>(value));
+#else
+        lua_pushnumber(L, static_cast<lua_Number>(value));
+#endif
+    }
+
+    static Result invalidData()
+    {
+        return makeErrorCode(ErrorCode::InvalidSerializedData);
+    }
+
+    lua_State* L;
+    SerializationInput& m_input;
+    int m_objectsIndex = 0;
+    int m_stringsIndex = 0;
+    std::uint64_t m_objectCount = 0;
+    std::uint64_t m_stringCount = 0;
+    std::vector<std::uint8_t> m_scratch;
+};
+
+} // namespace detail
+
+//=================================================================================================
+/**
+ * @brief Serialize a value to a compact binary format, appending it to a buffer.
+ *
+ * Nil, booleans, numbers, strings, tables and objects of classes registered with `Class<T>::addSerializer` are supported. Shared
+ * references and cycles are preserved, repeated strings are written once and numbers in the array part of tables are packed. Metatables
+ * of tables are not serialized. Integers written by Lua 5.1 and 5.2 are read back as integers by Lua 5.3 and later.
+ *
+ * @param L A lua state.
+ * @param index The index of the value on the stack.
+ * @param buffer The buffer to append to.
+ *
+ * @returns An empty result, or an error code with the buffer and the stack left untouched. If a serialization hook throws, the buffer
+ *          and the stack are restored before the exception propagates.
+ */
+inline Result serialize(lua_State* L, int index, std::vector<std::uint8_t>& buffer)
+{
+    const std::size_t size = buffer.size();
+
+    detail::ScopeGuard restoreBuffer([&buffer, size] { buffer.resize(size); });
+
+    detail::SerializationOutput output(buffer);
+    if (auto result = detail::Serializer(L, output).run(index); ! result)
+        return result;
+
+    restoreBuffer.reset();
+    return {};
+}
+
+/**
+ * @brief Serialize a value to a stream, written in chunks so large values never need to be held in memory as a whole.
+ *
+ * @returns An empty result, or an error code with the stack left untouched. On failure, part of the value might have been written.
+ */
+inline Result serialize(lua_State* L, int index, std::ostream& stream)
+{
+    detail::SerializationOutput output(stream);
+    return detail::Serializer(L, output).run(index);
+}
+
+//=================================================================================================
+/**
+ * @brief Deserialize a value written by `serialize`, pushing it on the stack.
+ *
+ * Objects are created with the deserialization hook of the class with the same name, that must be registered in the state.
+ *
+ * @returns An empty result with the value pushed, or an error code with the stack left untouched. If a deserialization hook throws,
+ *          the stack is restored before the exception propagates.
+ */
+inline Result deserialize(lua_State* L, const std::uint8_t* data, std::size_t size)
+{
+    detail::SerializationInput input(data, size);
+    return detail::Deserializer(L, input).run();
+}
+
+inline Result deserialize(lua_State* L, const std::vector<std::uint8_t>& buffer)
+{
+    return deserialize(L, buffer.data(), buffer.size());
+}
+
+/**
+ * @brief Deserialize a value from a stream, pushing it on the stack.
+ *
+ * The stream is read up to the end of the value, so several values can be read in sequence.
+ */
+inline Result deserialize(lua_State* L, std::istream& stream)
+{
+    if (! stream.good() || stream.rdbuf() == nullptr)
+        return makeErrorCode(ErrorCode::SerializationStreamFailed);
+
+    detail::SerializationInput input(stream);
+    return detail::Deserializer(L, input).run();
+}
+
+} // namespace luabridge
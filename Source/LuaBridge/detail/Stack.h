@@ -13,6 +13,7 @@
 #include "Result.h"
 #include "Userdata.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
@@ -66,6 +67,84 @@ private:
 template <class T, class>
 struct Stack;
 
+namespace detail {
+
+//=================================================================================================
+/**
+ * @brief Number of stack slots needed to push a value of a type, zero if the type doesn't declare it.
+ *
+ * Specializations declaring `stackSlots` also provide `pushUnchecked`, which pushes a value into stack space already reserved.
+ */
+template <class T, class = void>
+struct stack_slots : std::integral_constant<int, 0>
+{
+};
+
+template <class T>
+struct stack_slots<T, std::void_t<decltype(Stack<T>::stackSlots)>> : std::integral_constant<int, Stack<T>::stackSlots>
+{
+};
+
+template <class T>
+inline static constexpr int stack_slots_v = stack_slots<std::remove_cv_t<std::remove_reference_t<T>>>::value;
+
+/**
+ * @brief Stack slots needed to push a table filling its elements one at a time, each pushed over the given number of slots.
+ *
+ * Zero if any of the element types doesn't declare its stack slots.
+ */
+template <int Slots, class... Types>
+[[nodiscard]] constexpr int nested_stack_slots() noexcept
+{
+    if constexpr (sizeof...(Types) == 0)
+        return Slots;
+    else
+        return ((stack_slots_v<Types> > 0) && ...) ? Slots + std::max({ stack_slots_v<Types>... }) : 0;
+}
+
+template <int Slots, class... Types>
+inline static constexpr int nested_stack_slots_v = nested_stack_slots<Slots, Types...>();
+
+/**
+ * @brief Push a value into stack space reserved for `stack_slots_v<T>` slots, or with the usual checks if the type doesn't declare it.
+ */
+template <class T, class U>
+Result push_reserved(lua_State* L, U&& value)
+{
+    if constexpr (stack_slots_v<T> > 0)
+        return Stack<std::remove_cv_t<std::remove_reference_t<T>>>::pushUnchecked(L, std::forward<U>(value));
+    else
+        return Stack<T>::push(L, std::forward<U>(value));
+}
+
+/**
+ * @brief Get an integral value of type T, converting the lua value to integer once.
+ *
+ * The range of U is checked only when it can't hold every lua_Integer, integral types wider than lua_Integer need no check.
+ */
+template <class T, class U = T>
+TypeResult<T> get_integral(lua_State* L, int index)
+{
+    if (lua_type(L, index) != LUA_TNUMBER)
+        return makeErrorCode(ErrorCode::InvalidTypeCast);
+
+    int isValid = 0;
+    const lua_Integer value = tointeger(L, index, &isValid);
+
+    if (! isValid)
+        return makeErrorCode(ErrorCode::IntegerDoesntFitIntoLuaInteger);
+
+    if constexpr (! is_integral_range_within_v<lua_Integer, U>)
+    {
+        if (! is_integral_representable_by<U>(value))
+            return makeErrorCode(ErrorCode::IntegerDoesntFitIntoLuaInteger);
+    }
+
+    return static_cast<T>(value);
+}
+
+} // namespace detail
+
 //=================================================================================================
 /**
  * @brief Specialization for void type.
@@ -86,13 +165,20 @@ struct Stack<void>
 template <>
 struct Stack<std::nullptr_t>
 {
+    static constexpr int stackSlots = 1;
+
     [[nodiscard]] static Result push(lua_State* L, std::nullptr_t)
     {
 #if LUABRIDGE_SAFE_STACK_CHECKS
-        if (! lua_checkstack(L, 1))
+        if (! lua_checkstack(L, stackSlots))
             return makeErrorCode(ErrorCode::LuaStackOverflow);
 #endif
 
+        return pushUnchecked(L, nullptr);
+    }
+
+    [[nodiscard]] static Result pushUnchecked(lua_State* L, std::nullptr_t)
+    {
         lua_pushnil(L);
         return {};
     }
@@ -131,13 +217,20 @@ struct Stack<lua_State*>
 template <>
 struct Stack<lua_CFunction>
 {
+    static constexpr int stackSlots = 1;
+
     [[nodiscard]] static Result push(lua_State* L, lua_CFunction f)
     {
 #if LUABRIDGE_SAFE_STACK_CHECKS
-        if (! lua_checkstack(L, 1))
+        if (! lua_checkstack(L, stackSlots))
             return makeErrorCode(ErrorCode::LuaStackOverflow);
 #endif
 
+        return pushUnchecked(L, f);
+    }
+
+    [[nodiscard]] static Result pushUnchecked(lua_State* L, lua_CFunction f)
+    {
         lua_pushcfunction_x(L, f);
         return {};
     }
@@ -163,13 +256,20 @@ struct Stack<lua_CFunction>
 template <>
 struct Stack<bool>
 {
+    static constexpr int stackSlots = 1;
+
     [[nodiscard]] static Result push(lua_State* L, bool value)
     {
 #if LUABRIDGE_SAFE_STACK_CHECKS
-        if (! lua_checkstack(L, 1))
+        if (! lua_checkstack(L, stackSlots))
             return makeErrorCode(ErrorCode::LuaStackOverflow);
 #endif
 
+        return pushUnchecked(L, value);
+    }
+
+    [[nodiscard]] static Result pushUnchecked(lua_State* L, bool value)
+    {
         lua_pushboolean(L, value ? 1 : 0);
         return {};
     }
@@ -194,26 +294,27 @@ struct Stack<std::byte>
 {
     static_assert(sizeof(std::byte) < sizeof(lua_Integer));
 
+    static constexpr int stackSlots = 1;
+
     [[nodiscard]] static Result push(lua_State* L, std::byte value)
     {
 #if LUABRIDGE_SAFE_STACK_CHECKS
-        if (! lua_checkstack(L, 1))
+        if (! lua_checkstack(L, stackSlots))
             return makeErrorCode(ErrorCode::LuaStackOverflow);
 #endif
 
+        return pushUnchecked(L, value);
+    }
+
+    [[nodiscard]] static Result pushUnchecked(lua_State* L, std::byte value)
+    {
         pushunsigned(L, std::to_integer<std::make_unsigned_t<lua_Integer>>(value));
         return {};
     }
 
     [[nodiscard]] static TypeResult<std::byte> get(lua_State* L, int index)
     {
-        if (lua_type(L, index) != LUA_TNUMBER)
-            return makeErrorCode(ErrorCode::InvalidTypeCast);
-
-        if (! is_integral_representable_by<unsigned char>(L, index))
-            return makeErrorCode(ErrorCode::IntegerDoesntFitIntoLuaInteger);
-
-        return static_cast<std::byte>(lua_tointeger(L, index));
+        return detail::get_integral<std::byte, unsigned char>(L, index);
     }
 
     [[nodiscard]] static bool isInstance(lua_State* L, int index)
@@ -232,13 +333,20 @@ struct Stack<std::byte>
 template <>
 struct Stack<char>
 {
+    static constexpr int stackSlots = 1;
+
     [[nodiscard]] static Result push(lua_State* L, char value)
     {
 #if LUABRIDGE_SAFE_STACK_CHECKS
-        if (! lua_checkstack(L, 1))
+        if (! lua_checkstack(L, stackSlots))
             return makeErrorCode(ErrorCode::LuaStackOverflow);
 #endif
 
+        return pushUnchecked(L, value);
+    }
+
+    [[nodiscard]] static Result pushUnchecked(lua_State* L, char value)
+    {
         lua_pushlstring(L, &value, 1);
         return {};
     }
@@ -280,26 +388,27 @@ struct Stack<int8_t>
 {
     static_assert(sizeof(int8_t) < sizeof(lua_Integer));
 
+    static constexpr int stackSlots = 1;
+
     [[nodiscard]] static Result push(lua_State* L, int8_t value)
     {
 #if LUABRIDGE_SAFE_STACK_CHECKS
-        if (! lua_checkstack(L, 1))
+        if (! lua_checkstack(L, stackSlots))
             return makeErrorCode(ErrorCode::LuaStackOverflow);
 #endif
 
+        return pushUnchecked(L, value);
+    }
+
+    [[nodiscard]] static Result pushUnchecked(lua_State* L, int8_t value)
+    {
         lua_pushinteger(L, static_cast<lua_Integer>(value));
         return {};
     }
 
     [[nodiscard]] static TypeResult<int8_t> get(lua_State* L, int index)
     {
-        if (lua_type(L, index) != LUA_TNUMBER)
-            return makeErrorCode(ErrorCode::InvalidTypeCast);
-
-        if (! is_integral_representable_by<int8_t>(L, index))
-            return makeErrorCode(ErrorCode::IntegerDoesntFitIntoLuaInteger);
-
-        return static_cast<int8_t>(lua_tointeger(L, index));
+        return detail::get_integral<int8_t>(L, index);
     }
 
     [[nodiscard]] static bool isInstance(lua_State* L, int index)
@@ -321,26 +430,27 @@ struct Stack<unsigned char>
 {
     static_assert(sizeof(unsigned char) < sizeof(lua_Integer));
 
+    static constexpr int stackSlots = 1;
+
     [[nodiscard]] static Result push(lua_State* L, unsigned char value)
     {
 #if LUABRIDGE_SAFE_STACK_CHECKS
-        if (! lua_checkstack(L, 1))
+        if (! lua_checkstack(L, stackSlots))
             return makeErrorCode(ErrorCode::LuaStackOverflow);
 #endif
 
+        return pushUnchecked(L, value);
+    }
+
+    [[nodiscard]] static Result pushUnchecked(lua_State* L, unsigned char value)
+    {
         pushunsigned(L, value);
         return {};
     }
 
     [[nodiscard]] static TypeResult<unsigned char> get(lua_State* L, int index)
     {
-        if (lua_type(L, index) != LUA_TNUMBER)
-            return makeErrorCode(ErrorCode::InvalidTypeCast);
-
-        if (! is_integral_representable_by<unsigned char>(L, index))
-            return makeErrorCode(ErrorCode::IntegerDoesntFitIntoLuaInteger);
-
-        return static_cast<unsigned char>(lua_tointeger(L, index));
+        return detail::get_integral<unsigned char>(L, index);
     }
 
     [[nodiscard]] static bool isInstance(lua_State* L, int index)
@@ -361,26 +471,27 @@ struct Stack<short>
 {
     static_assert(sizeof(short) < sizeof(lua_Integer));
 
+    static constexpr int stackSlots = 1;
+
     [[nodiscard]] static Result push(lua_State* L, short value)
     {
 #if LUABRIDGE_SAFE_STACK_CHECKS
-        if (! lua_checkstack(L, 1))
+        if (! lua_checkstack(L, stackSlots))
             return makeErrorCode(ErrorCode::LuaStackOverflow);
 #endif
 
+        return pushUnchecked(L, value);
+    }
+
+    [[nodiscard]] static Result pushUnchecked(lua_State* L, short value)
+    {
         lua_pushinteger(L, static_cast<lua_Integer>(value));
         return {};
     }
 
     [[nodiscard]] static TypeResult<short> get(lua_State* L, int index)
     {
-        if (lua_type(L, index) != LUA_TNUMBER)
-            return makeErrorCode(ErrorCode::InvalidTypeCast);
-
-        if (! is_integral_representable_by<short>(L, index))
-            return makeErrorCode(ErrorCode::IntegerDoesntFitIntoLuaInteger);
-
-        return static_cast<short>(lua_tointeger(L, index));
+        return detail::get_integral<short>(L, index);
     }
 
     [[nodiscard]] static bool isInstance(lua_State* L, int index)
@@ -401,26 +512,27 @@ struct Stack<unsigned short>
 {
     static_assert(sizeof(unsigned short) < sizeof(lua_Integer));
 
+    static constexpr int stackSlots = 1;
+
     [[nodiscard]] static Result push(lua_State* L, unsigned short value)
     {
 #if LUABRIDGE_SAFE_STACK_CHECKS
-        if (! lua_checkstack(L, 1))
+        if (! lua_checkstack(L, stackSlots))
             return makeErrorCode(ErrorCode::LuaStackOverflow);
 #endif
 
+        return pushUnchecked(L, value);
+    }
+
+    [[nodiscard]] static Result pushUnchecked(lua_State* L, unsigned short value)
+    {
         pushunsigned(L, value);
         return {};
     }
 
     [[nodiscard]] static TypeResult<unsigned short> get(lua_State* L, int index)
     {
-        if (lua_type(L, index) != LUA_TNUMBER)
-            return makeErrorCode(ErrorCode::InvalidTypeCast);
-
-        if (! is_integral_representable_by<unsigned short>(L, index))
-            return makeErrorCode(ErrorCode::IntegerDoesntFitIntoLuaInteger);
-
-        return static_cast<unsigned short>(lua_tointeger(L, index));
+        return detail::get_integral<unsigned short>(L, index);
     }
 
     [[nodiscard]] static bool isInstance(lua_State* L, int index)
@@ -439,15 +551,25 @@ struct Stack<unsigned short>
 template <>
 struct Stack<int>
 {
+    static constexpr int stackSlots = 1;
+
     [[nodiscard]] static Result push(lua_State* L, int value)
     {
 #if LUABRIDGE_SAFE_STACK_CHECKS
-        if (! lua_checkstack(L, 1))
+        if (! lua_checkstack(L, stackSlots))
             return makeErrorCode(ErrorCode::LuaStackOverflow);
 #endif
 
-        if (! is_integral_representable_by(value))
-            return makeErrorCode(ErrorCode::IntegerDoesntFitIntoLuaInteger);
+        return pushUnchecked(L, value);
+    }
+
+    [[nodiscard]] static Result pushUnchecked(lua_State* L, int value)
+    {
+        if constexpr (! is_integral_range_within_v<int>)
+        {
+            if (! is_integral_representable_by(value))
+                return makeErrorCode(ErrorCode::IntegerDoesntFitIntoLuaInteger);
+        }
 
         lua_pushinteger(L, static_cast<lua_Integer>(value));
         return {};
@@ -455,13 +577,7 @@ struct Stack<int>
 
     [[nodiscard]] static TypeResult<int> get(lua_State* L, int index)
     {
-        if (lua_type(L, index) != LUA_TNUMBER)
-            return makeErrorCode(ErrorCode::InvalidTypeCast);
-
-        if (! is_integral_representable_by<int>(L, index))
-            return makeErrorCode(ErrorCode::IntegerDoesntFitIntoLuaInteger);
-
-        return static_cast<int>(lua_tointeger(L, index));
+        return detail::get_integral<int>(L, index);
     }
 
     [[nodiscard]] static bool isInstance(lua_State* L, int index)
@@ -480,15 +596,25 @@ struct Stack<int>
 template <>
 struct Stack<unsigned int>
 {
+    static constexpr int stackSlots = 1;
+
     [[nodiscard]] static Result push(lua_State* L, unsigned int value)
     {
 #if LUABRIDGE_SAFE_STACK_CHECKS
-        if (! lua_checkstack(L, 1))
+        if (! lua_checkstack(L, stackSlots))
             return makeErrorCode(ErrorCode::LuaStackOverflow);
 #endif
 
-        if (! is_integral_representable_by(value))
-            return makeErrorCode(ErrorCode::IntegerDoesntFitIntoLuaInteger);
+        return pushUnchecked(L, value);
+    }
+
+    [[nodiscard]] static Result pushUnchecked(lua_State* L, unsigned int value)
+    {
+        if constexpr (! is_integral_range_within_v<unsigned int>)
+        {
+            if (! is_integral_representable_by(value))
+                return makeErrorCode(ErrorCode::IntegerDoesntFitIntoLuaInteger);
+        }
 
         pushunsigned(L, value);
         return {};
@@ -496,13 +622,7 @@ struct Stack<unsigned int>
 
     [[nodiscard]] static TypeResult<unsigned int> get(lua_State* L, int index)
     {
-        if (lua_type(L, index) != LUA_TNUMBER)
-            return makeErrorCode(ErrorCode::InvalidTypeCast);
-
-        if (! is_integral_representable_by<unsigned int>(L, index))
-            return makeErrorCode(ErrorCode::IntegerDoesntFitIntoLuaInteger);
-
-        return static_cast<unsigned int>(lua_tointeger(L, index));
+        return detail::get_integral<unsigned int>(L, index);
     }
 
     [[nodiscard]] static bool isInstance(lua_State* L, int index)
@@ -521,15 +641,25 @@ struct Stack<unsigned int>
 template <>
 struct Stack<long>
 {
+    static constexpr int stackSlots = 1;
+
     [[nodiscard]] static Result push(lua_State* L, long value)
     {
 #if LUABRIDGE_SAFE_STACK_CHECKS
-        if (! lua_checkstack(L, 1))
+        if (! lua_checkstack(L, stackSlots))
             return makeErrorCode(ErrorCode::LuaStackOverflow);
 #endif
 
-        if (! is_integral_representable_by(value))
-            return makeErrorCode(ErrorCode::IntegerDoesntFitIntoLuaInteger);
+        return pushUnchecked(L, value);
+    }
+
+    [[nodiscard]] static Result pushUnchecked(lua_State* L, long value)
+    {
+        if constexpr (! is_integral_range_within_v<long>)
+        {
+            if (! is_integral_representable_by(value))
+                return makeErrorCode(ErrorCode::IntegerDoesntFitIntoLuaInteger);
+        }
 
         lua_pushinteger(L, static_cast<lua_Integer>(value));
         return {};
@@ -537,13 +667,7 @@ struct Stack<long>
 
     [[nodiscard]] static TypeResult<long> get(lua_State* L, int index)
     {
-        if (lua_type(L, index) != LUA_TNUMBER)
-            return makeErrorCode(ErrorCode::InvalidTypeCast);
-
-        if (! is_integral_representable_by<long>(L, index))
-            return makeErrorCode(ErrorCode::IntegerDoesntFitIntoLuaInteger);
-
-        return static_cast<long>(lua_tointeger(L, index));
+        return detail::get_integral<long>(L, index);
     }
 
     [[nodiscard]] static bool isInstance(lua_State* L, int index)
@@ -562,15 +686,25 @@ struct Stack<long>
 template <>
 struct Stack<unsigned long>
 {
+    static constexpr int stackSlots = 1;
+
     [[nodiscard]] static Result push(lua_State* L, unsigned long value)
     {
 #if LUABRIDGE_SAFE_STACK_CHECKS
-        if (! lua_checkstack(L, 1))
+        if (! lua_checkstack(L, stackSlots))
             return makeErrorCode(ErrorCode::LuaStackOverflow);
 #endif
 
-        if (! is_integral_representable_by(value))
-            return makeErrorCode(ErrorCode::IntegerDoesntFitIntoLuaInteger);
+        return pushUnchecked(L, value);
+    }
+
+    [[nodiscard]] static Result pushUnchecked(lua_State* L, unsigned long value)
+    {
+        if constexpr (! is_integral_range_within_v<unsigned long>)
+        {
+            if (! is_integral_representable_by(value))
+                return makeErrorCode(ErrorCode::IntegerDoesntFitIntoLuaInteger);
+        }
 
         pushunsigned(L, value);
         return {};
@@ -578,13 +712,7 @@ struct Stack<unsigned long>
 
     [[nodiscard]] static TypeResult<unsigned long> get(lua_State* L, int index)
     {
-        if (lua_type(L, index) != LUA_TNUMBER)
-            return makeErrorCode(ErrorCode::InvalidTypeCast);
-
-        if (! is_integral_representable_by<unsigned long>(L, index))
-            return makeErrorCode(ErrorCode::IntegerDoesntFitIntoLuaInteger);
-
-        return static_cast<unsigned long>(lua_tointeger(L, index));
+        return detail::get_integral<unsigned long>(L, index);
     }
 
     [[nodiscard]] static bool isInstance(lua_State* L, int index)
@@ -603,15 +731,25 @@ struct Stack<unsigned long>
 template <>
 struct Stack<long long>
 {
+    static constexpr int stackSlots = 1;
+
     [[nodiscard]] static Result push(lua_State* L, long long value)
     {
 #if LUABRIDGE_SAFE_STACK_CHECKS
-        if (! lua_checkstack(L, 1))
+        if (! lua_checkstack(L, stackSlots))
             return makeErrorCode(ErrorCode::LuaStackOverflow);
 #endif
 
-        if (! is_integral_representable_by(value))
-            return makeErrorCode(ErrorCode::IntegerDoesntFitIntoLuaInteger);
+        return pushUnchecked(L, value);
+    }
+
+    [[nodiscard]] static Result pushUnchecked(lua_State* L, long long value)
+    {
+        if constexpr (! is_integral_range_within_v<long long>)
+        {
+            if (! is_integral_representable_by(value))
+                return makeErrorCode(ErrorCode::IntegerDoesntFitIntoLuaInteger);
+        }
 
         lua_pushinteger(L, static_cast<lua_Integer>(value));
         return {};
@@ -619,13 +757,7 @@ struct Stack<long long>
 
     [[nodiscard]] static TypeResult<long long> get(lua_State* L, int index)
     {
-        if (lua_type(L, index) != LUA_TNUMBER)
-            return makeErrorCode(ErrorCode::InvalidTypeCast);
-
-        if (! is_integral_representable_by<long long>(L, index))
-            return makeErrorCode(ErrorCode::IntegerDoesntFitIntoLuaInteger);
-
-        return static_cast<long long>(lua_tointeger(L, index));
+        return detail::get_integral<long long>(L, index);
     }
 
     [[nodiscard]] static bool isInstance(lua_State* L, int index)
@@ -644,15 +776,25 @@ struct Stack<long long>
 template <>
 struct Stack<unsigned long long>
 {
+    static constexpr int stackSlots = 1;
+
     [[nodiscard]] static Result push(lua_State* L, unsigned long long value)
     {
 #if LUABRIDGE_SAFE_STACK_CHECKS
-        if (! lua_checkstack(L, 1))
+        if (! lua_checkstack(L, stackSlots))
             return makeErrorCode(ErrorCode::LuaStackOverflow);
 #endif
 
-        if (! is_integral_representable_by(value))
-            return makeErrorCode(ErrorCode::IntegerDoesntFitIntoLuaInteger);
+        return pushUnchecked(L, value);
+    }
+
+    [[nodiscard]] static Result pushUnchecked(lua_State* L, unsigned long long value)
+    {
+        if constexpr (! is_integral_range_within_v<unsigned long long>)
+        {
+            if (! is_integral_representable_by(value))
+                return makeErrorCode(ErrorCode::IntegerDoesntFitIntoLuaInteger);
+        }
 
         pushunsigned(L, value);
         return {};
@@ -660,13 +802,7 @@ struct Stack<unsigned long long>
 
     [[nodiscard]] static TypeResult<unsigned long long> get(lua_State* L, int index)
     {
-        if (lua_type(L, index) != LUA_TNUMBER)
-            return makeErrorCode(ErrorCode::InvalidTypeCast);
-
-        if (! is_integral_representable_by<unsigned long long>(L, index))
-            return makeErrorCode(ErrorCode::IntegerDoesntFitIntoLuaInteger);
-
-        return static_cast<unsigned long long>(lua_tointeger(L, index));
+        return detail::get_integral<unsigned long long>(L, index);
     }
 
     [[nodiscard]] static bool isInstance(lua_State* L, int index)
@@ -686,15 +822,25 @@ struct Stack<unsigned long long>
 template <>
 struct Stack<__int128_t>
 {
+    static constexpr int stackSlots = 1;
+
     [[nodiscard]] static Result push(lua_State* L, __int128_t value)
     {
 #if LUABRIDGE_SAFE_STACK_CHECKS
-        if (! lua_checkstack(L, 1))
+        if (! lua_checkstack(L, stackSlots))
             return makeErrorCode(ErrorCode::LuaStackOverflow);
 #endif
 
-        if (! is_integral_representable_by(value))
-            return makeErrorCode(ErrorCode::IntegerDoesntFitIntoLuaInteger);
+        return pushUnchecked(L, value);
+    }
+
+    [[nodiscard]] static Result pushUnchecked(lua_State* L, __int128_t value)
+    {
+        if constexpr (! is_integral_range_within_v<__int128_t>)
+        {
+            if (! is_integral_representable_by(value))
+                return makeErrorCode(ErrorCode::IntegerDoesntFitIntoLuaInteger);
+        }
 
         lua_pushinteger(L, static_cast<lua_Integer>(value));
         return {};
@@ -702,13 +848,7 @@ struct Stack<__int128_t>
 
     [[nodiscard]] static TypeResult<__int128_t> get(lua_State* L, int index)
     {
-        if (lua_type(L, index) != LUA_TNUMBER)
-            return makeErrorCode(ErrorCode::InvalidTypeCast);
-
-        if (! is_integral_representable_by<__int128_t>(L, index))
-            return makeErrorCode(ErrorCode::IntegerDoesntFitIntoLuaInteger);
-
-        return static_cast<__int128_t>(lua_tointeger(L, index));
+        return detail::get_integral<__int128_t>(L, index);
     }
 
     [[nodiscard]] static bool isInstance(lua_State* L, int index)
@@ -727,15 +867,25 @@ struct Stack<__int128_t>
 template <>
 struct Stack<__uint128_t>
 {
+    static constexpr int stackSlots = 1;
+
     [[nodiscard]] static Result push(lua_State* L, __uint128_t value)
     {
 #if LUABRIDGE_SAFE_STACK_CHECKS
-        if (! lua_checkstack(L, 1))
+        if (! lua_checkstack(L, stackSlots))
             return makeErrorCode(ErrorCode::LuaStackOverflow);
 #endif
 
-        if (! is_integral_representable_by(value))
-            return makeErrorCode(ErrorCode::IntegerDoesntFitIntoLuaInteger);
+        return pushUnchecked(L, value);
+    }
+
+    [[nodiscard]] static Result pushUnchecked(lua_State* L, __uint128_t value)
+    {
+        if constexpr (! is_integral_range_within_v<__uint128_t>)
+        {
+            if (! is_integral_representable_by(value))
+                return makeErrorCode(ErrorCode::IntegerDoesntFitIntoLuaInteger);
+        }
 
         lua_pushinteger(L, static_cast<lua_Integer>(value));
         return {};
@@ -743,13 +893,7 @@ struct Stack<__uint128_t>
 
     [[nodiscard]] static TypeResult<__uint128_t> get(lua_State* L, int index)
     {
-        if (lua_type(L, index) != LUA_TNUMBER)
-            return makeErrorCode(ErrorCode::InvalidTypeCast);
-
-        if (! is_integral_representable_by<__uint128_t>(L, index))
-            return makeErrorCode(ErrorCode::IntegerDoesntFitIntoLuaInteger);
-
-        return static_cast<__uint128_t>(lua_tointeger(L, index));
+        return detail::get_integral<__uint128_t>(L, index);
     }
 
     [[nodiscard]] static bool isInstance(lua_State* L, int index)
@@ -769,13 +913,20 @@ struct Stack<__uint128_t>
 template <>
 struct Stack<float>
 {
+    static constexpr int stackSlots = 1;
+
     [[nodiscard]] static Result push(lua_State* L, float value)
     {
 #if LUABRIDGE_SAFE_STACK_CHECKS
-        if (! lua_checkstack(L, 1))
+        if (! lua_checkstack(L, stackSlots))
             return makeErrorCode(ErrorCode::LuaStackOverflow);
 #endif
 
+        return pushUnchecked(L, value);
+    }
+
+    [[nodiscard]] static Result pushUnchecked(lua_State* L, float value)
+    {
         if (! is_floating_point_representable_by(value))
             return makeErrorCode(ErrorCode::FloatingPointDoesntFitIntoLuaNumber);
 
@@ -810,13 +961,20 @@ struct Stack<float>
 template <>
 struct Stack<double>
 {
+    static constexpr int stackSlots = 1;
+
     [[nodiscard]] static Result push(lua_State* L, double value)
     {
 #if LUABRIDGE_SAFE_STACK_CHECKS
-        if (! lua_checkstack(L, 1))
+        if (! lua_checkstack(L, stackSlots))
             return makeErrorCode(ErrorCode::LuaStackOverflow);
 #endif
 
+        return pushUnchecked(L, value);
+    }
+
+    [[nodiscard]] static Result pushUnchecked(lua_State* L, double value)
+    {
         if (! is_floating_point_representable_by(value))
             return makeErrorCode(ErrorCode::FloatingPointDoesntFitIntoLuaNumber);
 
@@ -851,13 +1009,20 @@ struct Stack<double>
 template <>
 struct Stack<long double>
 {
+    static constexpr int stackSlots = 1;
+
     [[nodiscard]] static Result push(lua_State* L, long double value)
     {
 #if LUABRIDGE_SAFE_STACK_CHECKS
-        if (! lua_checkstack(L, 1))
+        if (! lua_checkstack(L, stackSlots))
             return makeErrorCode(ErrorCode::LuaStackOverflow);
 #endif
 
+        return pushUnchecked(L, value);
+    }
+
+    [[nodiscard]] static Result pushUnchecked(lua_State* L, long double value)
+    {
         if (! is_floating_point_representable_by(value))
             return makeErrorCode(ErrorCode::FloatingPointDoesntFitIntoLuaNumber);
 
@@ -892,13 +1057,20 @@ struct Stack<long double>
 template <>
 struct Stack<const char*>
 {
+    static constexpr int stackSlots = 1;
+
     [[nodiscard]] static Result push(lua_State* L, const char* str)
     {
 #if LUABRIDGE_SAFE_STACK_CHECKS
-        if (! lua_checkstack(L, 1))
+        if (! lua_checkstack(L, stackSlots))
             return makeErrorCode(ErrorCode::LuaStackOverflow);
 #endif
 
+        return pushUnchecked(L, str);
+    }
+
+    [[nodiscard]] static Result pushUnchecked(lua_State* L, const char* str)
+    {
         if (str != nullptr)
             lua_pushstring(L, str);
         else
@@ -938,13 +1110,20 @@ struct Stack<const char*>
 template <>
 struct Stack<std::string_view>
 {
+    static constexpr int stackSlots = 1;
+
     [[nodiscard]] static Result push(lua_State* L, std::string_view str)
     {
 #if LUABRIDGE_SAFE_STACK_CHECKS
-        if (! lua_checkstack(L, 1))
+        if (! lua_checkstack(L, stackSlots))
             return makeErrorCode(ErrorCode::LuaStackOverflow);
 #endif
 
+        return pushUnchecked(L, str);
+    }
+
+    [[nodiscard]] static Result pushUnchecked(lua_State* L, std::string_view str)
+    {
         lua_pushlstring(L, str.data(), str.size());
         return {};
     }
@@ -975,13 +1154,20 @@ struct Stack<std::string_view>
 template <>
 struct Stack<std::string>
 {
+    static constexpr int stackSlots = 1;
+
     [[nodiscard]] static Result push(lua_State* L, const std::string& str)
     {
 #if LUABRIDGE_SAFE_STACK_CHECKS
-        if (! lua_checkstack(L, 1))
+        if (! lua_checkstack(L, stackSlots))
             return makeErrorCode(ErrorCode::LuaStackOverflow);
 #endif
 
+        return pushUnchecked(L, str);
+    }
+
+    [[nodiscard]] static Result pushUnchecked(lua_State* L, const std::string& str)
+    {
         lua_pushlstring(L, str.data(), str.size());
         return {};
     }
@@ -1032,13 +1218,25 @@ struct Stack<std::optional<T>>
 {
     using Type = std::optional<T>;
 
+    static constexpr int stackSlots = detail::nested_stack_slots_v<0, T>;
+
     [[nodiscard]] static Result push(lua_State* L, const Type& value)
+    {
+#if LUABRIDGE_SAFE_STACK_CHECKS
+        if (! lua_checkstack(L, stackSlots > 0 ? stackSlots : 1))
+            return makeErrorCode(ErrorCode::LuaStackOverflow);
+#endif
+
+        return pushUnchecked(L, value);
+    }
+
+    [[nodiscard]] static Result pushUnchecked(lua_State* L, const Type& value)
     {
         if (value)
         {
             StackRestore stackRestore(L);
 
-            auto result = Stack<T>::push(L, *value);
+            auto result = detail::push_reserved<T>(L, *value);
             if (! result)
                 return result;
 
@@ -1046,11 +1244,6 @@ struct Stack<std::optional<T>>
             return {};
         }
 
-#if LUABRIDGE_SAFE_STACK_CHECKS
-        if (! lua_checkstack(L, 1))
-            return makeErrorCode(ErrorCode::LuaStackOverflow);
-#endif
-
         lua_pushnil(L);
         return {};
     }
@@ -1082,13 +1275,20 @@ struct Stack<std::optional<T>>
 template <class T1, class T2>
 struct Stack<std::pair<T1, T2>>
 {
+    static constexpr int stackSlots = detail::nested_stack_slots_v<2, T1, T2>;
+
     [[nodiscard]] static Result push(lua_State* L, const std::pair<T1, T2>& t)
     {
 #if LUABRIDGE_SAFE_STACK_CHECKS
-        if (! lua_checkstack(L, 3))
+        if (! lua_checkstack(L, stackSlots > 0 ? stackSlots : 3))
             return makeErrorCode(ErrorCode::LuaStackOverflow);
 #endif
 
+        return pushUnchecked(L, t);
+    }
+
+    [[nodiscard]] static Result pushUnchecked(lua_State* L, const std::pair<T1, T2>& t)
+    {
         StackRestore stackRestore(L);
 
         lua_createtable(L, 2, 0);
@@ -1146,7 +1346,7 @@ private:
 
         lua_pushinteger(L, static_cast<lua_Integer>(Index + 1));
 
-        auto result = Stack<T>::push(L, std::get<Index>(p));
+        auto result = detail::push_reserved<T>(L, std::get<Index>(p));
         if (! result)
         {
             lua_pushnil(L);
@@ -1187,13 +1387,20 @@ private:
 template <class... Types>
 struct Stack<std::tuple<Types...>>
 {
+    static constexpr int stackSlots = detail::nested_stack_slots_v<2, Types...>;
+
     [[nodiscard]] static Result push(lua_State* L, const std::tuple<Types...>& t)
     {
 #if LUABRIDGE_SAFE_STACK_CHECKS
-        if (! lua_checkstack(L, 3))
+        if (! lua_checkstack(L, stackSlots > 0 ? stackSlots : 3))
             return makeErrorCode(ErrorCode::LuaStackOverflow);
 #endif
 
+        return pushUnchecked(L, t);
+    }
+
+    [[nodiscard]] static Result pushUnchecked(lua_State* L, const std::tuple<Types...>& t)
+    {
         StackRestore stackRestore(L);
 
         lua_createtable(L, static_cast<int>(Size), 0);
@@ -1251,7 +1458,7 @@ private:
 
         lua_pushinteger(L, static_cast<lua_Integer>(Index + 1));
 
-        auto result = Stack<T>::push(L, std::get<Index>(t));
+        auto result = detail::push_reserved<T>(L, std::get<Index>(t));
         if (! result)
         {
             lua_pushnil(L);
@@ -1300,24 +1507,26 @@ struct Stack<T[N]>
 {
     static_assert(N > 0, "Unsupported zero sized array");
 
+    static constexpr int stackSlots = std::is_same_v<T, char> ? 1 : detail::nested_stack_slots_v<2, T>;
+
     [[nodiscard]] static Result push(lua_State* L, const T (&value)[N])
     {
-        if constexpr (std::is_same_v<T, char>)
-        {
 #if LUABRIDGE_SAFE_STACK_CHECKS
-            if (! lua_checkstack(L, 1))
-                return makeErrorCode(ErrorCode::LuaStackOverflow);
+        if (! lua_checkstack(L, stackSlots > 0 ? stackSlots : 2))
+            return makeErrorCode(ErrorCode::LuaStackOverflow);
 #endif
 
+        return pushUnchecked(L, value);
+    }
+
+    [[nodiscard]] static Result pushUnchecked(lua_State* L, const T (&value)[N])
+    {
+        if constexpr (std::is_same_v<T, char>)
+        {
             lua_pushlstring(L, value, N - 1);
             return {};
         }
 
-#if LUABRIDGE_SAFE_STACK_CHECKS
-        if (! lua_checkstack(L, 2))
-            return makeErrorCode(ErrorCode::LuaStackOverflow);
-#endif
-
         StackRestore stackRestore(L);
 
         lua_createtable(L, static_cast<int>(N), 0);
@@ -1326,7 +1535,7 @@ struct Stack<T[N]>
         {
             lua_pushinteger(L, static_cast<lua_Integer>(i + 1));
 
-            auto result = Stack<T>::push(L, value[i]);
+            auto result = detail::push_reserved<T>(L, value[i]);
             if (! result)
                 return result;
 
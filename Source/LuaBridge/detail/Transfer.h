@@ -0,0 +1,325 @@
+// https://github.com/kunitoki/LuaBridge3
+// Copyright 2023, Lucio Asnaghi
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "Config.h"
+#include "ClassInfo.h"
+#include "Errors.h"
+#include "LuaHelpers.h"
+#include "Result.h"
+#include "ScopeGuard.h"
+#include "Userdata.h"
+
+#include <functional>
+
+namespace luabridge {
+namespace detail {
+
+inline constexpr int transferMaxDepth = 1000;
+
+//=================================================================================================
+/**
+ * @brief Hook pushing a copy of an object of a registered class into another state.
+ *
+ * The hook is stored as the upvalue of a closure in the class metatables, so binding images can capture it like any other function.
+ */
+struct TransferHook
+{
+    std::function<Result(const void* object, lua_State* to)> function;
+};
+
+/**
+ * @brief The closure holding a transfer hook as its upvalue, it is never called.
+ */
+inline int transfer_hook_holder(lua_State*)
+{
+    return 0;
+}
+
+//=================================================================================================
+/**
+ * @brief Deep copy of values between two independent states, using raw stack operations on both sides.
+ *
+ * Tables are rebuilt presized, with shared references and cycles preserved. Objects of registered classes are copied through the
+ * transfer hook stored in their metatable.
+ */
+class Transfer
+{
+public:
+    Transfer(lua_State* from, lua_State* to) noexcept
+        : m_from(from)
+        , m_to(to)
+    {
+    }
+
+    /**
+     * @brief Push on the destination state a copy of the value at index in the source state.
+     *
+     * On failure nothing is pushed and both stacks are left untouched.
+     */
+    Result run(int index)
+    {
+        index = lua_absindex(m_from, index);
+
+        if (isSameState())
+        {
+            if (! lua_checkstack(m_from, 1))
+                return makeErrorCode(ErrorCode::LuaStackOverflow);
+
+            lua_pushvalue(m_from, index);
+            lua_xmove(m_from, m_to, 1);
+            return {};
+        }
+
+        const int fromTop = lua_gettop(m_from);
+        const int toTop = lua_gettop(m_to);
+
+        if (! lua_checkstack(m_to, 1))
+            return makeErrorCode(ErrorCode::LuaStackOverflow);
+
+        // Transfer hooks pushing unregistered classes might throw
+        ScopeGuard restoreStacks([this, fromTop, toTop]
+        {
+            lua_settop(m_from, fromTop);
+            lua_settop(m_to, toTop);
+        });
+
+        lua_pushnil(m_to); // Stack: visited (vt) | nil
+        m_visitedIndex = lua_gettop(m_to);
+
+        if (auto result = transferValue(index, 0); ! result)
+            return result;
+
+        restoreStacks.reset();
+
+        lua_remove(m_to, m_visitedIndex); // Stack: value
+        return {};
+    }
+
+private:
+    bool isSameState() const
+    {
+        if (m_from == m_to)
+            return true;
+
+        if (! lua_checkstack(m_from, 1) || ! lua_checkstack(m_to, 1))
+            return false;
+
+        lua_pushvalue(m_from, LUA_REGISTRYINDEX);
+        lua_pushvalue(m_to, LUA_REGISTRYINDEX);
+
+        const bool sameRegistry = lua_topointer(m_from, -1) == lua_topointer(m_to, -1);
+
+        lua_pop(m_from, 1);
+        lua_pop(m_to, 1);
+
+        return sameRegistry;
+    }
+
+    Result transferValue(int index, int depth)
+    {
+        if (! lua_checkstack(m_to, 3))
+            return makeErrorCode(ErrorCode::LuaStackOverflow);
+
+        switch (lua_type(m_from, index))
+        {
+        case LUA_TNIL:
+            lua_pushnil(m_to);
+            return {};
+
+        case LUA_TBOOLEAN:
+            lua_pushboolean(m_to, lua_toboolean(m_from, index));
+            return {};
+
+        case LUA_TNUMBER:
+#if LUA_VERSION_NUM >= 503
+            if (lua_isinteger(m_from, index))
+            {
+                lua_pushinteger(m_to, lua_tointeger(m_from, index));
+                return {};
+            }
+#endif
+            lua_pushnumber(m_to, lua_tonumber(m_from, index));
+            return {};
+
+        case LUA_TSTRING:
+        {
+            std::size_t length = 0;
+            const char* string = lua_tolstring(m_from, index, &length);
+
+            lua_pushlstring(m_to, string, length);
+            return {};
+        }
+
+        case LUA_TLIGHTUSERDATA:
+            lua_pushlightuserdata(m_to, lua_touserdata(m_from, index));
+            return {};
+
+        case LUA_TTABLE:
+            if (pushVisited(index))
+                return {};
+
+            return transferTable(index, depth);
+
+        case LUA_TUSERDATA:
+            if (pushVisited(index))
+                return {};
+
+            return transferObject(index);
+
+        default:
+            return makeErrorCode(ErrorCode::ValueNotTransferable);
+        }
+    }
+
+    Result transferTable(int index, int depth)
+    {
+        if (depth >= transferMaxDepth)
+            return makeErrorCode(ErrorCode::ValueNestedTooDeeply);
+
+        if (! lua_checkstack(m_from, 3))
+            return makeErrorCode(ErrorCode::LuaStackOverflow);
+
+        const int arraySize = get_raw_length(m_from, index);
+
+        int entries = 0;
+        lua_pushnil(m_from); // Stack: nil
+        while (lua_next(m_from, index) != 0) // Stack: key, value
+        {
+            ++entries;
+            lua_pop(m_from, 1); // Stack: key
+        }
+
+        lua_createtable(m_to, arraySize, entries > arraySize ? entries - arraySize : 0); // Stack: table (tb)
+        setVisited(index);
+
+        for (int key = 1; key <= arraySize; ++key)
+        {
+            lua_rawgeti(m_from, index, key); // Stack: value
+            if (auto result = transferValue(lua_gettop(m_from), depth + 1); ! result)
+                return result;
+
+            lua_pop(m_from, 1); // Stack: -
+            lua_rawseti(m_to, -2, key); // tb [key] = value. Stack: tb
+        }
+
+        lua_pushnil(m_from); // Stack: nil
+        while (lua_next(m_from, index) != 0) // Stack: key, value
+        {
+            const int valueIndex = lua_gettop(m_from);
+
+            if (is_array_key(m_from, valueIndex - 1, arraySize))
+            {
+                lua_pop(m_from, 1); // Stack: key
+                continue;
+            }
+
+            if (auto result = transferValue(valueIndex - 1, depth + 1); ! result) // Stack: tb, key
+                return result;
+
+            if (auto result = transferValue(valueIndex, depth + 1); ! result) // Stack: tb, key, value
+                return result;
+
+            lua_rawset(m_to, -3); // tb [key] = value. Stack: tb
+            lua_pop(m_from, 1); // Stack: key
+        }
+
+        return {};
+    }
+
+    Result transferObject(int index)
+    {
+        if (! lua_checkstack(m_from, 2) || ! lua_getmetatable(m_from, index)) // Stack: metatable (mt)
+            return makeErrorCode(ErrorCode::ValueNotTransferable);
+
+        lua_rawgetp(m_from, -1, getTransferKey()); // Stack: mt, holder | nil
+        if (! lua_iscfunction(m_from, -1) || lua_getupvalue(m_from, -1, 1) == nullptr) // Stack: mt, holder, hook
+        {
+            lua_pop(m_from, 2);
+            return makeErrorCode(ErrorCode::ValueNotTransferable);
+        }
+
+        // The hook stays alive after the pops: the object at index is still on the source stack and references it through its metatable
+        const auto* hook = align<TransferHook>(get_closure_storage(m_from, -1));
+        lua_pop(m_from, 3); // Stack: -
+
+        const auto* object = static_cast<Userdata*>(lua_touserdata(m_from, index));
+        if (object->isDisposed())
+            return makeErrorCode(ErrorCode::ValueNotTransferable);
+
+        const int toTop = lua_gettop(m_to);
+
+        if (auto result = hook->function(object->getPointer(), m_to); ! result)
+        {
+            lua_settop(m_to, toTop);
+            return result;
+        }
+
+        LUABRIDGE_ASSERT(lua_gettop(m_to) == toTop + 1);
+
+        setVisited(index);
+        return {};
+    }
+
+    /**
+     * @brief Push the copy already made of a table or userdata, if any.
+     */
+    bool pushVisited(int index)
+    {
+        if (lua_isnil(m_to, m_visitedIndex))
+            return false;
+
+        lua_rawgetp(m_to, m_visitedIndex, lua_topointer(m_from, index)); // Stack: copy | nil
+        if (! lua_isnil(m_to, -1))
+            return true;
+
+        lua_pop(m_to, 1); // Stack: -
+        return false;
+    }
+
+    /**
+     * @brief Remember the copy on top of the destination stack, made of a table or userdata.
+     */
+    void setVisited(int index)
+    {
+        if (lua_isnil(m_to, m_visitedIndex))
+        {
+            lua_newtable(m_to); // Stack: copy, visited (vt)
+            lua_replace(m_to, m_visitedIndex); // Stack: copy
+        }
+
+        lua_pushvalue(m_to, -1); // Stack: copy, copy
+        lua_rawsetp(m_to, m_visitedIndex, lua_topointer(m_from, index)); // vt [source] = copy. Stack: copy
+    }
+
+    lua_State* m_from;
+    lua_State* m_to;
+    int m_visitedIndex = 0;
+};
+
+} // namespace detail
+
+//=================================================================================================
+/**
+ * @brief Copy a value from a state to another independent state.
+ *
+ * Tables are copied deeply and rebuilt with their final size, preserving shared references and cycles, but not their metatables.
+ * Objects of registered classes are copied through the hook set with `Class<T>::addTransfer`, the class must be registered in the
+ * destination state too. Functions, threads and objects without a transfer hook can't be transferred, nor can tables nested more than
+ * 1000 levels deep. When both states share the same main state the value itself is moved.
+ *
+ * @param from The source state.
+ * @param index The index of the value on the source stack.
+ * @param to The destination state.
+ *
+ * @returns An empty result with the copy pushed on the destination stack, or an error code with both stacks left untouched. If a
+ *          transfer hook throws, both stacks are restored before the exception propagates.
+ */
+inline Result transfer(lua_State* from, int index, lua_State* to)
+{
+    return detail::Transfer(from, to).run(index);
+}
+
+} // namespace luabridge
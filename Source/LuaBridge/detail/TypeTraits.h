@@ -9,6 +9,7 @@
 #include "Config.h"
 
 #include <memory>
+#include <type_traits>
 
 namespace luabridge {
 namespace detail {
@@ -124,5 +125,37 @@ public:
     static constexpr bool value = sizeof(test<ContainerTraits<T>>(nullptr)) == sizeof(yes);
 };
 
+//=================================================================================================
+/**
+ * @brief Determine if type T is an intrusive container.
+ *
+ * Intrusive containers declare the IsIntrusive alias in their ContainerTraits specialization, and the type they hold must expose
+ * `incReferenceCount` and `decReferenceCount`. The userdata then stores only the object pointer and not the container.
+ */
+template <class T, class Enable = void>
+struct IsIntrusiveContainer : std::false_type
+{
+};
+
+template <class T>
+struct IsIntrusiveContainer<T, std::void_t<typename ContainerTraits<T>::IsIntrusive>> : std::true_type
+{
+};
+
+//=================================================================================================
+/**
+ * @brief Determine if type T exposes an intrusive reference count.
+ */
+template <class T, class Enable = void>
+struct IsIntrusiveRefCounted : std::false_type
+{
+};
+
+template <class T>
+struct IsIntrusiveRefCounted<T, std::void_t<decltype(std::declval<const T&>().incReferenceCount()),
+                                            decltype(std::declval<const T&>().decReferenceCount())>> : std::true_type
+{
+};
+
 } // namespace detail
 } // namespace luabridge
@@ -8,6 +8,8 @@
 
 #include "Config.h"
 #include "Errors.h"
+#include "ExternalMemory.h"
+#include "ObjectCensus.h"
 #include "LuaException.h"
 #include "ClassInfo.h"
 #include "TypeTraits.h"
@@ -36,8 +38,27 @@ namespace detail {
  *   3. Scripts cannot set the metatable on a userdata.
  */
 
+/**
+ * @brief Storage kind of a userdata.
+ *
+ * Stored in the userdata header so the __gc metamethod can destroy the object with a direct call instead of going through a vtable.
+ */
+enum class UserdataKind : unsigned char
+{
+    Value,    ///< The object lives inside the userdata (UserdataValue).
+    Pointer,  ///< The userdata holds a non owning pointer (UserdataPtr).
+    External, ///< The userdata owns an externally allocated object (UserdataValueExternal).
+    Shared,   ///< The userdata holds a container referencing the object (UserdataShared).
+    Intrusive ///< The userdata holds a reference to an intrusively reference counted object (UserdataIntrusive).
+};
+
+//=================================================================================================
 /**
  * @brief Interface to a class pointer retrievable from a userdata.
+ *
+ * The header is deliberately non polymorphic: it is made of the object pointer and a kind byte, so small value types can use the
+ * trailing padding and no vtable pointer is stored per object. On Luau it also records the external memory reported for the object, as
+ * userdata are destroyed there without access to the state.
  */
 class Userdata
 {
@@ -202,9 +223,12 @@ private:
         return nullptr;
     }
 
-public:
-    virtual ~Userdata() {}
+    static void throwDisposedArg(lua_State* L, int index)
+    {
+        luaL_argerror(L, index, "attempt to use a disposed object");
+    }
 
+public:
     //=============================================================================================
     /**
      * @brief Returns the Userdata* if the class on the Lua stack matches.
@@ -228,7 +252,7 @@ public:
     /**
      * @brief Get a pointer to the class from the Lua stack.
      *
-     * If the object is not the class or a subclass, or it violates the const-ness, a Lua error is raised.
+     * If the object is not the class or a subclass, it violates the const-ness, or it has been disposed, a Lua error is raised.
      *
      * @tparam T A registered user class.
      *
@@ -248,6 +272,12 @@ public:
         if (! clazz)
             return nullptr;
 
+        if (clazz->isDisposed())
+        {
+            throwDisposedArg(L, index);
+            return nullptr;
+        }
+
         return static_cast<T*>(clazz->getPointer());
     }
 
@@ -257,8 +287,42 @@ public:
         return isInstance(L, index, detail::getClassRegistryKey<T>());
     }
 
-protected:
-    Userdata() = default;
+    /**
+     * @brief Push the metatable registered with the specified key.
+     *
+     * Nothing is pushed if the class is not registered, so the caller can bail out leaving the stack untouched.
+     */
+    static std::error_code pushClassMetatable(lua_State* L, const void* key)
+    {
+        lua_rawgetp(L, LUA_REGISTRYINDEX, key); // Stack: metatable (mt) | nil
+
+        if (lua_istable(L, -1))
+            return {};
+
+        lua_pop(L, 1); // possibly: a nil
+
+#if LUABRIDGE_RAISE_UNREGISTERED_CLASS_USAGE
+        return throw_or_error_code<LuaException>(L, ErrorCode::ClassNotRegistered);
+#else
+        return makeErrorCode(ErrorCode::ClassNotRegistered);
+#endif
+    }
+
+    /**
+     * @brief Get the storage kind of this userdata.
+     */
+    UserdataKind getKind() const noexcept
+    {
+        return m_kind;
+    }
+
+    /**
+     * @brief Check if the object has been released by `dispose` (or by the __gc metamethod).
+     */
+    bool isDisposed() const noexcept
+    {
+        return m_p == nullptr;
+    }
 
     /**
      * @brief Get an untyped pointer to the contained class.
@@ -268,7 +332,44 @@ protected:
         return m_p;
     }
 
+    /**
+     * @brief Remember the external memory reported for the object, to release the same amount when the object is released.
+     */
+    void trackExternalMemory(ExternalMemoryRecord record) noexcept
+    {
+        m_externalMemory = record;
+    }
+
+    /**
+     * @brief Release the external memory reported for the object, which must have been tracked.
+     */
+    void releaseExternalMemory([[maybe_unused]] lua_State* L)
+    {
+#if LUABRIDGE_ON_LUAU
+        m_externalMemory.release();
+#else
+        release_external_memory(L, m_externalMemory);
+#endif
+    }
+
+protected:
+    explicit Userdata(UserdataKind kind) noexcept
+        : m_kind(kind)
+    {
+    }
+
+#if LUABRIDGE_ON_LUAU
+    ~Userdata()
+    {
+        m_externalMemory.release();
+    }
+#else
+    ~Userdata() = default;
+#endif
+
     void* m_p = nullptr; // subclasses must set this
+    ExternalMemoryRecord m_externalMemory;
+    UserdataKind m_kind; // Last, so subclasses can pack their members in the tail padding
 };
 
 //=================================================================================================
@@ -289,10 +390,19 @@ public:
     UserdataValue operator=(const UserdataValue&) = delete;
 
     ~UserdataValue()
+    {
+        destroy();
+    }
+
+    /**
+     * @brief Destroy the object, the userdata is left disposed.
+     */
+    void destroy() noexcept
     {
         if (getPointer() != nullptr)
         {
             getObject()->~T();
+            m_p = nullptr;
         }
     }
 
@@ -307,26 +417,13 @@ public:
      */
     static UserdataValue<T>* place(lua_State* L, std::error_code& ec)
     {
-        auto* ud = new (lua_newuserdata_x<UserdataValue<T>>(L, sizeof(UserdataValue<T>))) UserdataValue<T>();
-
-        lua_rawgetp(L, LUA_REGISTRYINDEX, detail::getClassRegistryKey<T>());
-
-        if (!lua_istable(L, -1))
-        {
-            lua_pop(L, 1); // possibly: a nil
-
-            ud->~UserdataValue<T>();
-
-#if LUABRIDGE_RAISE_UNREGISTERED_CLASS_USAGE
-            ec = throw_or_error_code<LuaException>(L, ErrorCode::ClassNotRegistered);
-#else
-            ec = makeErrorCode(ErrorCode::ClassNotRegistered);
-#endif
-
+        ec = pushClassMetatable(L, detail::getClassRegistryKey<T>()); // Stack: mt
+        if (ec)
             return nullptr;
-        }
 
-        lua_setmetatable(L, -2);
+        auto* ud = new (lua_newuserdata_x<UserdataValue<T>>(L, sizeof(UserdataValue<T>))) UserdataValue<T>(); // Stack: mt, ud
+        lua_insert(L, -2); // Stack: ud, mt
+        lua_setmetatable(L, -2); // Stack: ud
 
         return ud;
     }
@@ -353,6 +450,9 @@ public:
 
         ud->commit();
 
+        count_object_created(L);
+        ud->trackExternalMemory(report_object_external_memory(L, ud->getObject()));
+
         return {};
     }
 
@@ -378,6 +478,9 @@ public:
 
         ud->commit();
 
+        count_object_created(L);
+        ud->trackExternalMemory(report_object_external_memory(L, ud->getObject()));
+
         return {};
     }
 
@@ -405,7 +508,7 @@ private:
      * @brief Used for placement construction.
      */
     UserdataValue() noexcept
-        : Userdata()
+        : Userdata(UserdataKind::Value)
     {
         if constexpr (MaxPadding > 0)
         {
@@ -433,6 +536,14 @@ public:
     UserdataPtr(const UserdataPtr&) = delete;
     UserdataPtr operator=(const UserdataPtr&) = delete;
 
+    /**
+     * @brief Forget the object pointer, the userdata is left disposed. The object itself is owned by C++ and is not destroyed.
+     */
+    void destroy() noexcept
+    {
+        m_p = nullptr;
+    }
+
     /**
      * @brief Push non-const pointer to object.
      *
@@ -471,35 +582,93 @@ public:
         return {};
     }
 
+    /**
+     * @brief Remove an object from the pointer identity cache of its class.
+     *
+     * @tparam T A user registered class.
+     *
+     * @param L A Lua state.
+     * @param ptr A pointer to the user class instance.
+     */
+    template <class T>
+    static void invalidate(lua_State* L, const T* ptr)
+    {
+        invalidate(L, ptr, getClassRegistryKey<T>());
+        invalidate(L, ptr, getConstRegistryKey<T>());
+    }
+
 private:
     /**
      * @brief Push a pointer to object using metatable key.
+     *
+     * If the class has been registered with the `cachedPointers` option, the userdata previously pushed for the same pointer is reused.
      */
     static Result push(lua_State* L, const void* ptr, const void* key)
     {
-        auto* udptr = new (lua_newuserdata_x<UserdataPtr>(L, sizeof(UserdataPtr))) UserdataPtr(const_cast<void*>(ptr));
+        if (auto ec = pushClassMetatable(L, key)) // Stack: metatable (mt)
+            return ec;
 
-        lua_rawgetp(L, LUA_REGISTRYINDEX, key);
+        lua_rawgetp(L, -1, getPointerCacheKey()); // Stack: mt, pointer cache (pc) | nil
 
         if (!lua_istable(L, -1))
         {
-            lua_pop(L, 1); // possibly: a nil
+            lua_pop(L, 1); // Stack: mt
 
-            udptr->~UserdataPtr();
+            new (lua_newuserdata_x<UserdataPtr>(L, sizeof(UserdataPtr))) UserdataPtr(const_cast<void*>(ptr)); // Stack: mt, ud
+            lua_insert(L, -2); // Stack: ud, mt
+            lua_setmetatable(L, -2); // Stack: ud
 
-#if LUABRIDGE_RAISE_UNREGISTERED_CLASS_USAGE
-            return throw_or_error_code<LuaException>(L, ErrorCode::ClassNotRegistered);
-#else
-            return makeErrorCode(ErrorCode::ClassNotRegistered);
-#endif
+            count_object_created(L);
+
+            return {};
+        }
+
+        lua_rawgetp(L, -1, ptr); // Stack: mt, pc, ud | nil
+
+        if (!lua_isuserdata(L, -1) || static_cast<Userdata*>(lua_touserdata(L, -1))->isDisposed())
+        {
+            lua_pop(L, 1); // Stack: mt, pc
+
+            new (lua_newuserdata_x<UserdataPtr>(L, sizeof(UserdataPtr))) UserdataPtr(const_cast<void*>(ptr)); // Stack: mt, pc, ud
+            lua_pushvalue(L, -3); // Stack: mt, pc, ud, mt
+            lua_setmetatable(L, -2); // Stack: mt, pc, ud
+            lua_pushvalue(L, -1); // Stack: mt, pc, ud, ud
+            lua_rawsetp(L, -3, ptr); // pc [ptr] = ud. Stack: mt, pc, ud
+
+            count_object_created(L);
         }
 
-        lua_setmetatable(L, -2);
+        lua_replace(L, -3); // Stack: ud, pc
+        lua_pop(L, 1); // Stack: ud
 
         return {};
     }
 
+    /**
+     * @brief Remove a pointer from the identity cache of the metatable with the specified key.
+     */
+    static void invalidate(lua_State* L, const void* ptr, const void* key)
+    {
+        lua_rawgetp(L, LUA_REGISTRYINDEX, key); // Stack: metatable (mt) | nil
+
+        if (lua_istable(L, -1))
+        {
+            lua_rawgetp(L, -1, getPointerCacheKey()); // Stack: mt, pointer cache (pc) | nil
+
+            if (lua_istable(L, -1))
+            {
+                lua_pushnil(L); // Stack: mt, pc, nil
+                lua_rawsetp(L, -2, ptr); // pc [ptr] = nil. Stack: mt, pc
+            }
+
+            lua_pop(L, 1); // Stack: mt
+        }
+
+        lua_pop(L, 1); // Stack: -
+    }
+
     explicit UserdataPtr(void* ptr)
+        : Userdata(UserdataKind::Pointer)
     {
         // Can't construct with a null object!
         LUABRIDGE_ASSERT(ptr != nullptr);
@@ -522,9 +691,20 @@ public:
     UserdataValueExternal operator=(const UserdataValueExternal&) = delete;
 
     ~UserdataValueExternal()
+    {
+        destroy();
+    }
+
+    /**
+     * @brief Deallocate the object, the userdata is left disposed.
+     */
+    void destroy() noexcept
     {
         if (getObject() != nullptr)
+        {
             m_dealloc(getObject());
+            m_p = nullptr;
+        }
     }
 
     /**
@@ -539,26 +719,15 @@ public:
     template <class Dealloc>
     static UserdataValueExternal<T>* place(lua_State* L, T* obj, Dealloc dealloc, std::error_code& ec)
     {
-        auto* ud = new (lua_newuserdata_x<UserdataValueExternal<T>>(L, sizeof(UserdataValueExternal<T>))) UserdataValueExternal<T>(obj, dealloc);
-
-        lua_rawgetp(L, LUA_REGISTRYINDEX, detail::getClassRegistryKey<T>());
-
-        if (!lua_istable(L, -1))
-        {
-            lua_pop(L, 1); // possibly: a nil
-
-            ud->~UserdataValueExternal<T>();
-
-#if LUABRIDGE_RAISE_UNREGISTERED_CLASS_USAGE
-            ec = throw_or_error_code<LuaException>(L, ErrorCode::ClassNotRegistered);
-#else
-            ec = makeErrorCode(ErrorCode::ClassNotRegistered);
-#endif
-
+        ec = pushClassMetatable(L, detail::getClassRegistryKey<T>()); // Stack: mt
+        if (ec)
             return nullptr;
-        }
 
-        lua_setmetatable(L, -2);
+        auto* ud = new (lua_newuserdata_x<UserdataValueExternal<T>>(L, sizeof(UserdataValueExternal<T>))) UserdataValueExternal<T>(obj, dealloc); // Stack: mt, ud
+        lua_insert(L, -2); // Stack: ud, mt
+        lua_setmetatable(L, -2); // Stack: ud
+
+        count_object_created(L);
 
         return ud;
     }
@@ -570,6 +739,7 @@ public:
 
 private:
     UserdataValueExternal(void* ptr, void (*dealloc)(T*)) noexcept
+        : Userdata(UserdataKind::External)
     {
         // Can't construct with a null object!
         LUABRIDGE_ASSERT(ptr != nullptr);
@@ -583,6 +753,44 @@ private:
     void (*m_dealloc)(T*) = nullptr;
 };
 
+//============================================================================
+/**
+ * @brief Common header of the userdata holding a container.
+ *
+ * The container type is not known by the __gc metamethod of the class, so the header stores the destroy function of the concrete
+ * UserdataShared instantiation.
+ */
+class UserdataSharedBase : public Userdata
+{
+public:
+    UserdataSharedBase(const UserdataSharedBase&) = delete;
+    UserdataSharedBase& operator=(const UserdataSharedBase&) = delete;
+
+    /**
+     * @brief Destroy the container, releasing its reference to the object. The userdata is left disposed.
+     */
+    void destroy() noexcept
+    {
+        if (m_p != nullptr)
+        {
+            m_destroy(this);
+            m_p = nullptr;
+        }
+    }
+
+protected:
+    explicit UserdataSharedBase(void (*destroy)(UserdataSharedBase*) noexcept) noexcept
+        : Userdata(UserdataKind::Shared)
+        , m_destroy(destroy)
+    {
+    }
+
+    ~UserdataSharedBase() = default;
+
+private:
+    void (*m_destroy)(UserdataSharedBase*) noexcept;
+};
+
 //============================================================================
 /**
  * @brief Wraps a container that references a class object.
@@ -590,13 +798,16 @@ private:
  * The template argument C is the container type, ContainerTraits must be specialized on C or else a compile error will result.
  */
 template <class C>
-class UserdataShared : public Userdata
+class UserdataShared : public UserdataSharedBase
 {
 public:
     UserdataShared(const UserdataShared&) = delete;
     UserdataShared& operator=(const UserdataShared&) = delete;
 
-    ~UserdataShared() = default;
+    ~UserdataShared()
+    {
+        destroy();
+    }
 
     /**
      * @brief Construct from a container to the class or a derived class.
@@ -606,7 +817,9 @@ public:
      * @param  u A container object reference.
      */
     template <class U>
-    explicit UserdataShared(const U& u) : m_c(u)
+    explicit UserdataShared(const U& u)
+        : UserdataSharedBase(&UserdataShared::destroyContainer)
+        , m_c(u)
     {
         m_p = const_cast<void*>(reinterpret_cast<const void*>((ContainerTraits<C>::get(m_c))));
     }
@@ -619,154 +832,128 @@ public:
      * @param u A container object pointer.
      */
     template <class U>
-    explicit UserdataShared(U* u) : m_c(u)
+    explicit UserdataShared(U* u)
+        : UserdataSharedBase(&UserdataShared::destroyContainer)
+        , m_c(u)
     {
         m_p = const_cast<void*>(reinterpret_cast<const void*>((ContainerTraits<C>::get(m_c))));
     }
 
 private:
-    C m_c;
+    static void destroyContainer(UserdataSharedBase* ud) noexcept
+    {
+        static_cast<UserdataShared*>(ud)->m_c.~C();
+    }
+
+    // The container is destroyed explicitly, so it can be released before the userdata is collected
+    union
+    {
+        C m_c;
+    };
 };
 
-//=================================================================================================
+//============================================================================
 /**
- * @brief SFINAE helper for non-const objects.
+ * @brief Wraps an intrusively reference counted class object.
+ *
+ * Only the object pointer is stored, the userdata holds one reference which is released on collection with a direct call.
  */
-template <class C, bool MakeObjectConst>
-struct UserdataSharedHelper
+template <class T>
+class UserdataIntrusive : public Userdata
 {
-    using T = std::remove_const_t<typename ContainerTraits<C>::Type>;
+public:
+    UserdataIntrusive(const UserdataIntrusive&) = delete;
+    UserdataIntrusive& operator=(const UserdataIntrusive&) = delete;
 
-    static Result push(lua_State* L, const C& c)
+    explicit UserdataIntrusive(const T* object) noexcept
+        : Userdata(UserdataKind::Intrusive)
     {
-        if (ContainerTraits<C>::get(c) != nullptr)
-        {
-            auto* us = new (lua_newuserdata_x<UserdataShared<C>>(L, sizeof(UserdataShared<C>))) UserdataShared<C>(c);
-
-            lua_rawgetp(L, LUA_REGISTRYINDEX, getClassRegistryKey<T>());
+        LUABRIDGE_ASSERT(object != nullptr);
 
-            if (!lua_istable(L, -1))
-            {
-                lua_pop(L, 1); // possibly: a nil
-
-                us->~UserdataShared<C>();
-
-#if LUABRIDGE_RAISE_UNREGISTERED_CLASS_USAGE
-                return throw_or_error_code<LuaException>(L, ErrorCode::ClassNotRegistered);
-#else
-                return makeErrorCode(ErrorCode::ClassNotRegistered);
-#endif
-            }
-
-            lua_setmetatable(L, -2);
-        }
-        else
-        {
-            lua_pushnil(L);
-        }
-
-        return {};
+        object->incReferenceCount();
+        m_p = const_cast<T*>(object);
     }
 
-    static Result push(lua_State* L, T* t)
+    ~UserdataIntrusive()
     {
-        if (t)
-        {
-            auto* us = new (lua_newuserdata_x<UserdataShared<C>>(L, sizeof(UserdataShared<C>))) UserdataShared<C>(t);
-
-            lua_rawgetp(L, LUA_REGISTRYINDEX, getClassRegistryKey<T>());
-
-            if (!lua_istable(L, -1))
-            {
-                lua_pop(L, 1); // possibly: a nil
-
-                us->~UserdataShared<C>();
-
-#if LUABRIDGE_RAISE_UNREGISTERED_CLASS_USAGE
-                return throw_or_error_code<LuaException>(L, ErrorCode::ClassNotRegistered);
-#else
-                return makeErrorCode(ErrorCode::ClassNotRegistered);
-#endif
-            }
+        destroy();
+    }
 
-            lua_setmetatable(L, -2);
-        }
-        else
+    /**
+     * @brief Release the reference to the object, the userdata is left disposed.
+     */
+    void destroy() noexcept
+    {
+        if (m_p != nullptr)
         {
-            lua_pushnil(L);
+            static_cast<const T*>(m_p)->decReferenceCount();
+            m_p = nullptr;
         }
-
-        return {};
     }
 };
 
+//=================================================================================================
 /**
- * @brief SFINAE helper for const objects.
+ * @brief SFINAE helper for non-const objects.
  */
-template <class C>
-struct UserdataSharedHelper<C, true>
+template <class C, bool MakeObjectConst>
+struct UserdataSharedHelper
 {
     using T = std::remove_const_t<typename ContainerTraits<C>::Type>;
 
     static Result push(lua_State* L, const C& c)
     {
-        if (ContainerTraits<C>::get(c) != nullptr)
-        {
-            auto* us = new (lua_newuserdata_x<UserdataShared<C>>(L, sizeof(UserdataShared<C>))) UserdataShared<C>(c);
-
-            lua_rawgetp(L, LUA_REGISTRYINDEX, getConstRegistryKey<T>());
-
-            if (!lua_istable(L, -1))
-            {
-                lua_pop(L, 1); // possibly: a nil
-
-                us->~UserdataShared<C>();
-
-#if LUABRIDGE_RAISE_UNREGISTERED_CLASS_USAGE
-                return throw_or_error_code<LuaException>(L, ErrorCode::ClassNotRegistered);
-#else
-                return makeErrorCode(ErrorCode::ClassNotRegistered);
-#endif
-            }
-
-            lua_setmetatable(L, -2);
-        }
-        else
+        if (ContainerTraits<C>::get(c) == nullptr)
         {
             lua_pushnil(L);
+            return {};
         }
 
-        return {};
+        return place(L, c);
     }
 
     static Result push(lua_State* L, T* t)
     {
-        if (t)
+        if (t == nullptr)
         {
-            auto* us = new (lua_newuserdata_x<UserdataShared<C>>(L, sizeof(UserdataShared<C>))) UserdataShared<C>(t);
+            lua_pushnil(L);
+            return {};
+        }
 
-            lua_rawgetp(L, LUA_REGISTRYINDEX, getConstRegistryKey<T>());
+        return place(L, t);
+    }
 
-            if (!lua_istable(L, -1))
-            {
-                lua_pop(L, 1); // possibly: a nil
+private:
+    template <class U>
+    static Result place(lua_State* L, const U& u)
+    {
+        const void* key = MakeObjectConst ? getConstRegistryKey<T>() : getClassRegistryKey<T>();
 
-                us->~UserdataShared<C>();
+        if (auto ec = Userdata::pushClassMetatable(L, key)) // Stack: mt
+            return ec;
 
-#if LUABRIDGE_RAISE_UNREGISTERED_CLASS_USAGE
-                return throw_or_error_code<LuaException>(L, ErrorCode::ClassNotRegistered);
-#else
-                return makeErrorCode(ErrorCode::ClassNotRegistered);
-#endif
-            }
+        Userdata* ud;
+        if constexpr (IsIntrusiveContainer<C>::value)
+        {
+            const T* object;
+            if constexpr (std::is_pointer_v<U>)
+                object = u;
+            else
+                object = ContainerTraits<C>::get(u);
 
-            lua_setmetatable(L, -2);
+            ud = new (lua_newuserdata_x<UserdataIntrusive<T>>(L, sizeof(UserdataIntrusive<T>))) UserdataIntrusive<T>(object); // Stack: mt, ud
         }
         else
         {
-            lua_pushnil(L);
+            ud = new (lua_newuserdata_x<UserdataShared<C>>(L, sizeof(UserdataShared<C>))) UserdataShared<C>(u); // Stack: mt, ud
         }
 
+        lua_insert(L, -2); // Stack: ud, mt
+        lua_setmetatable(L, -2); // Stack: ud
+
+        count_object_created(L);
+        ud->trackExternalMemory(report_object_external_memory(L, static_cast<const T*>(ud->getPointer())));
+
         return {};
     }
 };
@@ -1035,4 +1222,22 @@ struct StackOpSelector<const T&, true>
 };
 
 } // namespace detail
+
+//=================================================================================================
+/**
+ * @brief Forget the userdata cached for an object of a class registered with the `cachedPointers` option.
+ *
+ * Call this when the C++ object is destroyed, so a new object allocated at the same address will not reuse the stale userdata.
+ *
+ * @tparam T A user registered class.
+ *
+ * @param L A Lua state.
+ * @param object A pointer to the object being destroyed.
+ */
+template <class T>
+void invalidateCachedPointer(lua_State* L, const T* object)
+{
+    detail::UserdataPtr::invalidate(L, object);
+}
+
 } // namespace luabridge
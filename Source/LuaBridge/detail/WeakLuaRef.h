@@ -0,0 +1,345 @@
+// https://github.com/kunitoki/LuaBridge3
+// Copyright 2023, Lucio Asnaghi
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "Config.h"
+#include "ClassInfo.h"
+#include "LuaHelpers.h"
+#include "LuaRef.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+
+namespace luabridge {
+
+namespace detail {
+
+//=================================================================================================
+/**
+ * @brief Push the table holding the weak references of a state, creating it on first use.
+ *
+ * The table has weak values, so it doesn't keep the referenced values alive. Slots are reused through a free list: the head of the list
+ * is stored at index 0 and the number of allocated slots at index -1, free slots store the index of the next free slot.
+ */
+inline void push_weak_references_table(lua_State* L)
+{
+    lua_rawgetp(L, LUA_REGISTRYINDEX, getWeakReferencesKey()); // Stack: weak table (wt) | nil
+    if (lua_istable(L, -1))
+        return;
+
+    lua_pop(L, 1); // Stack: -
+
+    lua_newtable(L); // Stack: wt
+    lua_newtable(L); // Stack: wt, metatable (mt)
+    lua_pushstring(L, "v");
+    rawsetfield(L, -2, "__mode"); // mt ["__mode"] = "v". Stack: wt, mt
+    lua_setmetatable(L, -2); // Stack: wt
+
+    lua_pushvalue(L, -1); // Stack: wt, wt
+    lua_rawsetp(L, LUA_REGISTRYINDEX, getWeakReferencesKey()); // Stack: wt
+}
+
+/**
+ * @brief Store the value on top of the stack in a slot of the weak references table and pop it.
+ */
+inline int weak_ref(lua_State* L)
+{
+    if (lua_isnil(L, -1))
+    {
+        lua_pop(L, 1);
+        return LUA_NOREF;
+    }
+
+    push_weak_references_table(L); // Stack: value, wt
+
+    int slot = 0;
+
+    lua_rawgeti(L, -1, 0); // Stack: value, wt, free slot | nil
+    if (lua_isnumber(L, -1))
+    {
+        slot = static_cast<int>(lua_tointeger(L, -1));
+
+        lua_rawgeti(L, -2, slot); // Stack: value, wt, free slot, next free slot
+        lua_rawseti(L, -3, 0); // wt [0] = next free slot. Stack: value, wt, free slot
+    }
+    else
+    {
+        lua_rawgeti(L, -2, -1); // Stack: value, wt, nil, slots count | nil
+        slot = static_cast<int>(lua_tointeger(L, -1)) + 1;
+        lua_pop(L, 1); // Stack: value, wt, nil
+
+        lua_pushinteger(L, slot); // Stack: value, wt, nil, slots count
+        lua_rawseti(L, -3, -1); // wt [-1] = slots count. Stack: value, wt, nil
+    }
+
+    lua_pop(L, 1); // Stack: value, wt
+    lua_insert(L, -2); // Stack: wt, value
+    lua_rawseti(L, -2, slot); // wt [slot] = value. Stack: wt
+    lua_pop(L, 1); // Stack: -
+
+    return slot;
+}
+
+/**
+ * @brief Release a slot of the weak references table.
+ */
+inline void weak_unref(lua_State* L, int slot)
+{
+    push_weak_references_table(L); // Stack: wt
+
+    lua_rawgeti(L, -1, 0); // Stack: wt, free slot | nil
+    lua_rawseti(L, -2, slot); // wt [slot] = free slot. Stack: wt
+    lua_pushinteger(L, slot); // Stack: wt, slot
+    lua_rawseti(L, -2, 0); // wt [0] = slot. Stack: wt
+    lua_pop(L, 1); // Stack: -
+}
+
+/**
+ * @brief Push the value of a slot of the weak references table, nil if it has been collected.
+ */
+inline void weak_push(lua_State* L, int slot)
+{
+    push_weak_references_table(L); // Stack: wt
+    lua_rawgeti(L, -1, slot); // Stack: wt, value | nil
+    lua_remove(L, -2); // Stack: value | nil
+}
+
+} // namespace detail
+
+//=================================================================================================
+/**
+ * @brief Weak reference to a Lua value.
+ *
+ * Unlike `LuaRef`, a weak reference doesn't keep the value alive: it is stored in a per state table with weak values instead of the
+ * registry, so caches of script callbacks and objects don't grow the registry and can be reclaimed by the garbage collector. Use `lock`
+ * to get a strong reference while the value is needed.
+ *
+ * Strings, numbers and booleans are never collected, weak references to them never expire.
+ */
+class WeakLuaRef
+{
+public:
+    //=============================================================================================
+    /**
+     * @brief Create an empty weak reference.
+     *
+     * @param L A Lua state.
+     */
+    explicit WeakLuaRef(lua_State* L) noexcept
+        : m_L(L)
+    {
+    }
+
+    //=============================================================================================
+    /**
+     * @brief Create a weak reference to the value of a reference.
+     *
+     * @param ref A reference to the value.
+     */
+    explicit WeakLuaRef(const LuaRef& ref)
+        : m_L(ref.state())
+    {
+#if LUABRIDGE_SAFE_STACK_CHECKS
+        if (! lua_checkstack(m_L, 4))
+            return;
+#endif
+
+        ref.push(m_L);
+        m_ref = detail::weak_ref(m_L);
+    }
+
+    //=============================================================================================
+    /**
+     * @brief Create a new weak reference to the same value of an existing weak reference.
+     *
+     * @param other An existing weak reference.
+     */
+    WeakLuaRef(const WeakLuaRef& other)
+        : m_L(other.m_L)
+    {
+        if (other.m_ref == LUA_NOREF)
+            return;
+
+#if LUABRIDGE_SAFE_STACK_CHECKS
+        if (! lua_checkstack(m_L, 4))
+            return;
+#endif
+
+        detail::weak_push(m_L, other.m_ref);
+        m_ref = detail::weak_ref(m_L);
+    }
+
+    //=============================================================================================
+    /**
+     * @brief Move a weak reference.
+     *
+     * @param other An existing weak reference.
+     */
+    WeakLuaRef(WeakLuaRef&& other) noexcept
+        : m_L(other.m_L)
+        , m_ref(std::exchange(other.m_ref, LUA_NOREF))
+    {
+    }
+
+    //=============================================================================================
+    /**
+     * @brief Destroy a weak reference, releasing its slot.
+     */
+    ~WeakLuaRef()
+    {
+        reset();
+    }
+
+    //=============================================================================================
+    /**
+     * @brief Assign a weak reference.
+     */
+    WeakLuaRef& operator=(const WeakLuaRef& rhs)
+    {
+        if (this != &rhs)
+        {
+            WeakLuaRef copy(rhs);
+            swap(copy);
+        }
+
+        return *this;
+    }
+
+    WeakLuaRef& operator=(WeakLuaRef&& rhs) noexcept
+    {
+        if (this != &rhs)
+        {
+            reset();
+
+            m_L = rhs.m_L;
+            m_ref = std::exchange(rhs.m_ref, LUA_NOREF);
+        }
+
+        return *this;
+    }
+
+    //=============================================================================================
+    /**
+     * @brief Create a weak reference to a Lua stack item with a specified index.
+     *
+     * @param L A Lua state.
+     * @param index An index in the Lua stack.
+     *
+     * @returns A weak reference to a value in a Lua stack.
+     */
+    static WeakLuaRef fromStack(lua_State* L, int index)
+    {
+        WeakLuaRef result(L);
+
+#if LUABRIDGE_SAFE_STACK_CHECKS
+        if (! lua_checkstack(L, 4))
+            return result;
+#endif
+
+        lua_pushvalue(L, index);
+        result.m_ref = detail::weak_ref(L);
+        return result;
+    }
+
+    //=============================================================================================
+    /**
+     * @brief Get the lua state of the reference.
+     */
+    lua_State* state() const noexcept
+    {
+        return m_L;
+    }
+
+    //=============================================================================================
+    /**
+     * @brief Check if the referenced value has been collected, or if the reference is empty.
+     */
+    [[nodiscard]] bool expired() const
+    {
+        if (m_ref == LUA_NOREF)
+            return true;
+
+        detail::weak_push(m_L, m_ref);
+        const bool result = lua_isnil(m_L, -1);
+        lua_pop(m_L, 1);
+        return result;
+    }
+
+    //=============================================================================================
+    /**
+     * @brief Get a strong reference to the value.
+     *
+     * If the value has been collected, the slot is released and a nil reference is returned.
+     */
+    [[nodiscard]] LuaRef lock()
+    {
+        if (m_ref == LUA_NOREF)
+            return LuaRef(m_L);
+
+#if LUABRIDGE_SAFE_STACK_CHECKS
+        if (! lua_checkstack(m_L, 2))
+            return LuaRef(m_L);
+#endif
+
+        detail::weak_push(m_L, m_ref); // Stack: value | nil
+        if (lua_isnil(m_L, -1))
+        {
+            lua_pop(m_L, 1);
+            reset();
+            return LuaRef(m_L);
+        }
+
+        return LuaRef::fromStack(m_L);
+    }
+
+    //=============================================================================================
+    /**
+     * @brief Release the slot of the reference, leaving it empty.
+     */
+    void reset()
+    {
+        if (m_ref != LUA_NOREF)
+            detail::weak_unref(m_L, std::exchange(m_ref, LUA_NOREF));
+    }
+
+    //=============================================================================================
+    /**
+     * @brief Swap with another weak reference.
+     */
+    void swap(WeakLuaRef& other) noexcept
+    {
+        using std::swap;
+
+        swap(m_L, other.m_L);
+        swap(m_ref, other.m_ref);
+    }
+
+private:
+    lua_State* m_L = nullptr;
+    int m_ref = LUA_NOREF;
+};
+
+//=================================================================================================
+/**
+ * @brief Remove the expired weak references from a container, releasing their slots.
+ *
+ * @param refs A container of `WeakLuaRef` supporting erase, like `std::vector` or `std::list`.
+ *
+ * @returns The number of weak references removed.
+ */
+template <class Container>
+std::size_t purgeExpired(Container& refs)
+{
+    const auto first = std::remove_if(std::begin(refs), std::end(refs), [](const WeakLuaRef& ref) { return ref.expired(); });
+    const auto count = static_cast<std::size_t>(std::distance(first, std::end(refs)));
+
+    refs.erase(first, std::end(refs));
+
+    return count;
+}
+
+} // namespace luabridge
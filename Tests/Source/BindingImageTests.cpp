@@ -0,0 +1,171 @@
+// https://github.com/kunitoki/LuaBridge3
+// Copyright 2023, Lucio Asnaghi
+// SPDX-License-Identifier: MIT
+
+#include "TestBase.h"
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+struct BindingImageTests : TestBase
+{
+};
+
+namespace {
+struct Vec
+{
+    Vec() = default;
+    Vec(int x, int y) : x(x), y(y) {}
+
+    int length2() const { return x * x + y * y; }
+    void scale(int factor) { x *= factor; y *= factor; }
+
+    int getX() const { return x; }
+    void setX(int value) { x = value; }
+
+    static Vec zero() { return {}; }
+
+    int x = 0;
+    int y = 0;
+};
+
+struct Vec3 : Vec
+{
+    Vec3() = default;
+    Vec3(int x, int y, int z) : Vec(x, y), z(z) {}
+
+    int z = 0;
+};
+
+struct Bag
+{
+    std::unordered_map<std::string, int> values;
+};
+
+int vecCount = 0;
+
+luabridge::BindingImage makeImage(int offset)
+{
+    return luabridge::BindingImage::capture([offset](luabridge::Namespace ns)
+    {
+        ns.beginNamespace("geo")
+            .addFunction("offset", [offset](int value) { return value + offset; })
+            .addFunction("sum", std::function<int(int, int)>([](int a, int b) { return a + b; }))
+            .addProperty("count", &vecCount)
+            .beginClass<Vec>("Vec")
+                .addConstructor<void (*)(), void (*)(int, int)>()
+                .addFunction("length2", &Vec::length2)
+                .addFunction("scale", &Vec::scale)
+                .addFunction("shifted", [offset](const Vec* self) { return self->x + offset; })
+                .addProperty("x", &Vec::getX, &Vec::setX)
+                .addProperty("y", &Vec::y)
+                .addStaticFunction("zero", &Vec::zero)
+            .endClass()
+            .deriveClass<Vec3, Vec>("Vec3")
+                .addConstructor<void (*)(int, int, int)>()
+                .addProperty("z", &Vec3::z)
+            .endClass()
+        .endNamespace();
+    });
+}
+} // namespace
+
+TEST_F(BindingImageTests, InstantiateRegistrations)
+{
+    auto image = makeImage(100);
+    image.instantiate(L);
+
+    runLua("result = geo.offset(1) + geo.sum(2, 3)");
+    EXPECT_EQ(106, result<int>());
+
+    runLua("local v = geo.Vec(3, 4); v:scale(2); result = v:length2()");
+    EXPECT_EQ(100, result<int>());
+
+    runLua("local v = geo.Vec(); v.x = 5; v.y = 7; result = v.x * 10 + v.y + v:shifted()");
+    EXPECT_EQ(162, result<int>());
+
+    runLua("result = geo.Vec.zero():length2()");
+    EXPECT_EQ(0, result<int>());
+
+    runLua("local v = geo.Vec3(1, 2, 3); result = v:length2() + v.z");
+    EXPECT_EQ(8, result<int>());
+
+    runLua("geo.count = 42");
+    EXPECT_EQ(42, vecCount);
+
+    luabridge::setGlobal(L, Vec(1, 1), "pushed");
+    runLua("result = pushed:length2()");
+    EXPECT_EQ(2, result<int>());
+
+    Vec3 derived(2, 0, 0);
+    luabridge::setGlobal(L, static_cast<Vec*>(&derived), "derived");
+    runLua("result = derived:length2()");
+    EXPECT_EQ(4, result<int>());
+}
+
+TEST_F(BindingImageTests, StatesAreIndependent)
+{
+    auto image = makeImage(0);
+
+    lua_State* other = createNewLuaState();
+
+    image.instantiate(L);
+    image.instantiate(other);
+
+    runLua("rawset(geo, 'extra', 1); rawset(geo.Vec, 'extra', 2)", other);
+    runLua("result = tostring(rawget(geo, 'extra')) .. tostring(rawget(geo.Vec, 'extra'))");
+    EXPECT_EQ("nilnil", result<std::string>());
+
+    runLua("result = geo.Vec(1, 2):length2()", other);
+    EXPECT_EQ(5, *luabridge::getGlobal<int>(other, "result"));
+
+    lua_close(other);
+}
+
+TEST_F(BindingImageTests, StateKeepsImageAlive)
+{
+    makeImage(10).instantiate(L);
+
+    lua_gc(L, LUA_GCCOLLECT, 0);
+
+    runLua("result = geo.offset(5) + geo.Vec(1, 0):shifted()");
+    EXPECT_EQ(26, result<int>());
+}
+
+TEST_F(BindingImageTests, TypedFallbacks)
+{
+    auto image = luabridge::BindingImage::capture([](luabridge::Namespace ns)
+    {
+        ns.beginClass<Bag>("Bag")
+            .addConstructor<void (*)()>()
+            .addIndexMetaMethod([](Bag& bag, std::string_view key, lua_State* L) -> int
+            {
+                auto it = bag.values.find(std::string(key));
+                if (it == bag.values.end())
+                    return 0;
+
+                lua_pushinteger(L, it->second);
+                return 1;
+            })
+            .addNewIndexMetaMethod([](Bag& bag, std::string_view key, lua_State* L)
+            {
+                bag.values[std::string(key)] = luabridge::Stack<int>::get(L, -1).value();
+            })
+        .endClass();
+    });
+
+    lua_State* other = createNewLuaState();
+
+    image.instantiate(L);
+    image.instantiate(other);
+
+    runLua("local bag = Bag(); bag.apples = 3; result = bag.apples");
+    EXPECT_EQ(3, result<int>());
+
+    runLua("local bag = Bag(); bag.pears = 4; result = bag.pears + (bag.apples or 0)", other);
+    EXPECT_EQ(4, *luabridge::getGlobal<int>(other, "result"));
+
+    lua_close(other);
+}
@@ -0,0 +1,208 @@
+// https://github.com/kunitoki/LuaBridge3
+// Copyright 2023, Lucio Asnaghi
+// SPDX-License-Identifier: MIT
+
+#include "TestBase.h"
+
+#include <optional>
+#include <string>
+
+struct BindingStatsTests : TestBase
+{
+    void SetUp() override
+    {
+        TestBase::SetUp();
+
+        luabridge::resetBindingStats();
+    }
+
+    std::optional<luabridge::BindingStats> findStats(const std::string& name) const
+    {
+        for (auto& stats : luabridge::getBindingStats())
+        {
+            if (stats.name == name)
+                return stats;
+        }
+
+        return std::nullopt;
+    }
+};
+
+namespace {
+
+struct ProfiledVec
+{
+    double length() const
+    {
+        return x + y;
+    }
+
+    void scale(double factor)
+    {
+        x *= factor;
+        y *= factor;
+    }
+
+    static ProfiledVec unit()
+    {
+        ProfiledVec result;
+        result.x = 1.0;
+        result.y = 1.0;
+        return result;
+    }
+
+    double x = 0.0;
+    double y = 0.0;
+};
+
+int profiledAdd(int a, int b)
+{
+    return a + b;
+}
+
+} // namespace
+
+TEST_F(BindingStatsTests, PercentileFromHistogram)
+{
+    luabridge::BindingStats stats;
+    EXPECT_EQ(std::chrono::nanoseconds(0), stats.percentile(0.5));
+
+    stats.histogram[4] = 90; // [8, 16) ns
+    stats.histogram[10] = 10; // [512, 1024) ns
+    stats.totalTime = std::chrono::nanoseconds(100 * 100);
+
+    EXPECT_EQ(std::chrono::nanoseconds(16), stats.percentile(0.5));
+    EXPECT_EQ(std::chrono::nanoseconds(16), stats.percentile(0.9));
+    EXPECT_EQ(std::chrono::nanoseconds(1024), stats.percentile(0.99));
+    EXPECT_EQ(std::chrono::nanoseconds(100), stats.averageTime());
+}
+
+#if LUABRIDGE_ENABLE_PROFILING
+
+namespace {
+
+int profiledNegate(int value)
+{
+    return -value;
+}
+
+std::string profiledNegate(const std::string& value)
+{
+    return "-" + value;
+}
+
+} // namespace
+
+TEST_F(BindingStatsTests, CountsCallsPerRegisteredName)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<ProfiledVec>("ProfiledVec")
+            .addConstructor<void (*)()>()
+            .addProperty("x", &ProfiledVec::x)
+            .addProperty("y", &ProfiledVec::y)
+            .addFunction("length", &ProfiledVec::length)
+            .addFunction("scale", &ProfiledVec::scale)
+            .addStaticFunction("unit", &ProfiledVec::unit)
+        .endClass()
+        .addFunction("profiledAdd", &profiledAdd);
+
+    runLua(R"(
+        local v = ProfiledVec()
+        v.x = 1
+        v.y = 2
+        local sum = 0
+        for i = 1, 10 do sum = sum + v:length() end
+        v:scale(2)
+        result = sum + v.x + ProfiledVec.unit():length() + profiledAdd(1, 2)
+    )");
+    EXPECT_EQ(30.0 + 2.0 + 2.0 + 3.0, result<double>());
+
+    EXPECT_EQ(1u, findStats("ProfiledVec.__call")->calls);
+    EXPECT_EQ(1u, findStats("ProfiledVec.x [set]")->calls);
+    EXPECT_EQ(1u, findStats("ProfiledVec.x [get]")->calls);
+    EXPECT_EQ(11u, findStats("ProfiledVec.length")->calls);
+    EXPECT_EQ(1u, findStats("ProfiledVec.scale")->calls);
+    EXPECT_EQ(1u, findStats("ProfiledVec.unit")->calls);
+    EXPECT_EQ(1u, findStats("profiledAdd")->calls);
+    EXPECT_EQ(0u, findStats("ProfiledVec.y [get]")->calls);
+
+    const auto length = *findStats("ProfiledVec.length");
+    EXPECT_EQ(0u, length.decodeFailures);
+    EXPECT_GE(length.percentile(0.99), length.percentile(0.5));
+    EXPECT_GT(length.percentile(0.5).count(), 0);
+
+    luabridge::resetBindingStats();
+    EXPECT_EQ(0u, findStats("ProfiledVec.length")->calls);
+}
+
+TEST_F(BindingStatsTests, CountsArgumentDecodeFailures)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<ProfiledVec>("ProfiledVec")
+            .addConstructor<void (*)()>()
+            .addProperty("x", &ProfiledVec::x)
+            .addFunction("scale", &ProfiledVec::scale)
+        .endClass()
+        .addFunction("profiledAdd", &profiledAdd)
+        .addFunction("profiledNegate",
+            luabridge::overload<int>(&profiledNegate),
+            luabridge::overload<const std::string&>(&profiledNegate));
+
+    runLua(R"(
+        local v = ProfiledVec()
+        result = 0
+        if not pcall(function() profiledAdd(1, {}) end) then result = result + 1 end
+        if not pcall(function() v:scale('not a number') end) then result = result + 1 end
+        if not pcall(function() v.x = {} end) then result = result + 1 end
+        if not pcall(function() profiledNegate({}) end) then result = result + 1 end
+        profiledAdd(1, 2)
+        profiledNegate(1)
+    )");
+    EXPECT_EQ(4, result<int>());
+
+    EXPECT_EQ(2u, findStats("profiledAdd")->calls);
+    EXPECT_EQ(1u, findStats("profiledAdd")->decodeFailures);
+    EXPECT_EQ(1u, findStats("ProfiledVec.scale")->decodeFailures);
+    EXPECT_EQ(1u, findStats("ProfiledVec.x [set]")->decodeFailures);
+
+    // A call accepted by one of the overloads is not a failure, even if the other overloads rejected it
+    EXPECT_EQ(2u, findStats("profiledNegate")->calls);
+    EXPECT_EQ(1u, findStats("profiledNegate")->decodeFailures);
+}
+
+TEST_F(BindingStatsTests, LuaVisibleStatsTable)
+{
+    luabridge::getGlobalNamespace(L)
+        .addFunction("profiledAdd", &profiledAdd)
+        .addFunction("bindingStats", &luabridge::pushBindingStats);
+
+    runLua(R"(
+        for i = 1, 3 do profiledAdd(i, i) end
+        local stats = bindingStats()
+        local add = stats.profiledAdd
+        result = add.calls == 3 and add.decodeFailures == 0 and add.totalTime >= 0 and add.p50 > 0 and add.p99 >= add.p50
+            and stats.bindingStats == nil
+    )");
+    EXPECT_TRUE(result<bool>());
+}
+
+#else
+
+TEST_F(BindingStatsTests, CompiledOutByDefault)
+{
+    luabridge::getGlobalNamespace(L)
+        .addFunction("profiledAdd", &profiledAdd);
+
+    runLua("result = profiledAdd(1, 2)");
+    EXPECT_EQ(3, result<int>());
+
+    EXPECT_TRUE(luabridge::getBindingStats().empty());
+
+    luabridge::lua_pushcfunction_x(L, &luabridge::pushBindingStats);
+    lua_call(L, 0, 1);
+    lua_pushnil(L);
+    EXPECT_EQ(0, lua_next(L, -2));
+    lua_pop(L, 1);
+}
+
+#endif
@@ -8,6 +8,8 @@
 #include <functional>
 #include <map>
 #include <memory>
+#include <string>
+#include <string_view>
 #include <unordered_map>
 
 struct ClassExtensibleTests : TestBase
@@ -184,6 +186,137 @@ TEST_F(ClassExtensibleTests, NewIndexFallbackMetaMethodFreeFunctor)
     ASSERT_EQ(246, result<int>());
 }
 
+namespace {
+struct TypedX
+{
+    int value() const { return 42; }
+
+    int index(std::string_view key, lua_State* L)
+    {
+        auto it = components.find(std::string(key));
+        if (it == components.end())
+            return 0;
+
+        lua_pushinteger(L, it->second);
+        return 1;
+    }
+
+    void newIndex(std::string_view key, lua_State* L)
+    {
+        components[std::string(key)] = luabridge::Stack<int>::get(L, -1).value();
+    }
+
+    int constIndex(std::string_view key, lua_State* L) const
+    {
+        auto it = components.find(std::string(key));
+        if (it == components.end())
+            return 0;
+
+        lua_pushinteger(L, it->second);
+        return 1;
+    }
+
+    std::unordered_map<std::string, int> components;
+};
+
+int typedIndexFunction(TypedX& x, std::string_view key, lua_State* L)
+{
+    return x.index(key, L);
+}
+
+void typedNewIndexFunction(TypedX& x, std::string_view key, lua_State* L)
+{
+    x.newIndex(key, L);
+}
+} // namespace
+
+TEST_F(ClassExtensibleTests, TypedIndexFallbackMemberFptr)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<TypedX>("X")
+            .addFunction("value", &TypedX::value)
+            .addIndexMetaMethod(&TypedX::index)
+            .addNewIndexMetaMethod(&TypedX::newIndex)
+        .endClass();
+
+    TypedX x;
+    x.components["health"] = 100;
+    luabridge::setGlobal(L, &x, "x");
+
+    runLua("result = x.health");
+    EXPECT_EQ(100, result<int>());
+
+    runLua("x.armor = 5; result = x.armor + x:value()");
+    EXPECT_EQ(5, x.components["armor"]);
+    EXPECT_EQ(47, result<int>());
+
+    runLua("result = x.missing == nil and x[{}] == nil");
+    EXPECT_TRUE(result<bool>());
+}
+
+TEST_F(ClassExtensibleTests, TypedIndexFallbackConstMemberFptr)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<TypedX>("X")
+            .addIndexMetaMethod(&TypedX::constIndex)
+        .endClass();
+
+    TypedX x;
+    x.components["health"] = 100;
+    luabridge::setGlobal(L, static_cast<const TypedX*>(&x), "x");
+
+    runLua("result = x.health");
+    EXPECT_EQ(100, result<int>());
+}
+
+TEST_F(ClassExtensibleTests, TypedIndexFallbackFunctionPtr)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<TypedX>("X")
+            .addIndexMetaMethod(&typedIndexFunction)
+            .addNewIndexMetaMethod(&typedNewIndexFunction)
+        .endClass();
+
+    TypedX x;
+    luabridge::setGlobal(L, &x, "x");
+
+    runLua("x.speed = 3; result = x.speed");
+    EXPECT_EQ(3, result<int>());
+}
+
+TEST_F(ClassExtensibleTests, TypedIndexFallbackFunctor)
+{
+    int reads = 0;
+    std::string lastWritten;
+
+    luabridge::getGlobalNamespace(L)
+        .beginClass<TypedX>("X")
+            .addIndexMetaMethod([&reads](TypedX& x, std::string_view key, lua_State* L) -> int
+            {
+                ++reads;
+                return x.index(key, L);
+            })
+            .addNewIndexMetaMethod([&lastWritten](TypedX& x, std::string_view key, lua_State* L)
+            {
+                lastWritten = key;
+                x.newIndex(key, L);
+            })
+        .endClass();
+
+    TypedX x;
+    luabridge::setGlobal(L, &x, "x");
+
+    runLua("x.mana = 7; result = x.mana + x.mana");
+    EXPECT_EQ(14, result<int>());
+    EXPECT_EQ(2, reads);
+    EXPECT_EQ("mana", lastWritten);
+
+    const int top = lua_gettop(L);
+    runLua("result = x.unknown");
+    EXPECT_TRUE(result().isNil());
+    EXPECT_EQ(top, lua_gettop(L));
+}
+
 namespace {
 struct ExtensibleBase
 {
@@ -529,6 +662,101 @@ TEST_F(ClassExtensibleTests, ExtensibleClassWithCustomIndexMethod)
     EXPECT_EQ(1042, result<int>());
 }
 
+TEST_F(ClassExtensibleTests, ExtensibleClassInstanceFields)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<ExtensibleBase>("ExtensibleBase", luabridge::extensibleClass)
+            .addConstructor<void(*)()>()
+            .addFunction("baseClass", &ExtensibleBase::baseClass)
+        .endClass()
+    ;
+
+    runLua(R"(
+        function ExtensibleBase:test() return self.value + self:baseClass() end
+
+        local base1 = ExtensibleBase()
+        local base2 = ExtensibleBase()
+        base1.value = 10
+        base2.value = 20
+        base2.callback = function(self, x) return self.value * x end
+
+        result = base1:test() + base2:test() * 100 + base2:callback(2) * 10000
+    )");
+
+    EXPECT_EQ(11 + 2100 + 400000, result<int>());
+
+    runLua(R"(
+        local base = ExtensibleBase()
+        base.value = 1
+        base.value = nil
+        result = base.value == nil and ExtensibleBase().callback == nil and ExtensibleBase.value == nil
+    )");
+
+    EXPECT_TRUE(result<bool>());
+
+    // Fields belong to the userdata and are kept when it goes back and forth
+    runLua("result = ExtensibleBase(); result.name = 'first'");
+
+    auto object = result();
+    luabridge::setGlobal(L, object, "object");
+    runLua("result = object.name");
+    EXPECT_EQ("first", result<std::string>());
+
+#if LUABRIDGE_HAS_EXCEPTIONS
+    EXPECT_ANY_THROW(runLua("local base = ExtensibleBase(); base.baseClass = 42"));
+    EXPECT_ANY_THROW(runLua("local base = ExtensibleBase(); base.__index = 42"));
+#else
+    EXPECT_FALSE(runLua("local base = ExtensibleBase(); base.baseClass = 42"));
+    EXPECT_FALSE(runLua("local base = ExtensibleBase(); base.__index = 42"));
+#endif
+}
+
+TEST_F(ClassExtensibleTests, ExtensibleClassInstanceFieldsOverridingMethods)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<ExtensibleBase>("ExtensibleBase", luabridge::extensibleClass | luabridge::allowOverridingMethods)
+            .addConstructor<void(*)()>()
+            .addFunction("baseClass", &ExtensibleBase::baseClass)
+        .endClass()
+        .deriveClass<ExtensibleDerived, ExtensibleBase>("ExtensibleDerived", luabridge::extensibleClass | luabridge::allowOverridingMethods)
+            .addConstructor<void(*)()>()
+        .endClass()
+    ;
+
+    runLua(R"(
+        local derived1 = ExtensibleDerived()
+        local derived2 = ExtensibleDerived()
+        derived1.baseClass = function(self) return 42 end
+
+        result = derived1:baseClass() + derived2:baseClass()
+    )");
+
+    EXPECT_EQ(43, result<int>());
+}
+
+TEST_F(ClassExtensibleTests, InstanceFieldsRequireExtensibleClass)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<ExtensibleBase>("ExtensibleBase", luabridge::extensibleClass)
+            .addConstructor<void(*)()>()
+        .endClass()
+        .deriveClass<ExtensibleDerived, ExtensibleBase>("ExtensibleDerived")
+            .addConstructor<void(*)()>()
+        .endClass()
+    ;
+
+    const ExtensibleBase constBase;
+    luabridge::setGlobal(L, &constBase, "constBase");
+
+#if LUABRIDGE_HAS_EXCEPTIONS
+    EXPECT_ANY_THROW(runLua("local derived = ExtensibleDerived(); derived.value = 1"));
+    EXPECT_ANY_THROW(runLua("constBase.value = 1"));
+#else
+    EXPECT_FALSE(runLua("local derived = ExtensibleDerived(); derived.value = 1"));
+    EXPECT_FALSE(runLua("constBase.value = 1"));
+#endif
+}
+
 namespace {
 class ExampleStringifiableClass
 {
@@ -1458,6 +1458,38 @@ TEST_F(ClassStaticFunctions, StdFunctions)
     ASSERT_EQ(35, result<Int>().data);
 }
 
+namespace {
+double ffiStaticFunction(double value)
+{
+    return value * 2.0;
+}
+} // namespace
+
+TEST_F(ClassStaticFunctions, FfiFunctionsOption)
+{
+    using Int = Class<int, EmptyBase>;
+
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Int>("Int", luabridge::ffiFunctions)
+        .addConstructor<void (*)(int)>()
+        .addStaticFunction("twice", &ffiStaticFunction)
+        .addStaticFunction("static", &Int::staticFunction)
+        .endClass();
+
+    runLua("result = Int.twice (21)");
+    ASSERT_EQ(42.0, result<double>());
+
+    runLua("result = Int.static (Int (35))");
+    ASSERT_EQ(35, result<Int>().data);
+
+    runLua("result = type (Int.twice)");
+#if LUABRIDGE_ON_LUAJIT
+    EXPECT_EQ("cdata", result<std::string>());
+#else
+    EXPECT_EQ("function", result<std::string>());
+#endif
+}
+
 struct ClassStaticProperties : ClassTests
 {
 };
@@ -2936,3 +2968,228 @@ TEST_F(ClassTests, BugWithFactoryConstructor)
 
     SUCCEED();
 }
+
+namespace {
+struct SchemaClass
+{
+    SchemaClass() = default;
+    SchemaClass(int value) : value(value) {}
+
+    int get() const { return value; }
+    void set(int v) { value = v; }
+
+    int add(int x) const { return value + x; }
+    int add(int x, int y) const { return value + x + y; }
+
+    static int twice(int x) { return x * 2; }
+
+    int value = 0;
+    static int counter;
+};
+
+int SchemaClass::counter = 0;
+
+constexpr auto schemaClassSchema = luabridge::classSchema<SchemaClass>("SchemaClass",
+    luabridge::schemaConstructor<void (*)(), void (*)(int)>(),
+    luabridge::schemaFunction("get", &SchemaClass::get),
+    luabridge::schemaFunction("set", &SchemaClass::set),
+    luabridge::schemaFunction("add",
+        luabridge::constOverload<int>(&SchemaClass::add),
+        luabridge::constOverload<int, int>(&SchemaClass::add)),
+    luabridge::schemaProperty("value", &SchemaClass::value),
+    luabridge::schemaProperty("readOnly", &SchemaClass::get),
+    luabridge::schemaStaticFunction("twice", &SchemaClass::twice),
+    luabridge::schemaStaticProperty("counter", &SchemaClass::counter));
+} // namespace
+
+TEST_F(ClassTests, SchemaSizesAreComputedAtCompileTime)
+{
+    constexpr auto sizes = schemaClassSchema.sizes();
+
+    static_assert(sizes.constRecords == 2);
+    static_assert(sizes.classRecords == 3);
+    static_assert(sizes.staticRecords == 2);
+    static_assert(sizes.properties == 2);
+    static_assert(sizes.staticProperties == 1);
+
+    SUCCEED();
+}
+
+TEST_F(ClassTests, SchemaRegistration)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginNamespace("test")
+            .addClass(schemaClassSchema)
+        .endNamespace();
+
+    runLua("local c = test.SchemaClass(5); result = c:get()");
+    EXPECT_EQ(5, result<int>());
+
+    runLua("local c = test.SchemaClass(); c:set(3); result = c.value");
+    EXPECT_EQ(3, result<int>());
+
+    runLua("local c = test.SchemaClass(1); c.value = 7; result = c.readOnly");
+    EXPECT_EQ(7, result<int>());
+
+    runLua("local c = test.SchemaClass(1); result = c:add(2) + c:add(2, 3)");
+    EXPECT_EQ(9, result<int>());
+
+    runLua("result = test.SchemaClass.twice(21)");
+    EXPECT_EQ(42, result<int>());
+
+    runLua("test.SchemaClass.counter = 11; result = test.SchemaClass.counter");
+    EXPECT_EQ(11, result<int>());
+    EXPECT_EQ(11, SchemaClass::counter);
+
+#if LUABRIDGE_HAS_EXCEPTIONS
+    EXPECT_THROW(runLua("local c = test.SchemaClass(1); c.readOnly = 2"), std::exception);
+#else
+    EXPECT_FALSE(runLua("local c = test.SchemaClass(1); c.readOnly = 2"));
+#endif
+}
+
+TEST_F(ClassTests, SchemaRegistrationCanBeContinued)
+{
+    luabridge::getGlobalNamespace(L)
+        .addClass(schemaClassSchema)
+        .beginClass<SchemaClass>("SchemaClass")
+            .addFunction("negate", [](const SchemaClass* self) { return -self->value; })
+        .endClass();
+
+    runLua("local c = SchemaClass(4); result = c:negate() + c:get()");
+    EXPECT_EQ(0, result<int>());
+}
+
+#if LUABRIDGE_ON_LUAU
+namespace {
+int16_t sequentialUserAtom(const char*, size_t)
+{
+    static int16_t nextAtom = 0;
+    return nextAtom++;
+}
+
+struct NamecallBase
+{
+    int namecallIdentity(int value) const { return value; }
+    int namecallShadowed() const { return 1; }
+};
+
+struct NamecallDerived : NamecallBase
+{
+    int namecallDerived(int value) { return value * 2; }
+    int namecallShadowedProperty() const { return 2; }
+};
+} // namespace
+
+TEST_F(ClassTests, NamecallDispatchUsesAtoms)
+{
+    lua_callbacks(L)->useratom = &sequentialUserAtom;
+
+    luabridge::getGlobalNamespace(L)
+        .beginClass<NamecallBase>("NamecallBase")
+            .addFunction("namecallIdentity", &NamecallBase::namecallIdentity)
+            .addFunction("namecallShadowed", &NamecallBase::namecallShadowed)
+        .endClass()
+        .deriveClass<NamecallDerived, NamecallBase>("NamecallDerived")
+            .addFunction("namecallDerived", &NamecallDerived::namecallDerived)
+            .addProperty("namecallShadowed", &NamecallDerived::namecallShadowedProperty)
+        .endClass();
+
+    NamecallDerived derived;
+    luabridge::setGlobal(L, &derived, "derived");
+
+    runLua("result = derived:namecallIdentity(3) + derived:namecallDerived(4)");
+    EXPECT_EQ(11, result<int>());
+
+    runLua("result = derived.namecallShadowed");
+    EXPECT_EQ(2, result<int>());
+
+    const NamecallDerived* constDerived = &derived;
+    luabridge::setGlobal(L, constDerived, "constDerived");
+
+    runLua("result = constDerived:namecallIdentity(5)");
+    EXPECT_EQ(5, result<int>());
+
+#if LUABRIDGE_HAS_EXCEPTIONS
+    EXPECT_THROW(runLua("constDerived:namecallDerived(1)"), std::exception);
+    EXPECT_THROW(runLua("derived:namecallShadowed()"), std::exception);
+    EXPECT_THROW(runLua("derived:namecallMissing()"), std::exception);
+#else
+    EXPECT_FALSE(runLua("constDerived:namecallDerived(1)"));
+    EXPECT_FALSE(runLua("derived:namecallShadowed()"));
+    EXPECT_FALSE(runLua("derived:namecallMissing()"));
+#endif
+}
+
+TEST_F(ClassTests, NamecallDispatchTakesAtomLookup)
+{
+    lua_callbacks(L)->useratom = &sequentialUserAtom;
+
+    luabridge::getGlobalNamespace(L)
+        .beginClass<NamecallBase>("NamecallBase")
+            .addFunction("namecallIdentity", &NamecallBase::namecallIdentity)
+        .endClass();
+
+    NamecallBase base;
+    luabridge::setGlobal(L, &base, "base");
+
+    // Remove the method from the class table, only the atom table can still resolve it
+    luabridge::getGlobal(L, "base").push(L);
+    ASSERT_TRUE(lua_getmetatable(L, -1));
+    lua_pushnil(L);
+    luabridge::rawsetfield(L, -2, "namecallIdentity");
+    lua_pop(L, 2);
+
+    runLua("result = base.namecallIdentity == nil and base:namecallIdentity(7) == 7");
+    EXPECT_TRUE(result<bool>());
+}
+
+TEST_F(ClassTests, NamecallNotInstalledWithoutAtomsOrForLuaMethods)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<NamecallBase>("NamecallBase")
+            .addFunction("namecallIdentity", &NamecallBase::namecallIdentity)
+        .endClass();
+
+    auto hasNamecall = [this](const char* name)
+    {
+        luabridge::getGlobal(L, name).push(L);
+        EXPECT_TRUE(lua_getmetatable(L, -1));
+        lua_pushstring(L, "__namecall");
+        lua_rawget(L, -2);
+        const bool result = ! lua_isnil(L, -1);
+        lua_pop(L, 3);
+        return result;
+    };
+
+    NamecallBase base;
+    luabridge::setGlobal(L, &base, "base");
+    EXPECT_FALSE(hasNamecall("base"));
+
+    lua_callbacks(L)->useratom = &sequentialUserAtom;
+
+    luabridge::getGlobalNamespace(L)
+        .beginClass<NamecallDerived>("NamecallExtensible", luabridge::extensibleClass)
+            .addConstructor<void (*)()>()
+            .addFunction("namecallDerived", &NamecallDerived::namecallDerived)
+        .endClass();
+
+    runLua("result = NamecallExtensible()");
+    luabridge::setGlobal(L, result(), "extensible");
+    EXPECT_FALSE(hasNamecall("extensible"));
+
+    // Lua methods of extensible classes are called by the VM and can yield
+    runLua(R"(
+        function NamecallExtensible:wait(value)
+            local resumed = coroutine.yield(value)
+            return resumed + self:namecallDerived(value)
+        end
+
+        local co = coroutine.create(function() return extensible:wait(2) end)
+        local _, yielded = coroutine.resume(co)
+        local _, returned = coroutine.resume(co, 10)
+        result = yielded + returned
+    )");
+    EXPECT_EQ(16, result<int>());
+}
+#endif
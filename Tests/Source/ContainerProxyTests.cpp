@@ -0,0 +1,281 @@
+// https://github.com/kunitoki/LuaBridge3
+// Copyright 2023, Lucio Asnaghi
+// SPDX-License-Identifier: MIT
+
+#include "TestBase.h"
+
+#include "LuaBridge/ContainerProxy.h"
+
+#include <array>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct ContainerProxyTests : TestBase
+{
+};
+
+namespace {
+
+struct Item
+{
+    Item() = default;
+
+    explicit Item(int value)
+        : value(value)
+    {
+    }
+
+    int value = 0;
+};
+
+void registerItem(lua_State* L)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Item>("Item")
+            .addConstructor<void (*)(int)>()
+            .addProperty("value", &Item::value)
+        .endClass();
+}
+
+} // namespace
+
+TEST_F(ContainerProxyTests, MapLookupsOnDemand)
+{
+    std::map<std::string, int> map{ { "a", 1 }, { "b", 2 } };
+
+    ASSERT_TRUE(luabridge::setGlobal(L, luabridge::borrowContainer(map), "map"));
+
+    runLua("result = map.a + map['b']");
+    EXPECT_EQ(3, result<int>());
+
+    runLua("result = map.missing == nil and map[1] == nil and #map == 2");
+    EXPECT_TRUE(result<bool>());
+
+    // Changes made from C++ are visible without pushing the map again
+    map["c"] = 3;
+    runLua("result = map.c");
+    EXPECT_EQ(3, result<int>());
+
+    runLua("map.d = 4; map.a = 10; map.b = nil");
+    EXPECT_EQ(10, map["a"]);
+    EXPECT_EQ(4, map["d"]);
+    EXPECT_EQ(0u, map.count("b"));
+
+#if LUABRIDGE_HAS_EXCEPTIONS
+    EXPECT_ANY_THROW(runLua("map.e = 'not a number'"));
+#else
+    EXPECT_FALSE(runLua("map.e = 'not a number'"));
+#endif
+}
+
+TEST_F(ContainerProxyTests, VectorIndicesAndResizing)
+{
+    std::vector<int> vector{ 10, 20, 30 };
+
+    ASSERT_TRUE(luabridge::setGlobal(L, luabridge::borrowContainer(vector), "vector"));
+
+    runLua("result = vector[1] + vector[3]");
+    EXPECT_EQ(40, result<int>());
+
+    runLua("result = vector[0] == nil and vector[4] == nil and vector.x == nil and #vector == 3");
+    EXPECT_TRUE(result<bool>());
+
+    runLua("vector[2] = 25; vector[#vector + 1] = 40");
+    EXPECT_EQ((std::vector<int>{ 10, 25, 30, 40 }), vector);
+
+    runLua("vector[#vector] = nil");
+    EXPECT_EQ((std::vector<int>{ 10, 25, 30 }), vector);
+
+#if LUABRIDGE_HAS_EXCEPTIONS
+    EXPECT_ANY_THROW(runLua("vector[1] = nil"));
+    EXPECT_ANY_THROW(runLua("vector[10] = 1"));
+#else
+    EXPECT_FALSE(runLua("vector[1] = nil"));
+    EXPECT_FALSE(runLua("vector[10] = 1"));
+#endif
+}
+
+TEST_F(ContainerProxyTests, ArrayIsFixedSize)
+{
+    std::array<double, 3> array{ 1.5, 2.5, 3.5 };
+
+    ASSERT_TRUE(luabridge::setGlobal(L, luabridge::borrowContainer(array), "array"));
+
+    runLua("array[1] = array[2] + array[3]; result = #array");
+    EXPECT_EQ(3, result<int>());
+    EXPECT_EQ(6.0, array[0]);
+
+#if LUABRIDGE_HAS_EXCEPTIONS
+    EXPECT_ANY_THROW(runLua("array[4] = 1"));
+#else
+    EXPECT_FALSE(runLua("array[4] = 1"));
+#endif
+}
+
+TEST_F(ContainerProxyTests, ConstContainersAreReadOnly)
+{
+    const std::unordered_map<int, std::string> map{ { 1, "one" }, { 2, "two" } };
+
+    ASSERT_TRUE(luabridge::setGlobal(L, luabridge::borrowContainer(map), "map"));
+
+    runLua("result = map[1] .. map[2]");
+    EXPECT_EQ("onetwo", result<std::string>());
+
+#if LUABRIDGE_HAS_EXCEPTIONS
+    EXPECT_ANY_THROW(runLua("map[3] = 'three'"));
+#else
+    EXPECT_FALSE(runLua("map[3] = 'three'"));
+#endif
+}
+
+TEST_F(ContainerProxyTests, ClassElementsByReference)
+{
+    registerItem(L);
+
+    std::map<int, Item> map;
+    map.emplace(1, Item(1));
+    map.emplace(2, Item(2));
+
+    ASSERT_TRUE(luabridge::setGlobal(L, luabridge::borrowContainer(map), "map"));
+
+    runLua("map[1].value = 100; map[3] = Item(3); result = map[1].value + map[3].value");
+    EXPECT_EQ(103, result<int>());
+    EXPECT_EQ(100, map[1].value);
+    EXPECT_EQ(3, map[3].value);
+
+    std::vector<Item> vector(2);
+
+    ASSERT_TRUE(luabridge::setGlobal(L, luabridge::borrowContainer(vector), "vector"));
+
+    runLua("vector[2].value = 42");
+    EXPECT_EQ(42, vector[1].value);
+}
+
+TEST_F(ContainerProxyTests, SharedContainersOutliveProxies)
+{
+    registerItem(L);
+
+    auto vector = std::make_shared<std::vector<Item>>();
+    vector->emplace_back(7);
+
+    std::weak_ptr<std::vector<Item>> weak = vector;
+
+    ASSERT_TRUE(luabridge::setGlobal(L, luabridge::shareContainer(std::move(vector)), "vector"));
+
+    runLua("item = vector[1]; vector = nil");
+    lua_gc(L, LUA_GCCOLLECT, 0);
+
+    // The element keeps the container alive
+    EXPECT_FALSE(weak.expired());
+    runLua("result = item.value");
+    EXPECT_EQ(7, result<int>());
+
+    runLua("item = nil");
+    lua_gc(L, LUA_GCCOLLECT, 0);
+    lua_gc(L, LUA_GCCOLLECT, 0);
+    EXPECT_TRUE(weak.expired());
+}
+
+TEST_F(ContainerProxyTests, ClassContainersCantBeResized)
+{
+    registerItem(L);
+
+    auto vector = std::make_shared<std::vector<Item>>();
+    vector->emplace_back(1);
+
+    std::map<int, Item> map;
+    map.emplace(1, Item(1));
+
+    ASSERT_TRUE(luabridge::setGlobal(L, luabridge::shareContainer(vector), "vector"));
+    ASSERT_TRUE(luabridge::setGlobal(L, luabridge::borrowContainer(map), "map"));
+
+    runLua("item = vector[1]");
+
+#if LUABRIDGE_HAS_EXCEPTIONS
+    EXPECT_ANY_THROW(runLua("for i = 2, 1000 do vector[i] = Item(i) end"));
+    EXPECT_ANY_THROW(runLua("vector[1] = nil"));
+    EXPECT_ANY_THROW(runLua("map[1] = nil"));
+#else
+    EXPECT_FALSE(runLua("for i = 2, 1000 do vector[i] = Item(i) end"));
+    EXPECT_FALSE(runLua("vector[1] = nil"));
+    EXPECT_FALSE(runLua("map[1] = nil"));
+#endif
+
+    EXPECT_EQ(1u, vector->size());
+    EXPECT_EQ(1u, map.size());
+
+    // The referenced element is still valid, and assigning the entry keeps it in place
+    runLua("item.value = 2; result = vector[1].value");
+    EXPECT_EQ(2, result<int>());
+
+    runLua("vector[1] = Item(3); result = item.value");
+    EXPECT_EQ(3, result<int>());
+    EXPECT_EQ(3, vector->front().value);
+
+    runLua("map[2] = Item(2); result = #map");
+    EXPECT_EQ(2, result<int>());
+}
+
+TEST_F(ContainerProxyTests, StackRoundTrip)
+{
+    std::vector<int> vector{ 1, 2, 3 };
+
+    ASSERT_TRUE(luabridge::push(L, luabridge::borrowContainer(vector)));
+    EXPECT_TRUE(luabridge::isInstance<luabridge::ContainerProxy<std::vector<int>>>(L, -1));
+    EXPECT_FALSE(luabridge::isInstance<luabridge::ContainerProxy<const std::vector<int>>>(L, -1));
+
+    auto proxy = luabridge::get<luabridge::ContainerProxy<std::vector<int>>>(L, -1);
+    ASSERT_TRUE(proxy);
+    EXPECT_EQ(&vector, &proxy.value().container());
+    EXPECT_EQ(nullptr, proxy.value().owner());
+    lua_pop(L, 1);
+
+    lua_newtable(L);
+    EXPECT_FALSE(luabridge::isInstance<luabridge::ContainerProxy<std::vector<int>>>(L, -1));
+    EXPECT_FALSE(luabridge::get<luabridge::ContainerProxy<std::vector<int>>>(L, -1));
+    lua_pop(L, 1);
+}
+
+#if LUABRIDGE_ON_LUAU || LUA_VERSION_NUM >= 502
+TEST_F(ContainerProxyTests, Pairs)
+{
+    std::map<std::string, int> map{ { "a", 1 }, { "b", 2 }, { "c", 3 } };
+    std::unordered_map<int, int> unordered{ { 1, 10 }, { 2, 20 } };
+    std::vector<int> vector{ 5, 6, 7 };
+
+    ASSERT_TRUE(luabridge::setGlobal(L, luabridge::borrowContainer(map), "map"));
+    ASSERT_TRUE(luabridge::setGlobal(L, luabridge::borrowContainer(unordered), "unordered"));
+    ASSERT_TRUE(luabridge::setGlobal(L, luabridge::borrowContainer(vector), "vector"));
+
+#if LUABRIDGE_ON_LUAU
+    runLua(R"(
+        local keys, sum = '', 0
+        for k, v in map do keys = keys .. k; sum = sum + v end
+        for k, v in unordered do sum = sum + k + v end
+        for i, v in vector do sum = sum + i * v end
+        result = keys .. sum
+    )");
+#else
+    runLua(R"(
+        local keys, sum = '', 0
+        for k, v in pairs(map) do keys = keys .. k; sum = sum + v end
+        for k, v in pairs(unordered) do sum = sum + k + v end
+        for i, v in pairs(vector) do sum = sum + i * v end
+        result = keys .. sum
+    )");
+#endif
+
+    EXPECT_EQ("abc" + std::to_string(6 + 33 + 5 + 12 + 21), result<std::string>());
+
+    // Erasing the current entry of a map while iterating
+#if LUABRIDGE_ON_LUAU
+    runLua("for k in map do map[k] = nil end");
+#else
+    runLua("for k in pairs(map) do map[k] = nil end");
+#endif
+    EXPECT_TRUE(map.empty());
+}
+#endif
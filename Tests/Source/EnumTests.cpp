@@ -6,7 +6,10 @@
 
 #include "LuaBridge/Map.h"
 
+#include <cstdint>
+#include <limits>
 #include <string>
+#include <utility>
 
 namespace {
 enum A
@@ -56,6 +59,22 @@ enum class F
     F_TWO,
     F_THREE
 };
+
+enum class G : std::uint8_t
+{
+    G_ONE = 1,
+    G_TWO,
+    G_FOUR = 4,
+    G_EIGHT = 8
+};
+
+enum class H : long long
+{
+    H_MIN = std::numeric_limits<long long>::min(),
+    H_ZERO = 0,
+    H_MILLION = 1000000,
+    H_MAX = std::numeric_limits<long long>::max()
+};
 } // namespace
 
 struct EnumTests : TestBase
@@ -82,6 +101,36 @@ struct luabridge::Stack<F> : luabridge::Enum<F>
 {
 };
 
+template <>
+struct luabridge::Stack<G> : luabridge::Enum<G, G::G_EIGHT, G::G_ONE, G::G_FOUR, G::G_TWO>
+{
+};
+
+template <>
+struct luabridge::EnumNames<G>
+{
+    static constexpr std::pair<G, const char*> names[] = {
+        { G::G_ONE, "ONE" },
+        { G::G_TWO, "TWO" },
+        { G::G_FOUR, "FOUR" },
+        { G::G_EIGHT, "EIGHT" }
+    };
+};
+
+template <>
+struct luabridge::Stack<H> : luabridge::Enum<H, H::H_MAX, H::H_ZERO, H::H_MIN, H::H_MILLION>
+{
+};
+
+template <>
+struct luabridge::EnumNames<H>
+{
+    static constexpr std::pair<H, const char*> names[] = {
+        { H::H_ZERO, "ZERO" },
+        { H::H_MAX, "MAX" }
+    };
+};
+
 TEST_F(EnumTests, Unregistered)
 {
 #if LUABRIDGE_HAS_EXCEPTIONS
@@ -227,3 +276,96 @@ TEST_F(EnumTests, MethodTakingEnumAsMapKey)
     ASSERT_TRUE(runLua("result = map_of_d[D1.D_ONE]"));
     EXPECT_EQ("1", result<std::string>());
 }
+
+TEST_F(EnumTests, ValueSetStrategies)
+{
+    using Contiguous = luabridge::detail::EnumValueSet<int, 3, 1, 2, 0>;
+    static_assert(Contiguous::isContiguous);
+    EXPECT_TRUE(Contiguous::contains(0));
+    EXPECT_TRUE(Contiguous::contains(3));
+    EXPECT_FALSE(Contiguous::contains(-1));
+    EXPECT_FALSE(Contiguous::contains(4));
+
+    using Dense = luabridge::detail::EnumValueSet<std::uint8_t, 8, 1, 4, 2>;
+    static_assert(! Dense::isContiguous && Dense::isDense);
+    EXPECT_TRUE(Dense::contains(1));
+    EXPECT_TRUE(Dense::contains(8));
+    EXPECT_FALSE(Dense::contains(0));
+    EXPECT_FALSE(Dense::contains(3));
+    EXPECT_FALSE(Dense::contains(9));
+    EXPECT_FALSE(Dense::contains(255));
+
+    using Sparse = luabridge::detail::EnumValueSet<long long, std::numeric_limits<long long>::max(), 0, std::numeric_limits<long long>::min(), 1000000>;
+    static_assert(! Sparse::isContiguous && ! Sparse::isDense);
+    EXPECT_TRUE(Sparse::contains(std::numeric_limits<long long>::min()));
+    EXPECT_TRUE(Sparse::contains(1000000));
+    EXPECT_TRUE(Sparse::contains(std::numeric_limits<long long>::max()));
+    EXPECT_FALSE(Sparse::contains(1));
+    EXPECT_FALSE(Sparse::contains(-1));
+}
+
+TEST_F(EnumTests, RegisteredStackDenseAndSparseValues)
+{
+    for (int value : { 1, 2, 4, 8 })
+    {
+        ASSERT_TRUE(luabridge::push(L, value));
+        EXPECT_TRUE(luabridge::get<G>(L, -1));
+        lua_pop(L, 1);
+    }
+
+    for (int value : { 0, 3, 5, 9, 255, 256, -1 })
+    {
+        ASSERT_TRUE(luabridge::push(L, value));
+        EXPECT_FALSE(luabridge::get<G>(L, -1));
+        lua_pop(L, 1);
+    }
+
+    ASSERT_TRUE(luabridge::push(L, H::H_MILLION));
+    EXPECT_EQ(H::H_MILLION, *luabridge::get<H>(L, -1));
+    lua_pop(L, 1);
+
+    ASSERT_TRUE(luabridge::push(L, 999999));
+    EXPECT_FALSE(luabridge::get<H>(L, -1));
+    lua_pop(L, 1);
+}
+
+TEST_F(EnumTests, RegisteredNames)
+{
+    EXPECT_STREQ("ONE", luabridge::Stack<G>::name(G::G_ONE));
+    EXPECT_STREQ("EIGHT", luabridge::Stack<G>::name(G::G_EIGHT));
+    EXPECT_EQ(nullptr, luabridge::Stack<G>::name(static_cast<G>(3)));
+
+    EXPECT_STREQ("MAX", luabridge::Stack<H>::name(H::H_MAX));
+    EXPECT_EQ(nullptr, luabridge::Stack<H>::name(H::H_MILLION));
+
+    ASSERT_TRUE(luabridge::push(L, "FOUR"));
+    EXPECT_TRUE(luabridge::isInstance<G>(L, -1));
+    EXPECT_EQ(G::G_FOUR, *luabridge::get<G>(L, -1));
+    lua_pop(L, 1);
+
+    ASSERT_TRUE(luabridge::push(L, "THREE"));
+    EXPECT_FALSE(luabridge::isInstance<G>(L, -1));
+    EXPECT_FALSE(luabridge::get<G>(L, -1));
+    lua_pop(L, 1);
+
+    // Strings are only accepted by enums with names
+    ASSERT_TRUE(luabridge::push(L, "C_ONE"));
+    EXPECT_FALSE(luabridge::get<C>(L, -1));
+    lua_pop(L, 1);
+
+    luabridge::getGlobalNamespace(L)
+        .addFunction("takeG", +[](G value) { return static_cast<int>(value); })
+        .addFunction("takeH", +[](H value) { return value == H::H_MAX; });
+
+    ASSERT_TRUE(runLua("result = takeG('EIGHT') + takeG(2)"));
+    EXPECT_EQ(10, result<int>());
+
+    ASSERT_TRUE(runLua("result = takeH('MAX')"));
+    EXPECT_TRUE(result<bool>());
+
+#if LUABRIDGE_HAS_EXCEPTIONS
+    EXPECT_ANY_THROW(runLua("takeG('NONE')"));
+#else
+    EXPECT_FALSE(runLua("takeG('NONE')"));
+#endif
+}
@@ -0,0 +1,177 @@
+// https://github.com/kunitoki/LuaBridge3
+// Copyright 2023, Lucio Asnaghi
+// SPDX-License-Identifier: MIT
+
+#include "TestBase.h"
+
+#include <functional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+struct LuaFunctionTests : TestBase
+{
+};
+
+TEST_F(LuaFunctionTests, TypedArgumentsAndResult)
+{
+    runLua("result = function(a, b, s) return s .. (a + b) end");
+
+    luabridge::LuaFunction<std::string(int, double, const std::string&)> function(result());
+    EXPECT_TRUE(function.isValid());
+    EXPECT_EQ(L, function.state());
+
+    const int top = lua_gettop(L);
+
+    auto value = function(1, 2.5, "sum ");
+    ASSERT_TRUE(value);
+    EXPECT_EQ("sum 3.5", *value);
+    EXPECT_EQ(top, lua_gettop(L));
+
+    luabridge::LuaFunction<std::tuple<int, int>(std::vector<int>)> pair(luabridge::LuaRef(L, nullptr));
+    EXPECT_FALSE(pair.isValid());
+}
+
+TEST_F(LuaFunctionTests, VoidResultAndExtraResultsDiscarded)
+{
+    runLua(R"(
+        calls = 0
+        result = function(n) calls = calls + n; return 1, 2, 3 end
+    )");
+
+    luabridge::LuaFunction<void(int)> function(result());
+
+    const int top = lua_gettop(L);
+
+    EXPECT_TRUE(function(2));
+    EXPECT_TRUE(function(3));
+    EXPECT_EQ(top, lua_gettop(L));
+    EXPECT_EQ(5, luabridge::getGlobal(L, "calls").unsafe_cast<int>());
+}
+
+TEST_F(LuaFunctionTests, ResultConversionFailure)
+{
+    runLua("result = function() return 'not a number' end");
+
+    luabridge::LuaFunction<int()> function(result());
+
+    const int top = lua_gettop(L);
+
+    auto value = function();
+    ASSERT_FALSE(value);
+    EXPECT_EQ(luabridge::makeErrorCode(luabridge::ErrorCode::InvalidTypeCast), value.error());
+    EXPECT_EQ(top, lua_gettop(L));
+}
+
+TEST_F(LuaFunctionTests, LuaErrors)
+{
+    runLua("result = function() error('failed') end");
+
+    luabridge::LuaFunction<int()> function(result());
+
+    const int top = lua_gettop(L);
+
+#if LUABRIDGE_HAS_EXCEPTIONS
+    EXPECT_THROW(function(), luabridge::LuaException);
+#else
+    auto value = function();
+    ASSERT_FALSE(value);
+    EXPECT_EQ(luabridge::makeErrorCode(luabridge::ErrorCode::LuaFunctionCallFailed), value.error());
+#endif
+
+    EXPECT_EQ(top, lua_gettop(L));
+}
+
+TEST_F(LuaFunctionTests, CallableTables)
+{
+    runLua(R"(
+        result = setmetatable({ base = 10 }, { __call = function(self, x) return self.base + x end })
+    )");
+
+    luabridge::LuaFunction<int(int)> function(result());
+    EXPECT_TRUE(function.isValid());
+    EXPECT_EQ(15, *function(5));
+}
+
+TEST_F(LuaFunctionTests, StackRoundTrip)
+{
+    runLua("result = function(x) return x * 2 end");
+
+    ASSERT_TRUE(luabridge::push(L, result()));
+    EXPECT_TRUE(luabridge::isInstance<luabridge::LuaFunction<int(int)>>(L, -1));
+
+    auto function = luabridge::get<luabridge::LuaFunction<int(int)>>(L, -1);
+    lua_pop(L, 1);
+    ASSERT_TRUE(function);
+    EXPECT_EQ(8, *(*function)(4));
+
+    ASSERT_TRUE(luabridge::push(L, *function));
+    EXPECT_TRUE(lua_isfunction(L, -1));
+    lua_pop(L, 1);
+
+    lua_pushinteger(L, 1);
+    EXPECT_FALSE(luabridge::isInstance<luabridge::LuaFunction<int(int)>>(L, -1));
+    EXPECT_FALSE(luabridge::get<luabridge::LuaFunction<int(int)>>(L, -1));
+    lua_pop(L, 1);
+}
+
+TEST_F(LuaFunctionTests, StdFunctionFromLua)
+{
+    int received = 0;
+
+    luabridge::getGlobalNamespace(L)
+        .addFunction("dispatch", [&received](const std::function<int(int, const std::string&)>& callback)
+        {
+            received = callback(3, "abc");
+        })
+        .addFunction("dispatchVoid", [](std::function<void(int)> callback)
+        {
+            callback(1);
+            callback(2);
+        });
+
+    runLua(R"(
+        dispatch(function(n, s) return n + #s end)
+
+        total = 0
+        dispatchVoid(function(n) total = total + n end)
+    )");
+
+    EXPECT_EQ(6, received);
+    EXPECT_EQ(3, luabridge::getGlobal(L, "total").unsafe_cast<int>());
+
+#if LUABRIDGE_HAS_EXCEPTIONS
+    EXPECT_ANY_THROW(runLua("dispatch(42)"));
+#else
+    EXPECT_FALSE(runLua("dispatch(42)"));
+#endif
+}
+
+TEST_F(LuaFunctionTests, StdFunctionFromLuaErrors)
+{
+    runLua("result = function() error('failed') end");
+
+    ASSERT_TRUE(luabridge::push(L, result()));
+    auto function = luabridge::get<std::function<int()>>(L, -1);
+    lua_pop(L, 1);
+    ASSERT_TRUE(function);
+
+#if LUABRIDGE_HAS_EXCEPTIONS
+    EXPECT_THROW((*function)(), luabridge::LuaException);
+#else
+    EXPECT_EQ(0, (*function)());
+#endif
+}
+
+TEST_F(LuaFunctionTests, StdFunctionToLua)
+{
+    std::function<int(int, int)> add = [](int a, int b) { return a + b; };
+
+    luabridge::setGlobal(L, add, "add");
+    runLua("result = add(20, 22)");
+    EXPECT_EQ(42, result<int>());
+
+    luabridge::setGlobal(L, std::function<int(int, int)>(), "add");
+    runLua("result = add == nil");
+    EXPECT_TRUE(result<bool>());
+}
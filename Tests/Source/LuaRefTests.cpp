@@ -7,7 +7,10 @@
 
 #include "TestBase.h"
 
+#include <memory>
 #include <sstream>
+#include <thread>
+#include <vector>
 
 struct LuaRefTests : TestBase
 {
@@ -683,3 +686,108 @@ TEST_F(LuaRefTests, HookTesting)
         func.second(0, "x");
     }
 }
+
+TEST_F(LuaRefTests, DeferredReleaseFromOtherThreads)
+{
+    if (! luabridge::enableDeferredRelease(L))
+        GTEST_SKIP() << "Deferred release not supported";
+
+    std::vector<luabridge::LuaRef> refs1, refs2;
+    std::vector<luabridge::WeakLuaRef> weakRefs;
+    for (int i = 0; i < 100; ++i)
+    {
+        auto& refs = (i % 2) ? refs1 : refs2;
+        refs.push_back(luabridge::newTable(L));
+        weakRefs.emplace_back(refs.back());
+    }
+
+    std::thread worker1([refs = std::move(refs1)]() mutable { refs.clear(); });
+    std::thread worker2([refs = std::move(refs2)]() mutable { refs.clear(); });
+    worker1.join();
+    worker2.join();
+
+    lua_gc(L, LUA_GCCOLLECT, 0);
+    for (const auto& weakRef : weakRefs)
+        EXPECT_FALSE(weakRef.expired());
+
+    EXPECT_EQ(100u, luabridge::collectReleasedRefs(L));
+    EXPECT_EQ(0u, luabridge::collectReleasedRefs(L));
+
+    lua_gc(L, LUA_GCCOLLECT, 0);
+    for (const auto& weakRef : weakRefs)
+        EXPECT_TRUE(weakRef.expired());
+}
+
+TEST_F(LuaRefTests, DeferredReleaseKeepsAllocator)
+{
+    void* userData = nullptr;
+    const lua_Alloc allocator = lua_getallocf(L, &userData);
+
+    if (! luabridge::enableDeferredRelease(L))
+        GTEST_SKIP() << "Deferred release not supported";
+
+    void* currentUserData = nullptr;
+    EXPECT_EQ(allocator, lua_getallocf(L, &currentUserData));
+    EXPECT_EQ(userData, currentUserData);
+
+    lua_State* thread = lua_newthread(L);
+    ASSERT_TRUE(luabridge::enableDeferredRelease(thread));
+
+    auto table = std::make_unique<luabridge::LuaRef>(luabridge::newTable(thread));
+    luabridge::WeakLuaRef weakTable(*table);
+
+    std::thread([&table] { table.reset(); }).join();
+
+    lua_gc(L, LUA_GCCOLLECT, 0);
+    EXPECT_FALSE(weakTable.expired());
+
+    EXPECT_EQ(1u, luabridge::collectReleasedRefs(L));
+    lua_pop(L, 1);
+}
+
+TEST_F(LuaRefTests, DeferredReleaseForgetsCollectedCoroutines)
+{
+    if (! luabridge::enableDeferredRelease(L))
+        GTEST_SKIP() << "Deferred release not supported";
+
+    lua_State* thread = lua_newthread(L);
+    ASSERT_TRUE(luabridge::enableDeferredRelease(thread));
+    ASSERT_TRUE(luabridge::enableDeferredRelease(thread));
+    EXPECT_EQ(luabridge::detail::get_release_queue(L), luabridge::detail::get_release_queue(thread));
+
+    lua_pop(L, 1);
+    lua_gc(L, LUA_GCCOLLECT, 0);
+    lua_gc(L, LUA_GCCOLLECT, 0);
+
+    // Only the address is looked up, the collected coroutine is not dereferenced
+    EXPECT_EQ(nullptr, luabridge::detail::get_release_queue(thread));
+    EXPECT_NE(nullptr, luabridge::detail::get_release_queue(L));
+}
+
+TEST_F(LuaRefTests, DeferredReleaseDrainedByOwningThread)
+{
+    if (! luabridge::enableDeferredRelease(L))
+        GTEST_SKIP() << "Deferred release not supported";
+
+    auto table = std::make_unique<luabridge::LuaRef>(luabridge::newTable(L));
+    luabridge::WeakLuaRef weakTable(*table);
+
+    std::thread([&table] { table.reset(); }).join();
+
+    lua_gc(L, LUA_GCCOLLECT, 0);
+    EXPECT_FALSE(weakTable.expired());
+
+    {
+        luabridge::LuaRef other = luabridge::newTable(L);
+    }
+
+    EXPECT_EQ(0u, luabridge::collectReleasedRefs(L));
+
+    lua_gc(L, LUA_GCCOLLECT, 0);
+    EXPECT_TRUE(weakTable.expired());
+
+    luabridge::LuaRef value(L, 42);
+    runLua("result = 1 + 1");
+    EXPECT_EQ(2, result<int>());
+    EXPECT_EQ(42, value.unsafe_cast<int>());
+}
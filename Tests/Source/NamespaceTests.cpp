@@ -521,6 +521,90 @@ TEST_F(NamespaceTests, CapturingLambdas)
     ASSERT_EQ(42, result<int>());
 }
 
+namespace {
+int FfiFunction(double a, double b)
+{
+    return static_cast<int>(a + b);
+}
+
+std::string FfiUnsupportedFunction(const std::string& s)
+{
+    return s + "!";
+}
+
+char FfiCharFunction(int value)
+{
+    return static_cast<char>('a' + value);
+}
+
+void FfiVoidFunction(double)
+{
+}
+} // namespace
+
+TEST_F(NamespaceTests, FfiFunctions)
+{
+    luabridge::getGlobalNamespace(L)
+        .addFfiFunction("Function", &FfiFunction)
+        .addFfiFunction("Unsupported", &FfiUnsupportedFunction)
+        .addFfiFunction("Char", &FfiCharFunction)
+        .addFfiFunction("Void", &FfiVoidFunction);
+
+    runLua("result = Function (39.5, 2.5)");
+    ASSERT_TRUE(result().isNumber());
+    ASSERT_EQ(42, result<int>());
+
+    runLua("result = Unsupported ('abc')");
+    ASSERT_EQ("abc!", result<std::string>());
+
+    runLua("result = type (Unsupported)");
+    EXPECT_EQ("function", result<std::string>());
+
+    runLua("result = Char (1)");
+    ASSERT_EQ("b", result<std::string>());
+
+    runLua("result = type (Char)");
+    EXPECT_EQ("function", result<std::string>());
+
+#if LUABRIDGE_HAS_EXCEPTIONS
+    EXPECT_ANY_THROW(runLua("result = Char (2147483648)"));
+#else
+    EXPECT_FALSE(runLua("result = Char (2147483648)"));
+#endif
+
+    runLua("Void (1.0) result = type (Void)");
+#if LUABRIDGE_ON_LUAJIT
+    EXPECT_EQ("cdata", result<std::string>());
+#else
+    EXPECT_EQ("function", result<std::string>());
+#endif
+
+    runLua("result = type (Function)");
+#if LUABRIDGE_ON_LUAJIT
+    EXPECT_EQ("cdata", result<std::string>());
+#else
+    EXPECT_EQ("function", result<std::string>());
+#endif
+}
+
+TEST_F(NamespaceTests, FfiFunctionsIgnoreScriptGlobals)
+{
+    runLua("require = function () error ('hijacked') end");
+
+    luabridge::getGlobalNamespace(L)
+        .addFfiFunction("Function", &FfiFunction);
+
+    runLua("result = Function (39.5, 2.5)");
+    ASSERT_EQ(42, result<int>());
+
+    runLua("result = type (Function)");
+#if LUABRIDGE_ON_LUAJIT
+    EXPECT_EQ("cdata", result<std::string>());
+#else
+    EXPECT_EQ("function", result<std::string>());
+#endif
+}
+
 namespace {
 class SystemDestroyer {};
 } // namespacw
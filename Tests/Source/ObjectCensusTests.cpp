@@ -0,0 +1,194 @@
+// https://github.com/kunitoki/LuaBridge3
+// Copyright 2023, Lucio Asnaghi
+// SPDX-License-Identifier: MIT
+
+#include "TestBase.h"
+
+#include <memory>
+#include <string>
+
+struct ObjectCensusTests : TestBase
+{
+    void collectGarbage()
+    {
+        lua_gc(L, LUA_GCCOLLECT, 0);
+        lua_gc(L, LUA_GCCOLLECT, 0);
+    }
+};
+
+namespace {
+
+struct Counted
+{
+    Counted() = default;
+
+    explicit Counted(int value)
+        : value(value)
+    {
+    }
+
+    int value = 0;
+};
+
+struct Other
+{
+};
+
+} // namespace
+
+#if LUABRIDGE_ENABLE_OBJECT_CENSUS
+
+TEST_F(ObjectCensusTests, CountsLiveAndCreatedObjects)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Counted>("Counted")
+            .addConstructor<void (*)(int)>()
+        .endClass()
+        .beginClass<Other>("Other")
+        .endClass();
+
+    runLua(R"(
+        kept = Counted(1)
+        for i = 1, 9 do local c = Counted(i) end
+    )");
+    collectGarbage();
+
+    auto census = luabridge::getObjectCensus<Counted>(L);
+    EXPECT_EQ("Counted", census.name);
+    EXPECT_EQ(1u, census.live);
+    EXPECT_EQ(10u, census.created);
+    EXPECT_GE(census.bytes, sizeof(Counted));
+
+    const auto bytesPerObject = census.bytes;
+
+    runLua("kept = nil");
+    collectGarbage();
+
+    census = luabridge::getObjectCensus<Counted>(L);
+    EXPECT_EQ(0u, census.live);
+    EXPECT_EQ(10u, census.created);
+    EXPECT_EQ(0u, census.bytes);
+
+    // Copies pushed from C++ are counted as well
+    ASSERT_TRUE(luabridge::push(L, Counted(2)));
+    EXPECT_EQ(1u, luabridge::getObjectCensus<Counted>(L).live);
+    EXPECT_EQ(bytesPerObject, luabridge::getObjectCensus<Counted>(L).bytes);
+    lua_pop(L, 1);
+
+    // Classes are listed once they have objects
+    auto all = luabridge::getObjectCensus(L);
+    ASSERT_EQ(1u, all.size());
+    EXPECT_EQ("Counted", all[0].name);
+    EXPECT_EQ(11u, all[0].created);
+
+    EXPECT_EQ("Other", luabridge::getObjectCensus<Other>(L).name);
+    EXPECT_EQ(0u, luabridge::getObjectCensus<Other>(L).created);
+
+    ASSERT_TRUE(luabridge::push(L, Other()));
+    lua_pop(L, 1);
+
+    all = luabridge::getObjectCensus(L);
+    ASSERT_EQ(2u, all.size());
+    EXPECT_EQ("Other", all[1].name);
+    EXPECT_EQ(1u, all[1].created);
+}
+
+TEST_F(ObjectCensusTests, CountsPointersAndSharedObjects)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Counted>("Counted")
+        .endClass();
+
+    Counted object;
+    ASSERT_TRUE(luabridge::push(L, &object));
+    ASSERT_TRUE(luabridge::push(L, static_cast<const Counted*>(&object)));
+    ASSERT_TRUE(luabridge::push(L, std::make_shared<Counted>(3)));
+
+    auto census = luabridge::getObjectCensus<Counted>(L);
+    EXPECT_EQ(3u, census.live);
+    EXPECT_EQ(3u, census.created);
+
+    lua_pop(L, 3);
+    collectGarbage();
+
+    census = luabridge::getObjectCensus<Counted>(L);
+    EXPECT_EQ(0u, census.live);
+    EXPECT_EQ(0u, census.bytes);
+}
+
+TEST_F(ObjectCensusTests, CachedPointersAreCountedOnce)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Counted>("Counted", luabridge::cachedPointers)
+        .endClass();
+
+    Counted object;
+    ASSERT_TRUE(luabridge::push(L, &object));
+    ASSERT_TRUE(luabridge::push(L, &object));
+
+    EXPECT_EQ(1u, luabridge::getObjectCensus<Counted>(L).created);
+
+    lua_pop(L, 2);
+}
+
+TEST_F(ObjectCensusTests, DisposedObjectsAreReleasedOnce)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Counted>("Counted", luabridge::disposableClass)
+            .addConstructor<void (*)()>()
+        .endClass();
+
+    runLua(R"(
+        first = Counted()
+        second = Counted()
+        first:dispose()
+        first:dispose()
+    )");
+
+    EXPECT_EQ(1u, luabridge::getObjectCensus<Counted>(L).live);
+
+    runLua("first = nil");
+    collectGarbage();
+
+    const auto census = luabridge::getObjectCensus<Counted>(L);
+    EXPECT_EQ(1u, census.live);
+    EXPECT_EQ(2u, census.created);
+}
+
+TEST_F(ObjectCensusTests, LuaVisibleCensus)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Counted>("Counted")
+            .addConstructor<void (*)()>()
+        .endClass()
+        .addFunction("objectCensus", &luabridge::pushObjectCensus);
+
+    runLua(R"(
+        local objects = { Counted(), Counted() }
+        local all = objectCensus()
+        local counted = objectCensus('Counted')
+        result = all.Counted.live == 2 and all.Counted.created == 2 and all.Counted.bytes > 0
+            and counted.live == 2 and objectCensus('Unknown') == nil
+    )");
+    EXPECT_TRUE(result<bool>());
+}
+
+#else
+
+TEST_F(ObjectCensusTests, CompiledOutByDefault)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Counted>("Counted")
+            .addConstructor<void (*)()>()
+        .endClass();
+
+    runLua("result = Counted()");
+
+    EXPECT_TRUE(luabridge::getObjectCensus(L).empty());
+
+    const auto census = luabridge::getObjectCensus<Counted>(L);
+    EXPECT_EQ("Counted", census.name);
+    EXPECT_EQ(0u, census.created);
+}
+
+#endif
@@ -6,10 +6,19 @@
 
 #include "TestBase.h"
 
+#include "LuaBridge/ContainerProxy.h"
+#include "LuaBridge/Map.h"
+#include "LuaBridge/StatePool.h"
+#include "LuaBridge/detail/Dump.h"
+
+#include <atomic>
+#include <chrono>
 #include <cstdio>
 #include <ctime>
 #include <iomanip>
 #include <iostream>
+#include <map>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -70,6 +79,17 @@ struct A
 
 //------------------------------------------------------------------------------
 
+constexpr auto aSchema = classSchema<A>("A",
+    schemaConstructor<void (*)(void)>(),
+    schemaFunction("mf1", &A::mf1),
+    schemaFunction("mf2", &A::mf2),
+    schemaFunction("mf3", &A::mf3),
+    schemaFunction("vf1", &A::vf1),
+    schemaProperty("data", &A::data),
+    schemaProperty("prop", &A::getprop, &A::setprop));
+
+//------------------------------------------------------------------------------
+
 void addToState(lua_State* L)
 {
     getGlobalNamespace(L)
@@ -129,3 +149,489 @@ TEST_F(PerformanceTests, AllTests)
     addToState(L);
     runTests(L);
 }
+
+TEST_F(PerformanceTests, ClassRegistrationStartup)
+{
+    int const N = 2000;
+
+    auto measure = [this](auto&& registration)
+    {
+        double seconds = 0.0;
+
+        for (int i = 0; i < N; ++i)
+        {
+            lua_State* state = createNewLuaState();
+
+            Stopwatch sw;
+            registration(state);
+            seconds += sw.getElapsedSeconds();
+
+            lua_close(state);
+        }
+
+        return seconds;
+    };
+
+    double const imperativeSeconds = measure([](lua_State* state) { addToState(state); });
+    double const schemaSeconds = measure([](lua_State* state) { getGlobalNamespace(state).addClass(aSchema); });
+
+    cout.precision(4);
+    cout << "Imperative registration: " << imperativeSeconds << " s" << endl;
+    cout << "Schema registration: " << schemaSeconds << " s" << endl;
+
+    addToState(L);
+    getGlobalNamespace(L).beginNamespace("schema").addClass(aSchema).endNamespace();
+
+    runLua("local a = A(); a.prop = 5; local b = schema.A(); b.prop = a.prop; result = b.prop");
+    EXPECT_EQ(5, result<int>());
+}
+
+TEST_F(PerformanceTests, BindingImageStartup)
+{
+    int const N = 2000;
+
+    auto measure = [this](auto&& registration)
+    {
+        double seconds = 0.0;
+
+        for (int i = 0; i < N; ++i)
+        {
+            lua_State* state = createNewLuaState();
+
+            Stopwatch sw;
+            registration(state);
+            seconds += sw.getElapsedSeconds();
+
+            lua_close(state);
+        }
+
+        return seconds;
+    };
+
+    auto const image = BindingImage::capture([](Namespace ns) { ns.addClass(aSchema); });
+
+    double const imperativeSeconds = measure([](lua_State* state) { addToState(state); });
+    double const imageSeconds = measure([&image](lua_State* state) { image.instantiate(state); });
+
+    cout.precision(4);
+    cout << "Imperative registration: " << imperativeSeconds << " s" << endl;
+    cout << "Binding image instantiation: " << imageSeconds << " s" << endl;
+
+    image.instantiate(L);
+
+    runLua("local a = A(); a.prop = 5; result = a.prop");
+    EXPECT_EQ(5, result<int>());
+}
+
+namespace {
+double ffiAdd(double a, double b)
+{
+    return a + b;
+}
+} // namespace
+
+TEST_F(PerformanceTests, FfiFunctionCalls)
+{
+    int const N = 1000000;
+
+    getGlobalNamespace(L)
+        .addFunction("classicAdd", &ffiAdd)
+        .addFfiFunction("ffiAdd", &ffiAdd);
+
+    auto measure = [this](const char* function)
+    {
+        std::string const script =
+            "local f = " + std::string(function) + " local x = 0 "
+            "for i = 1, " + std::to_string(N) + " do x = f (x, 1) end "
+            "result = x";
+
+        Stopwatch sw;
+        runLua(script);
+        double const seconds = sw.getElapsedSeconds();
+
+        EXPECT_EQ(static_cast<double>(N), result<double>());
+        return seconds;
+    };
+
+    double const classicSeconds = measure("classicAdd");
+    double const ffiSeconds = measure("ffiAdd");
+
+    cout.precision(4);
+    cout << "Classic binding calls: " << classicSeconds << " s" << endl;
+#if LUABRIDGE_ON_LUAJIT
+    cout << "FFI (trace compiled) calls: " << ffiSeconds << " s" << endl;
+#else
+    cout << "FFI fallback calls: " << ffiSeconds << " s" << endl;
+#endif
+}
+
+TEST_F(PerformanceTests, StatePoolThroughput)
+{
+    int const N = 2000;
+
+    char const* const script = "local a = A() for i = 1, 200 do a:mf1() a.prop = i end return a.prop";
+
+    auto runScript = [script](lua_State* state)
+    {
+        if (luaL_loadstring(state, script) != LUABRIDGE_LUA_OK || lua_pcall(state, 0, 1, 0) != LUABRIDGE_LUA_OK)
+            return -1;
+
+        return static_cast<int>(lua_tointeger(state, -1));
+    };
+
+    auto registration = [](lua_State* state)
+    {
+        luaL_openlibs(state);
+        addToState(state);
+    };
+
+    // Wall clock time, as the processor time of the workers adds up
+    auto wallSeconds = [](auto&& function)
+    {
+        auto const start = chrono::steady_clock::now();
+        function();
+        return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    };
+
+    addToState(L);
+
+    double const singleSeconds = wallSeconds([&]
+    {
+        for (int i = 0; i < N; ++i)
+        {
+            EXPECT_EQ(200, runScript(L));
+            lua_settop(L, 0);
+        }
+    });
+
+    StatePool pool(0, registration, StatePoolOptions{ true, StatePoolCollect::Step });
+
+    std::atomic<int> failures{ 0 };
+    double const poolSeconds = wallSeconds([&]
+    {
+        for (int i = 0; i < N; ++i)
+            pool.submit([&](lua_State* state) { failures += runScript(state) != 200 ? 1 : 0; });
+
+        pool.wait();
+    });
+
+    EXPECT_EQ(0, failures.load());
+
+    auto const stats = pool.stats();
+
+    cout.precision(4);
+    cout << "Single state: " << N / singleSeconds << " scripts/s" << endl;
+    cout << "State pool (" << pool.size() << " states): " << N / poolSeconds << " scripts/s" << endl;
+    cout << "State pool utilization: " << stats.utilization() * 100.0 << " %, stolen jobs: " << stats.stolenJobs
+         << ", average latency: " << chrono::duration<double, milli>(stats.averageLatency()).count() << " ms" << endl;
+}
+
+namespace {
+LuaRef copyWithLuaRef(const LuaRef& value, lua_State* to)
+{
+    switch (value.type())
+    {
+    case LUA_TTABLE:
+    {
+        LuaRef table = newTable(to);
+        for (auto&& pair : pairs(value))
+            table[copyWithLuaRef(pair.first, to)] = copyWithLuaRef(pair.second, to);
+        return table;
+    }
+
+    case LUA_TNUMBER:
+        return LuaRef(to, value.unsafe_cast<lua_Number>());
+
+    case LUA_TSTRING:
+        return LuaRef(to, value.unsafe_cast<std::string>());
+
+    case LUA_TBOOLEAN:
+        return LuaRef(to, value.unsafe_cast<bool>());
+
+    default:
+        return LuaRef(to);
+    }
+}
+} // namespace
+
+TEST_F(PerformanceTests, TableTransfer)
+{
+    int const N = 100;
+
+    runLua(R"(
+        result = { messages = {} }
+        for i = 1, 500 do
+            result.messages[i] = { id = i, text = 'message ' .. i, flags = { urgent = i % 2 == 0, retries = i % 5 } }
+        end
+    )");
+
+    lua_State* other = createNewLuaState();
+
+    auto const source = result();
+
+    Stopwatch sw;
+    for (int i = 0; i < N; ++i)
+        copyWithLuaRef(source, other);
+    double const luaRefSeconds = sw.getElapsedSeconds();
+
+    sw.start();
+    for (int i = 0; i < N; ++i)
+    {
+        source.push(L);
+        EXPECT_TRUE(transfer(L, -1, other));
+        lua_pop(L, 1);
+        lua_pop(other, 1);
+    }
+    double const transferSeconds = sw.getElapsedSeconds();
+
+    source.push(L);
+    EXPECT_TRUE(transfer(L, -1, other));
+    lua_setglobal(other, "result");
+    runLua("result = result.messages[250].text .. tostring(result.messages[250].flags.urgent)", other);
+    EXPECT_EQ("message 250true", getGlobal(other, "result").unsafe_cast<std::string>());
+
+    lua_close(other);
+
+    cout.precision(4);
+    cout << "LuaRef walk copy: " << luaRefSeconds << " s" << endl;
+    cout << "Stack transfer: " << transferSeconds << " s" << endl;
+}
+
+TEST_F(PerformanceTests, TableSerialization)
+{
+    int const N = 100;
+
+    // The text dump only descends one level, so the table is kept flat
+    runLua(R"(
+        result = { name = 'snapshot', version = 3 }
+        for i = 1, 5000 do result[i] = i * 7 end
+        for i = 1, 1000 do result['key' .. i] = i * 0.25 end
+    )");
+
+    auto const source = result();
+    source.push(L);
+
+    std::size_t dumpSize = 0;
+    Stopwatch sw;
+    for (int i = 0; i < N; ++i)
+    {
+        std::ostringstream stream;
+        debug::dumpTable(L, -1, stream);
+        dumpSize = stream.str().size();
+    }
+    double const dumpSeconds = sw.getElapsedSeconds();
+
+    std::vector<std::uint8_t> buffer;
+    sw.start();
+    for (int i = 0; i < N; ++i)
+    {
+        buffer.clear();
+        EXPECT_TRUE(serialize(L, -1, buffer));
+    }
+    double const serializeSeconds = sw.getElapsedSeconds();
+
+    sw.start();
+    for (int i = 0; i < N; ++i)
+    {
+        EXPECT_TRUE(deserialize(L, buffer));
+        lua_pop(L, 1);
+    }
+    double const deserializeSeconds = sw.getElapsedSeconds();
+
+    lua_pop(L, 1);
+
+    EXPECT_LT(buffer.size(), dumpSize);
+
+    cout.precision(4);
+    cout << "Text dump: " << dumpSeconds << " s, " << dumpSize << " bytes" << endl;
+    cout << "Binary serialize: " << serializeSeconds << " s, " << buffer.size() << " bytes" << endl;
+    cout << "Binary deserialize: " << deserializeSeconds << " s" << endl;
+}
+
+namespace {
+template <class T>
+double measureIntegralConversions(lua_State* L, int count)
+{
+    T sum = 0;
+
+    Stopwatch sw;
+    for (int i = 0; i < count; ++i)
+    {
+        (void)Stack<T>::push(L, static_cast<T>(i & 0x7f));
+        sum = static_cast<T>(sum + *Stack<T>::get(L, -1));
+        lua_pop(L, 1);
+    }
+    double const seconds = sw.getElapsedSeconds();
+
+    EXPECT_NE(T(0), sum);
+    return seconds;
+}
+} // namespace
+
+TEST_F(PerformanceTests, IntegralConversions)
+{
+    int const N = 2000000;
+
+    cout.precision(4);
+    cout << "int8_t push/get: " << measureIntegralConversions<int8_t>(L, N) << " s" << endl;
+    cout << "unsigned char push/get: " << measureIntegralConversions<unsigned char>(L, N) << " s" << endl;
+    cout << "short push/get: " << measureIntegralConversions<short>(L, N) << " s" << endl;
+    cout << "unsigned short push/get: " << measureIntegralConversions<unsigned short>(L, N) << " s" << endl;
+    cout << "int push/get: " << measureIntegralConversions<int>(L, N) << " s" << endl;
+    cout << "unsigned int push/get: " << measureIntegralConversions<unsigned int>(L, N) << " s" << endl;
+    cout << "long push/get: " << measureIntegralConversions<long>(L, N) << " s" << endl;
+    cout << "unsigned long push/get: " << measureIntegralConversions<unsigned long>(L, N) << " s" << endl;
+    cout << "long long push/get: " << measureIntegralConversions<long long>(L, N) << " s" << endl;
+    cout << "unsigned long long push/get: " << measureIntegralConversions<unsigned long long>(L, N) << " s" << endl;
+}
+
+TEST_F(PerformanceTests, LuaCallbackInvocation)
+{
+    int const N = 500000;
+
+    runLua("function onEvent(id, value) return id + value end");
+
+    LuaRef ref = getGlobal(L, "onEvent");
+    LuaFunction<int(int, int)> function(ref);
+
+    long long refSum = 0;
+    Stopwatch sw;
+    for (int i = 0; i < N; ++i)
+        refSum += ref(i, 1)[0].unsafe_cast<int>();
+    double const refSeconds = sw.getElapsedSeconds();
+
+    long long functionSum = 0;
+    sw.start();
+    for (int i = 0; i < N; ++i)
+        functionSum += *function(i, 1);
+    double const functionSeconds = sw.getElapsedSeconds();
+
+    EXPECT_EQ(refSum, functionSum);
+
+    cout.precision(4);
+    cout << "LuaRef call: " << refSeconds << " s" << endl;
+    cout << "LuaFunction call: " << functionSeconds << " s" << endl;
+}
+
+TEST_F(PerformanceTests, ContainerProxyLookups)
+{
+    int const N = 50000;
+    int const Passes = 20;
+
+    std::map<int, A> map;
+    for (int i = 0; i < N; ++i)
+        map.emplace(i, A());
+
+    luabridge::getGlobalNamespace(L)
+        .beginClass<A>("A")
+            .addProperty("data", &A::data)
+        .endClass();
+
+    runLua("function touch(map) return map[1].data + map[2].data + map[3].data end");
+
+    LuaFunction<int(const std::map<int, A>&)> touchCopy(getGlobal(L, "touch"));
+    LuaFunction<int(ContainerProxy<std::map<int, A>>)> touchProxy(getGlobal(L, "touch"));
+
+    Stopwatch sw;
+    for (int i = 0; i < Passes; ++i)
+        EXPECT_TRUE(touchCopy(map));
+    double const copySeconds = sw.getElapsedSeconds();
+
+    sw.start();
+    for (int i = 0; i < Passes; ++i)
+        EXPECT_TRUE(touchProxy(borrowContainer(map)));
+    double const proxySeconds = sw.getElapsedSeconds();
+
+    cout.precision(4);
+    cout << "Map copied to table: " << copySeconds << " s" << endl;
+    cout << "Map proxy: " << proxySeconds << " s" << endl;
+}
+
+namespace {
+struct Entity
+{
+    LuaRef refIndex(const LuaRef& key, lua_State* L)
+    {
+        return LuaRef(L, key.tostring() == "health" ? health : 0);
+    }
+
+    int typedIndex(std::string_view key, lua_State* L)
+    {
+        lua_pushinteger(L, key == "health" ? health : 0);
+        return 1;
+    }
+
+    int health = 1;
+};
+
+struct TypedEntity : Entity
+{
+};
+} // namespace
+
+TEST_F(PerformanceTests, IndexFallbacks)
+{
+    int const N = 1000000;
+
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Entity>("Entity")
+            .addIndexMetaMethod(&Entity::refIndex)
+        .endClass()
+        .beginClass<TypedEntity>("TypedEntity")
+            .addIndexMetaMethod(+[](TypedEntity& e, std::string_view key, lua_State* L) { return e.typedIndex(key, L); })
+        .endClass();
+
+    Entity entity;
+    TypedEntity typedEntity;
+    setGlobal(L, &entity, "entity");
+    setGlobal(L, &typedEntity, "typedEntity");
+
+    std::stringstream ss;
+    ss << "function sumHealth(e) local sum = 0; for i = 1, " << N << " do sum = sum + e.health end; return sum end";
+    runLua(ss.str());
+
+    auto measure = [&](const std::string& name)
+    {
+        Stopwatch sw;
+        runLua("result = sumHealth(" + name + ")");
+        double const seconds = sw.getElapsedSeconds();
+
+        EXPECT_EQ(N, result<int>());
+        return seconds;
+    };
+
+    cout.precision(4);
+    cout << "LuaRef index fallback: " << measure("entity") << " s" << endl;
+    cout << "Typed index fallback: " << measure("typedEntity") << " s" << endl;
+}
+
+TEST_F(PerformanceTests, ExtensibleInstanceFields)
+{
+    int const N = 1000000;
+
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Entity>("Entity", extensibleClass)
+            .addConstructor<void (*)()>()
+        .endClass();
+
+    std::stringstream ss;
+    ss << "local e, side = Entity(), {}\n"
+       << "e.score = 1; side[e] = { score = 1 }\n"
+       << "function sumFields() local sum = 0; for i = 1, " << N << " do sum = sum + e.score end; return sum end\n"
+       << "function sumSideTable() local sum = 0; for i = 1, " << N << " do sum = sum + side[e].score end; return sum end";
+    runLua(ss.str());
+
+    auto measure = [&](const std::string& name)
+    {
+        Stopwatch sw;
+        runLua("result = " + name + "()");
+        double const seconds = sw.getElapsedSeconds();
+
+        EXPECT_EQ(N, result<int>());
+        return seconds;
+    };
+
+    cout.precision(4);
+    cout << "Side table field: " << measure("sumSideTable") << " s" << endl;
+    cout << "Instance field: " << measure("sumFields") << " s" << endl;
+}
@@ -0,0 +1,184 @@
+// https://github.com/kunitoki/LuaBridge3
+// Copyright 2023, Lucio Asnaghi
+// SPDX-License-Identifier: MIT
+
+#include "TestBase.h"
+
+#include <sstream>
+#include <string>
+
+struct ProfilerTests : TestBase
+{
+    void SetUp() override
+    {
+        TestBase::SetUp();
+
+#if LUABRIDGE_ON_LUAJIT
+        // Hooks are not called from compiled traces
+        luaJIT_setmode(L, 0, LUAJIT_MODE_ENGINE | LUAJIT_MODE_OFF);
+#endif
+    }
+};
+
+namespace {
+
+int profiledInvoke(const luabridge::LuaRef& function, int count)
+{
+    int total = 0;
+    for (int i = 0; i < count; ++i)
+        total += function(i)[0].unsafe_cast<int>();
+
+    return total;
+}
+
+} // namespace
+
+TEST_F(ProfilerTests, FoldedStacksMixLuaFramesAndBindings)
+{
+    luabridge::getGlobalNamespace(L)
+        .addFunction("profiledInvoke", &profiledInvoke);
+
+    luabridge::Profiler profiler(L, 100);
+    ASSERT_TRUE(profiler.start());
+    EXPECT_TRUE(profiler.isRunning());
+
+    runLua(R"(
+        function inner(n)
+            local sum = 0
+            for i = 1, 50 do sum = sum + i * n end
+            return sum % 7
+        end
+
+        function outer()
+            local total = profiledInvoke(inner, 2000) -- Not a tail call, which replaces the frame on LuaJIT
+            return total
+        end
+
+        result = outer()
+    )");
+
+    profiler.stop();
+    EXPECT_FALSE(profiler.isRunning());
+    EXPECT_GT(profiler.samples(), 0u);
+
+    const auto folded = profiler.folded();
+
+    // Functions called from C have no name, they are identified by the line where they are defined
+    EXPECT_NE(std::string::npos, folded.find("main chunk@"));
+    EXPECT_NE(std::string::npos, folded.find(";outer@"));
+#if LUABRIDGE_ENABLE_PROFILING
+    EXPECT_NE(std::string::npos, folded.find(":8;profiledInvoke;?@"));
+#else
+    EXPECT_NE(std::string::npos, folded.find(":8;[C] profiledInvoke;?@"));
+#endif
+    EXPECT_NE(std::string::npos, folded.find("]:2 "));
+
+    // Every line is a stack followed by its count, and the counts add up to the samples
+    std::istringstream lines(folded);
+    std::uint64_t total = 0;
+    for (std::string line; std::getline(lines, line);)
+    {
+        const auto space = line.rfind(' ');
+        ASSERT_NE(std::string::npos, space);
+        total += std::stoull(line.substr(space + 1));
+    }
+
+    EXPECT_EQ(profiler.samples(), total);
+
+    // Sampling stopped
+    const auto samples = profiler.samples();
+    runLua("for i = 1, 100000 do end");
+    EXPECT_EQ(samples, profiler.samples());
+
+    profiler.reset();
+    EXPECT_EQ(0u, profiler.samples());
+    EXPECT_TRUE(profiler.folded().empty());
+}
+
+TEST_F(ProfilerTests, OnlyOneProfilerPerState)
+{
+    luabridge::Profiler first(L, 10);
+    luabridge::Profiler second(L, 10);
+
+    ASSERT_TRUE(first.start());
+    EXPECT_FALSE(second.start());
+
+    first.stop();
+    ASSERT_TRUE(second.start());
+
+    runLua("for i = 1, 10000 do end");
+    EXPECT_EQ(0u, first.samples());
+    EXPECT_GT(second.samples(), 0u);
+}
+
+TEST_F(ProfilerTests, StopsWhenDestroyed)
+{
+    {
+        luabridge::Profiler profiler(L, 10);
+        ASSERT_TRUE(profiler.start());
+    }
+
+    runLua("for i = 1, 10000 do end");
+
+    luabridge::Profiler profiler(L, 10);
+    EXPECT_TRUE(profiler.start());
+}
+
+#if ! LUABRIDGE_ON_LUAU
+namespace {
+void lineHook(lua_State*, lua_Debug*)
+{
+}
+
+int countHookCalls = 0;
+
+void countHook(lua_State*, lua_Debug* ar)
+{
+    if (ar->event == LUA_HOOKCOUNT)
+        ++countHookCalls;
+}
+} // namespace
+
+TEST_F(ProfilerTests, ChainsPreviousHook)
+{
+    countHookCalls = 0;
+    lua_sethook(L, &countHook, LUA_MASKCOUNT, 100);
+
+    runLua("for i = 1, 10000 do end");
+    const int callsWithoutProfiler = countHookCalls;
+    EXPECT_GT(callsWithoutProfiler, 0);
+
+    countHookCalls = 0;
+
+    {
+        luabridge::Profiler profiler(L, 30);
+        ASSERT_TRUE(profiler.start());
+
+        runLua("for i = 1, 10000 do end");
+        EXPECT_GT(profiler.samples(), 0u);
+    }
+
+    // The previous hook keeps being called at its own pace while sampling
+    EXPECT_GE(countHookCalls, callsWithoutProfiler - 1);
+    EXPECT_LE(countHookCalls, callsWithoutProfiler + 1);
+
+    lua_sethook(L, nullptr, 0, 0);
+}
+
+TEST_F(ProfilerTests, RestoresPreviousHook)
+{
+    lua_sethook(L, &lineHook, LUA_MASKLINE | LUA_MASKCOUNT, 7);
+
+    {
+        luabridge::Profiler profiler(L, 10);
+        ASSERT_TRUE(profiler.start());
+        EXPECT_NE(&lineHook, lua_gethook(L));
+    }
+
+    EXPECT_EQ(&lineHook, lua_gethook(L));
+    EXPECT_EQ(LUA_MASKLINE | LUA_MASKCOUNT, lua_gethookmask(L));
+    EXPECT_EQ(7, lua_gethookcount(L));
+
+    lua_sethook(L, nullptr, 0, 0);
+}
+#endif
@@ -129,3 +129,129 @@ TEST_F(RefCountedPtrTests, LastReferenceInstantiatedFromLua)
 
     EXPECT_TRUE(RefCountedStatic::deleted);
 }
+
+namespace {
+
+template <class Base>
+struct IntrusiveCounted : Base
+{
+    explicit IntrusiveCounted(bool& deleted) : deleted(deleted) { deleted = false; }
+
+    ~IntrusiveCounted() { deleted = true; }
+
+    int value() const { return 42; }
+
+    bool& deleted;
+};
+
+template <class Base>
+struct IntrusiveCountedStatic : Base
+{
+    IntrusiveCountedStatic() = default;
+
+    ~IntrusiveCountedStatic() { deleted = true; }
+
+    static inline bool deleted = false;
+};
+
+} // namespace
+
+template <class T>
+struct IntrusivePtrTests : TestBase
+{
+};
+
+using IntrusivePtrCounterTypes = ::testing::Types<luabridge::AtomicRefCounted, luabridge::SingleThreadedRefCounted>;
+TYPED_TEST_SUITE(IntrusivePtrTests, IntrusivePtrCounterTypes);
+
+TYPED_TEST(IntrusivePtrTests, LastReferenceInLua)
+{
+    using Counted = IntrusiveCounted<TypeParam>;
+
+    luabridge::getGlobalNamespace(this->L)
+        .template beginClass<Counted>("Class")
+            .addFunction("value", &Counted::value)
+        .endClass();
+
+    bool deleted = false;
+    luabridge::IntrusivePtr<Counted> object(new Counted(deleted));
+
+    luabridge::setGlobal(this->L, object, "object");
+    EXPECT_EQ(2, object->getReferenceCount());
+
+    object = nullptr;
+    ASSERT_TRUE(this->runLua("result = object:value()"));
+    EXPECT_EQ(42, this->template result<int>());
+    EXPECT_FALSE(deleted);
+
+    ASSERT_TRUE(this->runLua("object = nil"));
+    lua_gc(this->L, LUA_GCCOLLECT, 0);
+    EXPECT_TRUE(deleted);
+}
+
+TYPED_TEST(IntrusivePtrTests, LastReferenceInCpp)
+{
+    using Counted = IntrusiveCounted<TypeParam>;
+
+    luabridge::getGlobalNamespace(this->L)
+        .template beginClass<Counted>("Class")
+        .endClass();
+
+    bool deleted = false;
+    luabridge::IntrusivePtr<Counted> object(new Counted(deleted));
+
+    luabridge::setGlobal(this->L, object, "object");
+
+    auto fromLua = luabridge::getGlobal<luabridge::IntrusivePtr<Counted>>(this->L, "object");
+    ASSERT_TRUE(fromLua);
+    EXPECT_EQ(object, *fromLua);
+    EXPECT_EQ(3, object->getReferenceCount());
+
+    fromLua = luabridge::IntrusivePtr<Counted>();
+    ASSERT_TRUE(this->runLua("object = nil"));
+    lua_gc(this->L, LUA_GCCOLLECT, 0);
+    EXPECT_FALSE(deleted);
+    EXPECT_EQ(1, object->getReferenceCount());
+
+    object = nullptr;
+    EXPECT_TRUE(deleted);
+}
+
+TYPED_TEST(IntrusivePtrTests, UserdataStoresOnlyThePointer)
+{
+    using Counted = IntrusiveCounted<TypeParam>;
+
+    luabridge::getGlobalNamespace(this->L)
+        .template beginClass<Counted>("Class")
+        .endClass();
+
+    bool deleted = false;
+    luabridge::IntrusivePtr<Counted> object(new Counted(deleted));
+
+    ASSERT_TRUE(luabridge::push(this->L, object));
+    EXPECT_EQ(luabridge::detail::UserdataKind::Intrusive, static_cast<luabridge::detail::Userdata*>(lua_touserdata(this->L, -1))->getKind());
+    EXPECT_EQ(sizeof(luabridge::detail::Userdata), sizeof(luabridge::detail::UserdataIntrusive<Counted>));
+    EXPECT_EQ(2, object->getReferenceCount());
+    lua_pop(this->L, 1);
+
+    lua_gc(this->L, LUA_GCCOLLECT, 0);
+    EXPECT_EQ(1, object->getReferenceCount());
+}
+
+TYPED_TEST(IntrusivePtrTests, InstantiatedFromLua)
+{
+    using Counted = IntrusiveCountedStatic<TypeParam>;
+
+    luabridge::getGlobalNamespace(this->L)
+        .template beginClass<Counted>("Class")
+            .template addConstructorFrom<luabridge::IntrusivePtr<Counted>, void()>()
+        .endClass();
+
+    Counted::deleted = false;
+
+    ASSERT_TRUE(this->runLua("local o = Class(); result = false"));
+    EXPECT_FALSE(Counted::deleted);
+
+    lua_gc(this->L, LUA_GCCOLLECT, 0);
+    EXPECT_TRUE(Counted::deleted);
+}
@@ -0,0 +1,298 @@
+// https://github.com/kunitoki/LuaBridge3
+// Copyright 2023, Lucio Asnaghi
+// SPDX-License-Identifier: MIT
+
+#include "TestBase.h"
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct SerializationTests : TestBase
+{
+    std::vector<std::uint8_t> serializeGlobal(const char* name)
+    {
+        lua_getglobal(L, name);
+
+        const int top = lua_gettop(L);
+
+        std::vector<std::uint8_t> buffer;
+        EXPECT_TRUE(luabridge::serialize(L, -1, buffer));
+        EXPECT_EQ(top, lua_gettop(L));
+
+        lua_pop(L, 1);
+        return buffer;
+    }
+
+    luabridge::Result deserializeGlobal(const char* name, const std::vector<std::uint8_t>& buffer)
+    {
+        const int top = lua_gettop(L);
+
+        auto result = luabridge::deserialize(L, buffer);
+        EXPECT_EQ(result ? top + 1 : top, lua_gettop(L));
+
+        if (result)
+            lua_setglobal(L, name);
+
+        return result;
+    }
+
+    bool roundTrip(const char* name)
+    {
+        return static_cast<bool>(deserializeGlobal(name, serializeGlobal(name)));
+    }
+};
+
+namespace {
+
+struct Vec
+{
+    double x;
+    double y;
+};
+
+struct Named
+{
+    explicit Named(std::string name) : name(std::move(name)) {}
+
+    std::string name;
+};
+
+} // namespace
+
+TEST_F(SerializationTests, PrimitiveValues)
+{
+    runLua("result = { b = true, f = false, n = 1.5, i = -42, s = 'a\\0b', [2] = 'two', inf = math.huge }");
+
+    ASSERT_TRUE(roundTrip("result"));
+    runLua("result = result.b == true and result.f == false and result.n == 1.5 and result.i == -42 and result.s == 'a\\0b' and result[2] == 'two' and result.inf == math.huge");
+    EXPECT_TRUE(result<bool>());
+
+    runLua("result = 'plain string'");
+    ASSERT_TRUE(roundTrip("result"));
+    EXPECT_EQ("plain string", result<std::string>());
+
+#if LUA_VERSION_NUM >= 503
+    runLua("result = { 9007199254740993, math.mininteger, 2.0 }");
+    ASSERT_TRUE(roundTrip("result"));
+    runLua("result = result[1] == 9007199254740993 and result[2] == math.mininteger and math.type(result[3]) == 'float'");
+    EXPECT_TRUE(result<bool>());
+#endif
+}
+
+TEST_F(SerializationTests, NestedTablesAndPackedRuns)
+{
+    runLua(R"(
+        result = { ints = {}, floats = {}, mixed = { 1, 2, 'x', 3.5, 4.5, true, 5 }, config = { ports = { 80, 443 }, deep = { deeper = 'value' } } }
+        for i = 1, 1000 do result.ints[i] = i * 3 - 1500 end
+        for i = 1, 100 do result.floats[i] = i / 4 end
+        result.ints.extra = 'x'
+    )");
+
+    const auto buffer = serializeGlobal("result");
+
+    // Small integers in a run take two bytes at most
+    EXPECT_LT(buffer.size(), 1000u * 2 + 100u * 8 + 200u);
+
+    ASSERT_TRUE(deserializeGlobal("result", buffer));
+    runLua(R"(
+        local ok = #result.ints == 1000 and #result.floats == 100 and result.ints.extra == 'x'
+        for i = 1, 1000 do ok = ok and result.ints[i] == i * 3 - 1500 end
+        for i = 1, 100 do ok = ok and result.floats[i] == i / 4 end
+        local m = result.mixed
+        ok = ok and m[1] == 1 and m[2] == 2 and m[3] == 'x' and m[4] == 3.5 and m[5] == 4.5 and m[6] == true and m[7] == 5
+        result = ok and result.config.ports[2] == 443 and result.config.deep.deeper == 'value'
+    )");
+    EXPECT_TRUE(result<bool>());
+}
+
+TEST_F(SerializationTests, SharedReferencesCyclesAndStrings)
+{
+    runLua(R"(
+        local shared = { 1, 2, 3 }
+        result = { a = shared, b = shared, list = {} }
+        result.self = result
+        result[shared] = 'table key'
+        for i = 1, 100 do result.list[i] = { name = 'a rather long repeated string value' } end
+    )");
+
+    const auto buffer = serializeGlobal("result");
+    EXPECT_LT(buffer.size(), 1000u);
+
+    ASSERT_TRUE(deserializeGlobal("result", buffer));
+    runLua("result = result.a == result.b and result.self == result and result[result.a] == 'table key' and result.list[100].name == 'a rather long repeated string value'");
+    EXPECT_TRUE(result<bool>());
+}
+
+TEST_F(SerializationTests, ClassObjects)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Vec>("Vec")
+            .addConstructor<void (*)()>()
+            .addProperty("x", &Vec::x)
+            .addProperty("y", &Vec::y)
+            .addSerializer()
+        .endClass()
+        .beginClass<Named>("Named")
+            .addProperty("name", &Named::name)
+            .addSerializer(
+                [](const Named& object, luabridge::SerializationWriter& writer) { writer.writeString(object.name); },
+                [](luabridge::SerializationReader& reader, lua_State* L) -> luabridge::Result
+                {
+                    std::string name;
+                    if (! reader.readString(name))
+                        return luabridge::makeErrorCode(luabridge::ErrorCode::InvalidSerializedData);
+
+                    return luabridge::push(L, Named(name + "!"));
+                })
+        .endClass();
+
+    ASSERT_TRUE(luabridge::push(L, Named("object")));
+    lua_setglobal(L, "named");
+
+    runLua("local v = Vec(); v.x = 1; v.y = 2; result = { first = v, second = v, named = named }");
+
+    ASSERT_TRUE(roundTrip("result"));
+    runLua("result = result.first.x == 1 and result.first.y == 2 and result.first == result.second and result.named.name == 'object!'");
+    EXPECT_TRUE(result<bool>());
+}
+
+TEST_F(SerializationTests, ClassObjectsFromBindingImage)
+{
+    auto image = luabridge::BindingImage::capture([](luabridge::Namespace ns)
+    {
+        ns.beginClass<Vec>("Vec")
+            .addConstructor<void (*)()>()
+            .addProperty("x", &Vec::x)
+            .addProperty("y", &Vec::y)
+            .addSerializer()
+        .endClass();
+    });
+
+    lua_State* other = createNewLuaState();
+
+    image.instantiate(L);
+    image.instantiate(other);
+
+    runLua("result = Vec(); result.x = 3; result.y = 4");
+    const auto buffer = serializeGlobal("result");
+
+    ASSERT_TRUE(luabridge::deserialize(other, buffer));
+    lua_setglobal(other, "result");
+
+    runLua("result = result.x == 3 and result.y == 4", other);
+    EXPECT_TRUE(*luabridge::getGlobal<bool>(other, "result"));
+
+    lua_close(other);
+}
+
+TEST_F(SerializationTests, StreamingMode)
+{
+    runLua(R"(
+        result = { data = {}, text = string.rep('abc', 50000) }
+        for i = 1, 20000 do result.data[i] = { id = i, value = i * 0.5 } end
+    )");
+
+    std::stringstream stream;
+
+    lua_getglobal(L, "result");
+    ASSERT_TRUE(luabridge::serialize(L, -1, stream));
+    lua_pushinteger(L, 42);
+    ASSERT_TRUE(luabridge::serialize(L, -1, stream));
+    lua_pop(L, 2);
+
+    const auto buffer = serializeGlobal("result");
+    EXPECT_EQ(std::string(buffer.begin(), buffer.end()), stream.str().substr(0, buffer.size()));
+
+    ASSERT_TRUE(luabridge::deserialize(L, stream));
+    lua_setglobal(L, "result");
+
+    // Values written in sequence are read back in sequence
+    ASSERT_TRUE(luabridge::deserialize(L, stream));
+    EXPECT_EQ(42, lua_tointeger(L, -1));
+    lua_pop(L, 1);
+
+    runLua("result = #result.data == 20000 and result.data[20000].value == 10000 and #result.text == 150000");
+    EXPECT_TRUE(result<bool>());
+}
+
+TEST_F(SerializationTests, UnsupportedValues)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Vec>("Vec")
+            .addConstructor<void (*)()>()
+        .endClass();
+
+    const char* scripts[] = {
+        "result = { f = function() end }",
+        "result = { coroutine.create(function() end) }",
+        "result = { Vec() }",
+    };
+
+    for (const char* script : scripts)
+    {
+        runLua(script);
+        lua_getglobal(L, "result");
+
+        std::vector<std::uint8_t> buffer{ 1, 2, 3 };
+        EXPECT_EQ(luabridge::makeErrorCode(luabridge::ErrorCode::ValueNotSerializable), luabridge::serialize(L, -1, buffer).error());
+        EXPECT_EQ(3u, buffer.size());
+
+        lua_pop(L, 1);
+    }
+}
+
+TEST_F(SerializationTests, InvalidData)
+{
+    runLua("result = { 1, 2, 3, name = 'name', nested = { 1.5, 2.5 } }");
+    const auto buffer = serializeGlobal("result");
+
+    const int top = lua_gettop(L);
+
+    // Every truncation is rejected
+    for (std::size_t size = 0; size < buffer.size(); ++size)
+    {
+        EXPECT_EQ(luabridge::makeErrorCode(luabridge::ErrorCode::InvalidSerializedData), luabridge::deserialize(L, buffer.data(), size).error());
+        EXPECT_EQ(top, lua_gettop(L));
+    }
+
+    // Corrupted bytes never crash, and leave the stack untouched when rejected
+    for (std::size_t i = 4; i < buffer.size(); ++i)
+    {
+        for (std::uint8_t value : { std::uint8_t(0x00), std::uint8_t(0x08), std::uint8_t(0x7f), std::uint8_t(0xff) })
+        {
+            auto corrupted = buffer;
+            corrupted[i] = value;
+
+            if (luabridge::deserialize(L, corrupted))
+                lua_pop(L, 1);
+
+            EXPECT_EQ(top, lua_gettop(L));
+        }
+    }
+
+    // A huge table size is not trusted for presizing
+    const std::vector<std::uint8_t> huge{ 'L', 'B', 'S', 1, 7, 0xff, 0xff, 0xff, 0xff, 0x07, 0x00 };
+    EXPECT_EQ(luabridge::makeErrorCode(luabridge::ErrorCode::InvalidSerializedData), luabridge::deserialize(L, huge).error());
+    EXPECT_EQ(top, lua_gettop(L));
+}
+
+TEST_F(SerializationTests, ClassNotRegisteredWhenDeserializing)
+{
+    lua_State* other = createNewLuaState();
+
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Vec>("Vec")
+            .addConstructor<void (*)()>()
+            .addSerializer()
+        .endClass();
+
+    runLua("result = { Vec() }");
+    const auto buffer = serializeGlobal("result");
+
+    EXPECT_EQ(luabridge::makeErrorCode(luabridge::ErrorCode::ClassNotRegistered), luabridge::deserialize(other, buffer).error());
+    EXPECT_EQ(0, lua_gettop(other));
+
+    lua_close(other);
+}
@@ -2153,6 +2153,16 @@ TEST_F(StackTests, TupleNesting)
     EXPECT_EQ("one", std::get<1>(std::get<1>(std::get<1>(*result))));
 }
 
+TEST_F(StackTests, EmptyTuple)
+{
+    static_assert(luabridge::detail::stack_slots_v<std::tuple<>> == 2);
+
+    ASSERT_TRUE(luabridge::push(L, std::tuple<>()));
+    EXPECT_TRUE(lua_istable(L, -1));
+    EXPECT_TRUE(luabridge::isInstance<std::tuple<>>(L, -1));
+    EXPECT_TRUE(luabridge::get<std::tuple<>>(L, -1));
+}
+
 TEST_F(StackTests, TupleStackOverflow)
 {
     exhaustStackSpace();
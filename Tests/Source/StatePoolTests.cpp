@@ -0,0 +1,176 @@
+// https://github.com/kunitoki/LuaBridge3
+// Copyright 2023, Lucio Asnaghi
+// SPDX-License-Identifier: MIT
+
+#include "TestBase.h"
+
+#include "LuaBridge/StatePool.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+struct StatePoolTests : TestBase
+{
+};
+
+namespace {
+
+int multiplyByTwo(int value)
+{
+    return value * 2;
+}
+
+void registerBindings(lua_State* L)
+{
+    luaL_openlibs(L);
+
+    luabridge::getGlobalNamespace(L)
+        .beginNamespace("pool")
+            .addFunction("multiplyByTwo", &multiplyByTwo)
+        .endNamespace();
+}
+
+int runScript(lua_State* L, const char* script)
+{
+    if (luaL_loadstring(L, script) != LUABRIDGE_LUA_OK || lua_pcall(L, 0, 1, 0) != LUABRIDGE_LUA_OK)
+        return -1;
+
+    return static_cast<int>(lua_tointeger(L, -1));
+}
+
+} // namespace
+
+TEST_F(StatePoolTests, RunsJobsWithRegisteredBindings)
+{
+    luabridge::StatePool pool(2, &registerBindings);
+    EXPECT_EQ(2u, pool.size());
+
+    std::vector<std::future<int>> results;
+    for (int i = 0; i < 20; ++i)
+    {
+        results.push_back(pool.submit([i](lua_State* L)
+        {
+            lua_pushinteger(L, i);
+            lua_setglobal(L, "input");
+
+            return runScript(L, "return pool.multiplyByTwo(input)");
+        }));
+    }
+
+    for (int i = 0; i < 20; ++i)
+        EXPECT_EQ(i * 2, results[static_cast<std::size_t>(i)].get());
+
+    pool.wait();
+
+    const auto stats = pool.stats();
+    EXPECT_EQ(2u, stats.states);
+    EXPECT_EQ(20u, stats.submittedJobs);
+    EXPECT_EQ(20u, stats.executedJobs);
+    EXPECT_GE(stats.totalLatency, stats.maxLatency);
+    EXPECT_GE(stats.utilization(), 0.0);
+    EXPECT_LE(stats.utilization(), 1.0);
+}
+
+TEST_F(StatePoolTests, ResetsGlobalsBetweenJobs)
+{
+    luabridge::StatePool pool(1, &registerBindings);
+
+    EXPECT_EQ(1, pool.submit([](lua_State* L)
+    {
+        return runScript(L, "leaked = 1; pool = nil; print = nil; return 1");
+    }).get());
+
+    EXPECT_EQ(1, pool.submit([](lua_State* L)
+    {
+        return runScript(L, "if leaked == nil and pool ~= nil and print ~= nil then return pool.multiplyByTwo(0) + 1 end return 0");
+    }).get());
+}
+
+TEST_F(StatePoolTests, KeepsGlobalsWhenResetDisabled)
+{
+    luabridge::StatePoolOptions options;
+    options.resetGlobals = false;
+    options.collect = luabridge::StatePoolCollect::None;
+
+    luabridge::StatePool pool(1, &registerBindings, options);
+
+    pool.submit([](lua_State* L) { runScript(L, "counter = (counter or 0) + 1"); });
+    pool.submit([](lua_State* L) { runScript(L, "counter = (counter or 0) + 1"); });
+
+    EXPECT_EQ(2, pool.submit([](lua_State* L) { return runScript(L, "return counter"); }).get());
+}
+
+TEST_F(StatePoolTests, IdleWorkersStealQueuedJobs)
+{
+    constexpr int jobs = 21;
+
+    luabridge::StatePool pool(2, &registerBindings);
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    int completed = 0;
+
+    // The first job blocks its worker until every other job completed, including the ones queued behind it on the same worker
+    auto blocking = pool.submit([&](lua_State*)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        return condition.wait_for(lock, std::chrono::seconds(10), [&] { return completed == jobs - 1; });
+    });
+
+    for (int i = 1; i < jobs; ++i)
+    {
+        pool.submit([&](lua_State* L)
+        {
+            runScript(L, "return pool.multiplyByTwo(1)");
+
+            std::lock_guard<std::mutex> lock(mutex);
+            ++completed;
+            condition.notify_all();
+        });
+    }
+
+    EXPECT_TRUE(blocking.get());
+
+    pool.wait();
+
+    const auto stats = pool.stats();
+    EXPECT_EQ(static_cast<std::uint64_t>(jobs), stats.executedJobs);
+    EXPECT_GE(stats.stolenJobs, static_cast<std::uint64_t>(jobs / 2));
+}
+
+TEST_F(StatePoolTests, DestructorCompletesQueuedJobs)
+{
+    std::atomic<int> executed{ 0 };
+
+    {
+        luabridge::StatePool pool(2, &registerBindings);
+
+        for (int i = 0; i < 50; ++i)
+            pool.submit([&executed](lua_State*) { ++executed; });
+    }
+
+    EXPECT_EQ(50, executed.load());
+}
+
+#if LUABRIDGE_HAS_EXCEPTIONS
+TEST_F(StatePoolTests, ClosesStatesWhenRegistrationThrows)
+{
+    int registered = 0;
+
+    auto registration = [&registered](lua_State* L)
+    {
+        registerBindings(L);
+
+        if (++registered == 3)
+            throw std::runtime_error("registration failed");
+    };
+
+    EXPECT_THROW(luabridge::StatePool(4, registration), std::runtime_error);
+    EXPECT_EQ(3, registered);
+}
+#endif
@@ -0,0 +1,254 @@
+// https://github.com/kunitoki/LuaBridge3
+// Copyright 2023, Lucio Asnaghi
+// SPDX-License-Identifier: MIT
+
+#include "TestBase.h"
+
+#include <memory>
+#include <string>
+
+struct TransferTests : TestBase
+{
+    lua_State* other = nullptr;
+
+    void SetUp() override
+    {
+        TestBase::SetUp();
+
+        other = createNewLuaState();
+    }
+
+    void TearDown() override
+    {
+        lua_close(other);
+
+        TestBase::TearDown();
+    }
+
+    luabridge::Result transferGlobal(const char* name)
+    {
+        lua_getglobal(L, name);
+
+        const int top = lua_gettop(L);
+        const int otherTop = lua_gettop(other);
+
+        auto result = luabridge::transfer(L, -1, other);
+
+        EXPECT_EQ(top, lua_gettop(L));
+        EXPECT_EQ(result ? otherTop + 1 : otherTop, lua_gettop(other));
+
+        lua_pop(L, 1);
+
+        if (result)
+            lua_setglobal(other, name);
+
+        return result;
+    }
+
+    bool runOther(const std::string& script)
+    {
+        if (luaL_loadstring(other, script.c_str()) != LUABRIDGE_LUA_OK || lua_pcall(other, 0, 1, 0) != LUABRIDGE_LUA_OK)
+            return false;
+
+        const bool value = lua_toboolean(other, -1) != 0;
+        lua_pop(other, 1);
+        return value;
+    }
+};
+
+namespace {
+
+struct Vec
+{
+    Vec(double x = 0.0, double y = 0.0) : x(x), y(y) {}
+
+    double x;
+    double y;
+};
+
+struct Resource
+{
+    explicit Resource(int id) : id(id) {}
+
+    Resource(const Resource&) = delete;
+
+    int id;
+};
+
+void registerVec(lua_State* L)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Vec>("Vec")
+            .addConstructor<void (*)(double, double)>()
+            .addProperty("x", &Vec::x)
+            .addProperty("y", &Vec::y)
+            .addTransfer()
+        .endClass();
+}
+
+} // namespace
+
+TEST_F(TransferTests, PrimitiveValues)
+{
+    runLua("result = { b = true, n = 1.5, s = 'a\\0b', [2] = 'two' }");
+
+    ASSERT_TRUE(transferGlobal("result"));
+    EXPECT_TRUE(runOther("return result.b == true and result.n == 1.5 and result.s == 'a\\0b' and result[2] == 'two'"));
+
+#if LUA_VERSION_NUM >= 503
+    runLua("result = 9007199254740993");
+    ASSERT_TRUE(transferGlobal("result"));
+    EXPECT_TRUE(runOther("return math.type(result) == 'integer' and result == 9007199254740993"));
+#endif
+}
+
+TEST_F(TransferTests, NestedTables)
+{
+    runLua(R"(
+        result = { list = {}, config = { name = 'server', ports = { 80, 443 }, nested = { deep = { deeper = 'value' } } } }
+        for i = 1, 100 do result.list[i] = i * 2 end
+        result.list.extra = 'x'
+    )");
+
+    ASSERT_TRUE(transferGlobal("result"));
+
+    EXPECT_TRUE(runOther(R"(
+        local ok = #result.list == 100 and result.list.extra == 'x'
+        for i = 1, 100 do ok = ok and result.list[i] == i * 2 end
+        return ok and result.config.name == 'server' and result.config.ports[2] == 443 and result.config.nested.deep.deeper == 'value'
+    )"));
+}
+
+TEST_F(TransferTests, SharedReferencesAndCycles)
+{
+    runLua(R"(
+        local shared = { 1, 2, 3 }
+        result = { a = shared, b = shared }
+        result.self = result
+        result[shared] = 'table key'
+    )");
+
+    ASSERT_TRUE(transferGlobal("result"));
+    EXPECT_TRUE(runOther("return result.a == result.b and result.self == result and result[result.a] == 'table key'"));
+}
+
+TEST_F(TransferTests, ClassObjectsAreCopied)
+{
+    registerVec(L);
+    registerVec(other);
+
+    runLua("result = { first = Vec(1, 2) }; result.second = result.first");
+
+    ASSERT_TRUE(transferGlobal("result"));
+    EXPECT_TRUE(runOther("return result.first.x == 1 and result.first.y == 2 and result.first == result.second"));
+
+    runOther("result.first.x = 10");
+    runLua("result = result.first.x");
+    EXPECT_EQ(1.0, result<double>());
+}
+
+TEST_F(TransferTests, ClassObjectsFromBindingImage)
+{
+    auto image = luabridge::BindingImage::capture([](luabridge::Namespace ns)
+    {
+        ns.beginClass<Vec>("Vec")
+            .addConstructor<void (*)(double, double)>()
+            .addProperty("x", &Vec::x)
+            .addProperty("y", &Vec::y)
+            .addTransfer()
+        .endClass();
+    });
+
+    image.instantiate(L);
+    image.instantiate(other);
+
+    runLua("result = Vec(42, 2)");
+
+    ASSERT_TRUE(transferGlobal("result"));
+    EXPECT_TRUE(runOther("return result.x == 42 and result.y == 2"));
+}
+
+TEST_F(TransferTests, ClassNotRegisteredInDestination)
+{
+    registerVec(L);
+
+    runLua("result = { Vec(1, 2) }");
+
+    lua_getglobal(L, "result");
+    const int top = lua_gettop(L);
+
+#if LUABRIDGE_HAS_EXCEPTIONS
+    EXPECT_ANY_THROW(luabridge::transfer(L, -1, other));
+#else
+    EXPECT_EQ(luabridge::makeErrorCode(luabridge::ErrorCode::ClassNotRegistered), luabridge::transfer(L, -1, other).error());
+#endif
+
+    EXPECT_EQ(top, lua_gettop(L));
+    EXPECT_EQ(0, lua_gettop(other));
+}
+
+TEST_F(TransferTests, CustomTransferHook)
+{
+    auto registerResource = [](lua_State* state)
+    {
+        luabridge::getGlobalNamespace(state)
+            .beginClass<Resource>("Resource")
+                .addProperty("id", &Resource::id, false)
+                .addTransfer([](const Resource& resource, lua_State* to) -> luabridge::Result
+                {
+                    return luabridge::push(to, std::make_shared<Resource>(resource.id + 1));
+                })
+            .endClass();
+    };
+
+    registerResource(L);
+    registerResource(other);
+
+    ASSERT_TRUE(luabridge::push(L, std::make_shared<Resource>(41)));
+    lua_setglobal(L, "result");
+
+    ASSERT_TRUE(transferGlobal("result"));
+    EXPECT_TRUE(runOther("return result.id == 42"));
+}
+
+TEST_F(TransferTests, UnsupportedValues)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Vec>("Vec")
+            .addConstructor<void (*)(double, double)>()
+        .endClass();
+
+    runLua("result = { f = function() end }");
+    EXPECT_EQ(luabridge::makeErrorCode(luabridge::ErrorCode::ValueNotTransferable), transferGlobal("result").error());
+
+    runLua("result = { coroutine.create(function() end) }");
+    EXPECT_EQ(luabridge::makeErrorCode(luabridge::ErrorCode::ValueNotTransferable), transferGlobal("result").error());
+
+    runLua("result = { Vec(1, 2) }");
+    EXPECT_EQ(luabridge::makeErrorCode(luabridge::ErrorCode::ValueNotTransferable), transferGlobal("result").error());
+}
+
+TEST_F(TransferTests, DeeplyNestedTables)
+{
+    runLua("result = {} local t = result for i = 1, 999 do t.next = {} t = t.next end");
+    EXPECT_TRUE(transferGlobal("result"));
+
+    runLua("result = {} local t = result for i = 1, 1000 do t.next = {} t = t.next end");
+    EXPECT_EQ(luabridge::makeErrorCode(luabridge::ErrorCode::ValueNestedTooDeeply), transferGlobal("result").error());
+}
+
+TEST_F(TransferTests, SameStateMovesTheValue)
+{
+    runLua("result = { value = 42 }");
+
+    lua_State* thread = lua_newthread(L);
+
+    lua_getglobal(L, "result");
+    ASSERT_TRUE(luabridge::transfer(L, -1, thread));
+    ASSERT_EQ(1, lua_gettop(thread));
+
+    lua_xmove(thread, L, 1);
+    EXPECT_TRUE(lua_rawequal(L, -1, -2));
+
+    lua_pop(L, 3);
+}
@@ -5,6 +5,9 @@
 
 #include "TestBase.h"
 
+#include <memory>
+#include <vector>
+
 namespace {
 class TestClass
 {
@@ -154,3 +157,352 @@ TEST_F(UserDataTest, FailNilRefConst)
     EXPECT_FALSE(runLua("testFunctionRefConst(nil)"));
 #endif
 }
+
+namespace {
+struct DestructorCounted
+{
+    DestructorCounted() = default;
+    DestructorCounted(const DestructorCounted&) = default;
+    ~DestructorCounted() { ++destructed; }
+
+    static inline int destructed = 0;
+};
+} // namespace
+
+TEST_F(UserDataTest, HeaderIsNotPolymorphic)
+{
+    constexpr std::size_t externalMemorySize = sizeof(luabridge::detail::ExternalMemoryRecord);
+
+    EXPECT_FALSE(std::is_polymorphic_v<luabridge::detail::Userdata>);
+    EXPECT_LE(sizeof(luabridge::detail::UserdataPtr), 2 * sizeof(void*) + externalMemorySize);
+    EXPECT_LT(sizeof(luabridge::detail::UserdataValue<int>), 2 * sizeof(void*) + sizeof(int) + externalMemorySize);
+}
+
+TEST_F(UserDataTest, GarbageCollectionDestroysByKind)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<DestructorCounted>("DestructorCounted")
+        .endClass();
+
+    DestructorCounted::destructed = 0;
+
+    DestructorCounted unowned;
+    auto shared = std::make_shared<DestructorCounted>();
+
+    ASSERT_TRUE(luabridge::push(L, DestructorCounted()));
+    ASSERT_TRUE(luabridge::push(L, &unowned));
+    ASSERT_TRUE(luabridge::push(L, shared));
+    EXPECT_EQ(1, DestructorCounted::destructed); // The temporary
+    EXPECT_EQ(2, shared.use_count());
+
+    lua_pop(L, 3);
+    lua_gc(L, LUA_GCCOLLECT, 0);
+
+    EXPECT_EQ(2, DestructorCounted::destructed); // The value userdata
+    EXPECT_EQ(1, shared.use_count());
+}
+
+namespace {
+struct CachedPointerClass
+{
+    int value = 0;
+};
+
+struct UncachedPointerClass
+{
+    int value = 0;
+};
+} // namespace
+
+TEST_F(UserDataTest, CachedPointersReuseUserdata)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<CachedPointerClass>("CachedPointerClass", luabridge::cachedPointers)
+            .addProperty("value", &CachedPointerClass::value)
+        .endClass()
+        .beginClass<UncachedPointerClass>("UncachedPointerClass")
+        .endClass();
+
+    CachedPointerClass cached;
+    UncachedPointerClass uncached;
+
+    ASSERT_TRUE(luabridge::push(L, &cached));
+    ASSERT_TRUE(luabridge::push(L, &cached));
+    EXPECT_TRUE(lua_rawequal(L, -1, -2));
+    lua_pop(L, 2);
+
+    ASSERT_TRUE(luabridge::push(L, static_cast<const CachedPointerClass*>(&cached)));
+    ASSERT_TRUE(luabridge::push(L, &cached));
+    EXPECT_FALSE(lua_rawequal(L, -1, -2));
+    lua_pop(L, 2);
+
+    ASSERT_TRUE(luabridge::push(L, &uncached));
+    ASSERT_TRUE(luabridge::push(L, &uncached));
+    EXPECT_FALSE(lua_rawequal(L, -1, -2));
+    lua_pop(L, 2);
+
+    luabridge::setGlobal(L, &cached, "a");
+    luabridge::setGlobal(L, &cached, "b");
+    runLua("result = a == b");
+    EXPECT_TRUE(result<bool>());
+
+    runLua("local t = { [a] = 42 }; result = t[b]");
+    EXPECT_EQ(42, result<int>());
+}
+
+TEST_F(UserDataTest, CachedPointersInvalidate)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<CachedPointerClass>("CachedPointerClass", luabridge::cachedPointers)
+        .endClass();
+
+    CachedPointerClass cached;
+
+    ASSERT_TRUE(luabridge::push(L, &cached));
+    luabridge::invalidateCachedPointer(L, &cached);
+    ASSERT_TRUE(luabridge::push(L, &cached));
+    EXPECT_FALSE(lua_rawequal(L, -1, -2));
+    EXPECT_EQ(&cached, luabridge::get<CachedPointerClass*>(L, -1).value());
+    lua_pop(L, 2);
+
+    lua_gc(L, LUA_GCCOLLECT, 0);
+
+    ASSERT_TRUE(luabridge::push(L, &cached));
+    EXPECT_EQ(&cached, luabridge::get<CachedPointerClass*>(L, -1).value());
+    lua_pop(L, 1);
+}
+
+namespace {
+struct DisposableDerived : DestructorCounted
+{
+    ~DisposableDerived() { ++derivedDestructed; }
+
+    static inline int derivedDestructed = 0;
+};
+
+int disposableValue(const DestructorCounted*)
+{
+    return 42;
+}
+} // namespace
+
+TEST_F(UserDataTest, DisposeReleasesObjectImmediately)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<DestructorCounted>("DestructorCounted", luabridge::disposableClass)
+            .addConstructor<void (*)()>()
+            .addFunction("value", &disposableValue)
+        .endClass();
+
+    DestructorCounted::destructed = 0;
+
+    runLua("obj = DestructorCounted (); result = obj:value (); obj:dispose ()");
+    EXPECT_EQ(42, result<int>());
+    EXPECT_EQ(1, DestructorCounted::destructed);
+
+    runLua("obj:dispose ()");
+    EXPECT_EQ(1, DestructorCounted::destructed);
+
+#if LUABRIDGE_HAS_EXCEPTIONS
+    EXPECT_THROW(runLua("result = obj:value ()"), std::exception);
+#else
+    EXPECT_FALSE(runLua("result = obj:value ()"));
+#endif
+
+    runLua("obj = nil");
+    lua_gc(L, LUA_GCCOLLECT, 0);
+    EXPECT_EQ(1, DestructorCounted::destructed);
+}
+
+TEST_F(UserDataTest, DisposeByKind)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<DestructorCounted>("DestructorCounted", luabridge::disposableClass | luabridge::cachedPointers)
+            .addFunction("value", &disposableValue)
+        .endClass();
+
+    DestructorCounted::destructed = 0;
+
+    DestructorCounted unowned;
+    auto shared = std::make_shared<DestructorCounted>();
+
+    luabridge::setGlobal(L, &unowned, "unowned");
+    luabridge::setGlobal(L, shared, "shared");
+    EXPECT_EQ(2, shared.use_count());
+
+    runLua("unowned:dispose (); shared:dispose ()");
+    EXPECT_EQ(0, DestructorCounted::destructed);
+    EXPECT_EQ(1, shared.use_count());
+
+#if LUABRIDGE_HAS_EXCEPTIONS
+    EXPECT_THROW(runLua("result = unowned:value ()"), std::exception);
+#else
+    EXPECT_FALSE(runLua("result = unowned:value ()"));
+#endif
+
+    luabridge::setGlobal(L, &unowned, "unowned");
+    runLua("result = unowned:value ()");
+    EXPECT_EQ(42, result<int>());
+}
+
+TEST_F(UserDataTest, DisposeConstObjects)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<DestructorCounted>("DestructorCounted", luabridge::disposableClass)
+            .addFunction("value", &disposableValue)
+        .endClass();
+
+    DestructorCounted::destructed = 0;
+
+    auto shared = std::make_shared<const DestructorCounted>();
+    luabridge::setGlobal(L, shared, "obj");
+    EXPECT_EQ(2, shared.use_count());
+
+    runLua("result = obj:value (); obj:dispose ()");
+    EXPECT_EQ(42, result<int>());
+    EXPECT_EQ(1, shared.use_count());
+
+#if LUABRIDGE_HAS_EXCEPTIONS
+    EXPECT_THROW(runLua("result = obj:value ()"), std::exception);
+#else
+    EXPECT_FALSE(runLua("result = obj:value ()"));
+#endif
+
+#if LUA_VERSION_NUM >= 504
+    luabridge::setGlobal(L, shared, "obj");
+    runLua("do local closed <close> = obj end; result = 1");
+    EXPECT_EQ(1, shared.use_count());
+#endif
+
+    shared.reset();
+    EXPECT_EQ(1, DestructorCounted::destructed);
+}
+
+TEST_F(UserDataTest, DisposeUsesDynamicType)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<DestructorCounted>("DestructorCounted", luabridge::disposableClass)
+        .endClass()
+        .deriveClass<DisposableDerived, DestructorCounted>("DisposableDerived")
+            .addConstructor<void (*)()>()
+        .endClass();
+
+    DestructorCounted::destructed = 0;
+    DisposableDerived::derivedDestructed = 0;
+
+    runLua("local obj = DisposableDerived (); obj:dispose ()");
+    EXPECT_EQ(1, DestructorCounted::destructed);
+    EXPECT_EQ(1, DisposableDerived::derivedDestructed);
+}
+
+#if LUA_VERSION_NUM >= 504
+TEST_F(UserDataTest, DisposeToBeClosedVariables)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<DestructorCounted>("DestructorCounted", luabridge::disposableClass)
+            .addConstructor<void (*)()>()
+        .endClass();
+
+    DestructorCounted::destructed = 0;
+
+    runLua("do local obj <close> = DestructorCounted () end; result = 1");
+    EXPECT_EQ(1, DestructorCounted::destructed);
+}
+#endif
+
+namespace {
+struct ExternalMemoryObject
+{
+    explicit ExternalMemoryObject(int size) : size(size) {}
+
+    std::size_t luabridge_memory_size() const { return static_cast<std::size_t>(size); }
+
+    int size;
+};
+
+struct ExternalMemoryTraitObject
+{
+    std::vector<char> buffer = std::vector<char>(2048);
+};
+} // namespace
+
+template <>
+struct luabridge::ExternalMemorySize<ExternalMemoryTraitObject>
+{
+    static std::size_t get(const ExternalMemoryTraitObject& object) { return object.buffer.size(); }
+};
+
+TEST_F(UserDataTest, ExternalMemoryIsReported)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<ExternalMemoryObject>("ExternalMemoryObject", luabridge::disposableClass)
+            .addConstructor<void (*)(int)>()
+        .endClass()
+        .beginClass<ExternalMemoryTraitObject>("ExternalMemoryTraitObject")
+        .endClass();
+
+    EXPECT_EQ(0u, luabridge::getExternalMemoryStats(L).bytes);
+
+    runLua("a = ExternalMemoryObject (4096); b = ExternalMemoryObject (1000)");
+    EXPECT_EQ(5096u, luabridge::getExternalMemoryStats(L).bytes);
+    EXPECT_EQ(2u, luabridge::getExternalMemoryStats(L).objects);
+
+    auto shared = std::make_shared<ExternalMemoryTraitObject>();
+    luabridge::setGlobal(L, ExternalMemoryTraitObject(), "c");
+    luabridge::setGlobal(L, shared, "d");
+    EXPECT_EQ(9192u, luabridge::getExternalMemoryStats(L).bytes);
+    EXPECT_EQ(4u, luabridge::getExternalMemoryStats(L).objects);
+
+    ExternalMemoryObject unowned(100);
+    luabridge::setGlobal(L, &unowned, "e");
+    EXPECT_EQ(9192u, luabridge::getExternalMemoryStats(L).bytes);
+
+    runLua("b:dispose (); b:dispose ()");
+    EXPECT_EQ(8192u, luabridge::getExternalMemoryStats(L).bytes);
+    EXPECT_EQ(3u, luabridge::getExternalMemoryStats(L).objects);
+
+    shared.reset();
+    runLua("a = nil; b = nil; c = nil; d = nil; e = nil");
+    lua_gc(L, LUA_GCCOLLECT, 0);
+    EXPECT_EQ(0u, luabridge::getExternalMemoryStats(L).bytes);
+    EXPECT_EQ(0u, luabridge::getExternalMemoryStats(L).objects);
+}
+
+TEST_F(UserDataTest, ExternalMemoryChangingSize)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<ExternalMemoryObject>("ExternalMemoryObject")
+            .addConstructor<void (*)(int)>()
+            .addProperty("size", &ExternalMemoryObject::size)
+        .endClass();
+
+    runLua("a = ExternalMemoryObject (1024); b = ExternalMemoryObject (16)");
+    EXPECT_EQ(1040u, luabridge::getExternalMemoryStats(L).bytes);
+
+    // The memory reported when the object was pushed is the one released
+    runLua("a.size = 4096; b.size = 0; a.size = 8192");
+    EXPECT_EQ(1040u, luabridge::getExternalMemoryStats(L).bytes);
+
+    runLua("a = nil");
+    lua_gc(L, LUA_GCCOLLECT, 0);
+    EXPECT_EQ(16u, luabridge::getExternalMemoryStats(L).bytes);
+    EXPECT_EQ(1u, luabridge::getExternalMemoryStats(L).objects);
+
+    runLua("b = nil");
+    lua_gc(L, LUA_GCCOLLECT, 0);
+    EXPECT_EQ(0u, luabridge::getExternalMemoryStats(L).bytes);
+    EXPECT_EQ(0u, luabridge::getExternalMemoryStats(L).objects);
+}
+
+TEST_F(UserDataTest, ExternalMemoryPacesCollector)
+{
+    luabridge::getGlobalNamespace(L)
+        .beginClass<ExternalMemoryObject>("ExternalMemoryObject")
+            .addConstructor<void (*)(int)>()
+        .endClass();
+
+    runLua("for i = 1, 1000 do local o = ExternalMemoryObject (1024 * 1024) end");
+
+    // Without the reported memory the few bytes of the userdata would not trigger any collection
+    EXPECT_LT(luabridge::getExternalMemoryStats(L).objects, 500u);
+}
@@ -7,6 +7,9 @@
 
 #include "LuaBridge/Vector.h"
 
+#include <optional>
+#include <string>
+#include <utility>
 #include <vector>
 
 namespace {
@@ -119,6 +122,67 @@ TEST_F(VectorTests, PassFromLua)
     ASSERT_EQ(std::vector<Data>({-3, 4}), result<std::vector<Data>>());
 }
 
+TEST_F(VectorTests, StackSlotsOfNestedValues)
+{
+    static_assert(luabridge::detail::stack_slots_v<int> == 1);
+    static_assert(luabridge::detail::stack_slots_v<const std::string&> == 1);
+    static_assert(luabridge::detail::stack_slots_v<std::vector<std::string>> == 3);
+    static_assert(luabridge::detail::stack_slots_v<std::vector<std::vector<std::string>>> == 5);
+    static_assert(luabridge::detail::stack_slots_v<std::vector<std::optional<std::pair<int, std::string>>>> == 5);
+    static_assert(luabridge::detail::stack_slots_v<std::vector<Data>> == 0);
+
+    exhaustStackSpace();
+    lua_pop(L, 4);
+
+    const int top = lua_gettop(L);
+
+    // The whole depth is reserved before pushing anything
+    const std::vector<std::vector<std::string>> nested{ { "a", "b" }, { "c" } };
+    ASSERT_FALSE(luabridge::push(L, nested));
+    EXPECT_EQ(top, lua_gettop(L));
+
+    ASSERT_TRUE(luabridge::push(L, std::vector<std::string>{ "a", "b" }));
+    EXPECT_EQ(top + 1, lua_gettop(L));
+}
+
+TEST_F(VectorTests, ReturnNestedFromFunction)
+{
+    luabridge::getGlobalNamespace(L)
+        .addFunction("nested", [](int count)
+        {
+            return std::vector<std::vector<std::string>>(static_cast<std::size_t>(count), { "x", "y" });
+        });
+
+    runLua("local t = nested(3); result = #t .. t[3][2]");
+    EXPECT_EQ("3y", result<std::string>());
+}
+
+#if LUABRIDGE_ON_RAVI
+TEST_F(VectorTests, RaviTypedArrays)
+{
+    const std::vector<lua_Number> numbers{ 1.5, -2.0, 3.25 };
+    const std::vector<lua_Integer> integers{ 1, -2, 3, 4 };
+
+    luabridge::setGlobal(L, numbers, "numbers");
+    luabridge::setGlobal(L, integers, "integers");
+
+    lua_getglobal(L, "numbers");
+    EXPECT_TRUE(ravi_is_number_array(L, -1));
+    lua_getglobal(L, "integers");
+    EXPECT_TRUE(ravi_is_integer_array(L, -1));
+    lua_pop(L, 2);
+
+    runLua("result = #numbers + #integers");
+    EXPECT_EQ(7, result<int>());
+
+    EXPECT_EQ(numbers, luabridge::getGlobal<std::vector<lua_Number>>(L, "numbers").value());
+    EXPECT_EQ(integers, luabridge::getGlobal<std::vector<lua_Integer>>(L, "integers").value());
+
+    runLua("result = { 4.0, 5.0 }");
+    EXPECT_EQ(std::vector<lua_Number>({ 4.0, 5.0 }), result<std::vector<lua_Number>>());
+}
+#endif
+
 #if !LUABRIDGE_HAS_EXCEPTIONS
 TEST_F(VectorTests, PushUnregisteredWithNoExceptionsShouldFailButRestoreStack)
 {
@@ -0,0 +1,148 @@
+// https://github.com/kunitoki/LuaBridge3
+// Copyright 2023, Lucio Asnaghi
+// SPDX-License-Identifier: MIT
+
+#include "TestBase.h"
+
+#include <list>
+#include <vector>
+
+struct WeakLuaRefTests : TestBase
+{
+    int weakTableSlots()
+    {
+        using namespace luabridge;
+
+        lua_rawgetp(L, LUA_REGISTRYINDEX, luabridge::detail::getWeakReferencesKey());
+        if (! lua_istable(L, -1))
+        {
+            lua_pop(L, 1);
+            return 0;
+        }
+
+        lua_rawgeti(L, -1, -1);
+        const int slots = static_cast<int>(lua_tointeger(L, -1));
+        lua_pop(L, 2);
+        return slots;
+    }
+};
+
+TEST_F(WeakLuaRefTests, LockWhileAlive)
+{
+    runLua("result = { value = 42 }");
+
+    luabridge::WeakLuaRef weak(result());
+    EXPECT_FALSE(weak.expired());
+
+    auto strong = weak.lock();
+    ASSERT_TRUE(strong.isTable());
+    EXPECT_EQ(42, strong["value"].cast<int>().value());
+    EXPECT_TRUE(strong == result());
+}
+
+TEST_F(WeakLuaRefTests, DoesNotKeepValuesAlive)
+{
+    runLua("result = { value = 42 }");
+
+    luabridge::WeakLuaRef weak(result());
+
+    runLua("result = nil");
+    lua_gc(L, LUA_GCCOLLECT, 0);
+
+    EXPECT_TRUE(weak.expired());
+    EXPECT_TRUE(weak.lock().isNil());
+    EXPECT_EQ(1, weakTableSlots());
+}
+
+TEST_F(WeakLuaRefTests, ValuesNeverCollected)
+{
+    luabridge::WeakLuaRef number(luabridge::LuaRef(L, 42));
+    luabridge::WeakLuaRef string(luabridge::LuaRef(L, "abc"));
+
+    lua_gc(L, LUA_GCCOLLECT, 0);
+
+    EXPECT_EQ(42, number.lock().cast<int>().value());
+    EXPECT_EQ("abc", string.lock().cast<std::string>().value());
+
+    luabridge::WeakLuaRef nil{ luabridge::LuaRef(L) };
+    EXPECT_TRUE(nil.expired());
+}
+
+TEST_F(WeakLuaRefTests, CopyAndMove)
+{
+    runLua("result = function () return 1 end");
+
+    luabridge::WeakLuaRef weak(result());
+    luabridge::WeakLuaRef copy(weak);
+    luabridge::WeakLuaRef moved(std::move(copy));
+
+    EXPECT_TRUE(copy.expired());
+    EXPECT_TRUE(moved.lock() == result());
+
+    copy = moved;
+    EXPECT_TRUE(copy.lock() == result());
+
+    weak.reset();
+    EXPECT_TRUE(weak.expired());
+    EXPECT_FALSE(moved.expired());
+}
+
+TEST_F(WeakLuaRefTests, FromStack)
+{
+    lua_newtable(L);
+
+    auto weak = luabridge::WeakLuaRef::fromStack(L, -1);
+    EXPECT_FALSE(weak.expired());
+
+    lua_pop(L, 1);
+    lua_gc(L, LUA_GCCOLLECT, 0);
+
+    EXPECT_TRUE(weak.expired());
+}
+
+TEST_F(WeakLuaRefTests, SlotsAreReused)
+{
+    for (int i = 0; i < 100; ++i)
+    {
+        luabridge::WeakLuaRef weak(luabridge::newTable(L));
+        EXPECT_FALSE(weak.expired());
+    }
+
+    EXPECT_EQ(1, weakTableSlots());
+
+    std::vector<luabridge::WeakLuaRef> refs;
+    for (int i = 0; i < 10; ++i)
+        refs.emplace_back(luabridge::newTable(L));
+
+    EXPECT_EQ(10, weakTableSlots());
+
+    refs.clear();
+    for (int i = 0; i < 10; ++i)
+        refs.emplace_back(luabridge::newTable(L));
+
+    EXPECT_EQ(10, weakTableSlots());
+}
+
+TEST_F(WeakLuaRefTests, PurgeExpired)
+{
+    runLua("a = {}; b = {}; c = {}");
+
+    std::vector<luabridge::WeakLuaRef> refs;
+    refs.emplace_back(luabridge::getGlobal(L, "a"));
+    refs.emplace_back(luabridge::getGlobal(L, "b"));
+    refs.emplace_back(luabridge::getGlobal(L, "c"));
+
+    std::list<luabridge::WeakLuaRef> listRefs;
+    listRefs.emplace_back(luabridge::getGlobal(L, "a"));
+    listRefs.emplace_back(luabridge::getGlobal(L, "b"));
+
+    runLua("a = nil; c = nil");
+    lua_gc(L, LUA_GCCOLLECT, 0);
+
+    EXPECT_EQ(2u, luabridge::purgeExpired(refs));
+    ASSERT_EQ(1u, refs.size());
+    EXPECT_TRUE(refs.front().lock() == luabridge::getGlobal(L, "b"));
+
+    EXPECT_EQ(1u, luabridge::purgeExpired(listRefs));
+    EXPECT_EQ(1u, listRefs.size());
+}